@@ -0,0 +1,174 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __BENCH_UTIL_H__
+#define __BENCH_UTIL_H__
+
+#include <benchmark/benchmark.h>
+
+#include "AllocationCounter.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace OverflowBench
+{
+    typedef std::vector<unsigned char> Bytes;
+
+    // recorded streams named by OVERFLOW_BENCH_CAPTURE, see CaptureBenchmarks.cc
+    void registerCaptureBenchmarks();
+    
+    class Helpers
+    {
+    public:
+        static Bytes makeRtpPacket(bool marker, uint16_t seq, uint32_t timestamp, const Bytes& payload)
+        {
+            Bytes packet = {
+                0x80, (unsigned char)((marker ? 0x80 : 0x00) | 96),
+                (unsigned char)(seq >> 8), (unsigned char)(seq & 0xFF),
+                (unsigned char)(timestamp >> 24), (unsigned char)(timestamp >> 16),
+                (unsigned char)(timestamp >> 8), (unsigned char)(timestamp & 0xFF),
+                0xDE, 0xAD, 0xBE, 0xEF
+            };
+            packet.insert(packet.end(), payload.begin(), payload.end());
+            return packet;
+        }
+
+        // one h264 access unit of frameSize bytes, fu-a fragmented to fit mtu
+        static std::vector<Bytes> makeH264FuAFrame(size_t frameSize, size_t mtu, uint16_t seq)
+        {
+            std::vector<Bytes> packets;
+            const size_t fragment = mtu - 12 - 2;
+            for (size_t offset = 0; offset < frameSize; offset += fragment)
+            {
+                size_t length = std::min(fragment, frameSize - offset);
+                bool first = offset == 0;
+                bool last = offset + length >= frameSize;
+                
+                Bytes payload(2 + length, 0xA5);
+                payload[0] = 0x7C;
+                payload[1] = (first ? 0x80 : 0x00) | (last ? 0x40 : 0x00) | 0x05;
+                packets.push_back(makeRtpPacket(last, seq++, 0, payload));
+            }
+            return packets;
+        }
+
+        // rfc 7798 fragmentation units of an idr_w_radl
+        static std::vector<Bytes> makeH265FuFrame(size_t frameSize, size_t mtu, uint16_t seq)
+        {
+            std::vector<Bytes> packets;
+            const size_t fragment = mtu - 12 - 3;
+            for (size_t offset = 0; offset < frameSize; offset += fragment)
+            {
+                size_t length = std::min(fragment, frameSize - offset);
+                bool first = offset == 0;
+                bool last = offset + length >= frameSize;
+                
+                Bytes payload(3 + length, 0xA5);
+                payload[0] = 49 << 1;
+                payload[1] = 0x01;
+                payload[2] = (first ? 0x80 : 0x00) | (last ? 0x40 : 0x00) | 19;
+                packets.push_back(makeRtpPacket(last, seq++, 0, payload));
+            }
+            return packets;
+        }
+
+        // rfc 2435 baseline jpeg with q < 128 so the tables are generated
+        static std::vector<Bytes> makeMJPEGFrame(size_t frameSize, size_t mtu, uint16_t seq)
+        {
+            std::vector<Bytes> packets;
+            const size_t fragment = mtu - 12 - 8;
+            for (size_t offset = 0; offset < frameSize; offset += fragment)
+            {
+                size_t length = std::min(fragment, frameSize - offset);
+                bool last = offset + length >= frameSize;
+
+                Bytes payload(8 + length, 0x5A);
+                payload[0] = 0;
+                payload[1] = (offset >> 16) & 0xFF;
+                payload[2] = (offset >> 8) & 0xFF;
+                payload[3] = offset & 0xFF;
+                payload[4] = 1;
+                payload[5] = 80;
+                payload[6] = 640 / 8;
+                payload[7] = 480 / 8;
+                packets.push_back(makeRtpPacket(last, seq++, 0, payload));
+            }
+            return packets;
+        }
+
+        static std::vector<Bytes> makeRawFrame(size_t frameSize, size_t mtu, uint16_t seq)
+        {
+            std::vector<Bytes> packets;
+            const size_t fragment = mtu - 12;
+            for (size_t offset = 0; offset < frameSize; offset += fragment)
+            {
+                size_t length = std::min(fragment, frameSize - offset);
+                bool last = offset + length >= frameSize;
+                packets.push_back(makeRtpPacket(last, seq++, 0, Bytes(length, 0x3C)));
+            }
+            return packets;
+        }
+
+        static size_t totalLength(const std::vector<Bytes>& packets)
+        {
+            size_t total = 0;
+            for (auto& packet: packets)
+                total += packet.size();
+            return total;
+        }
+
+        static size_t countFrames(const std::vector<Bytes>& packets)
+        {
+            size_t frames = 0;
+            for (auto& packet: packets)
+            {
+                if (packet.size() > 1 and (packet[1] & 0x80))
+                    frames++;
+            }
+            return frames;
+        }
+
+        // ns/packet, bytes/s and allocations/packet (and /frame when frames
+        // is given) for a loop that handled them once per iteration
+        static void reportPerPacket(benchmark::State& state,
+                                    size_t packets,
+                                    size_t bytes,
+                                    uint64_t allocationsBefore,
+                                    size_t frames = 0)
+        {
+            uint64_t allocations = OverflowTest::AllocationCounter::allocations() - allocationsBefore;
+            double handled = static_cast<double>(state.iterations() * packets);
+            
+            state.SetBytesProcessed(state.iterations() * bytes);
+            state.SetItemsProcessed(state.iterations() * packets);
+            state.counters["time_per_packet"] = benchmark::Counter(
+                handled, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+            state.counters["allocs_per_packet"] = handled > 0 ? allocations / handled : 0;
+            if (frames > 0)
+                state.counters["allocs_per_frame"] = allocations / static_cast<double>(state.iterations() * frames);
+        }
+    };
+};
+
+#endif //__BENCH_UTIL_H__
@@ -0,0 +1,208 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <benchmark/benchmark.h>
+
+#include "InterleavedTcpReader.h"
+#include "H264Depacketizer.h"
+#include "H265Depacketizer.h"
+#include "MJPEGDepacketizer.h"
+#include "MP4VDepacketizer.h"
+#include "FrameBuffer.h"
+#include "SessionDescription.h"
+
+#include "BenchUtil.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// Recorded captures are the raw bytes of an interleaved rtsp session
+// (for example wireshark "follow tcp stream" saved as raw), picked up from:
+//
+//   OVERFLOW_BENCH_CAPTURE=/path/to/stream.bin
+//   OVERFLOW_BENCH_CAPTURE_CODEC=h264|h265|mjpeg|mp4v   (default h264)
+//   OVERFLOW_BENCH_CAPTURE_FMTP="a=fmtp:96 ..."    (optional)
+//   OVERFLOW_BENCH_CAPTURE_CHANNEL=0               (rtp channel, default 0)
+
+#define CAPTURE_READ_SIZE (64 * 1024)
+
+using OverflowBench::Helpers;
+
+
+namespace
+{
+    class CaptureCollector: public Overflow::IInterleavedReaderDelegate
+    {
+    public:
+        CaptureCollector(int channel) : mChannel(channel) { }
+
+        void onInterleavedPacket(int channel,
+                                 const unsigned char* buffer,
+                                 size_t length) override
+        {
+            if (channel == mChannel)
+                packets.push_back(OverflowBench::Bytes(buffer, buffer + length));
+        }
+
+        void onRtspMessage(const unsigned char* buffer,
+                           size_t length,
+                           const Overflow::RtspResponseParser& parsed) override
+        { }
+
+        std::vector<OverflowBench::Bytes> packets;
+        
+    private:
+        int mChannel;
+    };
+
+    class NullReaderDelegate: public Overflow::IInterleavedReaderDelegate
+    {
+    public:
+        void onInterleavedPacket(int, const unsigned char* buffer, size_t) override
+        {
+            benchmark::DoNotOptimize(buffer);
+        }
+
+        void onRtspMessage(const unsigned char*, size_t,
+                           const Overflow::RtspResponseParser&) override { }
+    };
+    
+    std::string envOr(const char* name, const std::string& fallback)
+    {
+        const char* value = getenv(name);
+        return value != nullptr ? std::string(value) : fallback;
+    }
+
+    struct Capture
+    {
+        std::string stream;
+        std::vector<OverflowBench::Bytes> packets;
+        Overflow::SessionDescription palette;
+    };
+
+    Capture gCapture;
+
+    void BM_CaptureReaderFeed(benchmark::State& state)
+    {
+        const unsigned char *bytes = (const unsigned char*)gCapture.stream.c_str();
+        NullReaderDelegate delegate;
+        
+        uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+        for (auto _ : state)
+        {
+            Overflow::InterleavedTcpReader reader(&delegate);
+            for (size_t offset = 0; offset < gCapture.stream.size(); offset += CAPTURE_READ_SIZE)
+            {
+                size_t length = std::min<size_t>(CAPTURE_READ_SIZE, gCapture.stream.size() - offset);
+                reader.feed(bytes + offset, length);
+            }
+        }
+        Helpers::reportPerPacket(state, gCapture.packets.size(), gCapture.stream.size(), allocations);
+    }
+
+    template <typename Depacketizer>
+    void BM_CaptureDepacketize(benchmark::State& state)
+    {
+        Overflow::FrameBuffer frame(0);
+        bool isFirstPayload = true;
+
+        uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+        for (auto _ : state)
+        {
+            for (auto& raw: gCapture.packets)
+            {
+                Overflow::RtpPacketView packet(&raw[0], raw.size());
+                OverflowTest::Helpers::addPacketToFrame<Depacketizer>(&gCapture.palette, &packet,
+                                                                      isFirstPayload, &frame);
+                isFirstPayload = false;
+
+                if (packet.isMarked())
+                {
+                    benchmark::DoNotOptimize(frame.bytesPointer());
+                    frame.clear();
+                }
+            }
+        }
+        Helpers::reportPerPacket(state, gCapture.packets.size(),
+                                 Helpers::totalLength(gCapture.packets), allocations,
+                                 Helpers::countFrames(gCapture.packets));
+    }
+};
+
+
+void
+OverflowBench::registerCaptureBenchmarks()
+{
+    std::string path = envOr("OVERFLOW_BENCH_CAPTURE", "");
+    if (path.empty())
+        return;
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (not file)
+    {
+        fprintf(stderr, "unable to read capture: %s\n", path.c_str());
+        return;
+    }
+    gCapture.stream.assign(std::istreambuf_iterator<char>(file),
+                           std::istreambuf_iterator<char>());
+
+    CaptureCollector collector(atoi(envOr("OVERFLOW_BENCH_CAPTURE_CHANNEL", "0").c_str()));
+    Overflow::InterleavedTcpReader reader(&collector);
+    reader.feed((const unsigned char*)gCapture.stream.c_str(), gCapture.stream.size());
+    gCapture.packets.swap(collector.packets);
+
+    std::string codec = envOr("OVERFLOW_BENCH_CAPTURE_CODEC", "h264");
+    std::string fmtp = envOr("OVERFLOW_BENCH_CAPTURE_FMTP", "");
+    
+    Overflow::RtspSessionType type = Overflow::H264;
+    if (codec == "mjpeg")
+        type = Overflow::MJPEG;
+    else if (codec == "mp4v")
+        type = Overflow::MP4V;
+    else if (codec == "h265")
+        type = Overflow::H265;
+    gCapture.palette = Overflow::SessionDescription(type, "", "", fmtp, -1, -1, -1);
+
+    benchmark::RegisterBenchmark("BM_CaptureReaderFeed", BM_CaptureReaderFeed);
+    switch (type)
+    {
+    case Overflow::MJPEG:
+        benchmark::RegisterBenchmark("BM_CaptureDepacketize/mjpeg",
+                                     BM_CaptureDepacketize<Overflow::MJPEGDepacketizer>);
+        break;
+    case Overflow::MP4V:
+        benchmark::RegisterBenchmark("BM_CaptureDepacketize/mp4v",
+                                     BM_CaptureDepacketize<Overflow::MP4VDepacketizer>);
+        break;
+    case Overflow::H265:
+        benchmark::RegisterBenchmark("BM_CaptureDepacketize/h265",
+                                     BM_CaptureDepacketize<Overflow::H265Depacketizer>);
+        break;
+    default:
+        benchmark::RegisterBenchmark("BM_CaptureDepacketize/h264",
+                                     BM_CaptureDepacketize<Overflow::H264Depacketizer>);
+        break;
+    }
+}
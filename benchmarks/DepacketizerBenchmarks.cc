@@ -0,0 +1,179 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <benchmark/benchmark.h>
+
+#include "H264Depacketizer.h"
+#include "H265Depacketizer.h"
+#include "MJPEGDepacketizer.h"
+#include "MP4VDepacketizer.h"
+#include "FrameBuffer.h"
+#include "SessionDescription.h"
+
+#include "BenchUtil.h"
+#include "Util.h"
+
+using OverflowBench::Helpers;
+
+
+template <typename Depacketizer>
+static void depacketizeFrames(benchmark::State& state,
+                              Overflow::SessionDescription palette,
+                              const std::vector<OverflowBench::Bytes>& packets)
+{
+    Overflow::FrameBuffer frame(0);
+    bool isFirstPayload = true;
+
+    uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+    for (auto _ : state)
+    {
+        for (auto& raw: packets)
+        {
+            Overflow::RtpPacketView packet(&raw[0], raw.size());
+            OverflowTest::Helpers::addPacketToFrame<Depacketizer>(&palette, &packet, isFirstPayload, &frame);
+            isFirstPayload = false;
+
+            if (packet.isMarked())
+            {
+                benchmark::DoNotOptimize(frame.bytesPointer());
+                frame.clear();
+            }
+        }
+    }
+    Helpers::reportPerPacket(state, packets.size(), Helpers::totalLength(packets), allocations,
+                             Helpers::countFrames(packets));
+}
+
+// Arg(0): frame size
+static void BM_H264DepacketizerFuA(benchmark::State& state)
+{
+    Overflow::SessionDescription palette;
+    depacketizeFrames<Overflow::H264Depacketizer>(
+        state, palette, Helpers::makeH264FuAFrame(static_cast<size_t>(state.range(0)), 1400, 0));
+}
+BENCHMARK(BM_H264DepacketizerFuA)->Arg(8 * 1024)->Arg(64 * 1024)->Arg(512 * 1024);
+
+// Arg(0): frame size, lengths patched per fragment instead of start codes
+static void BM_H264DepacketizerFuALengthPrefixed(benchmark::State& state)
+{
+    Overflow::SessionDescription palette;
+    Overflow::NaluWriter writer(Overflow::NALU_FORMAT_LENGTH_PREFIXED, 4);
+    Overflow::FrameBuffer frame(0);
+    auto packets = Helpers::makeH264FuAFrame(static_cast<size_t>(state.range(0)), 1400, 0);
+
+    uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+    for (auto _ : state)
+    {
+        for (auto& raw: packets)
+        {
+            Overflow::RtpPacketView packet(&raw[0], raw.size());
+            Overflow::H264Depacketizer depacketizer(&palette, &packet, &writer);
+            depacketizer.addToFrame(&frame);
+
+            if (packet.isMarked())
+            {
+                benchmark::DoNotOptimize(frame.bytesPointer());
+                frame.clear();
+            }
+        }
+    }
+    Helpers::reportPerPacket(state, packets.size(), Helpers::totalLength(packets), allocations,
+                             Helpers::countFrames(packets));
+}
+BENCHMARK(BM_H264DepacketizerFuALengthPrefixed)->Arg(8 * 1024)->Arg(64 * 1024)->Arg(512 * 1024);
+
+static void BM_H264DepacketizerSingleNalu(benchmark::State& state)
+{
+    Overflow::SessionDescription palette;
+    std::vector<OverflowBench::Bytes> packets;
+    for (uint16_t i = 0; i < 16; ++i)
+    {
+        OverflowBench::Bytes payload(static_cast<size_t>(state.range(0)), 0xA5);
+        payload[0] = 0x41;
+        packets.push_back(Helpers::makeRtpPacket(i == 15, i, 0, payload));
+    }
+    depacketizeFrames<Overflow::H264Depacketizer>(state, palette, packets);
+}
+BENCHMARK(BM_H264DepacketizerSingleNalu)->Arg(200)->Arg(1200);
+
+// Arg(0): units per stap-a, sps/pps/sei sized
+static void BM_H264DepacketizerStapA(benchmark::State& state)
+{
+    Overflow::SessionDescription palette;
+    OverflowBench::Bytes payload(1, 0x18);
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        OverflowBench::Bytes unit(24, 0xA5);
+        unit[0] = 0x06;
+        payload.push_back(0x00);
+        payload.push_back(static_cast<unsigned char>(unit.size()));
+        payload.insert(payload.end(), unit.begin(), unit.end());
+    }
+    std::vector<OverflowBench::Bytes> packets;
+    packets.push_back(Helpers::makeRtpPacket(true, 0, 0, payload));
+    depacketizeFrames<Overflow::H264Depacketizer>(state, palette, packets);
+}
+BENCHMARK(BM_H264DepacketizerStapA)->Arg(3)->Arg(32);
+
+// Arg(0): frame size
+static void BM_H265DepacketizerFu(benchmark::State& state)
+{
+    Overflow::SessionDescription palette(Overflow::H265, "trackID=0", "a=rtpmap:96 H265/90000",
+                                         "", 25, 640, 480);
+    depacketizeFrames<Overflow::H265Depacketizer>(
+        state, palette, Helpers::makeH265FuFrame(static_cast<size_t>(state.range(0)), 1400, 0));
+}
+BENCHMARK(BM_H265DepacketizerFu)->Arg(8 * 1024)->Arg(64 * 1024)->Arg(512 * 1024);
+
+static void BM_H265DepacketizerSingleNalu(benchmark::State& state)
+{
+    Overflow::SessionDescription palette(Overflow::H265, "trackID=0", "a=rtpmap:96 H265/90000",
+                                         "", 25, 640, 480);
+    std::vector<OverflowBench::Bytes> packets;
+    for (uint16_t i = 0; i < 16; ++i)
+    {
+        OverflowBench::Bytes payload(static_cast<size_t>(state.range(0)), 0xA5);
+        payload[0] = 0x02;
+        payload[1] = 0x01;
+        packets.push_back(Helpers::makeRtpPacket(i == 15, i, 0, payload));
+    }
+    depacketizeFrames<Overflow::H265Depacketizer>(state, palette, packets);
+}
+BENCHMARK(BM_H265DepacketizerSingleNalu)->Arg(200)->Arg(1200);
+
+static void BM_MJPEGDepacketizer(benchmark::State& state)
+{
+    Overflow::SessionDescription palette;
+    depacketizeFrames<Overflow::MJPEGDepacketizer>(
+        state, palette, Helpers::makeMJPEGFrame(static_cast<size_t>(state.range(0)), 1400, 0));
+}
+BENCHMARK(BM_MJPEGDepacketizer)->Arg(64 * 1024)->Arg(256 * 1024);
+
+static void BM_MP4VDepacketizer(benchmark::State& state)
+{
+    Overflow::SessionDescription palette(Overflow::MP4V, "trackID=0",
+                                         "a=rtpmap:96 MP4V-ES/90000",
+                                         "a=fmtp:96 profile-level-id=1;config=000001B001000001B58913000001000000012000C48D8800F50A041E1463000001B24C61766335322E3132332E30",
+                                         25, 640, 480);
+    depacketizeFrames<Overflow::MP4VDepacketizer>(
+        state, palette, Helpers::makeRawFrame(static_cast<size_t>(state.range(0)), 1400, 0));
+}
+BENCHMARK(BM_MP4VDepacketizer)->Arg(16 * 1024)->Arg(128 * 1024);
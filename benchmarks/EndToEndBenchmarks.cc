@@ -0,0 +1,197 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <benchmark/benchmark.h>
+
+#include "RtspWanClient.h"
+#include "MockRtspServer.h"
+
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+// Drives a real RtspWanClient against the in-process mock server over
+// loopback. Args are the codec and the bitrate, bitrate 0 sends frames as
+// fast as the client takes them.
+
+#define E2E_FPS 60
+
+#define E2E_PACED_FRAMES 120
+
+#define E2E_FIRST_FRAME_TIMEOUT_MS 5000
+
+#define E2E_FRAME_TIMEOUT_MS 1000
+
+
+namespace
+{
+    uint64_t steadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double processCpuSeconds()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+            + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    }
+    
+    class LatencyDelegate: public Overflow::IRtspDelegate
+    {
+    public:
+        LatencyDelegate() : frames(0), bytes(0) { }
+        
+        void onPaletteType(Overflow::RtspSessionType) override { }
+
+        void onRtspClientStateChange(Overflow::RtspClientState, Overflow::RtspClientState) override { }
+
+        void onRtpPacketExtension(int, const unsigned char*, const size_t) override { }
+
+        void onPayload(const unsigned char* buffer, const size_t length) override
+        {
+            uint64_t now = steadyNanoseconds();
+            uint64_t stamp = 0;
+            bool haveStamp = OverflowMock::MockStream::findFrameStamp(buffer, length, &stamp);
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            if (haveStamp and now >= stamp)
+                latencies.push_back(now - stamp);
+            frames++;
+            bytes += length;
+            condition.notify_all();
+        }
+
+        bool waitForFrames(uint64_t count, int timeoutMs)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            return condition.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                      [&]() { return frames >= count; });
+        }
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<uint64_t> latencies;
+        uint64_t frames;
+        uint64_t bytes;
+    };
+
+    double percentile(std::vector<uint64_t>* values, double fraction)
+    {
+        if (values->empty())
+            return 0;
+        size_t index = std::min(values->size() - 1, (size_t)(fraction * values->size()));
+        std::nth_element(values->begin(), values->begin() + index, values->end());
+        return (*values)[index];
+    }
+
+    void BM_EndToEnd(benchmark::State& state)
+    {
+        OverflowMock::MockStreamOptions options;
+        options.codec = (OverflowMock::MockCodec)state.range(0);
+        options.bitrate = state.range(1);
+        options.fps = E2E_FPS;
+
+        OverflowMock::MockRtspServer server(options);
+        if (not server.start())
+        {
+            state.SkipWithError("mock server failed to start");
+            return;
+        }
+
+        LatencyDelegate delegate;
+        Overflow::RtspWanClient client(&delegate, server.getUrl());
+        client.start();
+        
+        if (not delegate.waitForFrames(1, E2E_FIRST_FRAME_TIMEOUT_MS))
+        {
+            state.SkipWithError("no frames from the mock server");
+            return;
+        }
+
+        uint64_t framesBefore;
+        uint64_t bytesBefore;
+        {
+            std::lock_guard<std::mutex> lock(delegate.mutex);
+            delegate.latencies.clear();
+            framesBefore = delegate.frames;
+            bytesBefore = delegate.bytes;
+        }
+        uint64_t receivedBefore = client.getMetrics().bytesReceived;
+        double cpuBefore = processCpuSeconds() - server.getCpuSeconds();
+        uint64_t startNanoseconds = steadyNanoseconds();
+
+        uint64_t expected = framesBefore;
+        for (auto _ : state)
+        {
+            if (not delegate.waitForFrames(++expected, E2E_FRAME_TIMEOUT_MS))
+            {
+                state.SkipWithError("stream stalled");
+                break;
+            }
+        }
+
+        double seconds = (steadyNanoseconds() - startNanoseconds) / 1e9;
+        double cpu = processCpuSeconds() - server.getCpuSeconds() - cpuBefore;
+        uint64_t received = client.getMetrics().bytesReceived - receivedBefore;
+
+        client.stop();
+        client.join();
+        server.stop();
+
+        std::lock_guard<std::mutex> lock(delegate.mutex);
+        double megabits = received * 8 / 1e6;
+        double mbps = seconds > 0 ? megabits / seconds : 0;
+        
+        state.SetBytesProcessed(delegate.bytes - bytesBefore);
+        state.counters["mbps"] = mbps;
+        state.counters["fps"] = seconds > 0 ? (delegate.frames - framesBefore) / seconds : 0;
+        // client cpu, one core is 100
+        state.counters["cpu_percent_per_mbps"] = (seconds > 0 and mbps > 0) ? (cpu / seconds * 100) / mbps : 0;
+        state.counters["latency_p50_us"] = percentile(&delegate.latencies, 0.50) / 1e3;
+        state.counters["latency_p99_us"] = percentile(&delegate.latencies, 0.99) / 1e3;
+    }
+};
+
+BENCHMARK(BM_EndToEnd)
+    ->ArgNames({ "codec", "bitrate" })
+    ->Args({ OverflowMock::MOCK_H264, 4 * 1000 * 1000 })
+    ->Args({ OverflowMock::MOCK_H264, 20 * 1000 * 1000 })
+    ->Args({ OverflowMock::MOCK_MJPEG, 20 * 1000 * 1000 })
+    ->Args({ OverflowMock::MOCK_MP4V, 4 * 1000 * 1000 })
+    ->Iterations(E2E_PACED_FRAMES)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// unpaced, how fast one client can go
+BENCHMARK(BM_EndToEnd)
+    ->ArgNames({ "codec", "bitrate" })
+    ->Args({ OverflowMock::MOCK_H264, 0 })
+    ->Args({ OverflowMock::MOCK_MJPEG, 0 })
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,97 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <benchmark/benchmark.h>
+
+#include "InterleavedTcpReader.h"
+
+#include "BenchUtil.h"
+
+#include <string>
+#include <algorithm>
+
+
+class CountingReaderDelegate: public Overflow::IInterleavedReaderDelegate
+{
+public:
+    CountingReaderDelegate(): payloadBytes(0) { }
+    
+    void onInterleavedPacket(int channel,
+                             const unsigned char* buffer,
+                             size_t length) override
+    {
+        payloadBytes += length;
+        benchmark::DoNotOptimize(buffer);
+    }
+
+    void onRtspMessage(const unsigned char* buffer,
+                       size_t length,
+                       const Overflow::RtspResponseParser& parsed) override
+    { }
+
+    uint64_t payloadBytes;
+};
+
+// synthetic interleaved stream of fixed size rtp packets on channel 0
+static std::string makeInterleavedStream(size_t packetSize, size_t count)
+{
+    std::string stream;
+    for (size_t i = 0; i < count; ++i)
+    {
+        stream += '$';
+        stream += (char)0;
+        stream += (char)((packetSize >> 8) & 0xFF);
+        stream += (char)(packetSize & 0xFF);
+        stream += std::string(packetSize, (char)(i & 0xFF));
+    }
+    return stream;
+}
+
+// Arg(0): rtp packet size, Arg(1): socket read size
+static void BM_InterleavedTcpReaderFeed(benchmark::State& state)
+{
+    const size_t packet_size = static_cast<size_t>(state.range(0));
+    const size_t read_size = static_cast<size_t>(state.range(1));
+    const std::string stream = makeInterleavedStream(packet_size, 256);
+    const unsigned char *bytes = (const unsigned char*)stream.c_str();
+
+    CountingReaderDelegate delegate;
+    Overflow::InterleavedTcpReader reader(&delegate);
+    
+    uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+    for (auto _ : state)
+    {
+        for (size_t offset = 0; offset < stream.size(); offset += read_size)
+        {
+            size_t length = std::min(read_size, stream.size() - offset);
+            reader.feed(bytes + offset, length);
+        }
+    }
+
+    double copied = static_cast<double>(reader.getReceiveBuffer().bytesCopied());
+    OverflowBench::Helpers::reportPerPacket(state, 256, stream.size(), allocations);
+    state.counters["copied_per_payload_byte"] = copied / delegate.payloadBytes;
+}
+BENCHMARK(BM_InterleavedTcpReaderFeed)
+    ->Args({1400, 1024})
+    ->Args({1400, 4096})
+    ->Args({1400, 64 * 1024})
+    ->Args({60000, 64 * 1024});
@@ -0,0 +1,80 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <benchmark/benchmark.h>
+
+#include "RtpPacketView.h"
+#include "RtpPacket.h"
+
+#include "BenchUtil.h"
+
+using OverflowBench::Helpers;
+
+
+static void BM_RtpPacketViewParse(benchmark::State& state)
+{
+    const OverflowBench::Bytes raw = Helpers::makeRtpPacket(
+        true, 1, 0, OverflowBench::Bytes(static_cast<size_t>(state.range(0)), 0x11));
+    
+    uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+    for (auto _ : state)
+    {
+        Overflow::RtpPacketView packet(&raw[0], raw.size());
+        benchmark::DoNotOptimize(packet.payloadData());
+    }
+    Helpers::reportPerPacket(state, 1, raw.size(), allocations);
+}
+BENCHMARK(BM_RtpPacketViewParse)->Arg(200)->Arg(1400);
+
+static void BM_RtpPacketViewParseExtension(benchmark::State& state)
+{
+    OverflowBench::Bytes raw = Helpers::makeRtpPacket(
+        true, 1, 0, { 0xAB, 0xAC, 0x00, 0x02, 1, 2, 3, 4, 5, 6, 7, 8 });
+    raw[0] |= 0x10;
+    raw.insert(raw.end(), 1400, 0x11);
+    
+    uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+    for (auto _ : state)
+    {
+        Overflow::RtpPacketView packet(&raw[0], raw.size());
+        benchmark::DoNotOptimize(packet.getExtensionData());
+    }
+    Helpers::reportPerPacket(state, 1, raw.size(), allocations);
+}
+BENCHMARK(BM_RtpPacketViewParseExtension);
+
+// the owning copy the jitter buffer makes for packets it has to hold
+static void BM_RtpPacketClone(benchmark::State& state)
+{
+    const OverflowBench::Bytes raw = Helpers::makeRtpPacket(
+        true, 1, 0, OverflowBench::Bytes(static_cast<size_t>(state.range(0)), 0x11));
+    Overflow::RtpPacketView view(&raw[0], raw.size());
+    
+    uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+    for (auto _ : state)
+    {
+        Overflow::RtpPacket* packet = view.clone();
+        benchmark::DoNotOptimize(packet);
+        delete packet;
+    }
+    Helpers::reportPerPacket(state, 1, raw.size(), allocations);
+}
+BENCHMARK(BM_RtpPacketClone)->Arg(200)->Arg(1400);
@@ -0,0 +1,83 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <benchmark/benchmark.h>
+
+#include "RtspResponse.h"
+#include "RtspResponseParser.h"
+
+#include "BenchUtil.h"
+
+#include <string>
+
+
+static const std::string kDescribeBody =
+    "v=0\r\n"
+    "o=- 1 1 IN IP4 127.0.0.1\r\n"
+    "s=Session streamed with GStreamer\r\n"
+    "t=0 0\r\n"
+    "a=control:*\r\n"
+    "m=video 0 RTP/AVP 96\r\n"
+    "a=rtpmap:96 H264/90000\r\n"
+    "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=Z0IAKQ==,aM4=\r\n"
+    "a=control:stream=0\r\n"
+    "a=framerate:25\r\n"
+    "a=x-dimensions:640,480\r\n";
+
+static const std::string kDescribeResponse =
+    "RTSP/1.0 200 OK\r\n"
+    "CSeq: 2\r\n"
+    "Date: Mon, 01 Jan 2018 00:00:00 GMT\r\n"
+    "Content-Base: rtsp://127.0.0.1:8554/test/\r\n"
+    "Content-Type: application/sdp\r\n"
+    "Content-Length: " + std::to_string(kDescribeBody.length()) + "\r\n"
+    "\r\n"
+    + kDescribeBody;
+
+static void BM_RtspResponseParse(benchmark::State& state)
+{
+    const unsigned char *bytes = (const unsigned char*)kDescribeResponse.c_str();
+    
+    uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+    for (auto _ : state)
+    {
+        Overflow::RtspResponse response(bytes, kDescribeResponse.length());
+        benchmark::DoNotOptimize(response.getCode());
+    }
+    OverflowBench::Helpers::reportPerPacket(state, 1, kDescribeResponse.length(), allocations);
+}
+BENCHMARK(BM_RtspResponseParse);
+
+static void BM_RtspResponseParserParse(benchmark::State& state)
+{
+    const unsigned char *bytes = (const unsigned char*)kDescribeResponse.c_str();
+    Overflow::RtspResponseParser parser;
+    
+    uint64_t allocations = OverflowTest::AllocationCounter::allocations();
+    for (auto _ : state)
+    {
+        parser.reset();
+        parser.parse(bytes, kDescribeResponse.length());
+        benchmark::DoNotOptimize(parser.getBody().bytesPointer());
+    }
+    OverflowBench::Helpers::reportPerPacket(state, 1, kDescribeResponse.length(), allocations);
+}
+BENCHMARK(BM_RtspResponseParserParse);
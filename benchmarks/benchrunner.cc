@@ -0,0 +1,14 @@
+#include <benchmark/benchmark.h>
+
+#include "BenchUtil.h"
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    OverflowBench::registerCaptureBenchmarks();
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,461 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "MockRtspServer.h"
+
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// how often idle loops look for stop()
+#define MOCK_POLL_INTERVAL_MS 100
+
+#define MOCK_SEND_TIMEOUT_MS 1000
+
+#define MOCK_MAX_REQUEST_SIZE 8192
+
+#define MOCK_SESSION_ID "4F564D4B"
+
+#define MOCK_SESSION_TIMEOUT_SECONDS 60
+
+// a paced stream that falls this far behind starts again from now
+#define MOCK_MAX_LAG_MS 1000
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+
+static uint64_t steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t unixMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t threadCpuNanoseconds()
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool writeAll(int fd, const unsigned char* data, size_t length, const std::atomic<bool>& isRunning)
+{
+    size_t offset = 0;
+    while (offset < length)
+    {
+        ssize_t written = send(fd, data + offset, length - offset, MSG_NOSIGNAL);
+        if (written < 0 and (errno == EAGAIN or errno == EWOULDBLOCK or errno == EINTR))
+        {
+            // a slow reader, keep trying unless we are stopping
+            if (not isRunning)
+                return false;
+            continue;
+        }
+        if (written <= 0)
+            return false;
+        offset += written;
+    }
+    return true;
+}
+
+static std::string headerValue(const std::string& request, const std::string& key)
+{
+    std::istringstream lines(request);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        if (line.length() <= key.length() or line[key.length()] != ':')
+            continue;
+        if (strncasecmp(line.c_str(), key.c_str(), key.length()) != 0)
+            continue;
+
+        size_t begin = line.find_first_not_of(' ', key.length() + 1);
+        size_t end = line.find_last_not_of("\r ");
+        if (begin == std::string::npos or end < begin)
+            return std::string();
+        return line.substr(begin, end - begin + 1);
+    }
+    return std::string();
+}
+
+
+OverflowMock::MockRtspServer::MockRtspServer(const MockStreamOptions& options)
+    : mOptions(options),
+      mListenFd(-1),
+      mPort(-1),
+      mIsRunning(false),
+      mThread(nullptr),
+      mPacketsSent(0),
+      mBytesSent(0),
+      mFramesSent(0),
+      mSessionsServed(0),
+      mCpuNanoseconds(0)
+{
+    // fail here rather than on every connection
+    MockStream stream(mOptions);
+}
+
+OverflowMock::MockRtspServer::~MockRtspServer()
+{
+    stop();
+}
+
+bool
+OverflowMock::MockRtspServer::start(int port, const std::string& address)
+{
+    if (mThread != nullptr)
+        return true;
+    
+    mListenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (mListenFd < 0)
+    {
+        LOG(ERROR) << "mock socket: " << strerror(errno);
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    fcntl(mListenFd, F_SETFD, FD_CLOEXEC);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1
+        or bind(mListenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0
+        or listen(mListenFd, 128) != 0)
+    {
+        LOG(ERROR) << "mock failed to listen on: " << address << ":" << port;
+        close(mListenFd);
+        mListenFd = -1;
+        return false;
+    }
+
+    socklen_t length = sizeof(addr);
+    getsockname(mListenFd, (struct sockaddr*)&addr, &length);
+    mPort = ntohs(addr.sin_port);
+    mAddress = address;
+    LOG(INFO) << "mock rtsp server on: " << getUrl();
+    
+    mIsRunning = true;
+    mThread = new std::thread([&]() { serverMain(); });
+    return true;
+}
+
+void
+OverflowMock::MockRtspServer::stop()
+{
+    if (mThread == nullptr)
+        return;
+
+    mIsRunning = false;
+    mThread->join();
+    delete mThread;
+    mThread = nullptr;
+
+    std::vector<std::thread*> sessions;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        sessions.swap(mSessions);
+    }
+    for (auto session: sessions)
+    {
+        session->join();
+        delete session;
+    }
+    
+    close(mListenFd);
+    mListenFd = -1;
+}
+
+std::string
+OverflowMock::MockRtspServer::getUrl() const
+{
+    std::ostringstream url;
+    url << "rtsp://" << mAddress << ":" << mPort << "/mock";
+    return url.str();
+}
+
+void
+OverflowMock::MockRtspServer::serverMain()
+{
+    uint64_t lastCpu = threadCpuNanoseconds();
+    
+    while (mIsRunning)
+    {
+        struct pollfd pfd;
+        pfd.fd = mListenFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ready = poll(&pfd, 1, MOCK_POLL_INTERVAL_MS);
+        accountCpu(&lastCpu);
+        if (ready <= 0)
+            continue;
+
+        int fd = accept(mListenFd, NULL, NULL);
+        if (fd < 0)
+            continue;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSessions.push_back(new std::thread([this, fd]() { sessionMain(fd); }));
+        mSessionsServed++;
+    }
+}
+
+void
+OverflowMock::MockRtspServer::sessionMain(int fd)
+{
+    uint64_t lastCpu = threadCpuNanoseconds();
+    
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    struct timeval timeout;
+    timeout.tv_sec = MOCK_SEND_TIMEOUT_MS / 1000;
+    timeout.tv_usec = (MOCK_SEND_TIMEOUT_MS % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    
+    MockStream stream(mOptions);
+    const uint64_t interval = stream.getFrameIntervalMicroseconds() * 1000ULL;
+    
+    std::string pending;
+    Bytes buffer;
+    int channel = 0;
+    bool isPlaying = false;
+    bool isOpen = true;
+    uint64_t nextFrame = 0;
+    
+    while (mIsRunning and isOpen)
+    {
+        int waitMs = MOCK_POLL_INTERVAL_MS;
+        if (isPlaying)
+        {
+            uint64_t now = steadyNanoseconds();
+            waitMs = (not stream.isPaced() or now >= nextFrame) ? 0 : (nextFrame - now) / 1000000;
+        }
+        
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        
+        if (poll(&pfd, 1, waitMs) > 0)
+        {
+            char data[4096];
+            ssize_t received = recv(fd, data, sizeof(data), 0);
+            if (received <= 0)
+                break;
+            pending.append(data, received);
+
+            while (isOpen and not pending.empty())
+            {
+                // interleaved rtcp from the client, skip it
+                if (pending[0] == '$')
+                {
+                    if (pending.length() < 4)
+                        break;
+                    size_t length = 4 + (((unsigned char)pending[2] << 8) | (unsigned char)pending[3]);
+                    if (pending.length() < length)
+                        break;
+                    pending.erase(0, length);
+                    continue;
+                }
+                
+                size_t end = pending.find("\r\n\r\n");
+                if (end == std::string::npos)
+                {
+                    if (pending.length() > MOCK_MAX_REQUEST_SIZE)
+                        isOpen = false;
+                    break;
+                }
+
+                bool wasPlaying = isPlaying;
+                isOpen = handleRequest(fd, stream, pending.substr(0, end + 4), &channel, &isPlaying);
+                pending.erase(0, end + 4);
+                
+                if (isPlaying and not wasPlaying)
+                    nextFrame = steadyNanoseconds();
+            }
+        }
+
+        if (isOpen and isPlaying)
+        {
+            uint64_t now = steadyNanoseconds();
+            if (not stream.isPaced() or now >= nextFrame)
+            {
+                isOpen = streamFrame(fd, &stream, channel, &buffer);
+                
+                nextFrame += interval;
+                if (now > nextFrame + MOCK_MAX_LAG_MS * 1000000ULL)
+                    nextFrame = now + interval;
+            }
+        }
+        
+        accountCpu(&lastCpu);
+    }
+
+    close(fd);
+    accountCpu(&lastCpu);
+}
+
+bool
+OverflowMock::MockRtspServer::handleRequest(int fd, const MockStream& stream, const std::string& request, int* channel, bool* isPlaying)
+{
+    std::string method = request.substr(0, request.find(' '));
+    std::string cseq = headerValue(request, "CSeq");
+    
+    std::ostringstream response;
+    std::string body;
+    bool keepOpen = true;
+    
+    if (method == "OPTIONS")
+    {
+        response << "RTSP/1.0 200 OK\r\n"
+                 << "CSeq: " << cseq << "\r\n"
+                 << "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER\r\n";
+    }
+    else if (method == "DESCRIBE")
+    {
+        body = stream.getSessionDescription();
+        response << "RTSP/1.0 200 OK\r\n"
+                 << "CSeq: " << cseq << "\r\n"
+                 << "Content-Base: " << getUrl() << "/\r\n"
+                 << "Content-Type: application/sdp\r\n"
+                 << "Content-Length: " << body.length() << "\r\n";
+    }
+    else if (method == "SETUP")
+    {
+        std::string transport = headerValue(request, "Transport");
+        size_t interleaved = transport.find("interleaved=");
+        
+        if (interleaved == std::string::npos)
+        {
+            response << "RTSP/1.0 461 Unsupported Transport\r\n"
+                     << "CSeq: " << cseq << "\r\n";
+        }
+        else
+        {
+            *channel = atoi(transport.c_str() + interleaved + 12);
+            response << "RTSP/1.0 200 OK\r\n"
+                     << "CSeq: " << cseq << "\r\n"
+                     << "Transport: RTP/AVP/TCP;unicast;interleaved="
+                     << *channel << "-" << (*channel + 1) << "\r\n"
+                     << "Session: " << MOCK_SESSION_ID << ";timeout=" << MOCK_SESSION_TIMEOUT_SECONDS << "\r\n";
+        }
+    }
+    else if (method == "PLAY")
+    {
+        *isPlaying = true;
+        response << "RTSP/1.0 200 OK\r\n"
+                 << "CSeq: " << cseq << "\r\n"
+                 << "Session: " << MOCK_SESSION_ID << "\r\n"
+                 << "Range: npt=0.000-\r\n";
+    }
+    else if (method == "PAUSE")
+    {
+        *isPlaying = false;
+        response << "RTSP/1.0 200 OK\r\n"
+                 << "CSeq: " << cseq << "\r\n"
+                 << "Session: " << MOCK_SESSION_ID << "\r\n";
+    }
+    else if (method == "TEARDOWN")
+    {
+        keepOpen = false;
+        response << "RTSP/1.0 200 OK\r\n"
+                 << "CSeq: " << cseq << "\r\n";
+    }
+    else
+    {
+        response << "RTSP/1.0 200 OK\r\n"
+                 << "CSeq: " << cseq << "\r\n";
+    }
+    response << "\r\n" << body;
+
+    std::string data = response.str();
+    if (not writeAll(fd, (const unsigned char*)data.c_str(), data.length(), mIsRunning))
+        return false;
+    return keepOpen;
+}
+
+bool
+OverflowMock::MockRtspServer::streamFrame(int fd, MockStream* stream, int channel, Bytes* buffer)
+{
+    std::vector<Bytes> packets;
+    Bytes senderReport;
+    if (stream->isStartOfGop())
+        stream->makeSenderReport(unixMicroseconds(), &senderReport);
+    stream->nextFrame(steadyNanoseconds(), &packets);
+
+    // the whole frame goes out in one write, behind its sender report
+    buffer->clear();
+    if (not senderReport.empty())
+    {
+        buffer->push_back('$');
+        buffer->push_back(channel + 1);
+        buffer->push_back((senderReport.size() >> 8) & 0xFF);
+        buffer->push_back(senderReport.size() & 0xFF);
+        buffer->insert(buffer->end(), senderReport.begin(), senderReport.end());
+    }
+    for (auto& packet: packets)
+    {
+        buffer->push_back('$');
+        buffer->push_back(channel);
+        buffer->push_back((packet.size() >> 8) & 0xFF);
+        buffer->push_back(packet.size() & 0xFF);
+        buffer->insert(buffer->end(), packet.begin(), packet.end());
+    }
+
+    if (not writeAll(fd, buffer->data(), buffer->size(), mIsRunning))
+        return false;
+
+    mPacketsSent += packets.size();
+    mBytesSent += buffer->size();
+    mFramesSent++;
+    return true;
+}
+
+void
+OverflowMock::MockRtspServer::accountCpu(uint64_t* lastCpuNanoseconds)
+{
+    uint64_t now = threadCpuNanoseconds();
+    mCpuNanoseconds += now - *lastCpuNanoseconds;
+    *lastCpuNanoseconds = now;
+}
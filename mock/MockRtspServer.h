@@ -0,0 +1,105 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __MOCK_RTSP_SERVER_H__
+#define __MOCK_RTSP_SERVER_H__
+
+#include "MockStream.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+
+namespace OverflowMock
+{
+    // Just enough of an RTSP server to drive a client end to end. It answers
+    // OPTIONS, DESCRIBE, SETUP and PLAY and then pumps a MockStream as
+    // interleaved RTP over the same connection, one thread per connection.
+    class MockRtspServer
+    {
+    public:
+        MockRtspServer(const MockStreamOptions& options);
+
+        ~MockRtspServer();
+
+        // port 0 picks an ephemeral port, see getPort()
+        bool start(int port = 0, const std::string& address = "127.0.0.1");
+
+        void stop();
+
+        int getPort() const { return mPort; }
+
+        // any path is accepted, this is just a convenient one
+        std::string getUrl() const;
+
+        const MockStreamOptions& getOptions() const { return mOptions; }
+        
+        uint64_t getPacketsSent() const { return mPacketsSent; }
+
+        uint64_t getBytesSent() const { return mBytesSent; }
+
+        uint64_t getFramesSent() const { return mFramesSent; }
+
+        uint64_t getSessionsServed() const { return mSessionsServed; }
+
+        // cpu burnt by the server's own threads, to subtract from a process
+        // that hosts both ends
+        double getCpuSeconds() const { return mCpuNanoseconds / 1e9; }
+
+    private:
+        MockRtspServer(const MockRtspServer&);
+
+        MockRtspServer& operator=(const MockRtspServer&);
+        
+        void serverMain();
+
+        void sessionMain(int fd);
+
+        bool handleRequest(int fd, const MockStream& stream, const std::string& request,
+                           int* channel, bool* isPlaying);
+
+        bool streamFrame(int fd, MockStream* stream, int channel, Bytes* buffer);
+
+        void accountCpu(uint64_t* lastCpuNanoseconds);
+
+        MockStreamOptions mOptions;
+        std::string mAddress;
+        int mListenFd;
+        int mPort;
+        std::atomic<bool> mIsRunning;
+        std::thread* mThread;
+
+        std::mutex mMutex;
+        std::vector<std::thread*> mSessions;
+
+        std::atomic<uint64_t> mPacketsSent;
+        std::atomic<uint64_t> mBytesSent;
+        std::atomic<uint64_t> mFramesSent;
+        std::atomic<uint64_t> mSessionsServed;
+        std::atomic<uint64_t> mCpuNanoseconds;
+    };
+};
+
+#endif //__MOCK_RTSP_SERVER_H__
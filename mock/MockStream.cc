@@ -0,0 +1,607 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "MockStream.h"
+
+#include <cppcodec/base64_default_rfc4648.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#define MOCK_RTP_CLOCK_RATE 90000
+
+// 1900 to 1970
+#define NTP_UNIX_EPOCH_OFFSET_SECONDS 2208988800ULL
+
+#define MOCK_STAMP_MAGIC "OVFLMOCK"
+#define MOCK_STAMP_MAGIC_LENGTH 8
+// magic followed by the nanoseconds as 16 hex digits, never a start code
+#define MOCK_STAMP_LENGTH (MOCK_STAMP_MAGIC_LENGTH + 16)
+
+#define MOCK_JPEG_WIDTH 640
+#define MOCK_JPEG_HEIGHT 480
+#define MOCK_JPEG_QUALITY 80
+
+// 640x480 baseline profile
+static const unsigned char kH264Sps[] = { 0x67, 0x42, 0xC0, 0x1E, 0xDA, 0x02, 0x80, 0xF6, 0x84, 0x00, 0x00, 0x03, 0x00, 0x04, 0x00, 0x00, 0x03, 0x00, 0xC8, 0x3C, 0x58, 0xBA, 0x80 };
+static const unsigned char kH264Pps[] = { 0x68, 0xCE, 0x3C, 0x80 };
+
+// user data unregistered sei, the stamp follows the uuid
+static const unsigned char kH264SeiUuid[] = { 0x9B, 0x3E, 0x51, 0xC2, 0x7A, 0x14, 0x4D, 0x86, 0xA1, 0x5F, 0x2D, 0x63, 0xE8, 0x47, 0xB0, 0x19 };
+
+// first_mb_in_slice 0, slice_type I or P, pic_parameter_set_id 0
+static const unsigned char kH264IdrSliceHeader[] = { 0x65, 0x88, 0x84 };
+static const unsigned char kH264SliceHeader[] = { 0x41, 0x9A, 0x02 };
+
+// only the nal headers are meaningful, like the slices these are filler a
+// receiver can frame and cache but not decode
+static const unsigned char kH265Vps[] = { 0x40, 0x01, 0x0C, 0x01, 0xFF, 0xFF };
+static const unsigned char kH265Sps[] = { 0x42, 0x01, 0x01, 0x01, 0x60, 0x00 };
+static const unsigned char kH265Pps[] = { 0x44, 0x01, 0xC1, 0x72, 0xB4 };
+
+// prefix sei carrying the same user data unregistered message as h264
+static const unsigned char kH265SeiHeader[] = { 0x4E, 0x01, 0x05 };
+
+// IDR_W_RADL or TRAIL_R with first_slice_segment_in_pic_flag set
+static const unsigned char kH265IdrSliceHeader[] = { 0x26, 0x01, 0xAF };
+static const unsigned char kH265SliceHeader[] = { 0x02, 0x01, 0xD0 };
+
+// simple profile visual object sequence, visual object and vol headers
+static const char kMP4VConfig[] = "000001B001000001B58913000001000000012000C48D8800F50A041E1463000001B24C61766335322E3132332E30";
+
+
+static std::string makeStamp(uint64_t stampNanoseconds)
+{
+    char digits[17];
+    snprintf(digits, sizeof(digits), "%016llx", (unsigned long long)stampNanoseconds);
+    return std::string(MOCK_STAMP_MAGIC) + digits;
+}
+
+static std::string toHex(const OverflowMock::Bytes& data)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    std::string hex;
+    for (unsigned char byte: data)
+    {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 0x0F];
+    }
+    return hex;
+}
+
+static OverflowMock::Bytes fromHex(const std::string& hex)
+{
+    OverflowMock::Bytes data;
+    for (size_t i = 0; i + 1 < hex.length(); i += 2)
+        data.push_back((unsigned char)strtol(hex.substr(i, 2).c_str(), NULL, 16));
+    return data;
+}
+
+// offsets of every 00 00 01 start code, pointing just past it
+static std::vector<size_t> findStartCodes(const OverflowMock::Bytes& data)
+{
+    std::vector<size_t> offsets;
+    for (size_t i = 0; i + 3 <= data.size(); ++i)
+    {
+        if (data[i] == 0 and data[i + 1] == 0 and data[i + 2] == 1)
+        {
+            offsets.push_back(i + 3);
+            i += 2;
+        }
+    }
+    return offsets;
+}
+
+
+OverflowMock::MockStream::MockStream(const MockStreamOptions& options)
+    : mOptions(options),
+      mSequence(0),
+      mTimestamp(0),
+      mSsrc(0x4F564D4B),
+      mFrameCount(0),
+      mPacketCount(0),
+      mOctetCount(0),
+      mSps(kH264Sps, kH264Sps + sizeof(kH264Sps)),
+      mPps(kH264Pps, kH264Pps + sizeof(kH264Pps)),
+      mH265Vps(kH265Vps, kH265Vps + sizeof(kH265Vps)),
+      mH265Sps(kH265Sps, kH265Sps + sizeof(kH265Sps)),
+      mH265Pps(kH265Pps, kH265Pps + sizeof(kH265Pps)),
+      mConfig(fromHex(kMP4VConfig))
+{
+    if (mOptions.fps <= 0)
+        mOptions.fps = 25;
+    if (mOptions.gopLength <= 0)
+        mOptions.gopLength = 1;
+    if (mOptions.packetSize < 12 + 64)
+        mOptions.packetSize = 12 + 64;
+    
+    if (mOptions.file.empty())
+        return;
+
+    std::ifstream input(mOptions.file.c_str(), std::ios::binary);
+    if (not input)
+    {
+        std::ostringstream message;
+        message << "failed to open: " << mOptions.file;
+        throw std::runtime_error(message.str());
+    }
+    Bytes data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    switch (mOptions.codec)
+    {
+    case MOCK_H264:
+        loadH264File(data);
+        break;
+    case MOCK_MP4V:
+        loadMP4VFile(data);
+        break;
+    case MOCK_H265:
+        throw std::runtime_error("h265 file input is not supported");
+    case MOCK_MJPEG:
+        throw std::runtime_error("mjpeg file input is not supported");
+    }
+
+    if (mFileFrames.empty())
+    {
+        std::ostringstream message;
+        message << "no frames found in: " << mOptions.file;
+        throw std::runtime_error(message.str());
+    }
+}
+
+bool
+OverflowMock::MockStream::codecFromString(const std::string& name, MockCodec* codec)
+{
+    if (name == "h264")
+        *codec = MOCK_H264;
+    else if (name == "h265")
+        *codec = MOCK_H265;
+    else if (name == "mjpeg")
+        *codec = MOCK_MJPEG;
+    else if (name == "mp4v")
+        *codec = MOCK_MP4V;
+    else
+        return false;
+    return true;
+}
+
+std::string
+OverflowMock::MockStream::getSessionDescription() const
+{
+    std::ostringstream sdp;
+    sdp << "v=0\r\n"
+        << "o=- 0 0 IN IP4 127.0.0.1\r\n"
+        << "s=Overflow Mock\r\n"
+        << "t=0 0\r\n"
+        << "a=control:*\r\n";
+
+    switch (mOptions.codec)
+    {
+    case MOCK_H264:
+        sdp << "m=video 0 RTP/AVP 96\r\n"
+            << "a=rtpmap:96 H264/" << MOCK_RTP_CLOCK_RATE << "\r\n"
+            << "a=fmtp:96 packetization-mode=1;sprop-parameter-sets="
+            << base64::encode(mSps.data(), mSps.size()) << ","
+            << base64::encode(mPps.data(), mPps.size()) << "\r\n";
+        break;
+
+    case MOCK_H265:
+        sdp << "m=video 0 RTP/AVP 96\r\n"
+            << "a=rtpmap:96 H265/" << MOCK_RTP_CLOCK_RATE << "\r\n"
+            << "a=fmtp:96 sprop-vps=" << base64::encode(mH265Vps.data(), mH265Vps.size())
+            << ";sprop-sps=" << base64::encode(mH265Sps.data(), mH265Sps.size())
+            << ";sprop-pps=" << base64::encode(mH265Pps.data(), mH265Pps.size()) << "\r\n";
+        break;
+        
+    case MOCK_MJPEG:
+        sdp << "m=video 0 RTP/AVP 26\r\n"
+            << "a=rtpmap:26 JPEG/" << MOCK_RTP_CLOCK_RATE << "\r\n";
+        break;
+
+    case MOCK_MP4V:
+        sdp << "m=video 0 RTP/AVP 96\r\n"
+            << "a=rtpmap:96 MP4V-ES/" << MOCK_RTP_CLOCK_RATE << "\r\n"
+            << "a=fmtp:96 profile-level-id=1;config=" << toHex(mConfig) << "\r\n";
+        break;
+    }
+
+    sdp << "a=framerate:" << mOptions.fps << "\r\n"
+        << "a=control:trackID=0\r\n";
+    return sdp.str();
+}
+
+void
+OverflowMock::MockStream::nextFrame(uint64_t stampNanoseconds, std::vector<Bytes>* packets)
+{
+    const std::string stamp = makeStamp(stampNanoseconds);
+    
+    switch (mOptions.codec)
+    {
+    case MOCK_H264:
+        nextH264Frame(stamp, packets);
+        break;
+    case MOCK_H265:
+        nextH265Frame(stamp, packets);
+        break;
+    case MOCK_MJPEG:
+        nextMJPEGFrame(stamp, packets);
+        break;
+    case MOCK_MP4V:
+        nextMP4VFrame(stamp, packets);
+        break;
+    }
+
+    mFrameCount++;
+    mTimestamp += MOCK_RTP_CLOCK_RATE / mOptions.fps;
+}
+
+void
+OverflowMock::MockStream::makeSenderReport(uint64_t unixMicroseconds, Bytes* packet) const
+{
+    uint64_t seconds = unixMicroseconds / 1000000 + NTP_UNIX_EPOCH_OFFSET_SECONDS;
+    uint64_t fraction = ((unixMicroseconds % 1000000) << 32) / 1000000;
+    uint32_t words[] = {
+        mSsrc,
+        (uint32_t)seconds,
+        (uint32_t)fraction,
+        mTimestamp,
+        mPacketCount,
+        mOctetCount
+    };
+
+    // SR without report blocks, 6 words after the header
+    packet->assign({ 0x80, 200, 0x00, 0x06 });
+    for (uint32_t word: words)
+    {
+        packet->push_back(word >> 24);
+        packet->push_back((word >> 16) & 0xFF);
+        packet->push_back((word >> 8) & 0xFF);
+        packet->push_back(word & 0xFF);
+    }
+}
+
+bool
+OverflowMock::MockStream::findFrameStamp(const unsigned char* frame, size_t length, uint64_t* stampNanoseconds)
+{
+    const unsigned char* end = frame + length;
+    const unsigned char* found = std::search(frame, end,
+                                             MOCK_STAMP_MAGIC,
+                                             MOCK_STAMP_MAGIC + MOCK_STAMP_MAGIC_LENGTH);
+    if (found == end or (size_t)(end - found) < MOCK_STAMP_LENGTH)
+        return false;
+
+    std::string digits((const char*)found + MOCK_STAMP_MAGIC_LENGTH, 16);
+    *stampNanoseconds = strtoull(digits.c_str(), NULL, 16);
+    return true;
+}
+
+size_t
+OverflowMock::MockStream::getSyntheticFrameSize() const
+{
+    size_t size = mOptions.frameSize;
+    if (mOptions.bitrate > 0)
+        size = mOptions.bitrate / 8 / mOptions.fps;
+    return std::max(size, (size_t)(MOCK_STAMP_LENGTH + 64));
+}
+
+void
+OverflowMock::MockStream::loadH264File(const Bytes& data)
+{
+    std::vector<size_t> starts = findStartCodes(data);
+    std::vector<Bytes> frame;
+    bool frameHasPicture = false;
+    bool haveSps = false;
+    bool havePps = false;
+
+    for (size_t i = 0; i < starts.size(); ++i)
+    {
+        size_t end = (i + 1 < starts.size()) ? starts[i + 1] - 3 : data.size();
+        // a 4 byte start code leaves its leading zero on the previous nalu
+        while (end > starts[i] and data[end - 1] == 0)
+            end--;
+        if (end <= starts[i])
+            continue;
+
+        Bytes nalu(data.begin() + starts[i], data.begin() + end);
+        int type = nalu[0] & 0x1F;
+        bool isPicture = type >= 1 and type <= 5;
+        bool isFirstSlice = isPicture and nalu.size() > 1 and (nalu[1] & 0x80);
+
+        // a new access unit starts on the first slice of a picture or on
+        // anything that is not a slice once a picture has been seen
+        if (frameHasPicture and (isFirstSlice or not isPicture))
+        {
+            mFileFrames.push_back(frame);
+            frame.clear();
+            frameHasPicture = false;
+        }
+
+        // the first parameter sets go in the sdp
+        if (type == 7 and not haveSps)
+        {
+            mSps = nalu;
+            haveSps = true;
+        }
+        if (type == 8 and not havePps)
+        {
+            mPps = nalu;
+            havePps = true;
+        }
+        
+        frameHasPicture |= isPicture;
+        frame.push_back(nalu);
+    }
+
+    if (frameHasPicture)
+        mFileFrames.push_back(frame);
+}
+
+void
+OverflowMock::MockStream::loadMP4VFile(const Bytes& data)
+{
+    std::vector<size_t> vops;
+    for (size_t start: findStartCodes(data))
+    {
+        if (start < data.size() and data[start] == 0xB6)
+            vops.push_back(start - 3);
+    }
+
+    if (vops.empty())
+        return;
+
+    // everything up to the first vop is the decoder config
+    if (vops[0] > 0)
+        mConfig = Bytes(data.begin(), data.begin() + vops[0]);
+
+    for (size_t i = 0; i < vops.size(); ++i)
+    {
+        size_t end = (i + 1 < vops.size()) ? vops[i + 1] : data.size();
+        mFileFrames.push_back(std::vector<Bytes>(1, Bytes(data.begin() + vops[i], data.begin() + end)));
+    }
+}
+
+void
+OverflowMock::MockStream::nextH264Frame(const std::string& stamp, std::vector<Bytes>* packets)
+{
+    Bytes sei = { 0x06, 0x05, (unsigned char)(sizeof(kH264SeiUuid) + stamp.length()) };
+    sei.insert(sei.end(), kH264SeiUuid, kH264SeiUuid + sizeof(kH264SeiUuid));
+    sei.insert(sei.end(), stamp.begin(), stamp.end());
+    sei.push_back(0x80);
+
+    if (not mFileFrames.empty())
+    {
+        const std::vector<Bytes>& frame = mFileFrames[mFrameCount % mFileFrames.size()];
+        packetizeH264Nalu(sei, false, packets);
+        for (size_t i = 0; i < frame.size(); ++i)
+            packetizeH264Nalu(frame[i], i + 1 == frame.size(), packets);
+        return;
+    }
+
+    bool isKeyFrame = (mFrameCount % mOptions.gopLength) == 0;
+    if (isKeyFrame)
+    {
+        packetizeH264Nalu(mSps, false, packets);
+        packetizeH264Nalu(mPps, false, packets);
+    }
+    packetizeH264Nalu(sei, false, packets);
+
+    Bytes slice;
+    if (isKeyFrame)
+        slice.assign(kH264IdrSliceHeader, kH264IdrSliceHeader + sizeof(kH264IdrSliceHeader));
+    else
+        slice.assign(kH264SliceHeader, kH264SliceHeader + sizeof(kH264SliceHeader));
+    slice.resize(std::max(getSyntheticFrameSize(), slice.size() + sei.size()) - sei.size(), 0xA5);
+    
+    packetizeH264Nalu(slice, true, packets);
+}
+
+void
+OverflowMock::MockStream::nextH265Frame(const std::string& stamp, std::vector<Bytes>* packets)
+{
+    Bytes sei(kH265SeiHeader, kH265SeiHeader + sizeof(kH265SeiHeader));
+    sei.push_back((unsigned char)(sizeof(kH264SeiUuid) + stamp.length()));
+    sei.insert(sei.end(), kH264SeiUuid, kH264SeiUuid + sizeof(kH264SeiUuid));
+    sei.insert(sei.end(), stamp.begin(), stamp.end());
+    sei.push_back(0x80);
+
+    // key frames aggregate the parameter sets with the sei
+    bool isKeyFrame = (mFrameCount % mOptions.gopLength) == 0;
+    if (isKeyFrame)
+        aggregateH265Nalus({ mH265Vps, mH265Sps, mH265Pps, sei }, packets);
+    else
+        packetizeH265Nalu(sei, false, packets);
+
+    Bytes slice;
+    if (isKeyFrame)
+        slice.assign(kH265IdrSliceHeader, kH265IdrSliceHeader + sizeof(kH265IdrSliceHeader));
+    else
+        slice.assign(kH265SliceHeader, kH265SliceHeader + sizeof(kH265SliceHeader));
+    slice.resize(std::max(getSyntheticFrameSize(), slice.size() + sei.size()) - sei.size(), 0xA5);
+
+    packetizeH265Nalu(slice, true, packets);
+}
+
+void
+OverflowMock::MockStream::nextMJPEGFrame(const std::string& stamp, std::vector<Bytes>* packets)
+{
+    // rfc 2435 type 1 with q < 128 so the receiver builds the tables,
+    // the scan data is filler that never contains a marker
+    Bytes scan(stamp.begin(), stamp.end());
+    scan.resize(getSyntheticFrameSize(), 0x5A);
+
+    const size_t fragment = getMaxPayloadLength() - 8;
+    for (size_t offset = 0; offset < scan.size(); offset += fragment)
+    {
+        size_t length = std::min(fragment, scan.size() - offset);
+        unsigned char* payload = addPacket(offset + length >= scan.size(), 8 + length, packets);
+        
+        payload[0] = 0;
+        payload[1] = (offset >> 16) & 0xFF;
+        payload[2] = (offset >> 8) & 0xFF;
+        payload[3] = offset & 0xFF;
+        payload[4] = 1;
+        payload[5] = MOCK_JPEG_QUALITY;
+        payload[6] = MOCK_JPEG_WIDTH / 8;
+        payload[7] = MOCK_JPEG_HEIGHT / 8;
+        memcpy(payload + 8, scan.data() + offset, length);
+    }
+}
+
+void
+OverflowMock::MockStream::nextMP4VFrame(const std::string& stamp, std::vector<Bytes>* packets)
+{
+    // the stamp rides in a user data header in front of the vop
+    Bytes frame = { 0x00, 0x00, 0x01, 0xB2 };
+    frame.insert(frame.end(), stamp.begin(), stamp.end());
+
+    if (not mFileFrames.empty())
+    {
+        const Bytes& vop = mFileFrames[mFrameCount % mFileFrames.size()][0];
+        frame.insert(frame.end(), vop.begin(), vop.end());
+    }
+    else
+    {
+        bool isKeyFrame = (mFrameCount % mOptions.gopLength) == 0;
+        // vop_coding_type I or P, modulo_time_base 0, marker
+        unsigned char vop[] = { 0x00, 0x00, 0x01, 0xB6, (unsigned char)(isKeyFrame ? 0x10 : 0x50) };
+        frame.insert(frame.end(), vop, vop + sizeof(vop));
+        frame.resize(std::max(getSyntheticFrameSize(), frame.size()), 0xA5);
+    }
+    
+    packetizeRaw(frame, packets);
+}
+
+void
+OverflowMock::MockStream::packetizeH264Nalu(const Bytes& nalu, bool isLastOfFrame, std::vector<Bytes>* packets)
+{
+    const size_t maxPayload = getMaxPayloadLength();
+    if (nalu.size() <= maxPayload)
+    {
+        unsigned char* payload = addPacket(isLastOfFrame, nalu.size(), packets);
+        memcpy(payload, nalu.data(), nalu.size());
+        return;
+    }
+
+    // fu-a, the nalu header is rebuilt from the indicator and fu header
+    const size_t fragment = maxPayload - 2;
+    for (size_t offset = 1; offset < nalu.size(); offset += fragment)
+    {
+        size_t length = std::min(fragment, nalu.size() - offset);
+        bool isFirst = offset == 1;
+        bool isLast = offset + length >= nalu.size();
+        
+        unsigned char* payload = addPacket(isLast and isLastOfFrame, 2 + length, packets);
+        payload[0] = (nalu[0] & 0xE0) | 28;
+        payload[1] = (isFirst ? 0x80 : 0x00) | (isLast ? 0x40 : 0x00) | (nalu[0] & 0x1F);
+        memcpy(payload + 2, nalu.data() + offset, length);
+    }
+}
+
+void
+OverflowMock::MockStream::packetizeH265Nalu(const Bytes& nalu, bool isLastOfFrame, std::vector<Bytes>* packets)
+{
+    const size_t maxPayload = getMaxPayloadLength();
+    if (nalu.size() <= maxPayload)
+    {
+        unsigned char* payload = addPacket(isLastOfFrame, nalu.size(), packets);
+        memcpy(payload, nalu.data(), nalu.size());
+        return;
+    }
+
+    // fu, the payload header keeps the layer and tid of the nalu
+    const size_t fragment = maxPayload - 3;
+    for (size_t offset = 2; offset < nalu.size(); offset += fragment)
+    {
+        size_t length = std::min(fragment, nalu.size() - offset);
+        bool isFirst = offset == 2;
+        bool isLast = offset + length >= nalu.size();
+
+        unsigned char* payload = addPacket(isLast and isLastOfFrame, 3 + length, packets);
+        payload[0] = (nalu[0] & 0x81) | (49 << 1);
+        payload[1] = nalu[1];
+        payload[2] = (isFirst ? 0x80 : 0x00) | (isLast ? 0x40 : 0x00) | ((nalu[0] >> 1) & 0x3F);
+        memcpy(payload + 3, nalu.data() + offset, length);
+    }
+}
+
+void
+OverflowMock::MockStream::aggregateH265Nalus(const std::vector<Bytes>& nalus, std::vector<Bytes>* packets)
+{
+    // an ap with a 16 bit size ahead of each unit, every unit is small
+    size_t length = 2;
+    for (const Bytes& nalu: nalus)
+        length += 2 + nalu.size();
+
+    unsigned char* payload = addPacket(false, length, packets);
+    payload[0] = 48 << 1;
+    payload[1] = 0x01;
+
+    size_t offset = 2;
+    for (const Bytes& nalu: nalus)
+    {
+        payload[offset] = (nalu.size() >> 8) & 0xFF;
+        payload[offset + 1] = nalu.size() & 0xFF;
+        memcpy(payload + offset + 2, nalu.data(), nalu.size());
+        offset += 2 + nalu.size();
+    }
+}
+
+void
+OverflowMock::MockStream::packetizeRaw(const Bytes& data, std::vector<Bytes>* packets)
+{
+    const size_t fragment = getMaxPayloadLength();
+    for (size_t offset = 0; offset < data.size(); offset += fragment)
+    {
+        size_t length = std::min(fragment, data.size() - offset);
+        unsigned char* payload = addPacket(offset + length >= data.size(), length, packets);
+        memcpy(payload, data.data() + offset, length);
+    }
+}
+
+unsigned char*
+OverflowMock::MockStream::addPacket(bool marker, size_t payloadLength, std::vector<Bytes>* packets)
+{
+    unsigned char payloadType = (mOptions.codec == MOCK_MJPEG) ? 26 : 96;
+    
+    packets->push_back(Bytes(12 + payloadLength));
+    unsigned char* header = packets->back().data();
+    header[0] = 0x80;
+    header[1] = (marker ? 0x80 : 0x00) | payloadType;
+    header[2] = mSequence >> 8;
+    header[3] = mSequence & 0xFF;
+    header[4] = mTimestamp >> 24;
+    header[5] = (mTimestamp >> 16) & 0xFF;
+    header[6] = (mTimestamp >> 8) & 0xFF;
+    header[7] = mTimestamp & 0xFF;
+    header[8] = mSsrc >> 24;
+    header[9] = (mSsrc >> 16) & 0xFF;
+    header[10] = (mSsrc >> 8) & 0xFF;
+    header[11] = mSsrc & 0xFF;
+
+    mSequence++;
+    mPacketCount++;
+    mOctetCount += payloadLength;
+    return header + 12;
+}
@@ -0,0 +1,146 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __MOCK_STREAM_H__
+#define __MOCK_STREAM_H__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace OverflowMock
+{
+    typedef enum
+    {
+        MOCK_H264,
+        MOCK_H265,
+        MOCK_MJPEG,
+        MOCK_MP4V
+    } MockCodec;
+
+    struct MockStreamOptions
+    {
+        MockStreamOptions()
+            : codec(MOCK_H264),
+              bitrate(4 * 1000 * 1000),
+              fps(25),
+              packetSize(1400),
+              gopLength(25),
+              frameSize(50 * 1024)
+        { }
+        
+        MockCodec codec;
+        // bits per second of synthetic video, 0 sends frameSize frames
+        // back to back as fast as the socket takes them
+        int bitrate;
+        int fps;
+        // rtp packet size including the 12 byte header
+        size_t packetSize;
+        // frames from one key frame to the next
+        int gopLength;
+        size_t frameSize;
+        // annex-b h264 or mpeg-4 part 2 elementary stream, looped at fps
+        std::string file;
+    };
+    
+    typedef std::vector<unsigned char> Bytes;
+
+    // Generates the rtp packets of one frame at a time. Every frame carries
+    // the steady clock time it was made at so a receiver can measure latency,
+    // see findFrameStamp.
+    class MockStream
+    {
+    public:
+        MockStream(const MockStreamOptions& options);
+
+        static bool codecFromString(const std::string& name, MockCodec* codec);
+
+        // sdp body for DESCRIBE
+        std::string getSessionDescription() const;
+
+        // packets are appended to packets, which is not cleared
+        void nextFrame(uint64_t stampNanoseconds, std::vector<Bytes>* packets);
+
+        // rtcp SR tying the next frame to unixMicroseconds, servers send
+        // one ahead of every gop
+        void makeSenderReport(uint64_t unixMicroseconds, Bytes* packet) const;
+
+        bool isStartOfGop() const { return mFrameCount % mOptions.gopLength == 0; }
+
+        int getFrameIntervalMicroseconds() const { return 1000000 / mOptions.fps; }
+
+        bool isPaced() const { return mOptions.bitrate > 0 or not mOptions.file.empty(); }
+
+        const MockStreamOptions& getOptions() const { return mOptions; }
+
+        // finds the stamp of nextFrame in a depacketized frame
+        static bool findFrameStamp(const unsigned char* frame, size_t length, uint64_t* stampNanoseconds);
+
+    private:
+        size_t getSyntheticFrameSize() const;
+        
+        size_t getMaxPayloadLength() const { return mOptions.packetSize - 12; }
+
+        void loadH264File(const Bytes& data);
+
+        void loadMP4VFile(const Bytes& data);
+
+        void nextH264Frame(const std::string& stamp, std::vector<Bytes>* packets);
+
+        void nextH265Frame(const std::string& stamp, std::vector<Bytes>* packets);
+
+        void nextMJPEGFrame(const std::string& stamp, std::vector<Bytes>* packets);
+
+        void nextMP4VFrame(const std::string& stamp, std::vector<Bytes>* packets);
+
+        void packetizeH264Nalu(const Bytes& nalu, bool isLastOfFrame, std::vector<Bytes>* packets);
+
+        void packetizeH265Nalu(const Bytes& nalu, bool isLastOfFrame, std::vector<Bytes>* packets);
+
+        void aggregateH265Nalus(const std::vector<Bytes>& nalus, std::vector<Bytes>* packets);
+
+        void packetizeRaw(const Bytes& data, std::vector<Bytes>* packets);
+
+        unsigned char* addPacket(bool marker, size_t payloadLength, std::vector<Bytes>* packets);
+
+        MockStreamOptions mOptions;
+        uint16_t mSequence;
+        uint32_t mTimestamp;
+        uint32_t mSsrc;
+        uint64_t mFrameCount;
+        uint32_t mPacketCount;
+        uint32_t mOctetCount;
+
+        Bytes mSps;
+        Bytes mPps;
+        Bytes mH265Vps;
+        Bytes mH265Sps;
+        Bytes mH265Pps;
+        Bytes mConfig;
+
+        // file input, each frame is its list of nal units or one vop
+        std::vector<std::vector<Bytes>> mFileFrames;
+    };
+};
+
+#endif //__MOCK_STREAM_H__
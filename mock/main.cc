@@ -0,0 +1,128 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "MockRtspServer.h"
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <getopt.h>
+
+
+static std::atomic<bool> isRunning(true);
+
+static void onSignal(int)
+{
+    isRunning = false;
+}
+
+static void usage(const char* program)
+{
+    std::cerr << "usage: " << program << " [options]" << std::endl
+              << "  --port N          listen port, default 8554" << std::endl
+              << "  --address ADDR    listen address, default 127.0.0.1" << std::endl
+              << "  --codec NAME      h264, h265, mjpeg or mp4v, default h264" << std::endl
+              << "  --bitrate BPS     synthetic bitrate, 0 sends unpaced, default 4000000" << std::endl
+              << "  --fps N           frame rate, default 25" << std::endl
+              << "  --packet-size N   rtp packet size, default 1400" << std::endl
+              << "  --gop N           frames per key frame, default 25" << std::endl
+              << "  --frame-size N    frame size when unpaced, default 51200" << std::endl
+              << "  --file PATH       loop an h264 annex-b or mp4v elementary stream" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    google::InitGoogleLogging(argv[0]);
+    
+    OverflowMock::MockStreamOptions options;
+    int port = 8554;
+    std::string address = "127.0.0.1";
+
+    static struct option longOptions[] = {
+        { "port", required_argument, 0, 'p' },
+        { "address", required_argument, 0, 'a' },
+        { "codec", required_argument, 0, 'c' },
+        { "bitrate", required_argument, 0, 'b' },
+        { "fps", required_argument, 0, 'f' },
+        { "packet-size", required_argument, 0, 's' },
+        { "gop", required_argument, 0, 'g' },
+        { "frame-size", required_argument, 0, 'z' },
+        { "file", required_argument, 0, 'i' },
+        { "help", no_argument, 0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:a:c:b:f:s:g:z:i:h", longOptions, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': port = atoi(optarg); break;
+        case 'a': address = optarg; break;
+        case 'c':
+            if (not OverflowMock::MockStream::codecFromString(optarg, &options.codec))
+            {
+                std::cerr << "unknown codec: " << optarg << std::endl;
+                return 1;
+            }
+            break;
+        case 'b': options.bitrate = atoi(optarg); break;
+        case 'f': options.fps = atoi(optarg); break;
+        case 's': options.packetSize = atoi(optarg); break;
+        case 'g': options.gopLength = atoi(optarg); break;
+        case 'z': options.frameSize = atoi(optarg); break;
+        case 'i': options.file = optarg; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    
+    try
+    {
+        OverflowMock::MockRtspServer server(options);
+        if (not server.start(port, address))
+            return 1;
+
+        std::cout << "serving " << server.getUrl() << std::endl;
+        while (isRunning)
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        server.stop();
+        std::cout << "sessions: " << server.getSessionsServed()
+                  << " frames: " << server.getFramesSent()
+                  << " packets: " << server.getPacketsSent()
+                  << " bytes: " << server.getBytesSent() << std::endl;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
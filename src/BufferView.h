@@ -0,0 +1,67 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __BUFFER_VIEW_H__
+#define __BUFFER_VIEW_H__
+
+#include <string>
+#include <cstddef>
+#include <cstring>
+#include <strings.h>
+
+
+namespace Overflow
+{
+    // Non-owning pointer and length into somebody else's buffer
+    class BufferView
+    {
+    public:
+        BufferView()
+            : mBytes(nullptr),
+              mLength(0)
+        { }
+
+        BufferView(const unsigned char *bytes, size_t length)
+            : mBytes(bytes),
+              mLength(length)
+        { }
+
+        const unsigned char * bytesPointer() const { return mBytes; }
+
+        size_t length() const { return mLength; }
+
+        bool empty() const { return mLength == 0; }
+
+        bool equalsIgnoreCase(const char *other) const
+        {
+            return strlen(other) == mLength
+                and strncasecmp((const char*)mBytes, other, mLength) == 0;
+        }
+
+        std::string toString() const { return std::string((const char*)mBytes, mLength); }
+
+    private:
+        const unsigned char *mBytes;
+        size_t mLength;
+    };
+};
+
+#endif //__BUFFER_VIEW_H__
@@ -0,0 +1,132 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "EventLoop.h"
+
+#include <glog/logging.h>
+
+
+Overflow::EventLoop::EventLoop ()
+    : mLoop (false),
+      mWakeupHandler ([&]() { runPendingTasks (); }),
+      mEventLoopHandler ([&]() { eventLoopMain (); }),
+      mWakeup (mLoop, mWakeupHandler),
+      mAttachedCount (0),
+      mThreadId (std::thread::id ()),
+      mThread (nullptr)
+{
+}
+
+Overflow::EventLoop::~EventLoop ()
+{
+    stop ();
+    join ();
+}
+
+void
+Overflow::EventLoop::start ()
+{
+    if (mThread == nullptr)
+        mThread = new std::thread (mEventLoopHandler);
+}
+
+void
+Overflow::EventLoop::stop ()
+{
+    if (isRunning ())
+        post ([&]() { mLoop.stop (); });
+}
+
+void
+Overflow::EventLoop::join ()
+{
+    if (mThread == nullptr)
+        return;
+
+    mThread->join ();
+
+    delete mThread;
+    mThread = nullptr;
+}
+
+bool
+Overflow::EventLoop::isRunning () const
+{
+    return mThread != nullptr and mThread->joinable ();
+}
+
+bool
+Overflow::EventLoop::isInLoopThread () const
+{
+    return mThreadId.load () == std::this_thread::get_id ();
+}
+
+void
+Overflow::EventLoop::post (const std::function<void ()>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock (mTaskMutex);
+        mTasks.push_back (task);
+    }
+    mWakeup.send ();
+}
+
+void
+Overflow::EventLoop::runPendingTasks ()
+{
+    // swap out so tasks can post more work without holding the lock
+    {
+        std::lock_guard<std::mutex> lock (mTaskMutex);
+        mRunningTasks.swap (mTasks);
+    }
+
+    for (auto& task: mRunningTasks)
+        task ();
+    mRunningTasks.clear ();
+}
+
+void
+Overflow::EventLoop::eventLoopMain ()
+{
+    mThreadId.store (std::this_thread::get_id ());
+    LOG(INFO) << "starting event-loop on: " << mThreadId.load ();
+
+    // anything posted before the thread came up
+    runPendingTasks ();
+    mLoop.run ();
+
+    // lbuv task.h make_valgrind_happy
+    uv_walk (mLoop.get (), closeWalkCb, NULL);
+    uv_run (mLoop.get (), UV_RUN_DEFAULT);
+
+    // close callbacks may have posted deferred deletes
+    runPendingTasks ();
+
+    mThreadId.store (std::thread::id ());
+    LOG(INFO) << "stopped event-loop";
+}
+
+void
+Overflow::EventLoop::closeWalkCb (uv_handle_t* handle, void* arg)
+{
+    if (!uv_is_closing (handle))
+        uv_close (handle, NULL);
+}
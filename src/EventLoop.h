@@ -0,0 +1,92 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __EVENT_LOOP_H__
+#define __EVENT_LOOP_H__
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+
+namespace Overflow
+{
+    // One libuv loop running on one thread. Controllers attached to the
+    // same loop share its thread; work is handed over with post() so that
+    // every handle is only ever touched from the loop thread.
+    class EventLoop
+    {
+    public:
+        EventLoop ();
+
+        ~EventLoop ();
+
+        void start ();
+
+        void stop ();
+
+        void join ();
+
+        bool isRunning () const;
+
+        bool isInLoopThread () const;
+
+        // thread-safe, the task runs on the loop thread
+        void post (const std::function<void ()>& task);
+
+        uvpp::loop& getLoop () { return mLoop; }
+
+        void attach () { mAttachedCount++; }
+
+        void detach () { mAttachedCount--; }
+
+        size_t getAttachedCount () const { return mAttachedCount.load (); }
+        
+    private:
+        EventLoop (const EventLoop&);
+
+        EventLoop& operator= (const EventLoop&);
+        
+        void eventLoopMain ();
+
+        void runPendingTasks ();
+
+        static void closeWalkCb (uv_handle_t* handle, void* arg);
+        
+        uvpp::loop mLoop;
+        std::function<void ()> mWakeupHandler;
+        std::function<void ()> mEventLoopHandler;
+        uvpp::Async mWakeup;
+
+        std::mutex mTaskMutex;
+        std::vector<std::function<void ()>> mTasks;
+        std::vector<std::function<void ()>> mRunningTasks;
+
+        std::atomic<size_t> mAttachedCount;
+        std::atomic<std::thread::id> mThreadId;
+        std::thread* mThread;
+    };
+};
+
+#endif //__EVENT_LOOP_H__
@@ -0,0 +1,78 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "EventLoopGroup.h"
+
+#include <thread>
+
+
+Overflow::EventLoopGroup::EventLoopGroup (size_t size)
+{
+    if (size == 0)
+        size = std::thread::hardware_concurrency ();
+    if (size == 0)
+        size = 1;
+
+    for (size_t i = 0; i < size; ++i)
+        mLoops.push_back (new EventLoop ());
+}
+
+Overflow::EventLoopGroup::~EventLoopGroup ()
+{
+    stop ();
+    join ();
+    
+    for (auto loop: mLoops)
+        delete loop;
+}
+
+void
+Overflow::EventLoopGroup::start ()
+{
+    for (auto loop: mLoops)
+        loop->start ();
+}
+
+void
+Overflow::EventLoopGroup::stop ()
+{
+    for (auto loop: mLoops)
+        loop->stop ();
+}
+
+void
+Overflow::EventLoopGroup::join ()
+{
+    for (auto loop: mLoops)
+        loop->join ();
+}
+
+Overflow::EventLoop*
+Overflow::EventLoopGroup::next ()
+{
+    EventLoop* least = mLoops.front ();
+    for (auto loop: mLoops)
+    {
+        if (loop->getAttachedCount () < least->getAttachedCount ())
+            least = loop;
+    }
+    return least;
+}
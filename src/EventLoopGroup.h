@@ -0,0 +1,65 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __EVENT_LOOP_GROUP_H__
+#define __EVENT_LOOP_GROUP_H__
+
+#include "EventLoop.h"
+
+#include <vector>
+#include <cstddef>
+
+
+namespace Overflow
+{
+    // Fixed set of event loops that many clients are spread across, the
+    // thread count follows the core count rather than the camera count.
+    class EventLoopGroup
+    {
+    public:
+        // size 0 means one loop per hardware thread
+        EventLoopGroup (size_t size = 0);
+
+        ~EventLoopGroup ();
+
+        void start ();
+
+        void stop ();
+
+        void join ();
+
+        size_t size () const { return mLoops.size (); }
+
+        // least loaded loop, hand it to the client constructor
+        EventLoop* next ();
+
+        EventLoop* getLoop (size_t index) { return mLoops[index]; }
+
+    private:
+        EventLoopGroup (const EventLoopGroup&);
+
+        EventLoopGroup& operator= (const EventLoopGroup&);
+        
+        std::vector<EventLoop*> mLoops;
+    };
+};
+
+#endif //__EVENT_LOOP_GROUP_H__
@@ -0,0 +1,66 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Frame.h"
+#include "FramePool.h"
+
+
+Overflow::Frame::Frame(FramePool * const pool, size_t capacity)
+    : mPool(pool),
+      mRefCount(1),
+      mBuffer(capacity)
+{
+    reset();
+}
+
+void
+Overflow::Frame::retain()
+{
+    mRefCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+Overflow::Frame::release()
+{
+    if (mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        mPool->recycle(this);
+}
+
+void
+Overflow::Frame::clear()
+{
+    mBuffer.clear();
+    mMetadata.clear();
+}
+
+void
+Overflow::Frame::reset()
+{
+    mRefCount.store(1, std::memory_order_relaxed);
+    clear();
+
+    mTimestamps.rtpTimestamp = 0;
+    mTimestamps.extendedTimestamp = 0;
+    mTimestamps.clockRate = 0;
+    mTimestamps.wallClockMicroseconds = -1;
+    mTimestamps.firstPacketMicroseconds = 0;
+    mTimestamps.lastPacketMicroseconds = 0;
+}
@@ -0,0 +1,146 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __FRAME_H__
+#define __FRAME_H__
+
+#include "FrameBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    class FramePool;
+
+    typedef enum
+    {
+        SLICE_TYPE_UNKNOWN = -1,
+        // h264 slice_type modulo 5, mpeg-4 vops map onto the first three
+        SLICE_TYPE_P = 0,
+        SLICE_TYPE_B = 1,
+        SLICE_TYPE_I = 2,
+        SLICE_TYPE_SP = 3,
+        SLICE_TYPE_SI = 4
+    } FrameSliceType;
+
+    // Filled in by the depacketizers from headers they already read, so
+    // nobody has to scan the frame for start codes to find a key frame.
+    struct FrameMetadata
+    {
+        FrameMetadata() { clear(); }
+
+        void clear()
+        {
+            naluTypes = 0;
+            isKeyFrame = false;
+            hasParameterSets = false;
+            sliceType = SLICE_TYPE_UNKNOWN;
+            isDisposable = false;
+        }
+        
+        // bit n set when a nal unit of type n was written, h264 and h265
+        uint64_t naluTypes;
+        // idr, irap, i-vop or any jpeg
+        bool isKeyFrame;
+        // sps and pps (and vps), or the mpeg-4 config, precede the picture
+        bool hasParameterSets;
+        // of the first slice or vop
+        FrameSliceType sliceType;
+        // nothing predicts from it, every h264 slice has nal_ref_idc 0 or
+        // it is a b-vop, so it can be dropped without breaking the chain
+        bool isDisposable;
+    };
+
+    struct FrameTimestamps
+    {
+        // of the first packet, as the server sent it
+        uint32_t rtpTimestamp;
+        // rtp timestamp with its wraps counted
+        uint64_t extendedTimestamp;
+        // timestamp units per second
+        int clockRate;
+        // microseconds since the unix epoch by way of the last rtcp sender
+        // report, -1 until the server has sent one
+        int64_t wallClockMicroseconds;
+        // steady_clock microseconds the first and last packet were read
+        uint64_t firstPacketMicroseconds;
+        uint64_t lastPacketMicroseconds;
+    };
+    
+    // A reassembled frame handed to IRtspDelegate::onFrame. The delegate
+    // gets a borrowed reference for the duration of the callback; call
+    // retain() to keep the frame and release() from any thread when done
+    // with it, the last release hands the buffer back to its pool.
+    class Frame
+    {
+    public:
+        void retain();
+
+        void release();
+
+        bool isShared() const { return mRefCount.load(std::memory_order_acquire) > 1; }
+
+        const unsigned char * bytesPointer() const { return mBuffer.bytesPointer(); }
+
+        size_t length() const { return mBuffer.length(); }
+
+        size_t capacity() const { return mBuffer.capacity(); }
+
+        FrameBuffer * getBuffer() { return &mBuffer; }
+
+        const FrameTimestamps * getTimestamps() const { return &mTimestamps; }
+
+        FrameTimestamps * getTimestamps() { return &mTimestamps; }
+
+        const FrameMetadata * getMetadata() const { return &mMetadata; }
+
+        FrameMetadata * getMetadata() { return &mMetadata; }
+
+        bool isKeyFrame() const { return mMetadata.isKeyFrame; }
+
+        // empties buffer and metadata so the owner can build the next frame
+        void clear();
+
+    private:
+        friend class FramePool;
+        
+        Frame(FramePool * const pool, size_t capacity);
+
+        ~Frame() { }
+
+        Frame(const Frame&);
+
+        Frame& operator=(const Frame&);
+
+        void reset();
+
+        FramePool * const mPool;
+        std::atomic<int> mRefCount;
+        FrameBuffer mBuffer;
+        FrameTimestamps mTimestamps;
+        FrameMetadata mMetadata;
+    };
+};
+
+#endif //__FRAME_H__
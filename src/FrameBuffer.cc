@@ -0,0 +1,90 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "FrameBuffer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+
+Overflow::FrameBuffer::FrameBuffer(size_t capacity)
+    : mBytes(nullptr),
+      mLength(0),
+      mCapacity(0)
+{
+    reserve(capacity);
+}
+
+Overflow::FrameBuffer::~FrameBuffer()
+{
+    free(mBytes);
+}
+
+unsigned char*
+Overflow::FrameBuffer::extend(size_t length)
+{
+    if (mLength + length > mCapacity)
+    {
+        size_t capacity = (mCapacity > 0) ? mCapacity : 4096;
+        while (capacity < mLength + length)
+            capacity *= 2;
+        
+        reserve(capacity);
+    }
+
+    unsigned char *position = mBytes + mLength;
+    mLength += length;
+    return position;
+}
+
+void
+Overflow::FrameBuffer::append(const unsigned char *bytes, size_t length)
+{
+    memcpy(extend(length), bytes, length);
+}
+
+void
+Overflow::FrameBuffer::appendByte(unsigned char byte)
+{
+    *extend(1) = byte;
+}
+
+void
+Overflow::FrameBuffer::reserve(size_t capacity)
+{
+    if (capacity <= mCapacity)
+        return;
+
+    unsigned char *bytes = (unsigned char*)realloc(mBytes, capacity);
+    if (bytes == nullptr)
+        throw std::bad_alloc();
+
+    mBytes = bytes;
+    mCapacity = capacity;
+}
+
+void
+Overflow::FrameBuffer::truncate(size_t length)
+{
+    if (length < mLength)
+        mLength = length;
+}
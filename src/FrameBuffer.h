@@ -0,0 +1,74 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __FRAME_BUFFER_H__
+#define __FRAME_BUFFER_H__
+
+#include <cstddef>
+
+
+namespace Overflow
+{
+    // Growable contiguous frame the depacketizers write into directly.
+    // clear() keeps the allocation so a session settles on a buffer big
+    // enough for its largest frame and stops allocating.
+    class FrameBuffer
+    {
+    public:
+        FrameBuffer(size_t capacity);
+
+        ~FrameBuffer();
+
+        // grows the frame by length bytes and returns where they start
+        unsigned char* extend(size_t length);
+
+        void append(const unsigned char *bytes, size_t length);
+
+        void appendByte(unsigned char byte);
+
+        void reserve(size_t capacity);
+
+        void truncate(size_t length);
+
+        void clear() { mLength = 0; }
+
+        bool empty() const { return mLength == 0; }
+
+        const unsigned char * bytesPointer() const { return mBytes; }
+
+        unsigned char * mutableBytesPointer() { return mBytes; }
+
+        size_t length() const { return mLength; }
+
+        size_t capacity() const { return mCapacity; }
+
+    private:
+        FrameBuffer(const FrameBuffer&);
+
+        FrameBuffer& operator=(const FrameBuffer&);
+
+        unsigned char *mBytes;
+        size_t mLength;
+        size_t mCapacity;
+    };
+};
+
+#endif //__FRAME_BUFFER_H__
@@ -0,0 +1,170 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "FramePool.h"
+
+#include <algorithm>
+
+#define FRAME_POOL_BUCKETS 5
+#define FRAME_POOL_SMALLEST_BUCKET (64 * 1024)
+#define FRAME_POOL_MAX_FRAMES_PER_BUCKET 64
+// how many size classes up a request may borrow a free frame from
+#define FRAME_POOL_MAX_BUCKET_STEP 1
+
+// 64K, 256K, 1M, 4M, 16M
+static size_t bucketSize(size_t bucket)
+{
+    return static_cast<size_t>(FRAME_POOL_SMALLEST_BUCKET) << (2 * bucket);
+}
+
+
+Overflow::FramePool::FramePool(size_t maxFramesPerBucket)
+    : mMaxFramesPerBucket(maxFramesPerBucket),
+      mBuckets(FRAME_POOL_BUCKETS),
+      mAllocated(0),
+      mReused(0)
+{
+    for (auto it = mBuckets.begin(); it != mBuckets.end(); ++it)
+        it->reserve(mMaxFramesPerBucket);
+}
+
+Overflow::FramePool::~FramePool()
+{
+    for (auto it = mBuckets.begin(); it != mBuckets.end(); ++it)
+    {
+        for (auto frame = it->begin(); frame != it->end(); ++frame)
+            delete *frame;
+    }
+}
+
+Overflow::FramePool*
+Overflow::FramePool::sharedPool()
+{
+    // never torn down, frames may still be held by consumers at exit
+    static FramePool *pool = new FramePool(FRAME_POOL_MAX_FRAMES_PER_BUCKET);
+    return pool;
+}
+
+Overflow::Frame*
+Overflow::FramePool::acquire(size_t sizeHint)
+{
+    // bigger than any size class, made to measure and never pooled
+    if (sizeHint > bucketSize(FRAME_POOL_BUCKETS - 1))
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mAllocated++;
+        }
+        return new Frame(this, sizeHint);
+    }
+    
+    size_t bucket = bucketForSize(sizeHint);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // the exact size class first, then only a little bigger, a 16M
+        // frame handed to a 64K request sits in every cache that holds it
+        size_t last = std::min(bucket + FRAME_POOL_MAX_BUCKET_STEP, mBuckets.size() - 1);
+        for (size_t i = bucket; i <= last; ++i)
+        {
+            std::vector<Frame*>& frames = mBuckets[i];
+            if (frames.empty())
+                continue;
+
+            Frame *frame = frames.back();
+            frames.pop_back();
+            mReused++;
+            return frame;
+        }
+        mAllocated++;
+    }
+
+    return new Frame(this, bucketSize(bucket));
+}
+
+void
+Overflow::FramePool::recycle(Frame * const frame)
+{
+    if (frame->capacity() > bucketSize(FRAME_POOL_BUCKETS - 1))
+    {
+        delete frame;
+        return;
+    }
+    
+    frame->reset();
+    
+    size_t bucket = bucketForCapacity(frame->capacity());
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        
+        std::vector<Frame*>& frames = mBuckets[bucket];
+        if (frames.size() < mMaxFramesPerBucket)
+        {
+            frames.push_back(frame);
+            return;
+        }
+    }
+
+    delete frame;
+}
+
+size_t
+Overflow::FramePool::getAllocatedCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mAllocated;
+}
+
+size_t
+Overflow::FramePool::getReusedCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mReused;
+}
+
+size_t
+Overflow::FramePool::getFreeCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    
+    size_t free_frames = 0;
+    for (auto it = mBuckets.begin(); it != mBuckets.end(); ++it)
+        free_frames += it->size();
+    return free_frames;
+}
+
+size_t
+Overflow::FramePool::bucketForSize(size_t size)
+{
+    size_t bucket = 0;
+    while (bucket < FRAME_POOL_BUCKETS - 1 and bucketSize(bucket) < size)
+        bucket++;
+    return bucket;
+}
+
+size_t
+Overflow::FramePool::bucketForCapacity(size_t capacity)
+{
+    size_t bucket = FRAME_POOL_BUCKETS - 1;
+    while (bucket > 0 and bucketSize(bucket) > capacity)
+        bucket--;
+    return bucket;
+}
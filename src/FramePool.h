@@ -0,0 +1,78 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __FRAME_POOL_H__
+#define __FRAME_POOL_H__
+
+#include "Frame.h"
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    // Free lists of frames bucketed by capacity. Frames come back here
+    // from whichever thread drops the last reference, so a pool can be
+    // shared by every session in the process.
+    class FramePool
+    {
+    public:
+        FramePool(size_t maxFramesPerBucket);
+
+        ~FramePool();
+
+        // returns a frame with one reference and at least sizeHint capacity,
+        // past the largest size class it is exact and freed on release
+        Frame* acquire(size_t sizeHint);
+
+        size_t getAllocatedCount() const;
+
+        size_t getReusedCount() const;
+
+        size_t getFreeCount() const;
+
+        static FramePool* sharedPool();
+
+    private:
+        friend class Frame;
+        
+        FramePool(const FramePool&);
+
+        FramePool& operator=(const FramePool&);
+
+        void recycle(Frame * const frame);
+
+        static size_t bucketForSize(size_t size);
+
+        static size_t bucketForCapacity(size_t capacity);
+
+        mutable std::mutex mMutex;
+        size_t mMaxFramesPerBucket;
+        std::vector<std::vector<Frame*>> mBuckets;
+        size_t mAllocated;
+        size_t mReused;
+    };
+};
+
+#endif //__FRAME_POOL_H__
@@ -0,0 +1,260 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "FrameQueue.h"
+
+#include <chrono>
+
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t power = 1;
+    while (power < value)
+        power <<= 1;
+    return power;
+}
+
+
+Overflow::FrameQueue::FrameQueue(size_t capacity,
+                                 FrameDropPolicy policy,
+                                 size_t memoryBudget)
+    : mSlots(roundUpToPowerOfTwo(capacity > 0 ? capacity : 1)),
+      mMask(mSlots.size() - 1),
+      mPolicy(policy),
+      mMemoryBudget(memoryBudget),
+      mSlotIsKeyFrame(mSlots.size(), false),
+      mIsAwaitingKeyFrame(false),
+      mHead(0),
+      mTail(0),
+      mQueuedBytes(0),
+      mPushed(0),
+      mHighWaterMark(0),
+      mConsumerWaiting(false)
+{
+    for (size_t i = 0; i < mSlots.size(); ++i)
+        mSlots[i].store(nullptr, std::memory_order_relaxed);
+
+    for (int i = 0; i < FRAME_DROP_REASON_COUNT; ++i)
+        mDropped[i].store(0, std::memory_order_relaxed);
+}
+
+Overflow::FrameQueue::~FrameQueue()
+{
+    Frame *frame = nullptr;
+    while ((frame = tryPop()) != nullptr)
+        frame->release();
+}
+
+bool
+Overflow::FrameQueue::push(Frame * const frame)
+{
+    bool isKeyFrame = frame->isKeyFrame();
+    bool isDisposable = frame->getMetadata()->isDisposable;
+    size_t length = frame->length();
+
+    if (mIsAwaitingKeyFrame and not isKeyFrame)
+    {
+        drop(FRAME_DROP_REASON_AWAITING_KEY_FRAME);
+        return false;
+    }
+
+    if (mPolicy == FRAME_DROP_NON_REFERENCE and isDisposable
+        and isOverBudget(mSlots.size() / 2, mMemoryBudget / 2, length))
+    {
+        drop(FRAME_DROP_REASON_NON_REFERENCE);
+        return false;
+    }
+
+    if (mPolicy == FRAME_DROP_OLDEST)
+    {
+        bool isEvictedToTail = false;
+        while (isOverBudget(mSlots.size(), mMemoryBudget, length)
+               and evictOldest(&isEvictedToTail))
+            ;
+
+        // no key frame was left queued, so the new frame predicts from
+        // what was just evicted
+        if (isEvictedToTail and not isKeyFrame)
+        {
+            mIsAwaitingKeyFrame = true;
+            drop(FRAME_DROP_REASON_AWAITING_KEY_FRAME);
+            return false;
+        }
+    }
+
+    if (isOverBudget(mSlots.size(), mMemoryBudget, length))
+    {
+        // losing a disposable frame takes nothing else with it
+        mIsAwaitingKeyFrame = mPolicy != FRAME_DROP_NEWEST and not isDisposable;
+        drop(FRAME_DROP_REASON_FULL);
+        return false;
+    }
+    
+    size_t tail = mTail.load(std::memory_order_relaxed);
+    size_t head = mHead.load(std::memory_order_acquire);
+    size_t depth = tail - head;
+
+    mSlotIsKeyFrame[tail & mMask] = isKeyFrame;
+    mSlots[tail & mMask].store(frame, std::memory_order_relaxed);
+    mQueuedBytes.fetch_add(length, std::memory_order_relaxed);
+    mTail.store(tail + 1, std::memory_order_release);
+    mIsAwaitingKeyFrame = false;
+    
+    mPushed.fetch_add(1, std::memory_order_relaxed);
+    if (depth + 1 > mHighWaterMark.load(std::memory_order_relaxed))
+        mHighWaterMark.store(depth + 1, std::memory_order_relaxed);
+
+    // pairs with the fence in pop so a sleeping consumer is never missed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mConsumerWaiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCondition.notify_one();
+    }
+    
+    return true;
+}
+
+Overflow::Frame*
+Overflow::FrameQueue::tryPop()
+{
+    // the producer may evict from the front too, whoever moves the head
+    // owns the frames it moved past
+    size_t head = mHead.load(std::memory_order_acquire);
+    for (;;)
+    {
+        size_t tail = mTail.load(std::memory_order_acquire);
+        if (head == tail)
+            return nullptr;
+
+        Frame *frame = mSlots[head & mMask].load(std::memory_order_relaxed);
+        if (mHead.compare_exchange_weak(head, head + 1,
+                                        std::memory_order_acq_rel,
+                                        std::memory_order_acquire))
+        {
+            mQueuedBytes.fetch_sub(frame->length(), std::memory_order_relaxed);
+            return frame;
+        }
+    }
+}
+
+Overflow::Frame*
+Overflow::FrameQueue::pop(int timeoutMilliseconds)
+{
+    Frame *frame = tryPop();
+    if (frame != nullptr or timeoutMilliseconds == 0)
+        return frame;
+
+    auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::milliseconds(timeoutMilliseconds);
+    
+    std::unique_lock<std::mutex> lock(mMutex);
+    mConsumerWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    while ((frame = tryPop()) == nullptr)
+    {
+        if (timeoutMilliseconds < 0)
+        {
+            mCondition.wait(lock);
+        }
+        else if (mCondition.wait_until(lock, deadline) == std::cv_status::timeout)
+        {
+            frame = tryPop();
+            break;
+        }
+    }
+    
+    mConsumerWaiting.store(false, std::memory_order_relaxed);
+    return frame;
+}
+
+size_t
+Overflow::FrameQueue::size() const
+{
+    size_t tail = mTail.load(std::memory_order_acquire);
+    size_t head = mHead.load(std::memory_order_acquire);
+    return tail - head;
+}
+
+uint64_t
+Overflow::FrameQueue::getDroppedCount() const
+{
+    uint64_t dropped = 0;
+    for (int i = 0; i < FRAME_DROP_REASON_COUNT; ++i)
+        dropped += mDropped[i].load(std::memory_order_relaxed);
+    return dropped;
+}
+
+bool
+Overflow::FrameQueue::isOverBudget(size_t maxDepth, size_t maxBytes, size_t length) const
+{
+    size_t depth = size();
+    if (depth + 1 > maxDepth)
+        return true;
+
+    // a frame bigger than the whole budget still goes into an empty queue
+    if (maxBytes == 0 or depth == 0)
+        return false;
+
+    return mQueuedBytes.load(std::memory_order_relaxed) + length > maxBytes;
+}
+
+bool
+Overflow::FrameQueue::evictOldest(bool * const isEvictedToTail)
+{
+    size_t tail = mTail.load(std::memory_order_relaxed);
+    size_t head = mHead.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        if (head == tail)
+            return false;
+
+        // the frames behind the oldest predict from it, so they go up to
+        // the next key frame in one step and the consumer never sees a
+        // frame whose reference was evicted
+        size_t end = head + 1;
+        while (end != tail and not mSlotIsKeyFrame[end & mMask])
+            ++end;
+
+        if (mHead.compare_exchange_weak(head, end,
+                                        std::memory_order_acq_rel,
+                                        std::memory_order_acquire))
+        {
+            *isEvictedToTail = end == tail;
+            for (size_t i = head; i != end; ++i)
+            {
+                Frame *frame = mSlots[i & mMask].load(std::memory_order_relaxed);
+                mQueuedBytes.fetch_sub(frame->length(), std::memory_order_relaxed);
+                frame->release();
+                drop(FRAME_DROP_REASON_OLDEST);
+            }
+            return true;
+        }
+    }
+}
+
+void
+Overflow::FrameQueue::drop(FrameDropReason reason)
+{
+    mDropped[reason].fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,151 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __FRAME_QUEUE_H__
+#define __FRAME_QUEUE_H__
+
+#include "Frame.h"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    // What push() gives up when the queue is over its depth or memory
+    // budget. Apart from FRAME_DROP_NEWEST every policy keeps the decode
+    // chain whole: once a frame others predict from is lost, everything
+    // up to the next key frame goes with it.
+    typedef enum {
+        // refuse the new frame and leave it to the caller, as before
+        FRAME_DROP_NEWEST,
+        // evict queued frames from the front up to the next key frame
+        FRAME_DROP_OLDEST,
+        // refuse disposable frames once half full; when a frame still does
+        // not fit, refuse it and all that follow until a key frame fits, as
+        // FRAME_DROP_UNTIL_KEY_FRAME does
+        FRAME_DROP_NON_REFERENCE,
+        // refuse the new frame and all that follow until a key frame fits
+        FRAME_DROP_UNTIL_KEY_FRAME
+    } FrameDropPolicy;
+
+    typedef enum {
+        // no room for the new frame
+        FRAME_DROP_REASON_FULL,
+        // evicted from the front to make room
+        FRAME_DROP_REASON_OLDEST,
+        // disposable frame shed early
+        FRAME_DROP_REASON_NON_REFERENCE,
+        // would have referenced a frame that was dropped
+        FRAME_DROP_REASON_AWAITING_KEY_FRAME,
+        FRAME_DROP_REASON_COUNT
+    } FrameDropReason;
+
+    // Bounded single-producer/single-consumer queue of retained frames.
+    // The transport thread pushes without ever blocking and applies the
+    // drop policy when the queue is full or holds more than the memory
+    // budget in frame bytes. One consumer thread polls with tryPop() or
+    // blocks in pop(), and owns a reference to every frame it gets back.
+    class FrameQueue
+    {
+    public:
+        // a memory budget of 0 only bounds the depth
+        FrameQueue(size_t capacity,
+                   FrameDropPolicy policy = FRAME_DROP_NEWEST,
+                   size_t memoryBudget = 0);
+
+        ~FrameQueue();
+
+        // producer side, takes over the callers reference on success and
+        // leaves it with the caller when the policy dropped the frame
+        bool push(Frame * const frame);
+
+        // consumer side, nullptr when empty
+        Frame* tryPop();
+
+        // consumer side, timeout < 0 waits forever, nullptr on timeout
+        Frame* pop(int timeoutMilliseconds);
+
+        size_t size() const;
+
+        size_t capacity() const { return mSlots.size(); }
+
+        uint64_t getPushedCount() const { return mPushed.load(std::memory_order_relaxed); }
+
+        FrameDropPolicy getPolicy() const { return mPolicy; }
+
+        size_t getMemoryBudget() const { return mMemoryBudget; }
+
+        // sum of the queued frame lengths
+        size_t getQueuedBytes() const { return mQueuedBytes.load(std::memory_order_relaxed); }
+
+        // every reason together
+        uint64_t getDroppedCount() const;
+
+        uint64_t getDroppedCount(FrameDropReason reason) const { return mDropped[reason].load(std::memory_order_relaxed); }
+
+        size_t getHighWaterMark() const { return mHighWaterMark.load(std::memory_order_relaxed); }
+
+    private:
+        FrameQueue(const FrameQueue&);
+
+        FrameQueue& operator=(const FrameQueue&);
+
+        bool isOverBudget(size_t maxDepth, size_t maxBytes, size_t length) const;
+
+        bool evictOldest(bool * const isEvictedToTail);
+
+        void drop(FrameDropReason reason);
+
+        std::vector<std::atomic<Frame*>> mSlots;
+        size_t mMask;
+        FrameDropPolicy mPolicy;
+        size_t mMemoryBudget;
+
+        // producer only, so eviction can look down the queue without
+        // touching frames the consumer may already own
+        std::vector<bool> mSlotIsKeyFrame;
+        bool mIsAwaitingKeyFrame;
+
+        // producer and consumer indexes on their own cache lines, padded
+        // rather than aligned so a plain new is fine under c++11
+        char mPaddingBefore[64];
+        std::atomic<size_t> mHead;
+        char mPaddingHead[64];
+        std::atomic<size_t> mTail;
+        char mPaddingTail[64];
+        
+        std::atomic<size_t> mQueuedBytes;
+        std::atomic<uint64_t> mPushed;
+        std::atomic<uint64_t> mDropped[FRAME_DROP_REASON_COUNT];
+        std::atomic<size_t> mHighWaterMark;
+
+        std::atomic<bool> mConsumerWaiting;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+    };
+};
+
+#endif //__FRAME_QUEUE_H__
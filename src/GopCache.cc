@@ -0,0 +1,94 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "GopCache.h"
+
+// enough for a couple of seconds of video before the first reallocation
+#define GOP_CACHE_INITIAL_FRAMES 64
+
+
+Overflow::GopCache::GopCache(size_t memoryBudget)
+    : mCachedBytes(0),
+      mMemoryBudget(memoryBudget)
+{
+    mFrames.reserve(GOP_CACHE_INITIAL_FRAMES);
+}
+
+Overflow::GopCache::~GopCache()
+{
+    clear();
+}
+
+void
+Overflow::GopCache::setMemoryBudget(size_t memoryBudget)
+{
+    mMemoryBudget = memoryBudget;
+    if (mCachedBytes > mMemoryBudget)
+        clear();
+}
+
+void
+Overflow::GopCache::push(Frame * const frame)
+{
+    if (not isEnabled())
+        return;
+
+    if (frame->isKeyFrame())
+        clear();
+    else if (mFrames.empty())
+        return;
+
+    // without its whole chain a replay could not be decoded
+    if (mCachedBytes + frame->capacity() > mMemoryBudget)
+    {
+        clear();
+        return;
+    }
+
+    frame->retain();
+    mFrames.push_back(frame);
+    mCachedBytes += frame->capacity();
+}
+
+size_t
+Overflow::GopCache::replay(FrameQueue * const queue) const
+{
+    size_t replayed = 0;
+    for (auto it = mFrames.begin(); it != mFrames.end(); ++it)
+    {
+        (*it)->retain();
+        if (queue->push(*it))
+            replayed++;
+        else
+            (*it)->release();
+    }
+    return replayed;
+}
+
+void
+Overflow::GopCache::clear()
+{
+    // the pool gets them back once every other holder is done too
+    for (auto it = mFrames.begin(); it != mFrames.end(); ++it)
+        (*it)->release();
+
+    mFrames.clear();
+    mCachedBytes = 0;
+}
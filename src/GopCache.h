@@ -0,0 +1,80 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __GOP_CACHE_H__
+#define __GOP_CACHE_H__
+
+#include "Frame.h"
+#include "FrameQueue.h"
+
+#include <vector>
+#include <cstddef>
+
+
+namespace Overflow
+{
+    // Retained frames from the last key frame on, so a consumer that
+    // attaches mid-stream can start decoding at once instead of waiting
+    // out the GOP. Frames stay pooled and shared with every other holder,
+    // the cache only keeps a reference. The budget is counted in frame
+    // capacity, which is what the pool cannot hand out again. Not thread
+    // safe, the owner serializes push() with replay().
+    class GopCache
+    {
+    public:
+        // a memory budget of 0 caches nothing
+        GopCache(size_t memoryBudget = 0);
+
+        ~GopCache();
+
+        void setMemoryBudget(size_t memoryBudget);
+
+        size_t getMemoryBudget() const { return mMemoryBudget; }
+
+        bool isEnabled() const { return mMemoryBudget > 0; }
+
+        // a key frame starts the gop over, anything before the first one
+        // is ignored. A gop that outgrows the budget is let go whole and
+        // caching resumes at the next key frame.
+        void push(Frame * const frame);
+
+        // the cached gop oldest first, each with a reference of its own,
+        // returns how many the queue took
+        size_t replay(FrameQueue * const queue) const;
+
+        void clear();
+
+        size_t getFrameCount() const { return mFrames.size(); }
+
+        size_t getCachedBytes() const { return mCachedBytes; }
+
+    private:
+        GopCache(const GopCache&);
+
+        GopCache& operator=(const GopCache&);
+
+        std::vector<Frame*> mFrames;
+        size_t mCachedBytes;
+        size_t mMemoryBudget;
+    };
+};
+
+#endif //__GOP_CACHE_H__
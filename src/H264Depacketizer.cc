@@ -18,137 +18,295 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
-#include <cppcodec/base64_default_rfc4648.hpp>
-
 #include "H264Depacketizer.h"
 
 #include <cstring>
 
+#define H264_NALU_SLICE 1
+#define H264_NALU_IDR 5
+#define H264_NALU_SPS 7
+#define H264_NALU_PPS 8
+#define H264_NALU_STAP_A 24
+#define H264_NALU_STAP_B 25
+#define H264_NALU_MTAP16 26
+#define H264_NALU_MTAP24 27
 
-Overflow::H264Depacketizer::H264Depacketizer(const SessionDescription* palette,
-                                             const RtpPacket *packet,
-                                             bool isFirstPayload)
-    : mPalette(palette),
-      mPacket(packet)
+
+// exp-golomb ue(v), the first fields of a slice header are too short to
+// hold an emulation prevention byte
+static bool readUnsignedExpGolomb(const unsigned char *data,
+                                  size_t length,
+                                  size_t *bit,
+                                  uint32_t *value)
 {
-    const unsigned char *rtp_packet_payload = mPacket->payloadData();
-    size_t rtp_packet_payload_length = mPacket->payloadLength();
+    int zeros = 0;
+    for (;;)
+    {
+        if (*bit >= length * 8 or zeros > 31)
+            return false;
+        
+        int current = (data[*bit / 8] >> (7 - *bit % 8)) & 1;
+        (*bit)++;
+        if (current)
+            break;
+        zeros++;
+    }
 
-    if (isFirstPayload) {
-        // append fmtp nalu config lines
-        std::string config = mPalette->getFmtpH264ConfigParameters();
+    uint32_t suffix = 0;
+    for (int i = 0; i < zeros; ++i)
+    {
+        if (*bit >= length * 8)
+            return false;
+        
+        suffix = (suffix << 1) | ((data[*bit / 8] >> (7 - *bit % 8)) & 1);
+        (*bit)++;
+    }
+    
+    *value = (1u << zeros) - 1 + suffix;
+    return true;
+}
 
-        size_t pos = config.find(",");
-        std::string first_nalu = config.substr(0, pos);
-        std::string second_nalu = config.substr(pos + 1, config.length());
 
-        // They are base 64 encoded
-        std::vector<uint8_t> first_nalu_decoded = base64::decode(first_nalu.c_str(), first_nalu.size());
-        std::vector<uint8_t> second_nalu_decoded = base64::decode(second_nalu.c_str(), second_nalu.size());
-        
-        push4ByteNaluHeaderToCurrentPayload();
-        pushBytesToCurrentPayload((const unsigned char *)&(first_nalu_decoded[0]),
-                                  first_nalu_decoded.size());
+Overflow::H264Depacketizer::H264Depacketizer(SessionDescription* palette,
+                                             const RtpPacketView *packet,
+                                             NaluWriter *writer)
+    : mPalette(palette),
+      mPacket(packet),
+      mWriter(writer != nullptr ? writer : &mAnnexBWriter),
+      mMetadata(nullptr)
+{
+}
 
-        push4ByteNaluHeaderToCurrentPayload();
-        pushBytesToCurrentPayload((const unsigned char *)&(second_nalu_decoded[0]),
-                                  second_nalu_decoded.size());
-    }
+void
+Overflow::H264Depacketizer::addToFrame(FrameBuffer * const frame,
+                                       FrameMetadata * const metadata)
+{
+    mMetadata = metadata;
+
+    const unsigned char *rtp_packet_payload = mPacket->payloadData();
+    size_t rtp_packet_payload_length = mPacket->payloadLength();
+
+    if (rtp_packet_payload_length == 0)
+        return;
 
     int payload_type = getH264NaluTypeFromByte(rtp_packet_payload[0]);
 
     switch(payload_type) {
     case 0:
-        pushBytesToCurrentPayload(rtp_packet_payload, rtp_packet_payload_length);
+        frame->append(rtp_packet_payload, rtp_packet_payload_length);
         break;
 
-    case 7:
-    case 8:
-        push3ByteNaluHeaderToCurrentPayload();
-        pushBytesToCurrentPayload(rtp_packet_payload, rtp_packet_payload_length);
-        break;
         
-    case 24:
-        push3ByteNaluHeaderToCurrentPayload();
-        pushBytesToCurrentPayload(rtp_packet_payload + 1, rtp_packet_payload_length - 1);
+    case H264_NALU_STAP_A:
+        addAggregatedNalusToFrame(frame, rtp_packet_payload, rtp_packet_payload_length, 1, 0);
+        break;
+
+    case H264_NALU_STAP_B:
+        // decoding order number ahead of the units
+        addAggregatedNalusToFrame(frame, rtp_packet_payload, rtp_packet_payload_length, 3, 0);
+        break;
+
+    case H264_NALU_MTAP16:
+        // base decoding order number, then a dond and timestamp offset
+        // behind the size of each unit
+        addAggregatedNalusToFrame(frame, rtp_packet_payload, rtp_packet_payload_length, 3, 3);
         break;
 
-    case 25:
-    case 26:
-    case 27:
-        push3ByteNaluHeaderToCurrentPayload();
-        pushBytesToCurrentPayload(rtp_packet_payload + 3, rtp_packet_payload_length - 3);
+    case H264_NALU_MTAP24:
+        addAggregatedNalusToFrame(frame, rtp_packet_payload, rtp_packet_payload_length, 3, 4);
         break;
 
     case 28:
     case 29: {
+        if (rtp_packet_payload_length < 2)
+            break;
+        
         unsigned char start_bit = rtp_packet_payload[1] >> 7;
+        size_t fragment_length = rtp_packet_payload_length - 2;
         if (start_bit)
         {
-            unsigned char *temp_payload = (unsigned char*)malloc(rtp_packet_payload_length - 1);
-            memcpy(temp_payload, rtp_packet_payload + 1, rtp_packet_payload_length - 1);
-            
-            unsigned char header = (rtp_packet_payload[0] & 0xE0) + (rtp_packet_payload[1] & 0x1F);
-            temp_payload[0] = header;
-            
-            push3ByteNaluHeaderToCurrentPayload();
-            pushBytesToCurrentPayload(temp_payload, rtp_packet_payload_length - 1);
-            
-            free(temp_payload);
+            addParameterSetsAheadOfIdr(frame, rtp_packet_payload[1],
+                                       rtp_packet_payload + 2, fragment_length);
+
+            // prefix + rebuilt nalu header + fragment in one go
+            unsigned char *out = mWriter->beginNalu(frame, 1 + fragment_length);
+            if (out == nullptr)
+                break;
+
+            out[0] = (rtp_packet_payload[0] & 0xE0) | (rtp_packet_payload[1] & 0x1F);
+            memcpy(out + 1, rtp_packet_payload + 2, fragment_length);
+            noteNalu(out, 1 + fragment_length);
         }
         else
         {
-            pushBytesToCurrentPayload(rtp_packet_payload + 2, rtp_packet_payload_length - 2);
+            mWriter->appendToNalu(frame, rtp_packet_payload + 2, fragment_length);
         }
     }
     break;
         
-    default:
-        push3ByteNaluHeaderToCurrentPayload();
-        pushBytesToCurrentPayload(rtp_packet_payload, rtp_packet_payload_length);
-        break;
+    default: {
+        addParameterSetsAheadOfIdr(frame, rtp_packet_payload[0],
+                                   rtp_packet_payload + 1, rtp_packet_payload_length - 1);
+
+        unsigned char *out = mWriter->beginNalu(frame, rtp_packet_payload_length,
+                                                payload_type == H264_NALU_SPS
+                                                or payload_type == H264_NALU_PPS);
+        if (out == nullptr)
+            break;
+
+        memcpy(out, rtp_packet_payload, rtp_packet_payload_length);
+        noteNalu(out, rtp_packet_payload_length);
+    }
+    break;
     }    
 }
 
-const unsigned char*
-Overflow::H264Depacketizer::bytes() const
+void
+Overflow::H264Depacketizer::noteNalu(const unsigned char *nalu, size_t length, bool isCached)
 {
-    return &(mPayload[0]);
-}
+    if (length == 0)
+        return;
 
-size_t
-Overflow::H264Depacketizer::length() const
-{
-    return mPayload.size();
+    int type = getH264NaluTypeFromByte(nalu[0]);
+    if (not isCached and (type == H264_NALU_SPS or type == H264_NALU_PPS))
+        mPalette->updateParameterSet(nalu, length);
+
+    if (mMetadata == nullptr)
+        return;
+
+    uint32_t slices = (1u << H264_NALU_SLICE) | (1u << H264_NALU_IDR);
+    bool isFirstSlice = (mMetadata->naluTypes & slices) == 0;
+    mMetadata->naluTypes |= 1u << type;
+    
+    uint32_t parameterSets = (1u << H264_NALU_SPS) | (1u << H264_NALU_PPS);
+    mMetadata->hasParameterSets = (mMetadata->naluTypes & parameterSets) == parameterSets;
+
+    if (type == H264_NALU_IDR)
+        mMetadata->isKeyFrame = true;
+
+    bool isSlice = type == H264_NALU_SLICE or type == H264_NALU_IDR;
+    if (not isSlice)
+        return;
+
+    if (mMetadata->sliceType == SLICE_TYPE_UNKNOWN)
+        mMetadata->sliceType = readSliceType(nalu + 1, length - 1);
+
+    // a single referenced slice makes the whole picture a reference
+    bool isNonReference = (nalu[0] & 0x60) == 0;
+    mMetadata->isDisposable = isNonReference and (isFirstSlice or mMetadata->isDisposable);
 }
 
-int
-Overflow::H264Depacketizer::getH264NaluTypeFromByte(const unsigned char byte) const
+void
+Overflow::H264Depacketizer::addAggregatedNalusToFrame(FrameBuffer * const frame,
+                                                      const unsigned char *payload,
+                                                      size_t length,
+                                                      size_t headerLength,
+                                                      size_t unitHeaderLength)
 {
-    return byte & 0x1F;
+    // 16 bit size ahead of each unit, units are written out in the order
+    // they were packed
+    size_t offset = headerLength;
+    while (offset + 2 + unitHeaderLength < length)
+    {
+        size_t size = (payload[offset] << 8) | payload[offset + 1];
+        offset += 2 + unitHeaderLength;
+        if (size == 0 or offset + size > length)
+            break;
+
+        addParameterSetsAheadOfIdr(frame, payload[offset], payload + offset + 1, size - 1);
+
+        unsigned char *out = mWriter->beginNalu(frame, size);
+        if (out != nullptr)
+        {
+            memcpy(out, payload + offset, size);
+            noteNalu(out, size);
+        }
+        offset += size;
+    }
 }
 
-void
-Overflow::H264Depacketizer::pushBytesToCurrentPayload(const unsigned char* bytes,
-                                                      size_t length)
+bool
+Overflow::H264Depacketizer::isNonIdrSlice(const unsigned char *payload, size_t length)
 {
-    size_t i;
-    for (i = 0; i < length; ++i)
+    if (length == 0)
+        return false;
+
+    // every fu fragment repeats the type of the nal it belongs to
+    int type = payload[0] & 0x1F;
+    if (type == 28 or type == 29)
     {
-        mPayload.push_back(bytes[i]);
+        if (length < 2)
+            return false;
+        type = payload[1] & 0x1F;
     }
+
+    return type >= H264_NALU_SLICE and type < H264_NALU_IDR;
+}
+
+bool
+Overflow::H264Depacketizer::isEndOfNalUnit(const unsigned char *payload, size_t length)
+{
+    if (length < 2)
+        return true;
+
+    int type = payload[0] & 0x1F;
+    if (type != 28 and type != 29)
+        return true;
+
+    return (payload[1] & 0x40) != 0;
+}
+
+Overflow::FrameSliceType
+Overflow::H264Depacketizer::readSliceType(const unsigned char *header, size_t length)
+{
+    // first_mb_in_slice then slice_type
+    size_t bit = 0;
+    uint32_t firstMacroblock = 0;
+    uint32_t sliceType = 0;
+    if (not readUnsignedExpGolomb(header, length, &bit, &firstMacroblock)
+        or not readUnsignedExpGolomb(header, length, &bit, &sliceType)
+        or sliceType > 9)
+        return SLICE_TYPE_UNKNOWN;
+
+    return static_cast<FrameSliceType>(sliceType % 5);
 }
 
 void
-Overflow::H264Depacketizer::push4ByteNaluHeaderToCurrentPayload()
+Overflow::H264Depacketizer::addParameterSetsAheadOfIdr(FrameBuffer * const frame,
+                                                       unsigned char header,
+                                                       const unsigned char *slice,
+                                                       size_t sliceLength)
 {
-    unsigned char nalu_header[] = { 0x00, 0x00, 0x00, 0x01 };
-    pushBytesToCurrentPayload(nalu_header, sizeof(nalu_header));
+    // first_mb_in_slice of 0 is a lone set bit
+    bool isFirstIdrSlice = getH264NaluTypeFromByte(header) == H264_NALU_IDR
+        and sliceLength > 0 and (slice[0] & 0x80) != 0;
+    if (not isFirstIdrSlice)
+        return;
+
+    // without metadata there is no telling what the frame already holds
+    if (mMetadata != nullptr and mMetadata->hasParameterSets)
+        return;
+
+    addParameterSetsToFrame(frame);
 }
 
 void
-Overflow::H264Depacketizer::push3ByteNaluHeaderToCurrentPayload()
+Overflow::H264Depacketizer::addParameterSetsToFrame(FrameBuffer * const frame)
 {
-    unsigned char nalu_header[] = { 0x00, 0x00, 0x01 };
-    pushBytesToCurrentPayload(nalu_header, sizeof(nalu_header));
+    const std::vector<ParameterSet>& units = mPalette->getParameterSets().getUnits();
+    for (auto it = units.begin(); it != units.end(); ++it)
+    {
+        unsigned char *out = mWriter->beginNalu(frame, it->bytes.size(), true);
+        if (out == nullptr)
+            continue;
+
+        memcpy(out, it->bytes.data(), it->bytes.size());
+        noteNalu(out, it->bytes.size(), true);
+    }
+}
+
+int
+Overflow::H264Depacketizer::getH264NaluTypeFromByte(const unsigned char byte) const
+{
+    return byte & 0x1F;
 }
@@ -23,9 +23,10 @@
 #define __H264_DEPACKETIZER_H__
 
 #include "SessionDescription.h"
-#include "RtpPacket.h"
-
-#include <vector>
+#include "RtpPacketView.h"
+#include "FrameBuffer.h"
+#include "Frame.h"
+#include "NaluWriter.h"
 
 
 namespace Overflow
@@ -33,26 +34,61 @@ namespace Overflow
     class H264Depacketizer
     {
     public:
-        H264Depacketizer(const SessionDescription* palette,
-                         const RtpPacket *packet,
-                         bool isFirstPayload);
+        // writer carries the output format across the packets of a
+        // session, annex b with 3 byte start codes without one. In-band
+        // parameter sets are kept on the palette and written ahead of an
+        // idr picture that arrives without its own.
+        H264Depacketizer(SessionDescription* palette,
+                         const RtpPacketView *packet,
+                         NaluWriter *writer = nullptr);
+
+        // metadata, when given, picks up the type of every nal unit written
+        void addToFrame(FrameBuffer * const frame,
+                        FrameMetadata * const metadata = nullptr);
+
+        // true for a single nal or fu fragment carrying a non-idr slice,
+        // read from the rtp payload header alone
+        static bool isNonIdrSlice(const unsigned char *payload,
+                                  size_t length);
 
-        const unsigned char* bytes() const;
+        // false only for an fu fragment before the one with the end bit
+        static bool isEndOfNalUnit(const unsigned char *payload,
+                                   size_t length);
 
-        size_t length() const;
+        // slice_type from the slice header following the nal header byte
+        static FrameSliceType readSliceType(const unsigned char *header,
+                                  size_t length);
 
     private:
         int getH264NaluTypeFromByte(const unsigned char byte) const;
-        
-        void pushBytesToCurrentPayload(const unsigned char *bytes, size_t length);
 
-        void push4ByteNaluHeaderToCurrentPayload();
+        // nalu starts at its header byte, isCached for the palette's own
+        // parameter sets
+        void noteNalu(const unsigned char *nalu, size_t length, bool isCached = false);
+
+        // ahead of the first slice of an idr picture when the frame has no
+        // parameter sets yet, header is the nal header byte and slice the
+        // slice header behind it
+        void addParameterSetsAheadOfIdr(FrameBuffer * const frame,
+                                        unsigned char header,
+                                        const unsigned char *slice,
+                                        size_t sliceLength);
+
+        // headerLength covers the payload header and any decoding order
+        // number, unitHeaderLength what follows the size of each unit
+        void addAggregatedNalusToFrame(FrameBuffer * const frame,
+                                       const unsigned char *payload,
+                                       size_t length,
+                                       size_t headerLength,
+                                       size_t unitHeaderLength);
 
-        void push3ByteNaluHeaderToCurrentPayload();
+        void addParameterSetsToFrame(FrameBuffer * const frame);
 
-        const SessionDescription *mPalette;
-        const RtpPacket *mPacket;
-        std::vector<unsigned char> mPayload;
+        SessionDescription *mPalette;
+        const RtpPacketView *mPacket;
+        NaluWriter mAnnexBWriter;
+        NaluWriter *mWriter;
+        FrameMetadata *mMetadata;
     };
     
 };
@@ -0,0 +1,291 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "H265Depacketizer.h"
+
+#include <cstring>
+
+#define H265_NALU_IRAP_FIRST 16
+#define H265_NALU_IRAP_LAST 23
+#define H265_NALU_VCL_LAST 31
+#define H265_NALU_VPS 32
+#define H265_NALU_SPS 33
+#define H265_NALU_PPS 34
+#define H265_NALU_AP 48
+#define H265_NALU_FU 49
+#define H265_NALU_PACI 50
+
+
+Overflow::H265Depacketizer::H265Depacketizer(SessionDescription* palette,
+                                             const RtpPacketView *packet,
+                                             NaluWriter *writer)
+    : mPalette(palette),
+      mPacket(packet),
+      mHasDonl(palette->getH265MaxDonDiff() > 0),
+      mWriter(writer != nullptr ? writer : &mAnnexBWriter),
+      mMetadata(nullptr)
+{
+}
+
+void
+Overflow::H265Depacketizer::addToFrame(FrameBuffer * const frame,
+                                       FrameMetadata * const metadata)
+{
+    mMetadata = metadata;
+
+    const unsigned char *rtp_packet_payload = mPacket->payloadData();
+    size_t rtp_packet_payload_length = mPacket->payloadLength();
+
+    // two byte payload header
+    if (rtp_packet_payload_length < 2)
+        return;
+
+    switch (getH265NaluTypeFromByte(rtp_packet_payload[0])) {
+    case H265_NALU_AP:
+        addAggregatedNalusToFrame(frame, rtp_packet_payload, rtp_packet_payload_length);
+        break;
+
+    case H265_NALU_FU:
+        addFragmentToFrame(frame, rtp_packet_payload, rtp_packet_payload_length);
+        break;
+
+    case H265_NALU_PACI:
+        // payload content information is optional to understand, skip it
+        break;
+
+    default:
+        addSingleNaluToFrame(frame, rtp_packet_payload, rtp_packet_payload_length);
+        break;
+    }
+}
+
+bool
+Overflow::H265Depacketizer::isNonIrapSlice(const unsigned char *payload, size_t length)
+{
+    if (length < 2)
+        return false;
+
+    // every fu fragment repeats the type of the nal it belongs to
+    int type = getH265NaluTypeFromByte(payload[0]);
+    if (type == H265_NALU_FU)
+    {
+        if (length < 3)
+            return false;
+        type = payload[2] & 0x3F;
+    }
+
+    return type < H265_NALU_IRAP_FIRST;
+}
+
+bool
+Overflow::H265Depacketizer::isEndOfNalUnit(const unsigned char *payload, size_t length)
+{
+    if (length < 3 or getH265NaluTypeFromByte(payload[0]) != H265_NALU_FU)
+        return true;
+
+    return (payload[2] & 0x40) != 0;
+}
+
+int
+Overflow::H265Depacketizer::getH265NaluTypeFromByte(const unsigned char byte)
+{
+    return (byte >> 1) & 0x3F;
+}
+
+void
+Overflow::H265Depacketizer::noteNalu(const unsigned char *nalu, size_t length, bool isCached)
+{
+    if (length < 2)
+        return;
+
+    int type = getH265NaluTypeFromByte(nalu[0]);
+    if (not isCached and type >= H265_NALU_VPS and type <= H265_NALU_PPS)
+        mPalette->updateParameterSet(nalu, length);
+
+    if (mMetadata == nullptr)
+        return;
+
+    uint64_t slices = (uint64_t(1) << (H265_NALU_VCL_LAST + 1)) - 1;
+    bool isFirstSlice = (mMetadata->naluTypes & slices) == 0;
+    mMetadata->naluTypes |= uint64_t(1) << type;
+
+    uint64_t parameterSets = (uint64_t(1) << H265_NALU_VPS)
+        | (uint64_t(1) << H265_NALU_SPS)
+        | (uint64_t(1) << H265_NALU_PPS);
+    mMetadata->hasParameterSets = (mMetadata->naluTypes & parameterSets) == parameterSets;
+
+    // slice_type sits behind fields sized by the pps, only an irap
+    // picture is known to be intra from its header
+    if (type >= H265_NALU_IRAP_FIRST and type <= H265_NALU_IRAP_LAST)
+    {
+        mMetadata->isKeyFrame = true;
+        mMetadata->sliceType = SLICE_TYPE_I;
+    }
+
+    if (type > H265_NALU_VCL_LAST)
+        return;
+
+    // the even types below the irap range (TRAIL_N, TSA_N, STSA_N, RADL_N,
+    // RASL_N) are sub-layer non-reference, any other slice is referenced
+    bool isNonReference = type < H265_NALU_IRAP_FIRST and (type % 2) == 0;
+    mMetadata->isDisposable = isNonReference and (isFirstSlice or mMetadata->isDisposable);
+}
+
+void
+Overflow::H265Depacketizer::addSingleNaluToFrame(FrameBuffer * const frame,
+                                                 const unsigned char *payload,
+                                                 size_t length)
+{
+    int type = getH265NaluTypeFromByte(payload[0]);
+    bool isParameterSet = type >= H265_NALU_VPS and type <= H265_NALU_PPS;
+    if (not mHasDonl)
+    {
+        addParameterSetsAheadOfIrap(frame, type, payload + 2, length - 2);
+
+        unsigned char *out = mWriter->beginNalu(frame, length, isParameterSet);
+        if (out == nullptr)
+            return;
+
+        memcpy(out, payload, length);
+        noteNalu(out, length);
+        return;
+    }
+
+    // the donl sits between the nal header and the rest of the unit
+    if (length < 4)
+        return;
+
+    addParameterSetsAheadOfIrap(frame, type, payload + 4, length - 4);
+
+    size_t nalu_length = length - 2;
+    unsigned char *out = mWriter->beginNalu(frame, nalu_length, isParameterSet);
+    if (out == nullptr)
+        return;
+
+    out[0] = payload[0];
+    out[1] = payload[1];
+    memcpy(out + 2, payload + 4, nalu_length - 2);
+    noteNalu(out, nalu_length);
+}
+
+void
+Overflow::H265Depacketizer::addAggregatedNalusToFrame(FrameBuffer * const frame,
+                                                      const unsigned char *payload,
+                                                      size_t length)
+{
+    // donl ahead of the first unit and a dond ahead of the others, then a
+    // 16 bit size ahead of each
+    size_t offset = 2;
+    bool isFirst = true;
+    for (;;)
+    {
+        if (mHasDonl)
+            offset += isFirst ? 2 : 1;
+        if (offset + 2 > length)
+            break;
+
+        size_t size = (payload[offset] << 8) | payload[offset + 1];
+        offset += 2;
+        if (size < 2 or offset + size > length)
+            break;
+
+        addParameterSetsAheadOfIrap(frame, getH265NaluTypeFromByte(payload[offset]),
+                                    payload + offset + 2, size - 2);
+
+        unsigned char *out = mWriter->beginNalu(frame, size);
+        if (out != nullptr)
+        {
+            memcpy(out, payload + offset, size);
+            noteNalu(out, size);
+        }
+
+        offset += size;
+        isFirst = false;
+    }
+}
+
+void
+Overflow::H265Depacketizer::addFragmentToFrame(FrameBuffer * const frame,
+                                               const unsigned char *payload,
+                                               size_t length)
+{
+    // payload header, fu header and the donl on the first fragment only
+    if (length < 3)
+        return;
+
+    unsigned char fu_header = payload[2];
+    bool start_bit = (fu_header & 0x80) != 0;
+    size_t header_length = (start_bit and mHasDonl) ? 5 : 3;
+    if (length < header_length)
+        return;
+
+    size_t fragment_length = length - header_length;
+    if (not start_bit)
+    {
+        mWriter->appendToNalu(frame, payload + header_length, fragment_length);
+        return;
+    }
+
+    addParameterSetsAheadOfIrap(frame, fu_header & 0x3F, payload + header_length, fragment_length);
+
+    // prefix + rebuilt nalu header + fragment in one go
+    unsigned char *out = mWriter->beginNalu(frame, 2 + fragment_length);
+    if (out == nullptr)
+        return;
+
+    out[0] = (payload[0] & 0x81) | ((fu_header & 0x3F) << 1);
+    out[1] = payload[1];
+    memcpy(out + 2, payload + header_length, fragment_length);
+    noteNalu(out, 2 + fragment_length);
+}
+
+void
+Overflow::H265Depacketizer::addParameterSetsAheadOfIrap(FrameBuffer * const frame,
+                                                        int type,
+                                                        const unsigned char *slice,
+                                                        size_t sliceLength)
+{
+    // first_slice_segment_in_pic_flag leads the slice header
+    bool isFirstIrapSlice = type >= H265_NALU_IRAP_FIRST and type <= H265_NALU_IRAP_LAST
+        and sliceLength > 0 and (slice[0] & 0x80) != 0;
+    if (not isFirstIrapSlice)
+        return;
+
+    // without metadata there is no telling what the frame already holds
+    if (mMetadata != nullptr and mMetadata->hasParameterSets)
+        return;
+
+    addParameterSetsToFrame(frame);
+}
+
+void
+Overflow::H265Depacketizer::addParameterSetsToFrame(FrameBuffer * const frame)
+{
+    const std::vector<ParameterSet>& units = mPalette->getParameterSets().getUnits();
+    for (auto it = units.begin(); it != units.end(); ++it)
+    {
+        unsigned char *out = mWriter->beginNalu(frame, it->bytes.size(), true);
+        if (out == nullptr)
+            continue;
+
+        memcpy(out, it->bytes.data(), it->bytes.size());
+        noteNalu(out, it->bytes.size(), true);
+    }
+}
@@ -0,0 +1,98 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __H265_DEPACKETIZER_H__
+#define __H265_DEPACKETIZER_H__
+
+#include "SessionDescription.h"
+#include "RtpPacketView.h"
+#include "FrameBuffer.h"
+#include "Frame.h"
+#include "NaluWriter.h"
+
+
+namespace Overflow
+{
+    // RFC 7798 single nal, aggregation and fragmentation unit packets into
+    // an annex b frame. DONL/DOND fields are skipped, units are written in
+    // transmission order.
+    class H265Depacketizer
+    {
+    public:
+        // writer is shared by every packet of the session so fragments
+        // can grow a length prefix, nullptr writes annex b. The palette
+        // keeps in-band parameter sets for irap pictures sent without them.
+        H265Depacketizer(SessionDescription* palette,
+                         const RtpPacketView *packet,
+                         NaluWriter *writer = nullptr);
+
+        // metadata, when given, picks up the type of every nal unit written
+        void addToFrame(FrameBuffer * const frame,
+                        FrameMetadata * const metadata = nullptr);
+
+        // true for a single nal or fu fragment carrying a slice of a
+        // picture that is not irap, read from the rtp payload header alone
+        static bool isNonIrapSlice(const unsigned char *payload,
+                                   size_t length);
+
+        // false only for an fu fragment before the one with the end bit
+        static bool isEndOfNalUnit(const unsigned char *payload,
+                                   size_t length);
+
+    private:
+        static int getH265NaluTypeFromByte(const unsigned char byte);
+
+        // nalu starts at its two byte header, isCached for the palette's
+        // own parameter sets
+        void noteNalu(const unsigned char *nalu, size_t length, bool isCached = false);
+
+        // ahead of the first slice segment of an irap picture when the
+        // frame has no parameter sets yet, slice follows the nal header
+        void addParameterSetsAheadOfIrap(FrameBuffer * const frame,
+                                         int type,
+                                         const unsigned char *slice,
+                                         size_t sliceLength);
+
+        void addSingleNaluToFrame(FrameBuffer * const frame,
+                                  const unsigned char *payload,
+                                  size_t length);
+
+        void addAggregatedNalusToFrame(FrameBuffer * const frame,
+                                       const unsigned char *payload,
+                                       size_t length);
+
+        void addFragmentToFrame(FrameBuffer * const frame,
+                                const unsigned char *payload,
+                                size_t length);
+
+        void addParameterSetsToFrame(FrameBuffer * const frame);
+
+        SessionDescription *mPalette;
+        const RtpPacketView *mPacket;
+        bool mHasDonl;
+        NaluWriter mAnnexBWriter;
+        NaluWriter *mWriter;
+        FrameMetadata *mMetadata;
+    };
+    
+};
+
+#endif //__H265_DEPACKETIZER_H__
@@ -0,0 +1,51 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __IINTERLEAVED_READER_DELEGATE_H__
+#define __IINTERLEAVED_READER_DELEGATE_H__
+
+#include "RtspResponseParser.h"
+
+#include <cstddef>
+
+
+namespace Overflow
+{
+    class IInterleavedReaderDelegate
+    {
+    public:
+        virtual ~IInterleavedReaderDelegate() { }
+
+        // buffer points into the receive buffer and is only valid for
+        // the duration of the callback
+        virtual void onInterleavedPacket(int channel,
+                                         const unsigned char* buffer,
+                                         size_t length) = 0;
+
+        // parsed carries the header views into buffer, both are only
+        // valid for the duration of the callback
+        virtual void onRtspMessage(const unsigned char* buffer,
+                                   size_t length,
+                                   const RtspResponseParser& parsed) = 0;
+    };
+};
+
+#endif //__IINTERLEAVED_READER_DELEGATE_H__
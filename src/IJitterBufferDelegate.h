@@ -0,0 +1,47 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __IJITTER_BUFFER_DELEGATE_H__
+#define __IJITTER_BUFFER_DELEGATE_H__
+
+#include "RtpPacketView.h"
+
+#include <cstdint>
+
+
+namespace Overflow
+{
+    class IJitterBufferDelegate
+    {
+    public:
+        virtual ~IJitterBufferDelegate() { }
+
+        // strictly increasing sequence, the packet is only borrowed and
+        // arrival is the time it was pushed in
+        virtual void onOrderedRtpPacket(const RtpPacketView* packet,
+                                        uint64_t arrivalMicroseconds) = 0;
+
+        // a gap was given up on, the next ordered packet follows it
+        virtual void onRtpPacketsLost(uint64_t count) = 0;
+    };
+};
+
+#endif //__IJITTER_BUFFER_DELEGATE_H__
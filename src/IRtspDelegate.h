@@ -23,6 +23,7 @@
 #define __IRTSP_DELEGATE_H__
 
 #include "SessionDescription.h"
+#include "Frame.h"
 
 #include <string>
 #include <cstddef>
@@ -70,6 +71,28 @@ namespace Overflow
         virtual void onPayload(const unsigned char * buffer,
                                const size_t length) = 0;
 
+        // frame is only borrowed for the callback, retain() it to queue it
+        // and release() it from whichever thread is finished with it
+        virtual void onFrame(Frame * const frame)
+        {
+            onPayload(frame->bytesPointer(), frame->length());
+        }
+
+        // sub-frame delivery only, in place of onFrame: the access unit so
+        // far, where the bytes from offset on are nal units completed by
+        // the last packet. Borrowed like onFrame, but do not retain() it
+        // until isEndOfAccessUnit.
+        virtual void onNalUnits(Frame * const frame,
+                                const size_t offset,
+                                bool isEndOfAccessUnit)
+        { }
+
+        // sub-frame delivery only: the access unit onNalUnits has been
+        // handing out was lost or skipped part way and will never see
+        // isEndOfAccessUnit, the next onNalUnits starts a new one
+        virtual void onAccessUnitAborted()
+        { }
+
         static std::string stateToString(RtspClientState state)
         {
             switch (state)
@@ -22,7 +22,11 @@
 #ifndef __ITRANSPORT_DELEGATE_H__
 #define __ITRANSPORT_DELEGATE_H__
 
-#include "RtpPacket.h"
+#include "RtpPacketView.h"
+#include "RtcpPacket.h"
+#include "Response.h"
+
+#include <string>
 
 
 namespace Overflow
@@ -45,10 +49,9 @@ namespace Overflow
     class ITransportDelegate
     {
     public:
-        virtual void onRtpPacket(const RtpPacket* packet) = 0;
+        virtual void onRtpPacket(const RtpPacketView* packet) = 0;
 
-        // TODO: not implemented
-        // virtual void onRtcpPacket(const RtcpPackate* packet) = 0;
+        virtual void onRtcpPacket(const RtcpPacket* packet) = 0;
 
         virtual void onRtspResponse(const Response* response) = 0;
 
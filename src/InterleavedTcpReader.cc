@@ -0,0 +1,179 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "InterleavedTcpReader.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include <arpa/inet.h>
+
+// large enough for a full interleaved frame ($ + channel + 16bit length)
+#define RECEIVE_BUFFER_SIZE (65535 + 4)
+
+
+Overflow::InterleavedTcpReader::InterleavedTcpReader(IInterleavedReaderDelegate * const delegate)
+    : mDelegate(delegate),
+      mReceiveBuffer(RECEIVE_BUFFER_SIZE)
+{
+}
+
+void
+Overflow::InterleavedTcpReader::feed(const unsigned char* buffer, size_t length)
+{
+    // finish off any partial message first, only pulling in as many bytes
+    // as it needs when the framing tells us its length
+    while (not mReceiveBuffer.empty() and length > 0)
+    {
+        size_t take = std::min(length, pendingMessageRemainder());
+        
+        mReceiveBuffer.append(buffer, take);
+        buffer += take;
+        length -= take;
+
+        size_t read_size = readResponse(mReceiveBuffer.readPointer(),
+                                        mReceiveBuffer.readableLength());
+        mReceiveBuffer.consume(read_size);
+    }
+
+    if (length == 0)
+        return;
+    
+    // nothing pending so parse straight out of the read buffer and
+    // only hold on to whatever partial message is left over
+    size_t read_size = readResponse(buffer, length);
+    if (read_size < length)
+        mReceiveBuffer.append(buffer + read_size, length - read_size);
+}
+
+size_t
+Overflow::InterleavedTcpReader::pendingMessageRemainder() const
+{
+    const unsigned char *pending = mReceiveBuffer.readPointer();
+    size_t pending_length = mReceiveBuffer.readableLength();
+
+    bool is_rtp = pending[0] == '$';
+    if (not is_rtp)
+    {
+        // once the headers are in we know exactly how much body to wait on
+        return mResponseParser.haveHeaders() ?
+            mResponseParser.getMessageLength() - pending_length :
+            std::numeric_limits<size_t>::max();
+    }
+
+    if (pending_length < 4)
+        return 4 - pending_length;
+
+    size_t packet_length = (pending[2] << 8) | pending[3];
+    return (packet_length + 4) - pending_length;
+}
+
+void
+Overflow::InterleavedTcpReader::reset()
+{
+    mReceiveBuffer.reset();
+    mResponseParser.reset();
+}
+
+size_t
+Overflow::InterleavedTcpReader::readResponse(const unsigned char* buffer,
+                                             size_t length)
+{
+    size_t offset = 0;
+    do {
+        // a header on its own is a whole frame when it says length 0
+        bool is_rtp = ((length - offset) >= 4) && buffer[offset] == '$';
+        bool is_rtsp = ((length - offset) > 8)
+            and strncmp((const char*)buffer + offset, "RTSP/1.0", 8) == 0;
+        
+        bool is_announce = ((length - offset) > 8)
+            and strncmp((const char*)buffer + offset, "ANNOUNCE", 8) == 0;
+        
+        bool is_redirect = ((length - offset) > 8)
+            and strncmp((const char*)buffer + offset, "REDIRECT", 8) == 0;
+
+        // dont have enough data
+        if (not is_rtp and not is_rtsp and not is_announce and not is_redirect)
+            break;
+
+        if (is_announce)
+        {
+            // TODO
+            break;
+        }
+        else if (is_redirect)
+        {
+            // TODO
+            break;
+        }
+        else if (is_rtp)
+        {
+            int channel = static_cast<int>(buffer[offset + 1]);
+
+            uint16_t network_order_packet_length;
+            memcpy(&network_order_packet_length, buffer + offset + 2, 2);
+            uint16_t packet_length = ntohs(network_order_packet_length);
+
+            bool have_whole_packet = (length - (offset + 4)) >= packet_length;
+            if (not have_whole_packet)
+                break;
+
+            // an empty frame carries no packet, skip past its header
+            if (mDelegate != nullptr and packet_length > 0)
+                mDelegate->onInterleavedPacket(channel, buffer + offset + 4, packet_length);
+            
+            offset += packet_length + 4;
+        }
+        else if (is_rtsp)
+        {
+            // resumes scanning from wherever the last read left off
+            bool has_full_rtsp_response = mResponseParser.parse(buffer + offset,
+                                                                length - offset);
+            if (mResponseParser.isError())
+            {
+                // no way to tell where this message ends, drop everything
+                // buffered rather than trust the length it claims
+                LOG(ERROR) << "dropping rtsp response with invalid framing";
+                mResponseParser.reset();
+                return length;
+            }
+            
+            if (not has_full_rtsp_response)
+                break;
+
+            const unsigned char *rtsp_buffer = buffer + offset;
+            size_t rtsp_buffer_length = mResponseParser.getMessageLength();
+
+            // the delegate builds from the parsed views, reset only after
+            if (mDelegate != nullptr)
+                mDelegate->onRtspMessage(rtsp_buffer, rtsp_buffer_length, mResponseParser);
+            mResponseParser.reset();
+            
+            offset += rtsp_buffer_length;
+        }        
+    } while (offset < length);
+    
+    return offset;
+}
@@ -0,0 +1,57 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __INTERLEAVED_TCP_READER_H__
+#define __INTERLEAVED_TCP_READER_H__
+
+#include "IInterleavedReaderDelegate.h"
+#include "ReceiveBuffer.h"
+#include "RtspResponseParser.h"
+
+
+namespace Overflow
+{
+    // Splits the interleaved rtsp/rtp byte stream into messages. Reads are
+    // parsed in place and only a trailing partial message is kept back in
+    // the receive buffer until the rest of it arrives.
+    class InterleavedTcpReader
+    {
+    public:
+        InterleavedTcpReader(IInterleavedReaderDelegate * const delegate);
+
+        void feed(const unsigned char* buffer, size_t length);
+
+        void reset();
+
+        const ReceiveBuffer& getReceiveBuffer() const { return mReceiveBuffer; }
+
+    private:
+        size_t pendingMessageRemainder() const;
+
+        size_t readResponse(const unsigned char* buffer, size_t length);
+
+        IInterleavedReaderDelegate * const mDelegate;
+        ReceiveBuffer mReceiveBuffer;
+        RtspResponseParser mResponseParser;
+    };
+};
+
+#endif //__INTERLEAVED_TCP_READER_H__
@@ -25,17 +25,27 @@
 
 #include <glog/logging.h>
 
+#include <cstring>
+#include <sys/socket.h>
+
+#define TCP_READ_SIZE (64 * 1024)
+
 
 Overflow::InterleavedTcpTransport::InterleavedTcpTransport(ITransportDelegate * const delegate,
+                                                           uvpp::loop& loop,
                                                            const std::string& url)
     : Transport (delegate),
-      mLoop (false),
+      mLoop (loop),
       mTcp (mLoop),
       mConnectionTimer (mLoop),
       mRequestTimer (mLoop),
       mRtpInterleavedChannel (0),
       mRtcpInterleavedChannel (1),
-      mStop (mLoop, mStopHandler)
+      mReader (this),
+      mConnectionHandler ([&](const uvpp::error& error) { connectionHandler (error); }),
+      mReadHandler ([&](const char* buf, ssize_t len) { readHandler (buf, len); }),
+      mIsStopping (false),
+      mPendingCloses (0)
 {
     Url uri(url, 554);
     mHost = uri.getHost();
@@ -82,19 +92,93 @@ Overflow::InterleavedTcpTransport::writeRtsp(const unsigned char *buffer,
     
     mTcp.write ((const char *)buffer, (int)length,
                 [&](uvpp::error e) {
-                    if (e)
+                    if (e and not mIsStopping)
                         onError(UNKNOWN);
                 });
 }
 
 void
-Overflow::InterleavedTcpTransport::shutdown()
+Overflow::InterleavedTcpTransport::writeRtcp(const unsigned char *buffer,
+                                             const size_t length)
 {
-    mRequestTimer.stop ();
-    mTcp.read_stop ();
-    mTcp.shutdown ([&](uvpp::error) {
-            mLoop.stop ();
-        });
+    if (getState () != CONNECTED or mIsStopping or length > 0xFFFF)
+        return;
+
+    // '$', channel and a 16 bit length ahead of the packet, in a buffer of
+    // its own that libuv may read from until the write completes
+    mRtcpWriteBuffers.push_back (std::vector<unsigned char> (length + 4));
+    std::vector<unsigned char>& framed = mRtcpWriteBuffers.back ();
+    framed[0] = '$';
+    framed[1] = mRtcpInterleavedChannel;
+    framed[2] = (length >> 8) & 0xFF;
+    framed[3] = length & 0xFF;
+    memcpy (&framed[4], buffer, length);
+
+    bool isQueued = mTcp.write ((const char *)framed.data (), (int)framed.size (),
+                                [&](uvpp::error e) {
+                                    mRtcpWriteBuffers.pop_front ();
+                                    if (e and not mIsStopping)
+                                        onError(UNKNOWN);
+                                });
+    // no callback comes for a write libuv refused outright
+    if (not isQueued)
+        mRtcpWriteBuffers.pop_back ();
+}
+
+void
+Overflow::InterleavedTcpTransport::onRtcpBytes(const unsigned char* buffer,
+                                               size_t length)
+{
+    try
+    {
+        RtcpPacket packet(buffer, length);
+        onRtcpPacket(&packet);
+    }
+    catch (std::exception& e)
+    {
+        LOG(ERROR) << "dropping rtcp-packet: " << e.what();
+    }
+}
+
+void
+Overflow::InterleavedTcpTransport::closeHandles()
+{
+    // the loop is shared so only our own handles are closed
+    addPendingCloses (3);
+    auto onClose = [&]() { onHandleClosed (); };
+    
+    mConnectionTimer.close (onClose);
+    mRequestTimer.close (onClose);
+    mTcp.close (onClose);
+}
+
+void
+Overflow::InterleavedTcpTransport::onHandleClosed()
+{
+    if (--mPendingCloses == 0)
+        mOnStopped ();
+}
+
+bool
+Overflow::InterleavedTcpTransport::getPeerAddress(struct sockaddr_storage* address)
+{
+    int length = sizeof(*address);
+    memset(address, 0, sizeof(*address));
+    
+    return uv_tcp_getpeername(mTcp.get<uv_tcp_t>(),
+                              (struct sockaddr*)address,
+                              &length) == 0;
+}
+
+void
+Overflow::InterleavedTcpTransport::setup(const SetupResponse* response)
+{
+    // servers are free to pick other channels than the ones we asked for
+    if (response->isInterleaved())
+    {
+        setRtpInterleavedChannel(response->getRtpInterleavedChannel());
+        setRtcpInterleavedChannel(response->getRtcpInterleavedChannel());
+    }
 }
 
 void
@@ -124,9 +208,25 @@ Overflow::InterleavedTcpTransport::startRequestTimer(int seconds)
 }
 
 void
-Overflow::InterleavedTcpTransport::stop()
+Overflow::InterleavedTcpTransport::stop(const std::function<void ()>& onStopped)
 {
-    mStop.send ();
+    if (mIsStopping)
+        return;
+    
+    mIsStopping = true;
+    mOnStopped = onStopped;
+    
+    mConnectionTimer.stop ();
+    mRequestTimer.stop ();
+    
+    // flush any pending teardown before closing
+    if (getState () == CONNECTED)
+    {
+        mTcp.read_stop ();
+        if (mTcp.shutdown ([&](uvpp::error) { closeHandles (); }))
+            return;
+    }
+    closeHandles ();
 }
 
 void
@@ -136,18 +236,15 @@ Overflow::InterleavedTcpTransport::start()
     
     startConnectionTimer();
     mTcp.connect(mHost, mPort, mConnectionHandler);
-    
-    mLoop.run();
-
-    // lbuv task.h make_valgrind_happy
-    uv_walk (mLoop.get (), closeWalkCb, NULL);
-    uv_run (mLoop.get (), UV_RUN_DEFAULT);
 }
 
 void
 Overflow::InterleavedTcpTransport::connectionHandler(const uvpp::error& error)
 {
     mConnectionTimer.stop();
+    if (mIsStopping)
+        return;
+    
     if (error)
     {
         LOG(INFO) << "failed to connect: tcp://" << mHost << ":" << mPort;
@@ -161,12 +258,15 @@ Overflow::InterleavedTcpTransport::connectionHandler(const uvpp::error& error)
     LOG(INFO) << "Connected: tcp://" << mHost << ":" << mPort;
 
     // start reading
-    mTcp.read_start<1024>(mReadHandler);
+    mTcp.read_start<TCP_READ_SIZE>(mReadHandler);
 }
 
 void
 Overflow::InterleavedTcpTransport::readHandler(const char* buf, ssize_t len)
 {
+    if (mIsStopping)
+        return;
+    
     bool isEof = buf == NULL or len < 0;
     if (isEof)
     {
@@ -174,118 +274,40 @@ Overflow::InterleavedTcpTransport::readHandler(const char* buf, ssize_t len)
         return;
     }
     
-    std::vector<unsigned char> response;
-    if (mReceivedBuffer.size() > 0)
-    {
-        response.resize (mReceivedBuffer.size());
-        std::copy (mReceivedBuffer.begin(), mReceivedBuffer.end(), response.begin());
-        mReceivedBuffer.clear ();
-        mReceivedBuffer.resize (0);
-    }
-    
-    size_t response_offset = response.size ();
-    size_t total_buffer_size = response_offset + len;
-    response.resize(total_buffer_size);
-    std::copy(buf, buf + len, response.begin() + response_offset);
-
-    size_t read_size = readResponse(&(response[0]), response.size());
-    if (read_size < total_buffer_size)
-    {
-        size_t trailing_length = total_buffer_size - read_size;
-        mReceivedBuffer.resize (trailing_length);
-        std::copy(response.begin() + read_size, response.end(), mReceivedBuffer.begin());
-    }
+    mReader.feed((const unsigned char*)buf, static_cast<size_t>(len));
 }
 
-size_t
-Overflow::InterleavedTcpTransport::readResponse(const unsigned char* buffer,
-                                                size_t length)
+void
+Overflow::InterleavedTcpTransport::onInterleavedPacket(int channel,
+                                                       const unsigned char* buffer,
+                                                       size_t length)
 {
-    size_t offset = 0;
-    do {
-        bool is_rtp = ((length - offset) > 4) && buffer[offset] == '$';
-        bool is_rtsp = ((length - offset) > 8)
-            and strncmp((const char*)buffer + offset, "RTSP/1.0", 8) == 0;
-        
-        bool is_announce = ((length - offset) > 8)
-            and strncmp((const char*)buffer + offset, "ANNOUNCE", 8) == 0;
-        
-        bool is_redirect = ((length - offset) > 8)
-            and strncmp((const char*)buffer + offset, "REDIRECT", 8) == 0;
-
-        // dont have enough data
-        if (not is_rtp and not is_rtsp and not is_announce and not is_redirect)
-            break;
-
-        if (is_announce)
-        {
-            // TODO
-            break;
-        }
-        else if (is_redirect)
+    if (channel == mRtpInterleavedChannel)
+    {
+        try
         {
-            // TODO
-            break;
+            RtpPacketView pack(buffer, length);
+            onRtpPacket(&pack);
         }
-        else if (is_rtp)
+        catch (std::exception& e)
         {
-            int channel = static_cast<int>(buffer[offset + 1]);
-
-            uint16_t network_order_packet_length;
-            memcpy(&network_order_packet_length, buffer + offset + 2, 2);
-            uint16_t packet_length = ntohs(network_order_packet_length);
-
-            bool have_whole_packet = (length - (offset + 4)) >= packet_length;
-            if (not have_whole_packet)
-                break;
-            
-            if (channel == mRtpInterleavedChannel)
-            {
-                RtpPacket pack(buffer + offset + 4, packet_length);
-                onRtpPacket(&pack);
-            }
-            // TODO RTCP
-            
-            offset += packet_length + 4;
+            LOG(ERROR) << "dropping rtp-packet: " << e.what();
         }
-        else if (is_rtsp)
-        {
-            mRequestTimer.stop();
-            
-            std::string string_response;
-            string_response.resize(length - offset);
-            std::copy(buffer + offset, buffer + length, string_response.begin());
-
-            size_t body_pos = string_response.find("\r\n\r\n");
-            bool has_body = body_pos != std::string::npos;
-            if (not has_body)
-                break;
-            
-            size_t pos = string_response.find("Content-Length:");
-            size_t content_length = (pos != std::string::npos) ?
-                static_cast<size_t>(atoi(&string_response[pos + 16])) :
-                0;
-                
-            size_t headers_length = body_pos;
-            const unsigned char *rtsp_buffer = buffer + offset;
-            size_t rtsp_buffer_length = content_length + 4 + headers_length;
-
-            bool has_full_rtsp_response = (length - offset) >= rtsp_buffer_length;
-            if (not has_full_rtsp_response)
-                break;
-
-            Response response(rtsp_buffer, rtsp_buffer_length);
-            onRtspResponse(&response);
-            offset += rtsp_buffer_length;
-        }        
-    } while (offset < length);
-    
-    return offset;
+    }
+    else if (channel == mRtcpInterleavedChannel)
+    {
+        onRtcpBytes(buffer, length);
+    }
 }
 
 void
-Overflow::InterleavedTcpTransport::closeWalkCb (uv_handle_t* handle, void* arg)
+Overflow::InterleavedTcpTransport::onRtspMessage(const unsigned char* buffer,
+                                                 size_t length,
+                                                 const RtspResponseParser& parsed)
 {
-    if (!uv_is_closing (handle))
-        uv_close (handle, NULL);
+    mRequestTimer.stop();
+    
+    // borrows the receive buffer, nothing keeps the response past the callback
+    Response response(buffer, length, &parsed);
+    onRtspResponse(&response);
 }
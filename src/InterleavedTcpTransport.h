@@ -23,17 +23,24 @@
 #define __INTERLEAVED_TCP_TRANSPORT_H__
 
 #include "ITransportDelegate.h"
+#include "IInterleavedReaderDelegate.h"
+#include "InterleavedTcpReader.h"
 #include "Transport.h"
 
+#include <deque>
+#include <vector>
+
 
 
 
 namespace Overflow
 {
-    class InterleavedTcpTransport: public Transport
+    class InterleavedTcpTransport: public Transport,
+                                   protected IInterleavedReaderDelegate
     {
     public:
         InterleavedTcpTransport(ITransportDelegate * const delegate,
+                                uvpp::loop& loop,
                                 const std::string& url);
 
         virtual ~InterleavedTcpTransport() { }
@@ -46,14 +53,45 @@ namespace Overflow
                        const size_t length,
                        int timeout) override;
 
+        void writeRtcp(const unsigned char *buffer,
+                       const size_t length) override;
+
         std::string getTransportHeaderString() const override;
 
         void start() override;
 
-        void stop() override;
+        void stop(const std::function<void ()>& onStopped) override;
+
+        void setup(const SetupResponse* response) override;
+
+    protected:
+        // parses and hands on, a malformed packet is logged and dropped
+        void onRtcpBytes(const unsigned char* buffer, size_t length);
+
+        // IInterleavedReaderDelegate
+        void onInterleavedPacket(int channel,
+                                 const unsigned char* buffer,
+                                 size_t length) override;
+
+        void onRtspMessage(const unsigned char* buffer,
+                           size_t length,
+                           const RtspResponseParser& parsed) override;
+        // IInterleavedReaderDelegate
+
+        virtual void closeHandles();
+
+        // subclasses closing handles of their own count them towards onStopped
+        void addPendingCloses(int count) { mPendingCloses += count; }
+
+        void onHandleClosed();
+
+        bool isStopping() const { return mIsStopping; }
+
+        uvpp::loop& getLoop() { return mLoop; }
+
+        bool getPeerAddress(struct sockaddr_storage* address);
 
     private:
-        void shutdown();
 
         void startConnectionTimer();
 
@@ -62,12 +100,8 @@ namespace Overflow
         void connectionHandler(const uvpp::error& error);
 
         void readHandler(const char* buf, ssize_t len);
-        
-        size_t readResponse(const unsigned char* buffer, size_t length);
-
-        static void closeWalkCb(uv_handle_t* handle, void* arg);
 
-        uvpp::loop mLoop;
+        uvpp::loop& mLoop;
         uvpp::Tcp mTcp;
         uvpp::Timer mConnectionTimer;
         uvpp::Timer mRequestTimer;
@@ -76,13 +110,17 @@ namespace Overflow
         int mPort;
         int mRtpInterleavedChannel;
         int mRtcpInterleavedChannel;
-        std::vector<unsigned char> mReceivedBuffer;
+        InterleavedTcpReader mReader;
+        // framed copy of each report in flight, oldest first. Writes on a
+        // stream complete in order, so the front one is done with first.
+        std::deque<std::vector<unsigned char>> mRtcpWriteBuffers;
 
         std::function<void (const uvpp::error&)> mConnectionHandler;
         std::function<void (const char* buf, ssize_t len)> mReadHandler;
 
-        std::function<void ()> mStopHandler;
-        uvpp::Async mStop;
+        bool mIsStopping;
+        int mPendingCloses;
+        std::function<void ()> mOnStopped;
     };
 };
 
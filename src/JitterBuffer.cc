@@ -0,0 +1,271 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "JitterBuffer.h"
+
+// the first packet is placed this far up so late packets can sit below it
+#define SEQUENCE_NUMBER_BASE (1 << 16)
+
+#define MICROSECONDS_PER_MILLISECOND 1000
+
+#define RTP_SEQ_MOD (1 << 16)
+
+// as in RFC 3550 A.1, bigger jumps either way are a restart or a stray
+#define MAX_DROPOUT 3000
+#define MAX_MISORDER 100
+
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t power = 1;
+    while (power < value)
+        power <<= 1;
+    return power;
+}
+
+
+Overflow::JitterBuffer::JitterBuffer(IJitterBufferDelegate * const delegate,
+                                     size_t capacity,
+                                     int latencyMilliseconds)
+    : mDelegate(delegate),
+      mLatency(latencyMilliseconds),
+      mSlots(roundUpToPowerOfTwo(capacity > 1 ? capacity : 2)),
+      mMask(mSlots.size() - 1),
+      mBufferedCount(0),
+      mHaveSequence(false),
+      mSsrc(0),
+      mHighestSequence(0),
+      mNextSequence(0),
+      mBadSequence(RTP_SEQ_MOD + 1),
+      mReceived(0),
+      mLost(0),
+      mReordered(0),
+      mDuplicates(0),
+      mLate(0)
+{
+    for (auto& slot: mSlots)
+    {
+        slot.packet = nullptr;
+        slot.arrival = 0;
+    }
+}
+
+Overflow::JitterBuffer::~JitterBuffer()
+{
+    reset();
+}
+
+void
+Overflow::JitterBuffer::push(const RtpPacketView* packet, uint64_t nowMicroseconds)
+{
+    increment(mReceived);
+
+    // a new source restarts the sequence
+    if (mHaveSequence and packet->getSsrc() != mSsrc)
+    {
+        flush();
+        mHaveSequence = false;
+    }
+
+    // the same source starting over, a camera or encoder restart
+    if (mHaveSequence and not isSequenceValid(packet->getSequenceNumber()))
+        return;
+    
+    uint64_t sequence = extendSequenceNumber(packet->getSequenceNumber());
+    if (not mHaveSequence)
+    {
+        mHaveSequence = true;
+        mSsrc = packet->getSsrc();
+        mHighestSequence = sequence;
+        mNextSequence = sequence;
+    }
+
+    if (sequence < mNextSequence)
+    {
+        // already handed on or given up on
+        increment(mLate);
+        return;
+    }
+    
+    if (sequence < mHighestSequence)
+        increment(mReordered);
+    else
+        mHighestSequence = sequence;
+
+    if (sequence != mNextSequence)
+    {
+        // too far ahead to hold, give up on the oldest gaps until it fits
+        while (mBufferedCount > 0 and sequence - mNextSequence >= mSlots.size())
+            skipGap();
+
+        bool holdPacket = mLatency > 0 and sequence - mNextSequence < mSlots.size();
+        if (not holdPacket and mBufferedCount == 0)
+        {
+            uint64_t missing = sequence - mNextSequence;
+            increment(mLost, missing);
+            mNextSequence = sequence;
+            mDelegate->onRtpPacketsLost(missing);
+        }
+    }
+    
+    if (sequence == mNextSequence)
+    {
+        mNextSequence++;
+        deliver(packet, nowMicroseconds);
+        releaseInOrder();
+    }
+    else
+    {
+        Slot& slot = mSlots[sequence & mMask];
+        if (slot.packet != nullptr)
+        {
+            increment(mDuplicates);
+            return;
+        }
+        
+        slot.packet = packet->clone();
+        slot.arrival = nowMicroseconds;
+        mBufferedCount++;
+    }
+
+    expire(nowMicroseconds);
+}
+
+void
+Overflow::JitterBuffer::flush()
+{
+    while (mBufferedCount > 0)
+        skipGap();
+}
+
+void
+Overflow::JitterBuffer::reset()
+{
+    for (auto& slot: mSlots)
+    {
+        delete slot.packet;
+        slot.packet = nullptr;
+    }
+    
+    mBufferedCount = 0;
+    mHaveSequence = false;
+    mBadSequence = RTP_SEQ_MOD + 1;
+}
+
+uint64_t
+Overflow::JitterBuffer::extendSequenceNumber(uint16_t sequenceNumber)
+{
+    if (not mHaveSequence)
+        return SEQUENCE_NUMBER_BASE + sequenceNumber;
+
+    // nearest extended value either side of the highest seen so far
+    int16_t delta = static_cast<int16_t>(
+        sequenceNumber - static_cast<uint16_t>(mHighestSequence));
+    return mHighestSequence + delta;
+}
+
+bool
+Overflow::JitterBuffer::isSequenceValid(uint16_t sequenceNumber)
+{
+    uint16_t delta = sequenceNumber - static_cast<uint16_t>(mHighestSequence);
+    if (delta < MAX_DROPOUT or delta > RTP_SEQ_MOD - MAX_MISORDER)
+        return true;
+
+    if (sequenceNumber != mBadSequence)
+    {
+        mBadSequence = (sequenceNumber + 1) & (RTP_SEQ_MOD - 1);
+        return false;
+    }
+
+    // hand on what was held and start over from this packet
+    flush();
+    mHaveSequence = false;
+    mBadSequence = RTP_SEQ_MOD + 1;
+    return true;
+}
+
+void
+Overflow::JitterBuffer::deliver(const RtpPacketView* packet, uint64_t arrivalMicroseconds)
+{
+    mDelegate->onOrderedRtpPacket(packet, arrivalMicroseconds);
+}
+
+void
+Overflow::JitterBuffer::releaseInOrder()
+{
+    while (mBufferedCount > 0)
+    {
+        Slot& slot = mSlots[mNextSequence & mMask];
+        if (slot.packet == nullptr)
+            break;
+
+        RtpPacket* packet = slot.packet;
+        uint64_t arrival = slot.arrival;
+        slot.packet = nullptr;
+        mBufferedCount--;
+        mNextSequence++;
+        
+        deliver(packet, arrival);
+        delete packet;
+    }
+}
+
+void
+Overflow::JitterBuffer::skipGap()
+{
+    uint64_t missing = 0;
+    while (mSlots[(mNextSequence + missing) & mMask].packet == nullptr)
+        missing++;
+
+    if (missing > 0)
+    {
+        increment(mLost, missing);
+        mNextSequence += missing;
+        mDelegate->onRtpPacketsLost(missing);
+    }
+    releaseInOrder();
+}
+
+void
+Overflow::JitterBuffer::expire(uint64_t nowMicroseconds)
+{
+    while (mBufferedCount > 0)
+    {
+        uint64_t offset = 0;
+        while (mSlots[(mNextSequence + offset) & mMask].packet == nullptr)
+            offset++;
+
+        const Slot& oldest = mSlots[(mNextSequence + offset) & mMask];
+        uint64_t latency = static_cast<uint64_t>(mLatency) * MICROSECONDS_PER_MILLISECOND;
+        if (mLatency > 0 and nowMicroseconds - oldest.arrival < latency)
+            break;
+        
+        skipGap();
+    }
+}
+
+void
+Overflow::JitterBuffer::increment(std::atomic<uint64_t>& counter, uint64_t count)
+{
+    // single writer, no need for a locked add
+    counter.store(counter.load(std::memory_order_relaxed) + count,
+                  std::memory_order_relaxed);
+}
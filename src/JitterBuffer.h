@@ -0,0 +1,129 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __JITTER_BUFFER_H__
+#define __JITTER_BUFFER_H__
+
+#include "IJitterBufferDelegate.h"
+#include "RtpPacketView.h"
+#include "RtpPacket.h"
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    // Puts rtp packets back in sequence order. Sequence numbers are
+    // extended to 64 bits so wraparound is just another increment. In
+    // order packets go straight through without a copy; packets that
+    // arrive ahead of a gap are cloned and held until the gap fills or
+    // the latency budget runs out, at which point the gap is declared lost.
+    // Each packet goes on with the time it arrived, not when it was released.
+    // A big jump in sequence from the same source, confirmed by the packet
+    // after it, restarts the sequence rather than counting everything late.
+    class JitterBuffer
+    {
+    public:
+        JitterBuffer(IJitterBufferDelegate * const delegate,
+                     size_t capacity,
+                     int latencyMilliseconds);
+
+        ~JitterBuffer();
+
+        void push(const RtpPacketView* packet, uint64_t nowMicroseconds);
+
+        // gives up on any gap whose oldest held packet has waited out the
+        // latency. push() does this too, call it from a timer as well so
+        // held packets still go on when nothing else arrives.
+        void expire(uint64_t nowMicroseconds);
+
+        // hand over everything held, declaring whatever is missing lost
+        void flush();
+
+        void reset();
+
+        void setLatency(int milliseconds) { mLatency = milliseconds; }
+
+        int getLatency() const { return mLatency; }
+
+        size_t capacity() const { return mSlots.size(); }
+
+        size_t getBufferedCount() const { return mBufferedCount; }
+
+        uint64_t getReceivedCount() const { return mReceived.load(std::memory_order_relaxed); }
+
+        uint64_t getLostCount() const { return mLost.load(std::memory_order_relaxed); }
+
+        uint64_t getReorderedCount() const { return mReordered.load(std::memory_order_relaxed); }
+
+        uint64_t getDuplicateCount() const { return mDuplicates.load(std::memory_order_relaxed); }
+
+        uint64_t getLateCount() const { return mLate.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot
+        {
+            RtpPacket* packet;
+            uint64_t arrival;
+        };
+        
+        JitterBuffer(const JitterBuffer&);
+
+        JitterBuffer& operator=(const JitterBuffer&);
+
+        uint64_t extendSequenceNumber(uint16_t sequenceNumber);
+
+        // RFC 3550 A.1, false for the first packet of a big jump; a second
+        // one straight after it means the sender restarted its sequence
+        bool isSequenceValid(uint16_t sequenceNumber);
+
+        void deliver(const RtpPacketView* packet, uint64_t arrivalMicroseconds);
+
+        void releaseInOrder();
+
+        void skipGap();
+
+        static void increment(std::atomic<uint64_t>& counter, uint64_t count = 1);
+
+        IJitterBufferDelegate * const mDelegate;
+        int mLatency;
+        std::vector<Slot> mSlots;
+        size_t mMask;
+        size_t mBufferedCount;
+
+        bool mHaveSequence;
+        uint32_t mSsrc;
+        uint64_t mHighestSequence;
+        uint64_t mNextSequence;
+        uint32_t mBadSequence;
+
+        std::atomic<uint64_t> mReceived;
+        std::atomic<uint64_t> mLost;
+        std::atomic<uint64_t> mReordered;
+        std::atomic<uint64_t> mDuplicates;
+        std::atomic<uint64_t> mLate;
+    };
+};
+
+#endif //__JITTER_BUFFER_H__
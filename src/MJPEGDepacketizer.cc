@@ -161,23 +161,21 @@ makeTables(int q, unsigned char *lqt, unsigned char *cqt)
 }
 
 static void
-makeQuantHeader(std::vector<unsigned char> * const p,
+makeQuantHeader(Overflow::FrameBuffer * const p,
                 unsigned char *qt,
                 int tableNo)
 {
-    p->push_back(0xff);
-    p->push_back(0xdb);
-    p->push_back(0);
-    p->push_back(67);
-    p->push_back(tableNo);
-
-    size_t preCopySize = p->size();
-    p->resize(p->size() + 64);
-    std::copy(qt, qt + 64, p->begin() + preCopySize);
+    p->appendByte(0xff);
+    p->appendByte(0xdb);
+    p->appendByte(0);
+    p->appendByte(67);
+    p->appendByte(tableNo);
+
+    p->append(qt, 64);
 }
 
 static void
-makeHuffmanHeader(std::vector<unsigned char> * const p,
+makeHuffmanHeader(Overflow::FrameBuffer * const p,
                   unsigned char *codelens,
                   int ncodes,
                   unsigned char *symbols,
@@ -185,30 +183,26 @@ makeHuffmanHeader(std::vector<unsigned char> * const p,
                   int tableNo,
                   int tableClass)
 {
-    p->push_back(0xff);
-    p->push_back(0xc4);
-    p->push_back(0);
-    p->push_back(3 + ncodes + nsymbols);
-    p->push_back((tableClass << 4) | tableNo);
-
-    size_t preCopySize = p->size();
-
-    p->resize(p->size() + ncodes + nsymbols);
-
-    std::copy(codelens, codelens + ncodes, p->begin() + preCopySize);
-    std::copy(symbols, symbols + nsymbols, p->begin() + preCopySize + ncodes);
+    p->appendByte(0xff);
+    p->appendByte(0xc4);
+    p->appendByte(0);
+    p->appendByte(3 + ncodes + nsymbols);
+    p->appendByte((tableClass << 4) | tableNo);
+
+    p->append(codelens, ncodes);
+    p->append(symbols, nsymbols);
 }
 
 static void
-makeDRIHeader(std::vector<unsigned char> * const p,
+makeDRIHeader(Overflow::FrameBuffer * const p,
               unsigned short dri)
 {
-    p->push_back(0xff);
-    p->push_back(0xdd);
-    p->push_back(0x0);
-    p->push_back(4);
-    p->push_back(dri >> 8);
-    p->push_back(dri & 0xff);
+    p->appendByte(0xff);
+    p->appendByte(0xdd);
+    p->appendByte(0x0);
+    p->appendByte(4);
+    p->appendByte(dri >> 8);
+    p->appendByte(dri & 0xff);
 }
 
 /*
@@ -230,7 +224,7 @@ makeDRIHeader(std::vector<unsigned char> * const p,
  *    absence of an EOI marker to terminate the scan).
  */
 static void
-makeHeaders(std::vector<unsigned char> * const p,
+makeHeaders(Overflow::FrameBuffer * const p,
             int type,
             int w,
             int h,
@@ -238,15 +232,12 @@ makeHeaders(std::vector<unsigned char> * const p,
             unsigned char *cqt,
             unsigned short dri)
 {
-    p->clear();
-    p->resize(0);
-
     /* convert from blocks to pixels */
     w <<= 3;
     h <<= 3;
 
-    p->push_back(0xff);
-    p->push_back(0xd8);
+    p->appendByte(0xff);
+    p->appendByte(0xd8);
 
     makeQuantHeader(p, lqt, 0);
     makeQuantHeader(p, cqt, 1);
@@ -254,30 +245,30 @@ makeHeaders(std::vector<unsigned char> * const p,
     if (dri != 0)
         makeDRIHeader(p, dri);
 
-    p->push_back(0xff);
-    p->push_back(0xc0);
-    p->push_back(0);
-    p->push_back(17);
-    p->push_back(8);
-    p->push_back(h >> 8);
-    p->push_back(h);
-    p->push_back(w >> 8);
-    p->push_back(w);
-    p->push_back(3);
-    p->push_back(0);
+    p->appendByte(0xff);
+    p->appendByte(0xc0);
+    p->appendByte(0);
+    p->appendByte(17);
+    p->appendByte(8);
+    p->appendByte(h >> 8);
+    p->appendByte(h);
+    p->appendByte(w >> 8);
+    p->appendByte(w);
+    p->appendByte(3);
+    p->appendByte(0);
     
     if (type == 0)
-        p->push_back(0x21);
+        p->appendByte(0x21);
     else
-        p->push_back(0x22);
-
-    p->push_back(0);
-    p->push_back(1);
-    p->push_back(0x11);
-    p->push_back(1);
-    p->push_back(2);
-    p->push_back(0x11);
-    p->push_back(1);
+        p->appendByte(0x22);
+
+    p->appendByte(0);
+    p->appendByte(1);
+    p->appendByte(0x11);
+    p->appendByte(1);
+    p->appendByte(2);
+    p->appendByte(0x11);
+    p->appendByte(1);
     
     makeHuffmanHeader(p, lum_dc_codelens,
                       sizeof(lum_dc_codelens),
@@ -296,24 +287,24 @@ makeHeaders(std::vector<unsigned char> * const p,
                       chm_ac_symbols,
                       sizeof(chm_ac_symbols), 1, 1);
 
-    p->push_back(0xff);
-    p->push_back(0xda);
-    p->push_back(0);
-    p->push_back(12);
-    p->push_back(3);
-    p->push_back(0);
-    p->push_back(0);
-    p->push_back(1);
-    p->push_back(0x11);
-    p->push_back(2);
-    p->push_back(0x11);
-    p->push_back(0);
-    p->push_back(63);
-    p->push_back(0);
+    p->appendByte(0xff);
+    p->appendByte(0xda);
+    p->appendByte(0);
+    p->appendByte(12);
+    p->appendByte(3);
+    p->appendByte(0);
+    p->appendByte(0);
+    p->appendByte(1);
+    p->appendByte(0x11);
+    p->appendByte(2);
+    p->appendByte(0x11);
+    p->appendByte(0);
+    p->appendByte(63);
+    p->appendByte(0);
 }
 
 Overflow::MJPEGDepacketizer::MJPEGDepacketizer(const SessionDescription* palette,
-                                               const RtpPacket *packet,
+                                               const RtpPacketView *packet,
                                                bool isFirstPayload)
     : mPalette(palette),
       mPacket(packet)
@@ -321,72 +312,68 @@ Overflow::MJPEGDepacketizer::MJPEGDepacketizer(const SessionDescription* palette
     const unsigned char *rtp_packet_payload = mPacket->payloadData();
     parseJpegHeader(rtp_packet_payload);
 
+    // the restart marker header is carried in every fragment
+    mRestartHeaderSize = ((mType >= RESTART_MIN) && (mType <= RESTART_MAX)) ?
+        RESTARTMARKERHEADERSIZE : 0;
+    mDri = 0;
+    
     if (mFragmentOffset == 0)
     {
-        mRestartHeaderSize = ((mType >= RESTART_MIN) && (mType <= RESTART_MAX)) ?
-            RESTARTMARKERHEADERSIZE : 0;
-        
-        mDri = 0;
-
         if (mRestartHeaderSize > 0 ) {
             parseRestartMarkerHeader(rtp_packet_payload + JPEGHEADERSIZE);
         }
 
-        parseQuantizationHeader(rtp_packet_payload + JPEGHEADERSIZE + mRestartHeaderSize);
-
-        if (mQuantizationPayloadLength > 0) {
-            parseQuantizationTableData(rtp_packet_payload
-                                       + JPEGHEADERSIZE
-                                       + mRestartHeaderSize
-                                       + QUANTIZATIONTABLEHEADERSIZE);
+        // rfc2435 3.1.8 in-band tables are only present for q >= 128
+        mQuantizationPayloadLength = 0;
+        if (mQValue >= 128) {
+            parseQuantizationHeader(rtp_packet_payload + JPEGHEADERSIZE + mRestartHeaderSize);
         }
 
-        makeHeaders(&mPayload, mType, mWidth, mHeight, mLumq, mChrq, mDri);
+        parseQuantizationTableData(rtp_packet_payload
+                                   + JPEGHEADERSIZE
+                                   + mRestartHeaderSize
+                                   + QUANTIZATIONTABLEHEADERSIZE);
     }
     else
     {
         mQuantizationPayloadLength = 0;
-        mPayload.resize(0);
-        mPayload.clear();
     }
 }
 
-void Overflow::MJPEGDepacketizer::addToFrame(std::vector<unsigned char> * const frame)
+void Overflow::MJPEGDepacketizer::addToFrame(FrameBuffer * const frame,
+                                             FrameMetadata * const metadata)
 {
     const unsigned char *rtp_packet_payload = mPacket->payloadData();
     size_t rtp_packet_length = mPacket->payloadLength();
-    
-    size_t frame_length = frame->size();
 
-    if (frame_length == 0 && mFragmentOffset > 0)
+    // fragments of a frame whose start we never saw are useless
+    if (frame->empty() && mFragmentOffset > 0)
         return;
 
-    size_t jpeg_payload_offset = JPEGHEADERSIZE;
+    size_t jpeg_payload_offset = JPEGHEADERSIZE + mRestartHeaderSize;
     if (mFragmentOffset == 0)
     {
-        jpeg_payload_offset += (mRestartHeaderSize
-                                + QUANTIZATIONTABLEHEADERSIZE
-                                + mQuantizationPayloadLength);
-    }
-    
-    size_t add_to_packet_size = mPayload.size() + rtp_packet_length - jpeg_payload_offset;
+        if (mQValue >= 128)
+            jpeg_payload_offset += (QUANTIZATIONTABLEHEADERSIZE
+                                    + mQuantizationPayloadLength);
 
-    if (frame_length < (frame_length + add_to_packet_size)) {
-        frame->resize(frame_length + add_to_packet_size);
-    }
+        // a new image starts here, the jfif headers go straight in front
+        frame->clear();
+        makeHeaders(frame, mType, mWidth, mHeight, mLumq, mChrq, mDri);
 
-    if (mFragmentOffset == 0) {
-        std::copy(mPayload.begin(), mPayload.end(), frame->begin());
-        frame_length += mPayload.size();
+        if (metadata != nullptr)
+        {
+            metadata->isKeyFrame = true;
+            metadata->hasParameterSets = true;
+            metadata->sliceType = SLICE_TYPE_I;
+        }
     }
 
-    if (mFragmentOffset != 0) {
-        jpeg_payload_offset += mRestartHeaderSize;
-    }
+    if (jpeg_payload_offset > rtp_packet_length)
+        return;
 
-    std::copy(rtp_packet_payload + jpeg_payload_offset,
-              rtp_packet_payload + rtp_packet_length,
-              frame->begin() + frame_length);
+    frame->append(rtp_packet_payload + jpeg_payload_offset,
+                  rtp_packet_length - jpeg_payload_offset);
 }
 
 void Overflow::MJPEGDepacketizer::parseJpegHeader(const unsigned char *buffer)
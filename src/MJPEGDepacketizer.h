@@ -23,9 +23,9 @@
 #define __MJPEG_DEPACKETIZER_H__
 
 #include "SessionDescription.h"
-#include "RtpPacket.h"
-
-#include <vector>
+#include "RtpPacketView.h"
+#include "FrameBuffer.h"
+#include "Frame.h"
 
 namespace Overflow
 {
@@ -33,10 +33,12 @@ namespace Overflow
     {
     public:
         MJPEGDepacketizer(const SessionDescription* palette,
-                          const RtpPacket *packet,
+                          const RtpPacketView *packet,
                           bool isFirstPayload);
 
-        void addToFrame(std::vector<unsigned char> * const frame);
+        // every jpeg is a key frame as far as metadata goes
+        void addToFrame(FrameBuffer * const frame,
+                        FrameMetadata * const metadata = nullptr);
 
     private:
         void parseJpegHeader(const unsigned char * buffer);
@@ -59,8 +61,7 @@ namespace Overflow
         unsigned char mChrq[64];
         
         const SessionDescription *mPalette;
-        const RtpPacket *mPacket;
-        std::vector<unsigned char> mPayload;
+        const RtpPacketView *mPacket;
     };
 };
 
@@ -22,54 +22,80 @@
 
 #include <cstdlib>
 
+#define MP4V_VISUAL_OBJECT_SEQUENCE 0xB0
+#define MP4V_VOP 0xB6
+#define MP4V_VIDEO_OBJECT_LAYER_FIRST 0x20
+#define MP4V_VIDEO_OBJECT_LAYER_LAST 0x2F
+
 
 Overflow::MP4VDepacketizer::MP4VDepacketizer(const SessionDescription* palette,
-                                             const RtpPacket *packet,
+                                             const RtpPacketView *packet,
                                              bool isFirstPayload)
     : mPalette(palette),
-      mPacket(packet)
+      mPacket(packet),
+      mIsFirstPayload(isFirstPayload)
 {
-    if (isFirstPayload)
-    {
-        std::string config = mPalette->getFmtpConfigParameters();
-        std::vector<unsigned char> config_bytes;
-
-        size_t i;
-        for (i = 0; i < config.length(); i += 2)
-        {
-            std::string current_byte = config.substr(i, 2);
-            unsigned char wrapped_byte = (unsigned char)strtol(current_byte.c_str(), NULL, 16);
-            config_bytes.push_back(wrapped_byte);
-        }
+}
 
-        pushBytesToCurrentPayload(&(config_bytes[0]), config_bytes.size());
+void
+Overflow::MP4VDepacketizer::addToFrame(FrameBuffer * const frame,
+                                       FrameMetadata * const metadata)
+{
+    if (mIsFirstPayload)
+    {
+        addConfigToFrame(frame);
+        if (metadata != nullptr)
+            metadata->hasParameterSets = true;
     }
 
-    const unsigned char *rtp_packet_payload = mPacket->payloadData();
-    size_t rtp_packet_payload_length = mPacket->payloadLength();
+    // once the vop header has been seen the rest of the frame is data
+    if (metadata != nullptr and metadata->sliceType == SLICE_TYPE_UNKNOWN)
+        noteStartCodes(metadata);
 
-    pushBytesToCurrentPayload(rtp_packet_payload, rtp_packet_payload_length);
+    frame->append(mPacket->payloadData(), mPacket->payloadLength());
 }
 
-const unsigned char*
-Overflow::MP4VDepacketizer::bytes() const
+void
+Overflow::MP4VDepacketizer::noteStartCodes(FrameMetadata * const metadata)
 {
-    return &(mPayload[0]);
-}
+    const unsigned char *payload = mPacket->payloadData();
+    size_t length = mPacket->payloadLength();
 
-size_t
-Overflow::MP4VDepacketizer::length() const
-{
-    return mPayload.size();
+    for (size_t i = 0; i + 4 < length; ++i)
+    {
+        if (payload[i] != 0x00 or payload[i + 1] != 0x00 or payload[i + 2] != 0x01)
+            continue;
+
+        int code = payload[i + 3];
+        if (code == MP4V_VISUAL_OBJECT_SEQUENCE
+            or (code >= MP4V_VIDEO_OBJECT_LAYER_FIRST and code <= MP4V_VIDEO_OBJECT_LAYER_LAST))
+        {
+            metadata->hasParameterSets = true;
+        }
+        else if (code == MP4V_VOP)
+        {
+            // vop_coding_type, a sprite vop is predicted like a p-vop
+            static const FrameSliceType types[] = {
+                SLICE_TYPE_I, SLICE_TYPE_P, SLICE_TYPE_B, SLICE_TYPE_P
+            };
+            metadata->sliceType = types[payload[i + 4] >> 6];
+            metadata->isKeyFrame = metadata->sliceType == SLICE_TYPE_I;
+            metadata->isDisposable = metadata->sliceType == SLICE_TYPE_B;
+            return;
+        }
+    }
 }
 
 void
-Overflow::MP4VDepacketizer::pushBytesToCurrentPayload(const unsigned char* bytes,
-                                                      size_t length)
+Overflow::MP4VDepacketizer::addConfigToFrame(FrameBuffer * const frame)
 {
+    // config is hex encoded, decode it straight into the frame
+    std::string config = mPalette->getFmtpConfigParameters();
+
     size_t i;
-    for (i = 0; i < length; ++i)
+    for (i = 0; i + 1 < config.length(); i += 2)
     {
-        mPayload.push_back(bytes[i]);
+        char current_byte[3] = { config[i], config[i + 1], 0 };
+        frame->appendByte((unsigned char)strtol(current_byte, NULL, 16));
     }
 }
@@ -23,9 +23,9 @@
 #define __MP4V_DEPACKETIZER_H__
 
 #include "SessionDescription.h"
-#include "RtpPacket.h"
-
-#include <vector>
+#include "RtpPacketView.h"
+#include "FrameBuffer.h"
+#include "Frame.h"
 
 namespace Overflow
 {
@@ -33,20 +33,21 @@ namespace Overflow
     {
     public:
         MP4VDepacketizer(const SessionDescription* palette,
-                         const RtpPacket *packet,
+                         const RtpPacketView *packet,
                          bool isFirstPayload);
 
-        const unsigned char *bytes() const;
-
-        size_t length() const;
+        // metadata, when given, picks up the vop coding type
+        void addToFrame(FrameBuffer * const frame,
+                        FrameMetadata * const metadata = nullptr);
 
     private:
-        void pushBytesToCurrentPayload(const unsigned char *payload,
-                                       size_t length);
+        void addConfigToFrame(FrameBuffer * const frame);
+
+        void noteStartCodes(FrameMetadata * const metadata);
         
         const SessionDescription *mPalette;
-        const RtpPacket *mPacket;
-        std::vector<unsigned char> mPayload;
+        const RtpPacketView *mPacket;
+        bool mIsFirstPayload;
     };
 };
 
@@ -0,0 +1,288 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "MetricsExporter.h"
+
+#include <glog/logging.h>
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// how often the accept loop looks for stop()
+#define METRICS_POLL_INTERVAL_MS 250
+
+#define METRICS_REQUEST_TIMEOUT_MS 1000
+
+#define METRICS_MAX_REQUEST_SIZE 4096
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+
+static std::string escapeLabel(const std::string& value)
+{
+    std::string escaped;
+    for (char c: value)
+    {
+        if (c == '\\' or c == '"')
+            escaped += '\\';
+        if (c == '\n')
+        {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+static bool writeAll(int fd, const std::string& data)
+{
+    size_t offset = 0;
+    while (offset < data.length())
+    {
+        ssize_t written = send(fd, data.c_str() + offset, data.length() - offset, MSG_NOSIGNAL);
+        if (written <= 0)
+            return false;
+        offset += written;
+    }
+    return true;
+}
+
+
+Overflow::MetricsExporter::MetricsExporter()
+    : mListenFd(-1),
+      mPort(-1),
+      mIsRunning(false),
+      mThread(nullptr)
+{
+}
+
+Overflow::MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool
+Overflow::MetricsExporter::start(int port, const std::string& address)
+{
+    if (mThread != nullptr)
+        return true;
+    
+    mListenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (mListenFd < 0)
+    {
+        LOG(ERROR) << "metrics socket: " << strerror(errno);
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    fcntl(mListenFd, F_SETFD, FD_CLOEXEC);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1
+        or bind(mListenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0
+        or listen(mListenFd, 16) != 0)
+    {
+        LOG(ERROR) << "metrics failed to listen on: " << address << ":" << port;
+        close(mListenFd);
+        mListenFd = -1;
+        return false;
+    }
+
+    socklen_t length = sizeof(addr);
+    getsockname(mListenFd, (struct sockaddr*)&addr, &length);
+    mPort = ntohs(addr.sin_port);
+    LOG(INFO) << "metrics on: http://" << address << ":" << mPort << "/metrics";
+    
+    mIsRunning = true;
+    mThread = new std::thread([&]() { serverMain(); });
+    return true;
+}
+
+void
+Overflow::MetricsExporter::stop()
+{
+    if (mThread == nullptr)
+        return;
+
+    mIsRunning = false;
+    mThread->join();
+    delete mThread;
+    mThread = nullptr;
+    
+    close(mListenFd);
+    mListenFd = -1;
+}
+
+void
+Overflow::MetricsExporter::add(RtspController* controller, const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSessions.push_back(std::make_pair(controller, name));
+}
+
+void
+Overflow::MetricsExporter::remove(RtspController* controller)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto it = mSessions.begin(); it != mSessions.end(); ++it)
+    {
+        if (it->first == controller)
+        {
+            mSessions.erase(it);
+            return;
+        }
+    }
+}
+
+std::string
+Overflow::MetricsExporter::render()
+{
+    std::vector<std::pair<std::string, SessionMetricsSnapshot>> snapshots;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& session: mSessions)
+            snapshots.push_back(std::make_pair(session.second, session.first->getMetrics()));
+    }
+    return render(snapshots);
+}
+
+std::string
+Overflow::MetricsExporter::render(const std::vector<std::pair<std::string, SessionMetricsSnapshot>>& sessions)
+{
+    std::ostringstream out;
+
+    auto family = [&](const char* name, const char* type, const char* help,
+                      std::function<double (const SessionMetricsSnapshot&)> value) {
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " " << type << "\n";
+        for (auto& session: sessions)
+        {
+            out << name << "{session=\"" << escapeLabel(session.first) << "\"} "
+                << value(session.second) << "\n";
+        }
+    };
+
+    out.precision(15);
+    family("overflow_rtp_bytes_received_total", "counter", "RTP bytes received.",
+           [](const SessionMetricsSnapshot& s) { return (double)s.bytesReceived; });
+    family("overflow_rtp_packets_received_total", "counter", "RTP packets received.",
+           [](const SessionMetricsSnapshot& s) { return (double)s.packetsReceived; });
+    family("overflow_rtp_packets_lost_total", "counter", "RTP sequence gaps given up on.",
+           [](const SessionMetricsSnapshot& s) { return (double)s.packetsLost; });
+    family("overflow_rtp_packets_reordered_total", "counter", "RTP packets that arrived out of order.",
+           [](const SessionMetricsSnapshot& s) { return (double)s.packetsReordered; });
+    family("overflow_frames_total", "counter", "Frames delivered.",
+           [](const SessionMetricsSnapshot& s) { return (double)s.framesDelivered; });
+    family("overflow_reconnects_total", "counter", "Connection attempts after the first.",
+           [](const SessionMetricsSnapshot& s) { return (double)s.reconnects; });
+    family("overflow_time_to_first_frame_seconds", "gauge",
+           "Connect to first frame on the current connection, -1 while waiting.",
+           [](const SessionMetricsSnapshot& s) { return s.timeToFirstFrameSeconds; });
+    family("overflow_rtp_jitter_seconds", "gauge", "RFC 3550 interarrival jitter.",
+           [](const SessionMetricsSnapshot& s) { return s.jitterSeconds; });
+    family("overflow_rtp_fraction_lost", "gauge", "Loss fraction in the last receiver report interval.",
+           [](const SessionMetricsSnapshot& s) { return s.fractionLost; });
+
+    out << "# HELP overflow_client_state Current RTSP client state.\n";
+    out << "# TYPE overflow_client_state gauge\n";
+    for (auto& session: sessions)
+    {
+        out << "overflow_client_state{session=\"" << escapeLabel(session.first)
+            << "\",state=\"" << IRtspDelegate::stateToString(session.second.state)
+            << "\"} 1\n";
+    }
+    
+    return out.str();
+}
+
+void
+Overflow::MetricsExporter::serverMain()
+{
+    while (mIsRunning)
+    {
+        struct pollfd pfd;
+        pfd.fd = mListenFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        if (poll(&pfd, 1, METRICS_POLL_INTERVAL_MS) <= 0)
+            continue;
+
+        int fd = accept(mListenFd, NULL, NULL);
+        if (fd < 0)
+            continue;
+
+        handleConnection(fd);
+        close(fd);
+    }
+}
+
+void
+Overflow::MetricsExporter::handleConnection(int fd)
+{
+    std::string request;
+    char buffer[1024];
+    
+    while (request.find("\r\n\r\n") == std::string::npos
+           and request.length() < METRICS_MAX_REQUEST_SIZE)
+    {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, METRICS_REQUEST_TIMEOUT_MS) <= 0)
+            return;
+
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            return;
+        request.append(buffer, received);
+    }
+
+    bool isMetrics = request.compare(0, 13, "GET /metrics ") == 0
+        or request.compare(0, 13, "GET /metrics?") == 0;
+    
+    std::string body = isMetrics ? render() : "not found\n";
+    std::ostringstream response;
+    response << "HTTP/1.1 " << (isMetrics ? "200 OK" : "404 Not Found") << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.length() << "\r\n"
+             << "Connection: close\r\n"
+             << "\r\n"
+             << body;
+
+    writeAll(fd, response.str());
+}
@@ -0,0 +1,82 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __METRICS_EXPORTER_H__
+#define __METRICS_EXPORTER_H__
+
+#include "RtspController.h"
+#include "SessionMetrics.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace Overflow
+{
+    // Serves every registered session as Prometheus text on
+    // http://<address>:<port>/metrics from one small thread of its own.
+    class MetricsExporter
+    {
+    public:
+        MetricsExporter();
+
+        ~MetricsExporter();
+
+        // port 0 picks an ephemeral port, see getPort()
+        bool start(int port, const std::string& address = "127.0.0.1");
+
+        void stop();
+
+        int getPort() const { return mPort; }
+
+        // name becomes the session label, remove before deleting the client
+        void add(RtspController* controller, const std::string& name);
+
+        void remove(RtspController* controller);
+
+        std::string render();
+
+        static std::string render(const std::vector<std::pair<std::string, SessionMetricsSnapshot>>& sessions);
+
+    private:
+        MetricsExporter(const MetricsExporter&);
+
+        MetricsExporter& operator=(const MetricsExporter&);
+        
+        void serverMain();
+
+        void handleConnection(int fd);
+        
+        std::mutex mMutex;
+        std::vector<std::pair<RtspController*, std::string>> mSessions;
+
+        int mListenFd;
+        int mPort;
+        std::atomic<bool> mIsRunning;
+        std::thread* mThread;
+    };
+};
+
+#endif //__METRICS_EXPORTER_H__
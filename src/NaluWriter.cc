@@ -0,0 +1,127 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "NaluWriter.h"
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+
+Overflow::NaluWriter::NaluWriter(NaluFormat format, size_t lengthSize)
+    : mFormat(format),
+      mLengthSize(lengthSize),
+      mDropped(0),
+      mOpenFrame(nullptr),
+      mOpenOffset(0),
+      mOpenEnd(0)
+{
+    if (lengthSize != 1 and lengthSize != 2 and lengthSize != 4)
+    {
+        std::ostringstream message;
+        message << "Invalid nal unit length size: " << lengthSize;
+        throw std::runtime_error(message.str());
+    }
+}
+
+unsigned char*
+Overflow::NaluWriter::beginNalu(FrameBuffer * const frame,
+                                size_t length,
+                                bool isParameterSet)
+{
+    size_t prefix_length = mLengthSize;
+    if (mFormat == NALU_FORMAT_ANNEX_B)
+        prefix_length = isParameterSet ? 4 : 3;
+    else if (mFormat == NALU_FORMAT_ANNEX_B_LONG)
+        prefix_length = 4;
+    else if (isTooLong(length))
+    {
+        mOpenFrame = nullptr;
+        mDropped++;
+        return nullptr;
+    }
+
+    mOpenFrame = frame;
+    mOpenOffset = frame->length();
+    unsigned char *out = frame->extend(prefix_length + length);
+    mOpenEnd = frame->length();
+
+    if (mFormat == NALU_FORMAT_LENGTH_PREFIXED)
+    {
+        writeLength(out, length);
+        return out + prefix_length;
+    }
+
+    memset(out, 0x00, prefix_length - 1);
+    out[prefix_length - 1] = 0x01;
+    return out + prefix_length;
+}
+
+void
+Overflow::NaluWriter::appendToNalu(FrameBuffer * const frame,
+                                   const unsigned char *bytes,
+                                   size_t length)
+{
+    bool isOpen = frame == mOpenFrame and frame->length() == mOpenEnd;
+    if (mFormat != NALU_FORMAT_LENGTH_PREFIXED)
+    {
+        // an annex b writer may be made per packet, so the fragment goes
+        // on the end whether or not it saw the unit begin
+        frame->append(bytes, length);
+        if (isOpen)
+            mOpenEnd = frame->length();
+        return;
+    }
+
+    if (not isOpen)
+    {
+        mDropped++;
+        return;
+    }
+
+    size_t nalu_length = mOpenEnd - mOpenOffset - mLengthSize + length;
+    if (isTooLong(nalu_length))
+    {
+        // the rest of its fragments find it closed and are dropped too
+        frame->truncate(mOpenOffset);
+        mOpenFrame = nullptr;
+        mDropped++;
+        return;
+    }
+
+    frame->append(bytes, length);
+    mOpenEnd = frame->length();
+    writeLength(frame->mutableBytesPointer() + mOpenOffset, nalu_length);
+}
+
+void
+Overflow::NaluWriter::writeLength(unsigned char *out, size_t length) const
+{
+    // big endian
+    for (size_t i = 0; i < mLengthSize; ++i)
+        out[i] = (length >> (8 * (mLengthSize - 1 - i))) & 0xFF;
+}
+
+bool
+Overflow::NaluWriter::isTooLong(size_t length) const
+{
+    return mLengthSize < sizeof(uint32_t) and (length >> (8 * mLengthSize)) != 0;
+}
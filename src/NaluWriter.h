@@ -0,0 +1,91 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __NALU_WRITER_H__
+#define __NALU_WRITER_H__
+
+#include "FrameBuffer.h"
+
+#include <cstddef>
+
+
+namespace Overflow
+{
+    typedef enum {
+        // 4 byte start codes ahead of parameter sets, 3 bytes otherwise
+        NALU_FORMAT_ANNEX_B,
+        // 4 byte start codes throughout
+        NALU_FORMAT_ANNEX_B_LONG,
+        // avcc/hvcc, a big endian length of 1, 2 or 4 bytes ahead of each.
+        // A 1 or 2 byte length only holds units under 256 bytes or 64KB,
+        // which an idr slice easily outgrows, anything longer is dropped.
+        NALU_FORMAT_LENGTH_PREFIXED
+    } NaluFormat;
+
+    // Writes the start code or length ahead of each nal unit as the h264
+    // and h265 depacketizers copy it into the frame. A unit that arrives
+    // in fragments has its length patched as each one is appended, so a
+    // length prefixed frame never needs a second pass.
+    class NaluWriter
+    {
+    public:
+        // throws when lengthSize is not 1, 2 or 4
+        NaluWriter(NaluFormat format = NALU_FORMAT_ANNEX_B, size_t lengthSize = 4);
+
+        NaluFormat getFormat() const { return mFormat; }
+
+        size_t getLengthSize() const { return mLengthSize; }
+
+        // returns where the bytes of the unit go, nullptr when it is too
+        // long for the length prefix and was dropped
+        unsigned char* beginNalu(FrameBuffer * const frame,
+                                 size_t length,
+                                 bool isParameterSet = false);
+
+        // grows the unit begun last, when it is still the end of the frame.
+        // A length prefixed unit that outgrows its prefix is taken back out
+        // of the frame, and fragments of a unit that was never begun are
+        // dropped rather than left without a length.
+        void appendToNalu(FrameBuffer * const frame,
+                          const unsigned char *bytes,
+                          size_t length);
+
+        // units dropped for outgrowing the length prefix and fragments
+        // dropped for having no unit to go in
+        size_t getDroppedCount() const { return mDropped; }
+
+    private:
+        void writeLength(unsigned char *out, size_t length) const;
+
+        bool isTooLong(size_t length) const;
+
+        NaluFormat mFormat;
+        size_t mLengthSize;
+        size_t mDropped;
+
+        // the unit begun last, its prefix and where it ends
+        const FrameBuffer *mOpenFrame;
+        size_t mOpenOffset;
+        size_t mOpenEnd;
+    };
+};
+
+#endif //__NALU_WRITER_H__
@@ -0,0 +1,241 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cppcodec/base64_default_rfc4648.hpp>
+#include <cppcodec/parse_error.hpp>
+#include <glog/logging.h>
+
+#include "ParameterSets.h"
+
+#include <cstring>
+
+#define H264_NALU_SPS 7
+#define H264_NALU_PPS 8
+#define H265_NALU_VPS 32
+#define H265_NALU_SPS 33
+#define H265_NALU_PPS 34
+
+// enough of an sps to reach its id behind a profile_tier_level with
+// every sub-layer present
+#define PARAMETER_SET_ID_HEAD 128
+
+
+namespace
+{
+    // reads the rbsp with emulation prevention bytes taken out
+    class BitReader
+    {
+    public:
+        BitReader(const unsigned char *data, size_t length)
+            : mLength(0),
+              mBit(0)
+        {
+            int zeros = 0;
+            for (size_t i = 0; i < length and mLength < sizeof(mData); ++i)
+            {
+                if (zeros >= 2 and data[i] == 0x03)
+                {
+                    zeros = 0;
+                    continue;
+                }
+                zeros = (data[i] == 0x00) ? zeros + 1 : 0;
+                mData[mLength++] = data[i];
+            }
+        }
+
+        bool skip(size_t bits)
+        {
+            mBit += bits;
+            return mBit <= mLength * 8;
+        }
+
+        bool read(size_t bits, uint32_t *value)
+        {
+            *value = 0;
+            for (size_t i = 0; i < bits; ++i)
+            {
+                if (mBit >= mLength * 8)
+                    return false;
+                *value = (*value << 1) | ((mData[mBit / 8] >> (7 - mBit % 8)) & 1);
+                mBit++;
+            }
+            return true;
+        }
+
+        // exp-golomb ue(v)
+        bool readUnsigned(uint32_t *value)
+        {
+            int zeros = 0;
+            uint32_t bit = 0;
+            for (;;)
+            {
+                if (not read(1, &bit) or zeros > 31)
+                    return false;
+                if (bit)
+                    break;
+                zeros++;
+            }
+
+            uint32_t suffix = 0;
+            if (not read(zeros, &suffix))
+                return false;
+            *value = (1u << zeros) - 1 + suffix;
+            return true;
+        }
+
+    private:
+        unsigned char mData[PARAMETER_SET_ID_HEAD];
+        size_t mLength;
+        size_t mBit;
+    };
+}
+
+
+void
+Overflow::ParameterSets::reset(bool isH265)
+{
+    mIsH265 = isH265;
+    mUnits.clear();
+    mVersion++;
+}
+
+void
+Overflow::ParameterSets::addBase64List(const std::string& list)
+{
+    size_t start = 0;
+    while (start < list.length())
+    {
+        size_t end = list.find(",", start);
+        if (end == std::string::npos)
+            end = list.length();
+
+        if (end > start)
+        {
+            // cameras send unpadded and otherwise broken units, skip just those
+            try
+            {
+                std::vector<uint8_t> nalu = base64::decode(list.c_str() + start, end - start);
+                if (not nalu.empty())
+                    update(nalu.data(), nalu.size());
+            }
+            catch (const cppcodec::parse_error& e)
+            {
+                LOG(ERROR) << "skipping sprop parameter set '"
+                           << list.substr(start, end - start) << "': " << e.what();
+            }
+        }
+        start = end + 1;
+    }
+}
+
+bool
+Overflow::ParameterSets::update(const unsigned char *nalu, size_t length)
+{
+    size_t header_length = mIsH265 ? 2 : 1;
+    if (length <= header_length)
+        return false;
+
+    int type = readType(nalu);
+    bool isParameterSet = mIsH265
+        ? (type >= H265_NALU_VPS and type <= H265_NALU_PPS)
+        : (type == H264_NALU_SPS or type == H264_NALU_PPS);
+    if (not isParameterSet)
+        return false;
+
+    int id = readId(type, nalu, length);
+
+    // sorted by type then id so they are written out in a usable order
+    std::vector<ParameterSet>::iterator it = mUnits.begin();
+    while (it != mUnits.end() and (it->type < type or (it->type == type and it->id < id)))
+        ++it;
+
+    if (it != mUnits.end() and it->type == type and it->id == id)
+    {
+        if (it->bytes.size() == length and memcmp(it->bytes.data(), nalu, length) == 0)
+            return false;
+        it->bytes.assign(nalu, nalu + length);
+    }
+    else
+    {
+        ParameterSet unit;
+        unit.type = type;
+        unit.id = id;
+        unit.bytes.assign(nalu, nalu + length);
+        mUnits.insert(it, unit);
+    }
+
+    mVersion++;
+    return true;
+}
+
+int
+Overflow::ParameterSets::readType(const unsigned char *nalu) const
+{
+    return mIsH265 ? (nalu[0] >> 1) & 0x3F : nalu[0] & 0x1F;
+}
+
+int
+Overflow::ParameterSets::readId(int type, const unsigned char *nalu, size_t length) const
+{
+    uint32_t id = 0;
+    if (not mIsH265)
+    {
+        // profile_idc, constraint flags and level_idc ahead of the sps id
+        BitReader reader(nalu + 1, length - 1);
+        if (type == H264_NALU_SPS and not reader.skip(24))
+            return -1;
+        return reader.readUnsigned(&id) ? static_cast<int>(id) : -1;
+    }
+
+    BitReader reader(nalu + 2, length - 2);
+    if (type == H265_NALU_VPS)
+        return reader.read(4, &id) ? static_cast<int>(id) : -1;
+
+    if (type == H265_NALU_PPS)
+        return reader.readUnsigned(&id) ? static_cast<int>(id) : -1;
+
+    // vps id then profile_tier_level sized by the sub-layer count
+    uint32_t max_sub_layers_minus1 = 0;
+    if (not reader.skip(4) or not reader.read(3, &max_sub_layers_minus1) or not reader.skip(1))
+        return -1;
+
+    // general profile and level
+    if (not reader.skip(88 + 8))
+        return -1;
+
+    uint32_t profile_present[8] = { 0 };
+    uint32_t level_present[8] = { 0 };
+    for (uint32_t i = 0; i < max_sub_layers_minus1; ++i)
+    {
+        if (not reader.read(1, &profile_present[i]) or not reader.read(1, &level_present[i]))
+            return -1;
+    }
+    if (max_sub_layers_minus1 > 0 and not reader.skip(2 * (8 - max_sub_layers_minus1)))
+        return -1;
+
+    for (uint32_t i = 0; i < max_sub_layers_minus1; ++i)
+    {
+        if ((profile_present[i] and not reader.skip(88))
+            or (level_present[i] and not reader.skip(8)))
+            return -1;
+    }
+
+    return reader.readUnsigned(&id) ? static_cast<int>(id) : -1;
+}
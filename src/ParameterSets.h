@@ -0,0 +1,80 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __PARAMETER_SETS_H__
+#define __PARAMETER_SETS_H__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    struct ParameterSet
+    {
+        // nal unit type and the id the slices refer to it by
+        int type;
+        int id;
+        // from the nal header on, no start code
+        std::vector<unsigned char> bytes;
+    };
+
+    // The vps/sps/pps nal units of an h264 or h265 session, decoded once
+    // from the sdp and kept current from the ones the camera sends in-band.
+    // A unit replaces the one of the same type and id.
+    class ParameterSets
+    {
+    public:
+        ParameterSets(): mIsH265(false), mVersion(0) { }
+
+        void reset(bool isH265);
+
+        // comma separated base 64 units as in the sprop fmtp parameters
+        void addBase64List(const std::string& list);
+
+        // ignores anything but a parameter set, true when it was new or
+        // differs from the one it replaced
+        bool update(const unsigned char *nalu, size_t length);
+
+        // in vps, sps, pps order
+        const std::vector<ParameterSet>& getUnits() const { return mUnits; }
+
+        bool empty() const { return mUnits.empty(); }
+
+        bool isH265() const { return mIsH265; }
+
+        // bumped on every change
+        uint32_t getVersion() const { return mVersion; }
+
+    private:
+        int readType(const unsigned char *nalu) const;
+
+        int readId(int type, const unsigned char *nalu, size_t length) const;
+
+        bool mIsH265;
+        uint32_t mVersion;
+        std::vector<ParameterSet> mUnits;
+    };
+};
+
+#endif //__PARAMETER_SETS_H__
@@ -0,0 +1,113 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ReceiveBuffer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+
+Overflow::ReceiveBuffer::ReceiveBuffer(size_t capacity)
+    : mBytes(nullptr),
+      mCapacity(capacity),
+      mReadOffset(0),
+      mWriteOffset(0),
+      mBytesCopied(0)
+{
+    mBytes = (unsigned char*)malloc(mCapacity);
+    if (mBytes == nullptr)
+        throw std::bad_alloc();
+}
+
+Overflow::ReceiveBuffer::~ReceiveBuffer()
+{
+    free(mBytes);
+}
+
+void
+Overflow::ReceiveBuffer::commit(size_t length)
+{
+    mWriteOffset += length;
+}
+
+void
+Overflow::ReceiveBuffer::append(const unsigned char* bytes, size_t length)
+{
+    reserve(length);
+    memcpy(writePointer(), bytes, length);
+    commit(length);
+    
+    mBytesCopied += length;
+}
+
+void
+Overflow::ReceiveBuffer::consume(size_t length)
+{
+    mReadOffset += length;
+
+    // rewind for free when everything has been parsed
+    if (mReadOffset == mWriteOffset)
+    {
+        mReadOffset = 0;
+        mWriteOffset = 0;
+    }
+}
+
+void
+Overflow::ReceiveBuffer::reserve(size_t length)
+{
+    if (writableLength() >= length)
+        return;
+
+    size_t pending = readableLength();
+    if (mReadOffset > 0)
+    {
+        // move the partial message back to the head of the slab
+        memmove(mBytes, mBytes + mReadOffset, pending);
+        mBytesCopied += pending;
+        
+        mReadOffset = 0;
+        mWriteOffset = pending;
+    }
+
+    if (writableLength() >= length)
+        return;
+
+    size_t capacity = mCapacity;
+    while (capacity - pending < length)
+        capacity *= 2;
+
+    unsigned char *bytes = (unsigned char*)realloc(mBytes, capacity);
+    if (bytes == nullptr)
+        throw std::bad_alloc();
+    
+    mBytes = bytes;
+    mCapacity = capacity;
+    mBytesCopied += pending;
+}
+
+void
+Overflow::ReceiveBuffer::reset()
+{
+    mReadOffset = 0;
+    mWriteOffset = 0;
+}
@@ -0,0 +1,78 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __RECEIVE_BUFFER_H__
+#define __RECEIVE_BUFFER_H__
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    // Contiguous receive slab: bytes are written at the tail and parsed
+    // in place from the head. The unparsed remainder is only moved back
+    // to the front of the slab when there is no room left at the tail.
+    class ReceiveBuffer
+    {
+    public:
+        ReceiveBuffer(size_t capacity);
+
+        ~ReceiveBuffer();
+
+        unsigned char* writePointer() { return mBytes + mWriteOffset; }
+
+        size_t writableLength() const { return mCapacity - mWriteOffset; }
+
+        void commit(size_t length);
+
+        void append(const unsigned char* bytes, size_t length);
+
+        const unsigned char* readPointer() const { return mBytes + mReadOffset; }
+
+        size_t readableLength() const { return mWriteOffset - mReadOffset; }
+
+        void consume(size_t length);
+
+        void reserve(size_t length);
+
+        bool empty() const { return readableLength() == 0; }
+
+        size_t capacity() const { return mCapacity; }
+
+        uint64_t bytesCopied() const { return mBytesCopied; }
+
+        void reset();
+
+    private:
+        ReceiveBuffer(const ReceiveBuffer&);
+
+        ReceiveBuffer& operator=(const ReceiveBuffer&);
+
+        unsigned char *mBytes;
+        size_t mCapacity;
+        size_t mReadOffset;
+        size_t mWriteOffset;
+        uint64_t mBytesCopied;
+    };
+};
+
+#endif //__RECEIVE_BUFFER_H__
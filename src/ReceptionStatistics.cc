@@ -0,0 +1,195 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ReceptionStatistics.h"
+
+#define DEFAULT_CLOCK_RATE 90000
+
+// RFC 3550 A.1, jumps beyond these restart the sequence
+#define MAX_DROPOUT 3000
+#define MAX_MISORDER 100
+#define RTP_SEQ_MOD (1 << 16)
+
+#define MICROSECONDS_PER_SECOND 1000000
+
+
+Overflow::ReceptionStatistics::ReceptionStatistics()
+    : mClockRate(DEFAULT_CLOCK_RATE),
+      mJitterSeconds(0),
+      mFractionLost(0),
+      mCumulativeLost(0)
+{
+    reset();
+}
+
+void
+Overflow::ReceptionStatistics::reset()
+{
+    mHaveSource = false;
+    mSsrc = 0;
+    mMaxSequence = 0;
+    mCycles = 0;
+    mBaseSequence = 0;
+    mBadSequence = RTP_SEQ_MOD + 1;
+    mReceived = 0;
+    mExpectedPrior = 0;
+    mReceivedPrior = 0;
+    mBaseArrivalMicroseconds = 0;
+    mHaveTransit = false;
+    mLastTransit = 0;
+    mJitter = 0;
+    mHaveSenderReport = false;
+    mLastSenderReport = 0;
+    mLastSenderReportArrivalMicroseconds = 0;
+    
+    mJitterSeconds.store(0, std::memory_order_relaxed);
+    mFractionLost.store(0, std::memory_order_relaxed);
+    mCumulativeLost.store(0, std::memory_order_relaxed);
+}
+
+void
+Overflow::ReceptionStatistics::initSequence(int sequence)
+{
+    mBaseSequence = sequence;
+    mMaxSequence = sequence;
+    mBadSequence = RTP_SEQ_MOD + 1;
+    mCycles = 0;
+    mReceived = 0;
+    mExpectedPrior = 0;
+    mReceivedPrior = 0;
+}
+
+bool
+Overflow::ReceptionStatistics::updateSequence(int sequence)
+{
+    uint32_t delta = (sequence - mMaxSequence) & (RTP_SEQ_MOD - 1);
+    
+    if (delta < MAX_DROPOUT)
+    {
+        // in order with a permissible gap
+        if ((uint32_t)sequence < mMaxSequence)
+            mCycles += RTP_SEQ_MOD;
+        mMaxSequence = sequence;
+    }
+    else if (delta <= RTP_SEQ_MOD - MAX_MISORDER)
+    {
+        // a big jump, two in a row means the sender restarted
+        if ((uint32_t)sequence != mBadSequence)
+        {
+            mBadSequence = (sequence + 1) & (RTP_SEQ_MOD - 1);
+            return false;
+        }
+        initSequence(sequence);
+        mHaveTransit = false;
+    }
+    // otherwise a duplicate or late packet, counted but nothing moves
+    
+    return true;
+}
+
+void
+Overflow::ReceptionStatistics::onRtpPacket(const RtpPacketView* packet, uint64_t arrivalMicroseconds)
+{
+    int sequence = packet->getSequenceNumber();
+    if (not mHaveSource or packet->getSsrc() != mSsrc)
+    {
+        mHaveSource = true;
+        mSsrc = packet->getSsrc();
+        mBaseArrivalMicroseconds = arrivalMicroseconds;
+        mHaveTransit = false;
+        mJitter = 0;
+        initSequence(sequence);
+    }
+    else if (not updateSequence(sequence))
+        return;
+
+    ++mReceived;
+
+    // arrival in timestamp units, relative so the product cannot overflow
+    uint64_t elapsed = arrivalMicroseconds - mBaseArrivalMicroseconds;
+    uint32_t arrival = (uint32_t)(elapsed * mClockRate / MICROSECONDS_PER_SECOND);
+    uint32_t transit = arrival - packet->getTimestamp();
+
+    if (mHaveTransit)
+    {
+        int32_t d = (int32_t)(transit - mLastTransit);
+        if (d < 0)
+            d = -d;
+        mJitter += d - ((mJitter + 8) >> 4);
+        
+        mJitterSeconds.store((double)(mJitter >> 4) / mClockRate, std::memory_order_relaxed);
+    }
+    mLastTransit = transit;
+    mHaveTransit = true;
+}
+
+void
+Overflow::ReceptionStatistics::onSenderReport(const RtcpPacket* packet, uint64_t arrivalMicroseconds)
+{
+    if (not packet->hasSenderReport())
+        return;
+    
+    // middle 32 bits of the ntp timestamp, echoed back as LSR
+    mLastSenderReport = (uint32_t)(packet->getNtpTimestamp() >> 16);
+    mLastSenderReportArrivalMicroseconds = arrivalMicroseconds;
+    mHaveSenderReport = true;
+}
+
+bool
+Overflow::ReceptionStatistics::makeReportBlock(uint64_t nowMicroseconds, RtcpReportBlock* block)
+{
+    if (not mHaveSource)
+        return false;
+
+    // RFC 3550 A.3
+    uint64_t extendedMax = (uint64_t)mCycles + mMaxSequence;
+    uint64_t expected = extendedMax - mBaseSequence + 1;
+    int64_t lost = (int64_t)expected - (int64_t)mReceived;
+
+    uint64_t expectedInterval = expected - mExpectedPrior;
+    uint64_t receivedInterval = mReceived - mReceivedPrior;
+    int64_t lostInterval = (int64_t)expectedInterval - (int64_t)receivedInterval;
+    mExpectedPrior = expected;
+    mReceivedPrior = mReceived;
+
+    int fraction = 0;
+    if (expectedInterval != 0 and lostInterval > 0)
+        fraction = (int)((lostInterval << 8) / expectedInterval);
+    if (fraction > 255)
+        fraction = 255;
+
+    block->ssrc = mSsrc;
+    block->fractionLost = fraction;
+    block->cumulativeLost = lost > 0x7FFFFF ? 0x7FFFFF : (lost < -0x800000 ? -0x800000 : (int32_t)lost);
+    block->highestSequence = (uint32_t)extendedMax;
+    block->jitter = mJitter >> 4;
+    block->lastSenderReport = 0;
+    block->delaySinceLastSenderReport = 0;
+    if (mHaveSenderReport)
+    {
+        uint64_t delay = nowMicroseconds - mLastSenderReportArrivalMicroseconds;
+        block->lastSenderReport = mLastSenderReport;
+        block->delaySinceLastSenderReport = (uint32_t)(delay * 65536 / MICROSECONDS_PER_SECOND);
+    }
+
+    mFractionLost.store(fraction, std::memory_order_relaxed);
+    mCumulativeLost.store(lost, std::memory_order_relaxed);
+    return true;
+}
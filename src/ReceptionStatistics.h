@@ -0,0 +1,103 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __RECEPTION_STATISTICS_H__
+#define __RECEPTION_STATISTICS_H__
+
+#include "RtpPacketView.h"
+#include "RtcpPacket.h"
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    // What RFC 3550 appendix A keeps per source: extended highest sequence,
+    // packets expected against received, interarrival jitter and the last
+    // sender report. Fed in arrival order on the event-loop thread before
+    // any reordering; the published jitter and loss are safe to read from
+    // any thread.
+    class ReceptionStatistics
+    {
+    public:
+        ReceptionStatistics();
+
+        // rtp timestamp units per second, 90kHz for all the video we know
+        void setClockRate(int hertz) { mClockRate = hertz > 0 ? hertz : 90000; }
+
+        int getClockRate() const { return mClockRate; }
+
+        void onRtpPacket(const RtpPacketView* packet, uint64_t arrivalMicroseconds);
+
+        void onSenderReport(const RtcpPacket* packet, uint64_t arrivalMicroseconds);
+
+        // fills in the block for the next receiver report and starts a new
+        // loss interval, false until a packet has been seen
+        bool makeReportBlock(uint64_t nowMicroseconds, RtcpReportBlock* block);
+
+        void reset();
+
+        double getJitterSeconds() const { return mJitterSeconds.load(std::memory_order_relaxed); }
+
+        // over 256, as of the last receiver report
+        int getFractionLost() const { return mFractionLost.load(std::memory_order_relaxed); }
+
+        int64_t getCumulativeLost() const { return mCumulativeLost.load(std::memory_order_relaxed); }
+
+        uint64_t getPacketsReceived() const { return mReceived; }
+
+        uint32_t getSsrc() const { return mSsrc; }
+
+    private:
+        void initSequence(int sequence);
+
+        bool updateSequence(int sequence);
+
+        int mClockRate;
+        bool mHaveSource;
+        uint32_t mSsrc;
+        
+        uint32_t mMaxSequence;
+        uint32_t mCycles;
+        uint32_t mBaseSequence;
+        uint32_t mBadSequence;
+        uint64_t mReceived;
+        uint64_t mExpectedPrior;
+        uint64_t mReceivedPrior;
+
+        uint64_t mBaseArrivalMicroseconds;
+        bool mHaveTransit;
+        uint32_t mLastTransit;
+        // scaled by 16 as in appendix A.8
+        uint32_t mJitter;
+
+        bool mHaveSenderReport;
+        uint32_t mLastSenderReport;
+        uint64_t mLastSenderReportArrivalMicroseconds;
+
+        std::atomic<double> mJitterSeconds;
+        std::atomic<int> mFractionLost;
+        std::atomic<int64_t> mCumulativeLost;
+    };
+};
+
+#endif //__RECEPTION_STATISTICS_H__
@@ -26,16 +26,28 @@
 
 Overflow::Response::Response(const unsigned char *buffer,
                              size_t length)
-    : mLength(length)
+    : mLength(length),
+      mOwnsBuffer(true),
+      mParsed(nullptr)
 {
     unsigned char *copy = (unsigned char*)malloc(length);
     memcpy((void*)copy, (const void *)buffer, length);
     mBuffer = copy;
 }
 
+Overflow::Response::Response(const unsigned char *buffer,
+                             size_t length,
+                             const RtspResponseParser *parsed)
+    : mBuffer(const_cast<unsigned char*>(buffer)),
+      mLength(length),
+      mOwnsBuffer(false),
+      mParsed(parsed)
+{
+}
+
 Overflow::Response::~Response()
 {
-    if (mBuffer != NULL)
+    if (mOwnsBuffer and mBuffer != NULL)
         free(mBuffer);
 }
 
@@ -22,6 +22,8 @@
 #ifndef __RESPONSE_H__
 #define __RESPONSE_H__
 
+#include "RtspResponseParser.h"
+
 #include <string>
 
 
@@ -32,6 +34,12 @@ namespace Overflow
     public:
         Response(const unsigned char *buffer, size_t length);
 
+        // borrows buffer rather than copying it, for responses already
+        // framed by the reader which only live as long as its callback
+        Response(const unsigned char *buffer,
+                 size_t length,
+                 const RtspResponseParser *parsed);
+
         ~Response();
 
         const unsigned char* bytesPointer() const;
@@ -44,9 +52,14 @@ namespace Overflow
 
         std::string getStringBuffer() const;
 
+        // header views into bytesPointer, null when the response was copied
+        const RtspResponseParser* getParsed() const { return mParsed; }
+
     private:
         unsigned char *mBuffer;
         size_t mLength;
+        bool mOwnsBuffer;
+        const RtspResponseParser *mParsed;
     };
 };
 
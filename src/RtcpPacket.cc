@@ -0,0 +1,256 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "RtcpPacket.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#define RTCP_HEADER_SIZE 4
+#define RTCP_REPORT_BLOCK_SIZE 24
+#define RTCP_SENDER_INFO_SIZE 20
+
+#define RTCP_SDES_END 0
+#define RTCP_SDES_CNAME 1
+
+
+static void throwInvalidPacket(const char *reason, size_t length)
+{
+    std::ostringstream message;
+    message << "Invalid RTCP packet " << reason << " length: " << length;
+    throw std::runtime_error(message.str());
+}
+
+static uint32_t read32(const unsigned char *buffer)
+{
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16)
+        | ((uint32_t)buffer[2] << 8) | (uint32_t)buffer[3];
+}
+
+static void write32(unsigned char *buffer, uint32_t value)
+{
+    buffer[0] = value >> 24;
+    buffer[1] = (value >> 16) & 0xFF;
+    buffer[2] = (value >> 8) & 0xFF;
+    buffer[3] = value & 0xFF;
+}
+
+static void writeHeader(unsigned char *buffer, int count, int type, size_t length)
+{
+    // length is in 32 bit words minus one
+    size_t words = length / 4 - 1;
+    buffer[0] = 0x80 | (count & 0x1F);
+    buffer[1] = type;
+    buffer[2] = (words >> 8) & 0xFF;
+    buffer[3] = words & 0xFF;
+}
+
+
+Overflow::RtcpPacket::RtcpPacket(const unsigned char *buffer, size_t length)
+    : mHasSenderReport(false),
+      mHasReceiverReport(false),
+      mSsrc(0),
+      mNtpTimestamp(0),
+      mRtpTimestamp(0),
+      mSenderPacketCount(0),
+      mSenderOctetCount(0)
+{
+    size_t offset = 0;
+    while (offset < length)
+    {
+        if (length - offset < RTCP_HEADER_SIZE)
+            throwInvalidPacket("header", length);
+
+        const unsigned char *header = buffer + offset;
+        int version = header[0] >> 6;
+        bool hasPadding = (header[0] & 0x20) != 0;
+        int count = header[0] & 0x1F;
+        int type = header[1];
+        size_t packetLength = (((size_t)header[2] << 8) | header[3]) * 4 + 4;
+
+        if (version != 2)
+        {
+            std::ostringstream message;
+            message << "Invalid RTCP packet version: " << version;
+            throw std::runtime_error(message.str());
+        }
+        if (packetLength > length - offset)
+            throwInvalidPacket("truncated", length);
+        
+        const unsigned char *body = header + RTCP_HEADER_SIZE;
+        size_t bodyLength = packetLength - RTCP_HEADER_SIZE;
+        if (hasPadding and bodyLength > 0)
+        {
+            size_t padding = header[packetLength - 1];
+            if (padding > bodyLength)
+                throwInvalidPacket("padding", length);
+            bodyLength -= padding;
+        }
+
+        switch (type)
+        {
+        case RTCP_SR:
+            parseReport(body, bodyLength, count, true);
+            break;
+        case RTCP_RR:
+            parseReport(body, bodyLength, count, false);
+            break;
+        case RTCP_SDES:
+            parseSourceDescription(body, bodyLength, count);
+            break;
+        case RTCP_BYE:
+            parseBye(body, bodyLength, count);
+            break;
+        default:
+            break;
+        }
+        
+        offset += packetLength;
+    }
+}
+
+void
+Overflow::RtcpPacket::parseReport(const unsigned char *body, size_t length, int count, bool isSenderReport)
+{
+    size_t needed = 4 + (isSenderReport ? RTCP_SENDER_INFO_SIZE : 0) + count * RTCP_REPORT_BLOCK_SIZE;
+    if (length < needed)
+        throwInvalidPacket(isSenderReport ? "sender report" : "receiver report", length);
+
+    // the first report in a compound packet is the one it is about
+    if (not mHasSenderReport and not mHasReceiverReport)
+        mSsrc = read32(body);
+    
+    const unsigned char *block = body + 4;
+    if (isSenderReport)
+    {
+        mHasSenderReport = true;
+        mNtpTimestamp = ((uint64_t)read32(block) << 32) | read32(block + 4);
+        mRtpTimestamp = read32(block + 8);
+        mSenderPacketCount = read32(block + 12);
+        mSenderOctetCount = read32(block + 16);
+        block += RTCP_SENDER_INFO_SIZE;
+    }
+    else
+    {
+        mHasReceiverReport = true;
+    }
+
+    for (int i = 0; i < count; ++i, block += RTCP_REPORT_BLOCK_SIZE)
+    {
+        RtcpReportBlock report;
+        report.ssrc = read32(block);
+        report.fractionLost = block[4];
+        // sign extend the 24 bit count
+        int32_t lost = ((int32_t)block[5] << 16) | ((int32_t)block[6] << 8) | block[7];
+        report.cumulativeLost = (lost & 0x800000) ? lost - 0x1000000 : lost;
+        report.highestSequence = read32(block + 8);
+        report.jitter = read32(block + 12);
+        report.lastSenderReport = read32(block + 16);
+        report.delaySinceLastSenderReport = read32(block + 20);
+        mReportBlocks.push_back(report);
+    }
+}
+
+void
+Overflow::RtcpPacket::parseSourceDescription(const unsigned char *body, size_t length, int count)
+{
+    size_t offset = 0;
+    for (int chunk = 0; chunk < count; ++chunk)
+    {
+        if (length - offset < 4)
+            throwInvalidPacket("source description", length);
+        offset += 4;
+
+        // items until an end item, then padding to the next word
+        while (offset < length and body[offset] != RTCP_SDES_END)
+        {
+            if (length - offset < 2 or length - offset - 2 < body[offset + 1])
+                throwInvalidPacket("source description item", length);
+
+            int type = body[offset];
+            size_t itemLength = body[offset + 1];
+            if (type == RTCP_SDES_CNAME and mCname.empty())
+                mCname.assign((const char*)body + offset + 2, itemLength);
+            offset += 2 + itemLength;
+        }
+        offset = (offset + 4) & ~(size_t)3;
+        if (offset > length)
+            offset = length;
+    }
+}
+
+void
+Overflow::RtcpPacket::parseBye(const unsigned char *body, size_t length, int count)
+{
+    if (length < (size_t)count * 4)
+        throwInvalidPacket("bye", length);
+
+    for (int i = 0; i < count; ++i)
+        mByeSsrcs.push_back(read32(body + i * 4));
+}
+
+size_t
+Overflow::RtcpPacket::writeReceiverReport(unsigned char *buffer,
+                                          size_t capacity,
+                                          uint32_t ssrc,
+                                          const RtcpReportBlock* block,
+                                          const std::string& cname)
+{
+    size_t reportLength = 8 + (block != nullptr ? RTCP_REPORT_BLOCK_SIZE : 0);
+    size_t cnameLength = cname.length() > 255 ? 255 : cname.length();
+    // ssrc, cname item, end item and padding to a word
+    size_t descriptionLength = (RTCP_HEADER_SIZE + 4 + 2 + cnameLength + 1 + 3) & ~(size_t)3;
+    
+    if (capacity < reportLength + descriptionLength)
+        return 0;
+
+    writeHeader(buffer, block != nullptr ? 1 : 0, RTCP_RR, reportLength);
+    write32(buffer + 4, ssrc);
+    if (block != nullptr)
+    {
+        unsigned char *out = buffer + 8;
+        int32_t lost = block->cumulativeLost;
+        if (lost > 0x7FFFFF)
+            lost = 0x7FFFFF;
+        if (lost < -0x800000)
+            lost = -0x800000;
+        
+        write32(out, block->ssrc);
+        out[4] = block->fractionLost;
+        out[5] = (lost >> 16) & 0xFF;
+        out[6] = (lost >> 8) & 0xFF;
+        out[7] = lost & 0xFF;
+        write32(out + 8, block->highestSequence);
+        write32(out + 12, block->jitter);
+        write32(out + 16, block->lastSenderReport);
+        write32(out + 20, block->delaySinceLastSenderReport);
+    }
+
+    unsigned char *description = buffer + reportLength;
+    memset(description, 0, descriptionLength);
+    writeHeader(description, 1, RTCP_SDES, descriptionLength);
+    write32(description + 4, ssrc);
+    description[8] = RTCP_SDES_CNAME;
+    description[9] = cnameLength;
+    memcpy(description + 10, cname.c_str(), cnameLength);
+
+    return reportLength + descriptionLength;
+}
@@ -0,0 +1,116 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __RTCP_PACKET_H__
+#define __RTCP_PACKET_H__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    typedef enum
+    {
+        RTCP_SR = 200,
+        RTCP_RR = 201,
+        RTCP_SDES = 202,
+        RTCP_BYE = 203,
+        RTCP_APP = 204
+    } RtcpPacketType;
+
+    struct RtcpReportBlock
+    {
+        uint32_t ssrc;
+        // fraction of packets lost since the previous report, over 256
+        uint8_t fractionLost;
+        // 24 bits signed on the wire
+        int32_t cumulativeLost;
+        uint32_t highestSequence;
+        // interarrival jitter in timestamp units
+        uint32_t jitter;
+        // middle 32 bits of the last sr ntp timestamp, 0 without one
+        uint32_t lastSenderReport;
+        // since the last sr in 1/65536 seconds
+        uint32_t delaySinceLastSenderReport;
+    };
+    
+    // One compound rtcp packet (RFC 3550 6.1). Sender and receiver reports,
+    // the SDES CNAME and BYE are picked out, anything else is skipped.
+    class RtcpPacket
+    {
+    public:
+        RtcpPacket(const unsigned char *buffer, size_t length);
+
+        bool hasSenderReport() const { return mHasSenderReport; }
+
+        bool hasReceiverReport() const { return mHasReceiverReport; }
+
+        // of the sender or receiver report
+        uint32_t getSsrc() const { return mSsrc; }
+
+        uint64_t getNtpTimestamp() const { return mNtpTimestamp; }
+
+        uint32_t getRtpTimestamp() const { return mRtpTimestamp; }
+
+        uint32_t getSenderPacketCount() const { return mSenderPacketCount; }
+
+        uint32_t getSenderOctetCount() const { return mSenderOctetCount; }
+
+        const std::vector<RtcpReportBlock>& getReportBlocks() const { return mReportBlocks; }
+
+        const std::string& getCname() const { return mCname; }
+
+        bool hasBye() const { return not mByeSsrcs.empty(); }
+
+        const std::vector<uint32_t>& getByeSsrcs() const { return mByeSsrcs; }
+
+        // RR with at most one block followed by the SDES CNAME every compound
+        // packet has to carry, returns the length or 0 if capacity is short
+        static size_t writeReceiverReport(unsigned char *buffer,
+                                          size_t capacity,
+                                          uint32_t ssrc,
+                                          const RtcpReportBlock* block,
+                                          const std::string& cname);
+
+    private:
+        void parseReport(const unsigned char *body, size_t length, int count, bool isSenderReport);
+
+        void parseSourceDescription(const unsigned char *body, size_t length, int count);
+
+        void parseBye(const unsigned char *body, size_t length, int count);
+
+        bool mHasSenderReport;
+        bool mHasReceiverReport;
+        uint32_t mSsrc;
+        uint64_t mNtpTimestamp;
+        uint32_t mRtpTimestamp;
+        uint32_t mSenderPacketCount;
+        uint32_t mSenderOctetCount;
+        std::vector<RtcpReportBlock> mReportBlocks;
+        std::string mCname;
+        std::vector<uint32_t> mByeSsrcs;
+    };
+};
+
+#endif //__RTCP_PACKET_H__
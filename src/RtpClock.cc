@@ -0,0 +1,91 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "RtpClock.h"
+
+#define DEFAULT_CLOCK_RATE 90000
+
+// 1900 to 1970
+#define NTP_UNIX_EPOCH_OFFSET_SECONDS 2208988800ULL
+
+#define MICROSECONDS_PER_SECOND 1000000
+
+
+Overflow::RtpClock::RtpClock()
+    : mClockRate(DEFAULT_CLOCK_RATE)
+{
+    reset();
+}
+
+void
+Overflow::RtpClock::reset()
+{
+    mHaveTimestamp = false;
+    mExtendedTimestamp = 0;
+    mHaveSenderReport = false;
+    mSenderReportNtp = 0;
+    mSenderReportRtp = 0;
+}
+
+uint64_t
+Overflow::RtpClock::extend(uint32_t timestamp)
+{
+    if (not mHaveTimestamp)
+    {
+        mHaveTimestamp = true;
+        mExtendedTimestamp = timestamp;
+        return mExtendedTimestamp;
+    }
+
+    // nearest extended value either side of the last, b-frames step back
+    int32_t delta = (int32_t)(timestamp - (uint32_t)mExtendedTimestamp);
+    mExtendedTimestamp += delta;
+    return mExtendedTimestamp;
+}
+
+void
+Overflow::RtpClock::onSenderReport(uint64_t ntpTimestamp, uint32_t rtpTimestamp)
+{
+    mHaveSenderReport = true;
+    mSenderReportNtp = ntpTimestamp;
+    mSenderReportRtp = rtpTimestamp;
+}
+
+int64_t
+Overflow::RtpClock::toWallClockMicroseconds(uint64_t extendedTimestamp) const
+{
+    if (not mHaveSenderReport)
+        return -1;
+
+    // the report is close to the frame so only the low bits matter
+    int64_t ticks = (int32_t)((uint32_t)extendedTimestamp - mSenderReportRtp);
+    int64_t offset = ticks * MICROSECONDS_PER_SECOND / mClockRate;
+    
+    return ntpToUnixMicroseconds(mSenderReportNtp) + offset;
+}
+
+int64_t
+Overflow::RtpClock::ntpToUnixMicroseconds(uint64_t ntpTimestamp)
+{
+    int64_t seconds = (int64_t)(ntpTimestamp >> 32) - (int64_t)NTP_UNIX_EPOCH_OFFSET_SECONDS;
+    uint64_t fraction = ntpTimestamp & 0xFFFFFFFF;
+    
+    return seconds * MICROSECONDS_PER_SECOND + (int64_t)((fraction * MICROSECONDS_PER_SECOND) >> 32);
+}
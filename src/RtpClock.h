@@ -0,0 +1,67 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __RTP_CLOCK_H__
+#define __RTP_CLOCK_H__
+
+#include <cstdint>
+
+
+namespace Overflow
+{
+    // Counts wraps of the 32 bit rtp timestamp and maps it onto wall-clock
+    // time through the ntp/rtp pair of the last rtcp sender report, as in
+    // RFC 3550 6.4.1. Event-loop thread only.
+    class RtpClock
+    {
+    public:
+        RtpClock();
+
+        void setClockRate(int hertz) { mClockRate = hertz > 0 ? hertz : 90000; }
+
+        int getClockRate() const { return mClockRate; }
+
+        // timestamps come in roughly in order, each within 2^31 of the last
+        uint64_t extend(uint32_t timestamp);
+
+        void onSenderReport(uint64_t ntpTimestamp, uint32_t rtpTimestamp);
+
+        bool hasWallClock() const { return mHaveSenderReport; }
+
+        // microseconds since the unix epoch, -1 before any sender report
+        int64_t toWallClockMicroseconds(uint64_t extendedTimestamp) const;
+
+        void reset();
+
+        static int64_t ntpToUnixMicroseconds(uint64_t ntpTimestamp);
+
+    private:
+        int mClockRate;
+        bool mHaveTimestamp;
+        uint64_t mExtendedTimestamp;
+        
+        bool mHaveSenderReport;
+        uint64_t mSenderReportNtp;
+        uint32_t mSenderReportRtp;
+    };
+};
+
+#endif //__RTP_CLOCK_H__
@@ -22,6 +22,7 @@
 #ifndef __RTP_PACKET_H__
 #define __RTP_PACKET_H__
 
+#include "RtpPacketView.h"
 #include "Response.h"
 
 #include <cstdlib>
@@ -29,50 +30,23 @@
 
 namespace Overflow
 {
-    class RtpPacket
+    // Owning rtp packet, the bytes are copied once into a single
+    // allocation and parsed by the view.
+    class RtpPacket: public RtpPacketView
     {
     public:        
-        RtpPacket(const unsigned char *buffer, uint16_t length);
+        RtpPacket(const unsigned char *buffer, size_t length);
 
         RtpPacket(const Response* response);
 
         ~RtpPacket();
 
-        int getVersion() const { return mVersion; }
-
-        int getSequenceNumber() const { return mSequenceNumber; }
-
-        int getType() const { return mType; }
-
-        bool isMarked() const { return mMarker; }
-
-        bool hasExtension() const { return mExtension != nullptr; }
-
-        int getExtensionID() const { return mExtensionID; }
-
-        const unsigned char * getExtensionData() const { return mExtension; }
-
-        size_t getExtensionLength() const { return mExtensionLength; }
-
-        bool hasPayload() const { return mPayload != nullptr; }
-
-        const unsigned char * payloadData() const { return mPayload; }
-
-        size_t payloadLength() const { return mPayloadLength; }
+    private:
+        RtpPacket(const RtpPacket&);
 
-        uint32_t getTimestamp() const { return mTimestmap; }
+        RtpPacket& operator=(const RtpPacket&);
 
-    private:
-        uint32_t mTimestmap;
-        int mVersion;
-        int mSequenceNumber;
-        int mType;
-        bool mMarker;
-        int mExtensionID;
-        unsigned char *mExtension;
-        size_t mExtensionLength;
-        unsigned char *mPayload;
-        size_t mPayloadLength;
+        static const unsigned char* copyBuffer(const unsigned char *buffer, size_t length);
     };
     
 };
@@ -0,0 +1,145 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef BINDING_BUILD
+# include "Config.h"
+#endif
+
+#include "RtpPacketView.h"
+#include "RtpPacket.h"
+
+#include <string>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+
+struct _RTPHeader {
+#if IS_BIG_ENDIAN
+	uint8_t version:2;
+	uint8_t padding:1;
+	uint8_t extension:1;
+	uint8_t csrccount:4;
+	
+	uint8_t marker:1;
+	uint8_t payloadtype:7;
+#else // little endian
+	uint8_t csrccount:4;
+	uint8_t extension:1;
+	uint8_t padding:1;
+	uint8_t version:2;
+	
+	uint8_t payloadtype:7;
+	uint8_t marker:1;
+#endif // RTP_BIG_ENDIAN
+	
+	uint16_t sequencenumber;
+	uint32_t timestamp;
+	uint32_t ssrc;
+} __attribute__((packed)) ;
+
+struct _RTPExtensionHeader {
+    uint16_t extid;
+    uint16_t length;
+} __attribute__((packed)) ;
+
+static void throwInvalidPacket(const char *reason, size_t length)
+{
+    std::ostringstream message;
+    message << "Invalid RTP packet " << reason << " length: " << length;
+    throw std::runtime_error(message.str());
+}
+
+Overflow::RtpPacketView::RtpPacketView(const unsigned char *buffer,
+                                       size_t length)
+    : mBuffer(buffer),
+      mLength(length),
+      mTimestamp(0),
+      mSsrc(0),
+      mExtensionID(-1),
+      mExtension(nullptr),
+      mExtensionLength(0),
+      mPayload(nullptr),
+      mPayloadLength(0)
+{
+    if (length < sizeof(struct _RTPHeader))
+        throwInvalidPacket("header", length);
+    
+    struct _RTPHeader header;
+    memcpy(&header, buffer, sizeof(struct _RTPHeader));
+    
+    mVersion = static_cast<int>(header.version);
+    mSequenceNumber = ntohs(header.sequencenumber);
+    mType = static_cast<int>(header.payloadtype);
+    mMarker = header.marker == 0 ? false : true;
+    mTimestamp = ntohl(header.timestamp);
+    mSsrc = ntohl(header.ssrc);
+
+    if (mVersion != 2)
+    {
+        std::ostringstream message;
+        message << "Invalid RTP packet version: " << mVersion;
+        throw std::runtime_error(message.str());
+    }
+
+    size_t payload_offset = sizeof(struct _RTPHeader) + (header.csrccount * sizeof(uint32_t));
+    size_t payload_end = length;
+
+    bool has_extension = (header.extension == 0) ? false : true;
+    if (has_extension)
+    {
+        if (length < payload_offset + sizeof(struct _RTPExtensionHeader))
+            throwInvalidPacket("extension header", length);
+        
+        struct _RTPExtensionHeader extension_header;
+        memcpy(&extension_header, buffer + payload_offset, sizeof(struct _RTPExtensionHeader));
+        
+        mExtensionID = ntohs(extension_header.extid);
+        mExtensionLength = (sizeof(uint32_t) * ntohs(extension_header.length));
+        mExtension = buffer + payload_offset + sizeof(struct _RTPExtensionHeader);
+        
+        payload_offset += sizeof(struct _RTPExtensionHeader) + mExtensionLength;
+    }
+
+    bool has_padding = (header.padding == 0) ? false : true;
+    if (has_padding and payload_end > payload_offset)
+    {
+        // last octet is the count of padding octets including itself
+        size_t padding = buffer[length - 1];
+        if (padding > payload_end - payload_offset)
+            throwInvalidPacket("padding", length);
+        
+        payload_end -= padding;
+    }
+
+    if (payload_offset > payload_end)
+        throwInvalidPacket("payload", length);
+
+    mPayload = buffer + payload_offset;
+    mPayloadLength = payload_end - payload_offset;
+}
+
+Overflow::RtpPacket*
+Overflow::RtpPacketView::clone() const
+{
+    return new RtpPacket(mBuffer, mLength);
+}
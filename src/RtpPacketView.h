@@ -0,0 +1,92 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __RTP_PACKET_VIEW_H__
+#define __RTP_PACKET_VIEW_H__
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    class RtpPacket;
+    
+    // Parsed rtp header over bytes owned by someone else, usually the
+    // transport receive buffer. Only valid for as long as those bytes are,
+    // use clone() to keep hold of a packet past the callback.
+    class RtpPacketView
+    {
+    public:
+        RtpPacketView(const unsigned char *buffer, size_t length);
+
+        virtual ~RtpPacketView() { }
+
+        int getVersion() const { return mVersion; }
+
+        int getSequenceNumber() const { return mSequenceNumber; }
+
+        int getType() const { return mType; }
+
+        bool isMarked() const { return mMarker; }
+
+        uint32_t getTimestamp() const { return mTimestamp; }
+
+        uint32_t getSsrc() const { return mSsrc; }
+
+        bool hasExtension() const { return mExtension != nullptr; }
+
+        int getExtensionID() const { return mExtensionID; }
+
+        const unsigned char * getExtensionData() const { return mExtension; }
+
+        size_t getExtensionLength() const { return mExtensionLength; }
+
+        bool hasPayload() const { return mPayloadLength > 0; }
+
+        const unsigned char * payloadData() const { return mPayload; }
+
+        size_t payloadLength() const { return mPayloadLength; }
+
+        const unsigned char * bytesPointer() const { return mBuffer; }
+
+        size_t length() const { return mLength; }
+
+        RtpPacket* clone() const;
+
+    private:
+        const unsigned char *mBuffer;
+        size_t mLength;
+        uint32_t mTimestamp;
+        uint32_t mSsrc;
+        int mVersion;
+        int mSequenceNumber;
+        int mType;
+        bool mMarker;
+        int mExtensionID;
+        const unsigned char *mExtension;
+        size_t mExtensionLength;
+        const unsigned char *mPayload;
+        size_t mPayloadLength;
+    };
+};
+
+#endif //__RTP_PACKET_VIEW_H__
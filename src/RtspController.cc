@@ -24,29 +24,82 @@
 #include "SetupResponse.h"
 
 #include "H264Depacketizer.h"
+#include "H265Depacketizer.h"
 #include "MP4VDepacketizer.h"
 #include "MJPEGDepacketizer.h"
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+
+// starting size of the reassembly buffer, it grows to the largest frame
+#define INITIAL_FRAME_BUFFER_SIZE (256 * 1024)
+
+// packets held while waiting on a gap
+#define REORDER_BUFFER_CAPACITY 512
+
+#define DEFAULT_REORDER_LATENCY_MS 100
+
+// a receiver report with one block and a full length cname
+#define RTCP_REPORT_BUFFER_SIZE 512
+
+
+static uint64_t nowMicroseconds ()
+{
+    auto now = std::chrono::steady_clock::now ().time_since_epoch ();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count ();
+}
+
+static std::string makeCname ()
+{
+    char host[256];
+    memset (host, 0, sizeof(host));
+    if (gethostname (host, sizeof(host) - 1) != 0 or host[0] == '\0')
+        return "overflow";
+    
+    return "overflow@" + std::string (host);
+}
+
 
 Overflow::RtspController::RtspController (IRtspDelegate* delegate,
-                                          std::string url)
-    : TransportController (),
+                                          std::string url,
+                                          EventLoop* loop)
+    : TransportController (loop),
       mDelegate (delegate),
       mUrl (url),
       mFactory (mUrl),
       mState (CLIENT_INITILIZED),
       mServerAllowsAggregate (false),
-      mLastSeqNum (-1),
-      mIsFirstPayload (true)
-{
-    
+      mJitterBuffer (this, REORDER_BUFFER_CAPACITY, DEFAULT_REORDER_LATENCY_MS),
+      mIsFirstPayload (true),
+      mIsFirstFrame (true),
+      mIsKeyFramesOnly (false),
+      mIsSubFrameDelivery (false),
+      mNalUnitsOffset (0),
+      mIsDiscardingFrame (false),
+      mIsDiscardTimestampKnown (false),
+      mDiscardTimestamp (0),
+      mIsFrameStarted (false),
+      mFramePool (FramePool::sharedPool ()),
+      mCurrentFrame (mFramePool->acquire (INITIAL_FRAME_BUFFER_SIZE)),
+      mFrameQueue (nullptr),
+      mReportCname (makeCname ())
+{
+    std::random_device random;
+    mReportSsrc = random ();
 }
 
 Overflow::RtspController::~RtspController ()
 {
+    // no more callbacks into us once the base starts tearing down
+    stop ();
+    join ();
     
+    mCurrentFrame->release ();
 }
 
 bool
@@ -58,13 +111,15 @@ Overflow::RtspController::haveSession () const
 void
 Overflow::RtspController::standby ()
 {
-    if (isConnected () and haveSession ())
-        sendTeardownRequest ();
+    runOnEventLoop ([&]() {
+            if (isConnected () and haveSession ())
+                sendTeardownRequest ();
     
-    stopReconnectTimer ();
-    stopTransport ();
+            stopReconnectTimer ();
+            stopTransport ();
     
-    resetClientState ();
+            resetClientState ();
+        });
 }
 
 void
@@ -94,33 +149,126 @@ Overflow::RtspController::onKeepAlive ()
 }
 
 void
-Overflow::RtspController::onRtpPacket (const RtpPacket* packet)
+Overflow::RtspController::onRtpPacket (const RtpPacketView* packet)
+{
+    uint64_t now = nowMicroseconds ();
+    
+    mMetrics.onPacket (packet->length ());
+    // jitter is about arrival order so it is taken before any reordering
+    mReception.onRtpPacket (packet, now);
+    mJitterBuffer.push (packet, now);
+}
+
+void
+Overflow::RtspController::onRtcpPacket (const RtcpPacket* packet)
 {
-    int seqNum = packet->getSequenceNumber ();
-    bool initialized_last_seq_num = mLastSeqNum != -1;    
-    if (initialized_last_seq_num)
+    if (packet->hasSenderReport ()
+        and (packet->getSsrc () == mReception.getSsrc () or mReception.getPacketsReceived () == 0))
     {
-        bool out_of_sequence = (mLastSeqNum + 1) != seqNum;
-        if (out_of_sequence)
+        mReception.onSenderReport (packet, nowMicroseconds ());
+        mClock.onSenderReport (packet->getNtpTimestamp (), packet->getRtpTimestamp ());
+    }
+
+    if (packet->hasBye ())
+        LOG(INFO) << "rtcp-bye from: " << mUrl;
+}
+
+void
+Overflow::RtspController::onExpiryTimer ()
+{
+    mJitterBuffer.expire (nowMicroseconds ());
+}
+
+void
+Overflow::RtspController::onReport ()
+{
+    if (not haveSession ())
+        return;
+    
+    RtcpReportBlock block;
+    bool haveBlock = mReception.makeReportBlock (nowMicroseconds (), &block);
+
+    unsigned char buffer[RTCP_REPORT_BUFFER_SIZE];
+    size_t length = RtcpPacket::writeReceiverReport (buffer,
+                                                     sizeof(buffer),
+                                                     mReportSsrc,
+                                                     haveBlock ? &block : nullptr,
+                                                     mReportCname);
+    if (length > 0)
+        sendRtcpBytes (buffer, length);
+}
+
+Overflow::SessionMetricsSnapshot
+Overflow::RtspController::getMetrics (SessionMetricsWindow* window)
+{
+    SessionMetricsSnapshot snapshot = mMetrics.snapshot (mJitterBuffer.getLostCount (),
+                                                         mJitterBuffer.getReorderedCount (),
+                                                         window);
+    snapshot.jitterSeconds = mReception.getJitterSeconds ();
+    snapshot.fractionLost = mReception.getFractionLost () / 256.0;
+    return snapshot;
+}
+
+void
+Overflow::RtspController::onRtpPacketsLost (uint64_t count)
+{
+    LOG(ERROR) << "lost rtp-packets: " << count;
+
+    // the gap may hold the tail of the frame being built or the head of
+    // the next one, so drop whichever frame the next packet belongs to
+    abortCurrentPayload ();
+    mIsDiscardingFrame = true;
+    mIsDiscardTimestampKnown = false;
+}
+
+void
+Overflow::RtspController::onOrderedRtpPacket (const RtpPacketView* packet,
+                                              uint64_t arrivalMicroseconds)
+{
+    bool isMarked = packet->isMarked ();
+    
+    if (mIsDiscardingFrame)
+    {
+        if (not mIsDiscardTimestampKnown)
         {
-            LOG(ERROR) << "out of sequence rtp-packets: "
-                       << mLastSeqNum << "[LAST] - "
-                       << seqNum << "[CURRENT]";
+            mIsDiscardTimestampKnown = true;
+            mDiscardTimestamp = packet->getTimestamp ();
         }
+
+        // a new timestamp means the marker was lost too and this packet
+        // already starts the next frame
+        if (packet->getTimestamp () == mDiscardTimestamp)
+        {
+            mIsDiscardingFrame = not isMarked;
+            return;
+        }
+        mIsDiscardingFrame = false;
     }
-    mLastSeqNum = seqNum;
 
+    bool isKeyFramesOnly = mIsKeyFramesOnly.load (std::memory_order_relaxed);
+    if (isKeyFramesOnly and isNonIdrSlice (packet))
+    {
+        skipCurrentFrame (packet);
+        return;
+    }
+    
     if (packet->hasExtension ())
     {
         notifyDelegateOfExtension (packet);
     }
 
+    stampCurrentFrame (packet, arrivalMicroseconds);
+
     switch (mPalette.getType())
     {
     case H264:
         processH264Packet(packet);
         break;
 
+    case H265:
+        processH265Packet(packet);
+        break;
+
     case MP4V:
         processMP4VPacket(packet);
         break;
@@ -136,7 +284,21 @@ Overflow::RtspController::onRtpPacket (const RtpPacket* packet)
         return;
     }
 
+    // mpeg-4 only knows once the vop header is in, the rest is never copied
+    const FrameMetadata* metadata = mCurrentFrame->getMetadata ();
+    bool isKnownDelta = metadata->sliceType != SLICE_TYPE_UNKNOWN and not metadata->isKeyFrame;
+    if (isKeyFramesOnly and (isKnownDelta or (isMarked and not metadata->isKeyFrame)))
+    {
+        skipCurrentFrame (packet);
+        return;
+    }
+
     mIsFirstPayload = false;
+    if (isDeliveringNalUnits () and (isMarked or isEndOfNalUnit (packet)))
+    {
+        notifyDelegateOfNalUnits (isMarked);
+    }
+    
     if (not packet->isMarked())
         return;
 
@@ -144,6 +306,46 @@ Overflow::RtspController::onRtpPacket (const RtpPacket* packet)
     resetCurrentPayload();
 }
 
+bool
+Overflow::RtspController::isNonIdrSlice (const RtpPacketView* packet) const
+{
+    switch (mPalette.getType ())
+    {
+    case H264:
+        return H264Depacketizer::isNonIdrSlice (packet->payloadData (),
+                                                packet->payloadLength ());
+    case H265:
+        return H265Depacketizer::isNonIrapSlice (packet->payloadData (),
+                                                 packet->payloadLength ());
+    default:
+        return false;
+    }
+}
+
+bool
+Overflow::RtspController::isEndOfNalUnit (const RtpPacketView* packet) const
+{
+    if (mPalette.getType () == H265)
+        return H265Depacketizer::isEndOfNalUnit (packet->payloadData (),
+                                                 packet->payloadLength ());
+
+    return H264Depacketizer::isEndOfNalUnit (packet->payloadData (),
+                                             packet->payloadLength ());
+}
+
+void
+Overflow::RtspController::skipCurrentFrame (const RtpPacketView* packet)
+{
+    abortCurrentPayload ();
+    mIsDiscardingFrame = not packet->isMarked ();
+    mIsDiscardTimestampKnown = true;
+    mDiscardTimestamp = packet->getTimestamp ();
+    
+    // the mpeg-4 config from the sdp still goes in front of the first
+    // frame delivered, h264 and h265 put parameter sets ahead of any idr
+    mIsFirstPayload = mIsFirstFrame;
+}
+
 void
 Overflow::RtspController::onRtspResponse(const Response* response)
 {
@@ -230,20 +432,114 @@ Overflow::RtspController::onStateChange(RtspClientState state)
 {
     RtspClientState oldState = mState;
     mState = state;
+    mMetrics.onStateChange (state);
 
     notifyDelegateOfStateChange (oldState, mState);
 }
 
+void
+Overflow::RtspController::stampCurrentFrame (const RtpPacketView* packet,
+                                             uint64_t arrivalMicroseconds)
+{
+    FrameTimestamps* timestamps = mCurrentFrame->getTimestamps ();
+    timestamps->lastPacketMicroseconds = arrivalMicroseconds;
+    
+    if (mIsFrameStarted)
+        return;
+
+    mIsFrameStarted = true;
+    timestamps->rtpTimestamp = packet->getTimestamp ();
+    timestamps->extendedTimestamp = mClock.extend (packet->getTimestamp ());
+    timestamps->clockRate = mClock.getClockRate ();
+    timestamps->firstPacketMicroseconds = arrivalMicroseconds;
+}
+
 void
 Overflow::RtspController::notifyDelegateOfPayload ()
 {
+    mMetrics.onFrame ();
+    mIsFirstFrame = false;
+
+    // a sender report may have come in while the frame was built
+    FrameTimestamps* timestamps = mCurrentFrame->getTimestamps ();
+    timestamps->wallClockMicroseconds = mClock.toWallClockMicroseconds (timestamps->extendedTimestamp);
+    
+    {
+        std::lock_guard<std::mutex> lock (mSubscribersMutex);
+        mGopCache.push (mCurrentFrame);
+        for (auto it = mSubscribers.begin (); it != mSubscribers.end (); ++it)
+        {
+            mCurrentFrame->retain ();
+            if (not (*it)->push (mCurrentFrame))
+                mCurrentFrame->release ();
+        }
+    }
+
+    if (isDeliveringNalUnits ())
+        return;
+    
+    if (mFrameQueue != nullptr)
+    {
+        // the queue owns the extra reference, a full queue drops the frame
+        mCurrentFrame->retain ();
+        if (not mFrameQueue->push (mCurrentFrame))
+            mCurrentFrame->release ();
+    }
+    else if (mDelegate != nullptr)
+        mDelegate->onFrame(mCurrentFrame);
+}
+
+void
+Overflow::RtspController::setGopCacheBudget (size_t bytes)
+{
+    std::lock_guard<std::mutex> lock (mSubscribersMutex);
+    mGopCache.setMemoryBudget (bytes);
+}
+
+void
+Overflow::RtspController::subscribe (FrameQueue* queue)
+{
+    std::lock_guard<std::mutex> lock (mSubscribersMutex);
+    if (std::find (mSubscribers.begin (), mSubscribers.end (), queue) != mSubscribers.end ())
+        return;
+
+    size_t replayed = mGopCache.replay (queue);
+    LOG(INFO) << "subscriber replayed " << replayed << " of " << mGopCache.getFrameCount () << " cached frames";
+    mSubscribers.push_back (queue);
+}
+
+void
+Overflow::RtspController::unsubscribe (FrameQueue* queue)
+{
+    std::lock_guard<std::mutex> lock (mSubscribersMutex);
+    mSubscribers.erase (std::remove (mSubscribers.begin (), mSubscribers.end (), queue),
+                        mSubscribers.end ());
+}
+
+bool
+Overflow::RtspController::isDeliveringNalUnits () const
+{
+    return mIsSubFrameDelivery
+        and (mPalette.getType () == H264 or mPalette.getType () == H265);
+}
+
+void
+Overflow::RtspController::notifyDelegateOfNalUnits (bool isEndOfAccessUnit)
+{
+    size_t offset = mNalUnitsOffset;
+    if (offset == mCurrentFrame->length () and not isEndOfAccessUnit)
+        return;
+    mNalUnitsOffset = mCurrentFrame->length ();
+
+    FrameTimestamps* timestamps = mCurrentFrame->getTimestamps ();
+    timestamps->wallClockMicroseconds = mClock.toWallClockMicroseconds (timestamps->extendedTimestamp);
+
     if (mDelegate != nullptr)
-        mDelegate->onPayload(getCurrentFrame(),
-                             getCurrentFrameSize());
+        mDelegate->onNalUnits (mCurrentFrame, offset, isEndOfAccessUnit);
 }
 
 void
-Overflow::RtspController::notifyDelegateOfExtension (const RtpPacket* packet)
+Overflow::RtspController::notifyDelegateOfExtension (const RtpPacketView* packet)
 {
     if (mDelegate != nullptr)
         mDelegate->onRtpPacketExtension(
@@ -260,71 +556,82 @@ Overflow::RtspController::notifyDelegateOfPaletteType ()
 }
 
 void
-Overflow::RtspController::processH264Packet(const RtpPacket* packet)
+Overflow::RtspController::processH264Packet(const RtpPacketView* packet)
 {
-    H264Depacketizer depacketizer(&mPalette, packet, mIsFirstPayload);
+    H264Depacketizer depacketizer(&mPalette, packet, &mNaluWriter);
 
-    const unsigned char *payload = depacketizer.bytes();
-    size_t payload_size = depacketizer.length();
+    depacketizer.addToFrame(mCurrentFrame->getBuffer(), mCurrentFrame->getMetadata());
+}
 
-    appendPayloadToCurrentFrame(payload, payload_size);
+void
+Overflow::RtspController::processH265Packet(const RtpPacketView* packet)
+{
+    H265Depacketizer depacketizer(&mPalette, packet, &mNaluWriter);
+
+    depacketizer.addToFrame(mCurrentFrame->getBuffer(), mCurrentFrame->getMetadata());
 }
 
 void
-Overflow::RtspController::processMP4VPacket(const RtpPacket* packet)
+Overflow::RtspController::processMP4VPacket(const RtpPacketView* packet)
 {
     MP4VDepacketizer depacketizer(&mPalette, packet, mIsFirstPayload);
 
-    const unsigned char *payload = depacketizer.bytes();
-    size_t payload_size = depacketizer.length();
-
-    appendPayloadToCurrentFrame(payload, payload_size);
+    depacketizer.addToFrame(mCurrentFrame->getBuffer(), mCurrentFrame->getMetadata());
 }
 
 void
-Overflow::RtspController::processMJPEGPacket(const RtpPacket* packet)
+Overflow::RtspController::processMJPEGPacket(const RtpPacketView* packet)
 {
     MJPEGDepacketizer depacketizer(&mPalette, packet, mIsFirstPayload);
 
-    depacketizer.addToFrame(&mCurrentFrame);
+    depacketizer.addToFrame(mCurrentFrame->getBuffer(), mCurrentFrame->getMetadata());
 }
 
 void
 Overflow::RtspController::resetCurrentPayload()
 {
-    mCurrentFrame.clear ();
-    mCurrentFrame.resize (0);
+    mIsFrameStarted = false;
+    mNalUnitsOffset = 0;
+    if (not mCurrentFrame->isShared ())
+    {
+        mCurrentFrame->clear ();
+        return;
+    }
+
+    // a delegate kept hold of it, carry on in a fresh one of the same size
+    size_t size_hint = mCurrentFrame->length ();
+    mCurrentFrame->release ();
+    mCurrentFrame = mFramePool->acquire (size_hint);
 }
 
 void
-Overflow::RtspController::resetClientState()
+Overflow::RtspController::abortCurrentPayload()
 {
-    mSession.clear();
-    mLastSeqNum = -1;
-    mIsFirstPayload = true;
+    bool isAccessUnitStarted = mNalUnitsOffset > 0;
     resetCurrentPayload ();
-}
-
-size_t
-Overflow::RtspController::getCurrentFrameSize() const
-{
-    return mCurrentFrame.size();
-}
 
-const unsigned char*
-Overflow::RtspController::getCurrentFrame() const
-{
-    return &(mCurrentFrame[0]);
+    if (isAccessUnitStarted and mDelegate != nullptr)
+        mDelegate->onAccessUnitAborted ();
 }
 
 void
-Overflow::RtspController::appendPayloadToCurrentFrame(
-    const unsigned char* buffer,
-    size_t length)
+Overflow::RtspController::resetClientState()
 {
-    size_t old_size = mCurrentFrame.size();
-    mCurrentFrame.resize(old_size + length);
-    std::copy(buffer, buffer + length, mCurrentFrame.begin() + old_size);
+    mSession.clear();
+    mJitterBuffer.reset ();
+    mReception.reset ();
+    mClock.reset ();
+    stopReportTimer ();
+    stopExpiryTimer ();
+    mIsDiscardingFrame = false;
+    mIsDiscardTimestampKnown = false;
+    mIsFirstPayload = true;
+    mIsFirstFrame = true;
+    abortCurrentPayload ();
+
+    // a new session starts from its own key frame
+    std::lock_guard<std::mutex> lock (mSubscribersMutex);
+    mGopCache.clear ();
 }
 
 void
@@ -385,7 +692,15 @@ Overflow::RtspController::onDescribeResponse(const Response* response)
     else
     {
         onStateChange (CLIENT_DESCRIBE_OK);
-        mPalette = resp.getSessionDescriptions()[0];
+        SessionDescription palette = resp.getSessionDescriptions()[0];
+
+        // a reconnect to a camera that leaves sprop out of its sdp keeps
+        // the parameter sets it sent in-band last time
+        if (palette.getParameterSets().empty() and palette.getType() == mPalette.getType())
+            palette.setParameterSets (mPalette.getParameterSets ());
+        mPalette = palette;
+        mReception.setClockRate (mPalette.getClockRate ());
+        mClock.setClockRate (mPalette.getClockRate ());
         notifyDelegateOfPaletteType ();
         sendSetupRequest ();
     }
@@ -439,6 +754,7 @@ Overflow::RtspController::onSetupResponse(const Response* response)
         {
             onStateChange(CLIENT_SETUP_OK);
             mSession = resp.getSession();
+            setupTransport(&resp);
             startKeepAliveTimer(resp.getTimeoutSeconds());
             sendPlayRequest();
         }
@@ -458,6 +774,16 @@ Overflow::RtspController::onPlayResponse(const Response* response)
               << response->getStringBuffer();
     RtspResponse resp(response);
     onStateChange (resp.ok() ? CLIENT_PLAY_OK :CLIENT_ERROR);
+
+    if (resp.ok())
+    {
+        startReportTimer ();
+
+        // a gap is given up on within half the latency of its deadline
+        int latency = mJitterBuffer.getLatency ();
+        if (latency > 0)
+            startExpiryTimer (latency > 1 ? latency / 2 : 1);
+    }
 }
 
 void
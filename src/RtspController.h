@@ -28,17 +28,33 @@
 #include "IRtspDelegate.h"
 #include "RtspFactory.h"
 #include "SessionDescription.h"
-
+#include "Frame.h"
+#include "FramePool.h"
+#include "FrameQueue.h"
+#include "GopCache.h"
+#include "JitterBuffer.h"
+#include "IJitterBufferDelegate.h"
+#include "SessionMetrics.h"
+#include "ReceptionStatistics.h"
+#include "RtpClock.h"
+#include "NaluWriter.h"
+
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <vector>
 
 
 namespace Overflow
 {
     class RtspController: public TransportController,
-                          protected ITransportDelegate
+                          protected ITransportDelegate,
+                          protected IJitterBufferDelegate
     {
     public:
-        RtspController (IRtspDelegate* delegate, std::string url);
+        RtspController (IRtspDelegate* delegate,
+                        std::string url,
+                        EventLoop* loop = nullptr);
 
         virtual ~RtspController ();
 
@@ -48,16 +64,74 @@ namespace Overflow
 
         void standby ();
 
+        // frames go to the queue instead of IRtspDelegate::onFrame, set it
+        // before start() and keep it alive until the client is stopped
+        void setFrameQueue (FrameQueue* queue) { mFrameQueue = queue; }
+
+        // frames from the last key frame on are held for late subscribers,
+        // up to bytes of pooled frame capacity, 0 (the default) holds none
+        void setGopCacheBudget (size_t bytes);
+
+        // safe from any thread: the queue is handed the cached gop in one
+        // burst, then every frame after it alongside the frame queue or
+        // delegate. Size it for a gop and keep it alive until unsubscribe().
+        void subscribe (FrameQueue* queue);
+
+        void unsubscribe (FrameQueue* queue);
+
+        // how long a gap may hold back later packets before it is declared
+        // lost, 0 hands packets on as soon as they arrive
+        void setReorderLatency (int milliseconds) { mJitterBuffer.setLatency (milliseconds); }
+
+        // only idr access units with their parameter sets are delivered,
+        // non-idr h264 and h265 slices are dropped from their rtp header
+        // before any copy and mpeg-4 frames once their vop header shows
+        // they are not intra. Safe to flip from any thread while streaming.
+        void setKeyFramesOnly (bool keyFramesOnly) { mIsKeyFramesOnly.store (keyFramesOnly, std::memory_order_relaxed); }
+
+        bool isKeyFramesOnly () const { return mIsKeyFramesOnly.load (std::memory_order_relaxed); }
+
+        // h264 and h265 access units go to IRtspDelegate::onNalUnits a nal
+        // unit at a time as they are reassembled instead of to onFrame or
+        // the frame queue once the marker is in, other codecs are not
+        // affected. Set it before start().
+        void setSubFrameDelivery (bool subFrameDelivery) { mIsSubFrameDelivery = subFrameDelivery; }
+
+        bool isSubFrameDelivery () const { return mIsSubFrameDelivery; }
+
+        // how h264 and h265 nal units are delimited in delivered frames,
+        // avcc style length prefixes are written as the units are copied
+        // in. Set it before start(), throws on a length size other than
+        // 1, 2 or 4.
+        void setNaluFormat (NaluFormat format, size_t lengthSize = 4) { mNaluWriter = NaluWriter (format, lengthSize); }
+
+        NaluFormat getNaluFormat () const { return mNaluWriter.getFormat (); }
+
+        const JitterBuffer& getJitterBuffer () const { return mJitterBuffer; }
+
+        const ReceptionStatistics& getReceptionStatistics () const { return mReception; }
+
+        // safe from any thread, rates are since the last call that was
+        // handed the same window and stay 0 without one
+        SessionMetricsSnapshot getMetrics (SessionMetricsWindow* window = nullptr);
+
+        const std::string& getUrl () const { return mUrl; }
+
     protected:
         void onKeepAlive () override;
 
+        void onReport () override;
+
+        // releases held packets when the stream stalls behind a gap
+        void onExpiryTimer () override;
+
         virtual Transport* createTransport () { return nullptr; }
         
     private:
         // ITransportDelegate
-        void onRtpPacket (const RtpPacket* packet) override;
+        void onRtpPacket (const RtpPacketView* packet) override;
 
-        // void onRtcpPacket(const RtcpPackat* packet) = 0;
+        void onRtcpPacket (const RtcpPacket* packet) override;
 
         void onRtspResponse(const Response* response) override;
 
@@ -65,32 +139,51 @@ namespace Overflow
         
         void onTransportError(TransportErrorReason reason) override;
         // ITransportDelegate
+
+        // IJitterBufferDelegate
+        void onOrderedRtpPacket (const RtpPacketView* packet,
+                                 uint64_t arrivalMicroseconds) override;
+
+        void onRtpPacketsLost (uint64_t count) override;
+        // IJitterBufferDelegate
         
         void onStateChange(RtspClientState state);
 
         void notifyDelegateOfPayload();
 
-        void notifyDelegateOfExtension(const RtpPacket* packet);
+        bool isDeliveringNalUnits () const;
+
+        void notifyDelegateOfNalUnits (bool isEndOfAccessUnit);
+
+        void stampCurrentFrame(const RtpPacketView* packet, uint64_t arrivalMicroseconds);
+
+        void notifyDelegateOfExtension(const RtpPacketView* packet);
 
         void notifyDelegateOfPaletteType();
 
-        void processH264Packet(const RtpPacket* packet);
+        void processH264Packet(const RtpPacketView* packet);
 
-        void processMP4VPacket(const RtpPacket* packet);
+        void processH265Packet(const RtpPacketView* packet);
 
-        void processMJPEGPacket(const RtpPacket* packet);
+        void processMP4VPacket(const RtpPacketView* packet);
+
+        void processMJPEGPacket(const RtpPacketView* packet);
 
         void resetCurrentPayload ();
 
-        void resetClientState ();
+        // resets, telling the delegate when part of it was already handed out
+        void abortCurrentPayload ();
 
-        bool haveSession () const;
+        bool isNonIdrSlice (const RtpPacketView* packet) const;
+
+        bool isEndOfNalUnit (const RtpPacketView* packet) const;
 
-        size_t getCurrentFrameSize() const;
+        void skipCurrentFrame (const RtpPacketView* packet);
 
-        const unsigned char* getCurrentFrame() const;
+        void resetClientState ();
+
+        bool haveSession () const;
 
-        void appendPayloadToCurrentFrame(const unsigned char* buffer, size_t length);
 
         void notifyDelegateOfStateChange (RtspClientState oldState,
                                           RtspClientState newState);
@@ -125,9 +218,31 @@ namespace Overflow
         SessionDescription mPalette;
         bool mServerAllowsAggregate;
         std::string mSession;
-        int mLastSeqNum;
+        JitterBuffer mJitterBuffer;
         bool mIsFirstPayload;
-        std::vector<unsigned char> mCurrentFrame;
+        bool mIsFirstFrame;
+        std::atomic<bool> mIsKeyFramesOnly;
+        bool mIsSubFrameDelivery;
+        size_t mNalUnitsOffset;
+        NaluWriter mNaluWriter;
+        bool mIsDiscardingFrame;
+        // frame being dropped, taken from the first packet after a loss
+        bool mIsDiscardTimestampKnown;
+        uint32_t mDiscardTimestamp;
+        bool mIsFrameStarted;
+        FramePool* mFramePool;
+        Frame* mCurrentFrame;
+        FrameQueue* mFrameQueue;
+        // the cache and the subscribers it replays into, under one lock so
+        // a new subscriber sees no frame twice and misses none
+        std::mutex mSubscribersMutex;
+        GopCache mGopCache;
+        std::vector<FrameQueue*> mSubscribers;
+        SessionMetrics mMetrics;
+        ReceptionStatistics mReception;
+        RtpClock mClock;
+        uint32_t mReportSsrc;
+        std::string mReportCname;
     };
 };
 
@@ -109,8 +109,19 @@ Overflow::RtspResponse::RtspResponse(const unsigned char* buffer,
 
 
 Overflow::RtspResponse::RtspResponse(const Response* resp)
-    : RtspResponse(resp->bytesPointer(), resp->length())
+    : mCode(500)
 {
+    const RtspResponseParser *parsed = resp->getParsed();
+    if (parsed != nullptr)
+    {
+        loadParsed(parsed);
+        return;
+    }
+
+    RtspResponse copy(resp->bytesPointer(), resp->length());
+    mCode = copy.mCode;
+    mBody.swap(copy.mBody);
+    mHeaders.swap(copy.mHeaders);
 }
 
 Overflow::RtspResponse::RtspResponse(int code, std::string body)
@@ -123,6 +134,29 @@ Overflow::RtspResponse::~RtspResponse()
 {
 }
 
+void
+Overflow::RtspResponse::loadParsed(const RtspResponseParser* parsed)
+{
+    // the reader has already framed this message, take the fields from its
+    // views rather than splitting the bytes all over again
+    if (parsed->getCode() < 0)
+    {
+        std::ostringstream message;
+        message << "Invalid RTSP Response - not enough status tokens";
+        throw std::runtime_error{ message.str() };
+    }
+    
+    mCode = parsed->getCode();
+    
+    for (size_t i = 0; i < parsed->getHeaderCount(); ++i)
+    {
+        mHeaders.insert(std::pair<std::string, std::string>(parsed->getHeaderKey(i).toString(),
+                                                            parsed->getHeaderValue(i).toString()));
+    }
+
+    mBody = parsed->getBody().toString();
+}
+
 const std::string
 Overflow::RtspResponse::headerValueForKey(const std::string& key)
 {
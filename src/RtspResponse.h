@@ -59,6 +59,8 @@ namespace Overflow
         int mCode;
         std::string mBody;
         std::map<std::string, std::string> mHeaders;
+
+        void loadParsed(const RtspResponseParser* parsed);
     };
 };
 
@@ -0,0 +1,185 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "RtspResponseParser.h"
+
+#include <cstring>
+#include <cstdlib>
+
+// bodies (sdp, get_parameter replies) never come close to this, anything
+// larger would not fit the interleaved reader's receive slab anyway
+#define RTSP_MAX_CONTENT_LENGTH 65535
+
+
+Overflow::RtspResponseParser::RtspResponseParser()
+    : mBuffer(nullptr),
+      mState(PARSING_STATUS_LINE),
+      mScanOffset(0),
+      mCode(-1),
+      mHeadersLength(0),
+      mContentLength(0)
+{
+    mHeaders.reserve(16);
+}
+
+void
+Overflow::RtspResponseParser::reset()
+{
+    mBuffer = nullptr;
+    mState = PARSING_STATUS_LINE;
+    mScanOffset = 0;
+    mCode = -1;
+    mHeadersLength = 0;
+    mContentLength = 0;
+    mHeaders.clear();
+}
+
+bool
+Overflow::RtspResponseParser::parse(const unsigned char *buffer, size_t length)
+{
+    mBuffer = buffer;
+    
+    while (mState == PARSING_STATUS_LINE or mState == PARSING_HEADERS)
+    {
+        // only ever look at bytes we have not scanned on a previous read
+        const void *eol = memchr(buffer + mScanOffset, '\n', length - mScanOffset);
+        if (eol == nullptr)
+            return false;
+
+        size_t line_end = ((const unsigned char*)eol - buffer) + 1;
+        size_t line_length = line_end - mScanOffset;
+
+        parseLine(mScanOffset, line_length);
+        mScanOffset = line_end;
+    }
+
+    if (mState == PARSING_BODY and length >= getMessageLength())
+        mState = PARSING_COMPLETE;
+
+    return isComplete();
+}
+
+void
+Overflow::RtspResponseParser::parseLine(size_t offset, size_t length)
+{
+    // strip the line terminator, be lenient about bare \n
+    size_t content_length = length - 1;
+    if (content_length > 0 and mBuffer[offset + content_length - 1] == '\r')
+        content_length--;
+
+    if (mState == PARSING_STATUS_LINE)
+    {
+        parseStatusLine(offset, content_length);
+        mState = PARSING_HEADERS;
+    }
+    else if (content_length == 0)
+    {
+        mHeadersLength = offset + length;
+        mState = PARSING_BODY;
+    }
+    else
+    {
+        parseHeaderLine(offset, content_length);
+    }
+}
+
+void
+Overflow::RtspResponseParser::parseStatusLine(size_t offset, size_t length)
+{
+    // RTSP/1.0 200 OK
+    const char *line = (const char*)mBuffer + offset;
+    const char *space = (const char*)memchr(line, ' ', length);
+    
+    mCode = (space != nullptr) ? atoi(space + 1) : -1;
+}
+
+void
+Overflow::RtspResponseParser::parseHeaderLine(size_t offset, size_t length)
+{
+    const unsigned char *line = mBuffer + offset;
+    const void *colon = memchr(line, ':', length);
+    if (colon == nullptr)
+        return;
+
+    size_t key_length = (const unsigned char*)colon - line;
+    size_t value_offset = key_length + 1;
+    while (value_offset < length and (line[value_offset] == ' ' or line[value_offset] == '\t'))
+        value_offset++;
+
+    HeaderField field;
+    field.keyOffset = offset;
+    field.keyLength = key_length;
+    field.valueOffset = offset + value_offset;
+    field.valueLength = length - value_offset;
+    mHeaders.push_back(field);
+
+    BufferView key(line, key_length);
+    if (key.equalsIgnoreCase("Content-Length"))
+    {
+        // bounded as it is accumulated so a long digit run can not wrap
+        size_t content_length = 0;
+        for (size_t i = value_offset; i < length and line[i] >= '0' and line[i] <= '9'; ++i)
+        {
+            content_length = (content_length * 10) + (line[i] - '0');
+            if (content_length > RTSP_MAX_CONTENT_LENGTH)
+            {
+                mState = PARSING_ERROR;
+                return;
+            }
+        }
+        
+        mContentLength = content_length;
+    }
+}
+
+Overflow::BufferView
+Overflow::RtspResponseParser::getHeaderKey(size_t index) const
+{
+    const HeaderField& field = mHeaders[index];
+    return BufferView(mBuffer + field.keyOffset, field.keyLength);
+}
+
+Overflow::BufferView
+Overflow::RtspResponseParser::getHeaderValue(size_t index) const
+{
+    const HeaderField& field = mHeaders[index];
+    return BufferView(mBuffer + field.valueOffset, field.valueLength);
+}
+
+Overflow::BufferView
+Overflow::RtspResponseParser::headerValueForKey(const char *key) const
+{
+    for (size_t i = 0; i < mHeaders.size(); ++i)
+    {
+        if (getHeaderKey(i).equalsIgnoreCase(key))
+            return getHeaderValue(i);
+    }
+    return BufferView();
+}
+
+Overflow::BufferView
+Overflow::RtspResponseParser::getBody() const
+{
+    if (not isComplete())
+        return BufferView();
+    
+    return BufferView(mBuffer + mHeadersLength, mContentLength);
+}
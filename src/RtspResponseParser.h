@@ -0,0 +1,111 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __RTSP_RESPONSE_PARSER_H__
+#define __RTSP_RESPONSE_PARSER_H__
+
+#include "BufferView.h"
+
+#include <vector>
+#include <cstddef>
+
+
+namespace Overflow
+{
+    typedef enum
+    {
+        PARSING_STATUS_LINE,
+        PARSING_HEADERS,
+        PARSING_BODY,
+        PARSING_COMPLETE,
+        PARSING_ERROR
+    } RtspResponseParserState;
+    
+    // Resumable rtsp response framer. It is handed the same message again
+    // (with more bytes on the end) after every read and carries on from
+    // where it stopped scanning. Header fields are kept as offsets from the
+    // start of the message so the caller is free to move the bytes around
+    // between reads.
+    class RtspResponseParser
+    {
+    public:
+        RtspResponseParser();
+
+        // true once the whole message including the body is in buffer
+        bool parse(const unsigned char *buffer, size_t length);
+
+        void reset();
+
+        RtspResponseParserState getState() const { return mState; }
+
+        bool isComplete() const { return mState == PARSING_COMPLETE; }
+
+        bool haveHeaders() const { return mState == PARSING_BODY or mState == PARSING_COMPLETE; }
+
+        // the framing can not be trusted (eg: a bogus Content-Length),
+        // the caller has to reset and drop what it has buffered
+        bool isError() const { return mState == PARSING_ERROR; }
+
+        int getCode() const { return mCode; }
+
+        size_t getHeadersLength() const { return mHeadersLength; }
+
+        size_t getContentLength() const { return mContentLength; }
+
+        size_t getMessageLength() const { return mHeadersLength + mContentLength; }
+
+        size_t getHeaderCount() const { return mHeaders.size(); }
+
+        // views are into the buffer passed to the last call of parse
+        BufferView getHeaderKey(size_t index) const;
+
+        BufferView getHeaderValue(size_t index) const;
+
+        BufferView headerValueForKey(const char *key) const;
+
+        BufferView getBody() const;
+
+    private:
+        struct HeaderField
+        {
+            size_t keyOffset;
+            size_t keyLength;
+            size_t valueOffset;
+            size_t valueLength;
+        };
+
+        void parseLine(size_t offset, size_t length);
+
+        void parseStatusLine(size_t offset, size_t length);
+
+        void parseHeaderLine(size_t offset, size_t length);
+        
+        const unsigned char *mBuffer;
+        RtspResponseParserState mState;
+        size_t mScanOffset;
+        int mCode;
+        size_t mHeadersLength;
+        size_t mContentLength;
+        std::vector<HeaderField> mHeaders;
+    };
+};
+
+#endif //__RTSP_RESPONSE_PARSER_H__
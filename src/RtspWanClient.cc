@@ -23,10 +23,13 @@
 
 
 Overflow::RtspWanClient::RtspWanClient (IRtspDelegate * const delegate,
-                                        const std::string& url)
-    : RtspController (delegate, url),
+                                        const std::string& url,
+                                        EventLoop* loop)
+    : RtspController (delegate, url, loop),
       mUrl (url)
 {
+    // tcp never reorders, a gap is a loss straight away
+    setReorderLatency (0);
 }
 
 Overflow::RtspWanClient::~RtspWanClient ()
@@ -37,5 +40,5 @@ Overflow::RtspWanClient::~RtspWanClient ()
 Overflow::Transport*
 Overflow::RtspWanClient::createTransport ()
 {
-    return new InterleavedTcpTransport (this, mUrl);
+    return new InterleavedTcpTransport (this, getEventLoop (), mUrl);
 }
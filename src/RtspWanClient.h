@@ -26,6 +26,7 @@
 #include "InterleavedTcpTransport.h"
 #include "IRtspDelegate.h"
 #include "Transport.h"
+#include "EventLoop.h"
 
 #include <string>
 
@@ -35,7 +36,9 @@ namespace Overflow
     class RtspWanClient : public RtspController
     {
     public:
-        RtspWanClient(IRtspDelegate * const delegate, const std::string& url);
+        RtspWanClient(IRtspDelegate * const delegate,
+                      const std::string& url,
+                      EventLoop* loop = nullptr);
 
         ~RtspWanClient();
 
@@ -24,6 +24,10 @@
 
 #include <string>
 #include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include "ParameterSets.h"
 
 
 namespace Overflow
@@ -32,6 +36,7 @@ namespace Overflow
         H264,
         MP4V,
         MJPEG,
+        H265,
         UNKNOWN_PALETTE
     } RtspSessionType;
 
@@ -58,7 +63,9 @@ namespace Overflow
               mFrameRate(frameRate),
               mResolutionWidth(width),
               mResolutionHeight(height)
-        { }
+        {
+            loadParameterSets();
+        }
 
         virtual ~SessionDescription() { }
 
@@ -87,6 +94,33 @@ namespace Overflow
             return mFmtp.substr(pos + 21, end - pos - 21);
         }
 
+        // value of a name=value fmtp parameter, empty when absent
+        const std::string getFmtpParameter(const char *name) const
+        {
+            size_t pos = findFmtpParameter(name);
+            if (pos == std::string::npos) {
+                return std::string();
+            }
+
+            size_t end = mFmtp.find(";", pos);
+            if (end == std::string::npos) {
+                end = mFmtp.length();
+            }
+
+            return mFmtp.substr(pos, end - pos);
+        }
+
+        // rfc 7798, above 0 every h265 packet carries a decoding order number
+        int getH265MaxDonDiff() const
+        {
+            if (mType != RtspSessionType::H265) {
+                return 0;
+            }
+
+            size_t pos = findFmtpParameter("sprop-max-don-diff");
+            return pos == std::string::npos ? 0 : atoi(mFmtp.c_str() + pos);
+        }
+
         const std::string getFmtpConfigParameters() const
         {
             size_t pos = mFmtp.find("config=");
@@ -99,7 +133,31 @@ namespace Overflow
                 end = mFmtp.length();
             }
 
-            return mFmtp.substr(pos + 7, end - pos);
+            return mFmtp.substr(pos + 7, end - pos - 7);
+        }
+
+        // from the rtpmap encoding, 90kHz when it gives none
+        int getClockRate() const
+        {
+            size_t pos = mRtpMap.find("/");
+            if (pos == std::string::npos) {
+                return 90000;
+            }
+
+            int rate = atoi(mRtpMap.c_str() + pos + 1);
+            return rate > 0 ? rate : 90000;
+        }
+
+        // h264/h265 parameter sets, from the sprop parameters until the
+        // camera sends its own
+        const ParameterSets& getParameterSets() const { return mParameterSets; }
+
+        void setParameterSets(const ParameterSets& parameterSets) { mParameterSets = parameterSets; }
+
+        // true when the nal unit was a parameter set the cache did not have
+        bool updateParameterSet(const unsigned char *nalu, size_t length)
+        {
+            return mParameterSets.update(nalu, length);
         }
 
         int getFrameRate() const { return mFrameRate; }
@@ -113,6 +171,9 @@ namespace Overflow
             if (raw_mime.find("H264") != std::string::npos) {
                 return H264;
             }
+            else if (raw_mime.find("H265") != std::string::npos) {
+                return H265;
+            }
             else if (raw_mime.find("MP4V-ES") != std::string::npos) {
                 return MP4V;
             }
@@ -136,6 +197,9 @@ namespace Overflow
             case MJPEG:
                 typeString = "MJPEG";
                 break;
+            case H265:
+                typeString = "H265";
+                break;
             case UNKNOWN_PALETTE:
                 typeString = "UNKNOWN";
                 break;
@@ -144,6 +208,35 @@ namespace Overflow
         }
 
     protected:
+        void loadParameterSets()
+        {
+            mParameterSets.reset(mType == RtspSessionType::H265);
+            if (mType == RtspSessionType::H264) {
+                mParameterSets.addBase64List(getFmtpH264ConfigParameters());
+            }
+            else if (mType == RtspSessionType::H265) {
+                mParameterSets.addBase64List(getFmtpParameter("sprop-vps"));
+                mParameterSets.addBase64List(getFmtpParameter("sprop-sps"));
+                mParameterSets.addBase64List(getFmtpParameter("sprop-pps"));
+            }
+        }
+
+        // start of the value, npos when absent
+        size_t findFmtpParameter(const char *name) const
+        {
+            size_t length = strlen(name);
+            size_t pos = mFmtp.find(name);
+            while (pos != std::string::npos)
+            {
+                bool isStart = pos == 0 or mFmtp[pos - 1] == ';' or mFmtp[pos - 1] == ' ';
+                if (isStart and pos + length < mFmtp.length() and mFmtp[pos + length] == '=') {
+                    return pos + length + 1;
+                }
+                pos = mFmtp.find(name, pos + 1);
+            }
+            return std::string::npos;
+        }
+
         RtspSessionType mType;
         std::string mControl;
         std::string mRtpMap;
@@ -151,6 +244,7 @@ namespace Overflow
         int mFrameRate;
         int mResolutionWidth;
         int mResolutionHeight;
+        ParameterSets mParameterSets;
     };
 
 }
@@ -57,4 +57,6 @@ Overflow::SessionDescriptionV0::SessionDescriptionV0(const std::string& rawSessi
             mType = getTypeFromMime(current_line);
         }
     }
+
+    loadParameterSets();
 }
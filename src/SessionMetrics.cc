@@ -0,0 +1,103 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SessionMetrics.h"
+
+#include <chrono>
+
+#define NANOSECONDS_PER_SECOND 1e9
+
+
+Overflow::SessionMetrics::SessionMetrics()
+    : mBytesReceived(0),
+      mPacketsReceived(0),
+      mFramesDelivered(0),
+      mFirstFrameNanoseconds(0),
+      mConnects(0),
+      mConnectNanoseconds(0),
+      mState(CLIENT_INITILIZED)
+{
+}
+
+uint64_t
+Overflow::SessionMetrics::now()
+{
+    auto since = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(since).count();
+}
+
+void
+Overflow::SessionMetrics::onStateChange(RtspClientState state)
+{
+    mState.store(state, std::memory_order_relaxed);
+
+    if (state == CLIENT_CONNECTING)
+    {
+        // time to first frame restarts with every connection attempt
+        increment(mConnects, 1);
+        mConnectNanoseconds.store(now(), std::memory_order_relaxed);
+        mFirstFrameNanoseconds.store(0, std::memory_order_relaxed);
+    }
+}
+
+Overflow::SessionMetricsSnapshot
+Overflow::SessionMetrics::snapshot(uint64_t packetsLost,
+                                   uint64_t packetsReordered,
+                                   SessionMetricsWindow* window)
+{
+    SessionMetricsSnapshot snapshot;
+    snapshot.nanoseconds = now();
+    snapshot.bytesReceived = mBytesReceived.load(std::memory_order_relaxed);
+    snapshot.packetsReceived = mPacketsReceived.load(std::memory_order_relaxed);
+    snapshot.framesDelivered = mFramesDelivered.load(std::memory_order_relaxed);
+    snapshot.packetsLost = packetsLost;
+    snapshot.packetsReordered = packetsReordered;
+    snapshot.jitterSeconds = 0;
+    snapshot.fractionLost = 0;
+    snapshot.state = static_cast<RtspClientState>(mState.load(std::memory_order_relaxed));
+
+    uint64_t connects = mConnects.load(std::memory_order_relaxed);
+    snapshot.reconnects = connects > 0 ? connects - 1 : 0;
+
+    uint64_t connected = mConnectNanoseconds.load(std::memory_order_relaxed);
+    uint64_t firstFrame = mFirstFrameNanoseconds.load(std::memory_order_relaxed);
+    snapshot.timeToFirstFrameSeconds = (firstFrame != 0 and firstFrame >= connected) ?
+        (firstFrame - connected) / NANOSECONDS_PER_SECOND :
+        -1;
+
+    snapshot.framesPerSecond = 0;
+    snapshot.bitsPerSecond = 0;
+    if (window == nullptr)
+        return snapshot;
+    
+    if (window->nanoseconds != 0 and snapshot.nanoseconds > window->nanoseconds)
+    {
+        double elapsed = (snapshot.nanoseconds - window->nanoseconds) / NANOSECONDS_PER_SECOND;
+        snapshot.framesPerSecond = (snapshot.framesDelivered - window->framesDelivered) / elapsed;
+        snapshot.bitsPerSecond = (snapshot.bytesReceived - window->bytesReceived) * 8 / elapsed;
+    }
+    
+    window->nanoseconds = snapshot.nanoseconds;
+    window->bytesReceived = snapshot.bytesReceived;
+    window->framesDelivered = snapshot.framesDelivered;
+    
+    return snapshot;
+}
@@ -0,0 +1,126 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __SESSION_METRICS_H__
+#define __SESSION_METRICS_H__
+
+#include "IRtspDelegate.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Overflow
+{
+    struct SessionMetricsSnapshot
+    {
+        uint64_t bytesReceived;
+        uint64_t packetsReceived;
+        uint64_t framesDelivered;
+        uint64_t packetsLost;
+        uint64_t packetsReordered;
+        uint64_t reconnects;
+        // steady clock time the counters were read at
+        uint64_t nanoseconds;
+        // since the window passed to snapshot, 0 without one
+        double framesPerSecond;
+        double bitsPerSecond;
+        // -1 until the first frame of the current connection
+        double timeToFirstFrameSeconds;
+        // RFC 3550 interarrival jitter and the loss fraction of the last
+        // receiver report, filled in by the controller
+        double jitterSeconds;
+        double fractionLost;
+        RtspClientState state;
+    };
+
+    // Where the previous look left off, one per reader so that a second
+    // scraper does not shorten the rate window of the first.
+    struct SessionMetricsWindow
+    {
+        SessionMetricsWindow()
+            : nanoseconds(0),
+              bytesReceived(0),
+              framesDelivered(0)
+        { }
+
+        uint64_t nanoseconds;
+        uint64_t bytesReceived;
+        uint64_t framesDelivered;
+    };
+    
+    // Counters for one session. Only the event-loop thread writes them so
+    // the hot path is a relaxed load and store per counter; readers take
+    // snapshot() from any thread. Packet and frame counters sit on their own
+    // cache line away from the ones readers and the control path touch.
+    class SessionMetrics
+    {
+    public:
+        SessionMetrics();
+
+        void onPacket(size_t bytes)
+        {
+            increment(mBytesReceived, bytes);
+            increment(mPacketsReceived, 1);
+        }
+
+        void onFrame()
+        {
+            increment(mFramesDelivered, 1);
+            if (mFirstFrameNanoseconds.load(std::memory_order_relaxed) == 0)
+                mFirstFrameNanoseconds.store(now(), std::memory_order_relaxed);
+        }
+
+        void onStateChange(RtspClientState state);
+
+        // counters only ever go up, rates are worked out against window
+        // which then moves on to this snapshot. The first look through a
+        // fresh window has no rate yet.
+        SessionMetricsSnapshot snapshot(uint64_t packetsLost,
+                                        uint64_t packetsReordered,
+                                        SessionMetricsWindow* window = nullptr);
+
+        static uint64_t now();
+        
+    private:
+        static void increment(std::atomic<uint64_t>& counter, uint64_t count)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + count,
+                          std::memory_order_relaxed);
+        }
+        
+        // padding rather than alignas keeps the owner allocatable with a
+        // plain new under c++11 while still splitting the cache lines
+        char mPaddingBefore[64];
+        std::atomic<uint64_t> mBytesReceived;
+        std::atomic<uint64_t> mPacketsReceived;
+        std::atomic<uint64_t> mFramesDelivered;
+        std::atomic<uint64_t> mFirstFrameNanoseconds;
+
+        char mPaddingHot[64];
+        std::atomic<uint64_t> mConnects;
+        std::atomic<uint64_t> mConnectNanoseconds;
+        std::atomic<int> mState;
+    };
+};
+
+#endif //__SESSION_METRICS_H__
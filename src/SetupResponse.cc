@@ -31,6 +31,10 @@ Overflow::SetupResponse::SetupResponse(const Response* resp)
       mIsInterleaved(false),
       mRtpInterleavedChannel(0),
       mRtcpInterleavedChannel(1),
+      mRtpServerPort(-1),
+      mRtcpServerPort(-1),
+      mRtpClientPort(-1),
+      mRtcpClientPort(-1),
       mTimeout(60)
 {
     const std::string session_header = headerValueForKey("Session");
@@ -70,6 +74,19 @@ Overflow::SetupResponse::SetupResponse(const Response* resp)
     delim[0] = ';';
     values = Helper::stringSplit(transport_header, std::string((const char *)delim));
     std::string value = Helper::findKeyAndValuePair(&values, "interleaved");
+    std::string server_port = Helper::findKeyAndValuePair(&values, "server_port");
+    std::string client_port = Helper::findKeyAndValuePair(&values, "client_port");
+    std::string source = Helper::findKeyAndValuePair(&values, "source");
+
+    parsePortRange(server_port, &mRtpServerPort, &mRtcpServerPort);
+    parsePortRange(client_port, &mRtpClientPort, &mRtcpClientPort);
+    
+    if (not source.empty())
+    {
+        size_t offset = source.find('=');
+        if (offset != std::string::npos)
+            mSource = source.substr(offset + 1);
+    }
     
     if (!value.empty()) {
         mIsInterleaved = true;
@@ -83,3 +100,20 @@ Overflow::SetupResponse::SetupResponse(const Response* resp)
         mRtcpInterleavedChannel = atoi(values[1].c_str());
     }
 }
+
+void
+Overflow::SetupResponse::parsePortRange(const std::string& value, int *rtp, int *rtcp)
+{
+    // key=rtp[-rtcp], rtcp defaults to the next port up
+    size_t offset = value.find('=');
+    if (offset == std::string::npos)
+        return;
+
+    std::vector<std::string> ports =
+        Helper::stringSplit(value.substr(offset + 1), std::string("-"));
+    if (ports.empty() or ports[0].empty())
+        return;
+
+    *rtp = atoi(ports[0].c_str());
+    *rtcp = (ports.size() > 1) ? atoi(ports[1].c_str()) : *rtp + 1;
+}
@@ -41,12 +41,29 @@ namespace Overflow
         int getTimeoutSeconds() const { return mTimeout; }
         
         bool isInterleaved() const { return mIsInterleaved; }
+
+        // udp unicast, -1 when the server did not say
+        int getRtpServerPort() const { return mRtpServerPort; }
+
+        int getRtcpServerPort() const { return mRtcpServerPort; }
+
+        int getRtpClientPort() const { return mRtpClientPort; }
+
+        int getRtcpClientPort() const { return mRtcpClientPort; }
+
+        const std::string getSource() const { return mSource; }
         
     private:
+        static void parsePortRange(const std::string& value, int *rtp, int *rtcp);
         
         bool mIsInterleaved;
         int mRtpInterleavedChannel;
         int mRtcpInterleavedChannel;
+        int mRtpServerPort;
+        int mRtcpServerPort;
+        int mRtpClientPort;
+        int mRtcpClientPort;
+        std::string mSource;
         std::string mSession;
         int mTimeout;
     };
@@ -23,8 +23,12 @@
 #define __TRANSPORT_H__
 
 #include "ITransportDelegate.h"
-#include "RtpPacket.h"
+#include "RtpPacketView.h"
 #include "Response.h"
+#include "SetupResponse.h"
+
+#include <functional>
+#include <string>
 
 
 namespace Overflow
@@ -48,11 +52,21 @@ namespace Overflow
                                const size_t length,
                                int seconds) = 0;
 
+        // compound rtcp back to the server, dropped when there is no path
+        virtual void writeRtcp(const unsigned char *buffer,
+                               const size_t length) { }
+
         virtual std::string getTransportHeaderString() const = 0;
 
+        // whatever the server settled on in its SETUP reply
+        virtual void setup(const SetupResponse* response) { }
+
+        // both run on the event-loop thread and return straight away
         virtual void start() = 0;
 
-        virtual void stop() = 0;
+        // onStopped fires once every handle is closed, the transport can
+        // be deleted from then on but not from within the callback itself
+        virtual void stop(const std::function<void ()>& onStopped) = 0;
 
     protected:
         void onStateChange(TransportState state)
@@ -62,11 +76,16 @@ namespace Overflow
             notifyDelegateStateChange(oldState, mState);
         }
 
-        void onRtpPacket(const RtpPacket* packet)
+        void onRtpPacket(const RtpPacketView* packet)
         {
             notifyDelegateOfRtpPacket(packet);
         }
 
+        void onRtcpPacket(const RtcpPacket* packet)
+        {
+            notifyDelegateOfRtcpPacket(packet);
+        }
+
         void onRtspResponse(const Response* response)
         {
             notifyDelegateOfRtspResponse(response);
@@ -86,7 +105,7 @@ namespace Overflow
             }
         }
 
-        void notifyDelegateOfRtpPacket(const RtpPacket* packet)
+        void notifyDelegateOfRtpPacket(const RtpPacketView* packet)
         {
             if (mDelegate != nullptr)
             {
@@ -94,6 +113,14 @@ namespace Overflow
             }   
         }
 
+        void notifyDelegateOfRtcpPacket(const RtcpPacket* packet)
+        {
+            if (mDelegate != nullptr)
+            {
+                mDelegate->onRtcpPacket(packet);
+            }
+        }
+
         void notifyDelegateOfRtspResponse(const Response* response)
         {
             if (mDelegate != nullptr)
@@ -21,69 +21,89 @@
 #include "TransportController.h"
 
 #include <chrono>
+#include <cstdlib>
+#include <stdexcept>
 #include <glog/logging.h>
 
+// RFC 3550 asks for 5 seconds as the minimum between reports
+#define RTCP_REPORT_INTERVAL_MS 5000
 
-Overflow::TransportController::TransportController ()
-    : mLoop (false),
-      mKeepAliveTimer (mLoop),
-      mReconnectTimer (mLoop),
-      
-      mStopEventLoopHandler([&]() { stopEventLoop(); }),
-      mReconnectHandler([&]() { startReconnectTimer(); }),
-      mStopTransportHandler([&]() { stopTransport(); }),
-      mEventLoopHandler([&]() { eventLoopMain(); }),
-      mTransportLoopHandler([&]() { transportLoopMain(); }),
-      
-      mStopEventLoop(mLoop, mStopEventLoopHandler),
-      mReconnect(mLoop, mReconnectHandler),
-      mStopTransport(mLoop, mStopTransportHandler),
-      
-      mIsReconnecting(false),
-      mTransport(nullptr),
-      mEventLoop(nullptr),
-      mTransportLoop(nullptr)
+
+Overflow::TransportController::TransportController (EventLoop* loop)
+    : mEventLoop (loop != nullptr ? loop : new EventLoop ()),
+      mOwnsEventLoop (loop == nullptr),
+      mKeepAliveTimer (nullptr),
+      mReconnectTimer (nullptr),
+      mReportTimer (nullptr),
+      mExpiryTimer (nullptr),
+      mPendingCloses (0),
+      mIsReconnecting (false),
+      mTransport (nullptr),
+      mIsRunning (false),
+      mIsStopped (true)
 {
+    mEventLoop->attach ();
 }
 
 Overflow::TransportController::~TransportController ()
 {
+    // handles and timers are still live on the loop, freeing them from
+    // one of its own callbacks could only end in a use-after-free
+    if (mEventLoop->isInLoopThread ())
+    {
+        LOG(FATAL) << "transport-controller destroyed from its own event-loop thread";
+        std::abort ();
+    }
+
     stop ();
     join ();
+    
+    mEventLoop->detach ();
+    if (mOwnsEventLoop)
+        delete mEventLoop;
 }
 
 void
 Overflow::TransportController::start ()
 {
-    startTransport ();
-    
-    if (not isRunning())
-        mEventLoop = new std::thread (mEventLoopHandler);
+    if (mOwnsEventLoop)
+        mEventLoop->start ();
+
+    if (mIsRunning.exchange (true))
+    {
+        // already up, this is a restart after standby
+        runOnEventLoop ([&]() { startTransport (); });
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock (mStoppedMutex);
+        mIsStopped = false;
+    }
+    runOnEventLoop ([&]() { onStart (); });
 }
 
 void
 Overflow::TransportController::stop ()
 {
-    if (isRunning ())
-        mStopEventLoop.send();
+    if (mIsRunning.exchange (false))
+        runOnEventLoop ([&]() { onStop (); });
 }
 
 void
 Overflow::TransportController::join ()
 {
-    if (not isRunning ())
-        return;
-
-    mEventLoop->join ();
+    if (mEventLoop->isInLoopThread ())
+        throw std::runtime_error ("join from the event-loop thread would never return");
     
-    delete mEventLoop;
-    mEventLoop = nullptr;
+    std::unique_lock<std::mutex> lock (mStoppedMutex);
+    mStoppedCondition.wait (lock, [&]() { return mIsStopped; });
 }
 
 bool
 Overflow::TransportController::isRunning () const
 {
-    return mEventLoop != nullptr and mEventLoop->joinable();
+    return mIsRunning.load ();
 }
 
 bool
@@ -93,39 +113,99 @@ Overflow::TransportController::isConnected () const
 }
 
 void
-Overflow::TransportController::stopTransport ()
+Overflow::TransportController::runOnEventLoop (const std::function<void ()>& task)
 {
-    if (mTransport != nullptr)
-    {
-        mTransport->stop ();        
-        mTransportLoop->join ();
-        
-        delete mTransportLoop;
-        delete mTransport;
+    mEventLoop->post (task);
+}
 
-        mTransport = nullptr;
-        mTransportLoop = nullptr;
-    }
+uvpp::loop&
+Overflow::TransportController::getEventLoop ()
+{
+    return mEventLoop->getLoop ();
 }
 
 void
-Overflow::TransportController::stopTransportAsync ()
+Overflow::TransportController::onStart ()
 {
-    mStopTransport.send ();
+    // handles are created on the loop thread as the loop may be shared
+    if (mKeepAliveTimer == nullptr)
+        mKeepAliveTimer = new uvpp::Timer (getEventLoop ());
+    if (mReconnectTimer == nullptr)
+        mReconnectTimer = new uvpp::Timer (getEventLoop ());
+    if (mReportTimer == nullptr)
+        mReportTimer = new uvpp::Timer (getEventLoop ());
+    if (mExpiryTimer == nullptr)
+        mExpiryTimer = new uvpp::Timer (getEventLoop ());
+    
+    startTransport ();
 }
 
 void
-Overflow::TransportController::startTransport ()
+Overflow::TransportController::onStop ()
+{
+    LOG(INFO) << "stopping transport-controller";
+    
+    stopTransport ();
+    mIsReconnecting = false;
+
+    mPendingCloses = 4;
+    auto onClose = [&]() {
+        if (--mPendingCloses == 0)
+            runOnEventLoop ([&]() { onStopped (); });
+    };
+    mKeepAliveTimer->close (onClose);
+    mReconnectTimer->close (onClose);
+    mReportTimer->close (onClose);
+    mExpiryTimer->close (onClose);
+}
+
+void
+Overflow::TransportController::onStopped ()
+{
+    delete mKeepAliveTimer;
+    delete mReconnectTimer;
+    delete mReportTimer;
+    delete mExpiryTimer;
+    mKeepAliveTimer = nullptr;
+    mReconnectTimer = nullptr;
+    mReportTimer = nullptr;
+    mExpiryTimer = nullptr;
+    
+    LOG(INFO) << "stopped transport-controller";
+
+    std::lock_guard<std::mutex> lock (mStoppedMutex);
+    mIsStopped = true;
+    mStoppedCondition.notify_all ();
+}
+
+void
+Overflow::TransportController::stopTransport ()
+{
+    if (mTransport == nullptr)
+        return;
+
+    // the transport goes once its handles are closed, this may be well
+    // after the controller has gone so nothing of ours is captured
+    Transport* transport = mTransport;
+    EventLoop* loop = mEventLoop;
+    mTransport = nullptr;
+    
+    transport->stop ([transport, loop]() {
+            loop->post ([transport]() { delete transport; });
+        });
+}
+
+void
+Overflow::TransportController::stopTransportAsync ()
 {
-    if (mTransportLoop == nullptr)
-        mTransportLoop = new std::thread (mTransportLoopHandler);
+    runOnEventLoop ([&]() { stopTransport (); });
 }
 
 void
-Overflow::TransportController::transportLoopMain ()
+Overflow::TransportController::startTransport ()
 {
-    auto transportThreadId = std::this_thread::get_id();
-    LOG(INFO) << "starting transport on: "<< transportThreadId;
+    if (mTransport != nullptr or not isRunning ())
+        return;
     
     mTransport = createTransport ();
     mTransport->start ();
@@ -134,12 +214,15 @@ Overflow::TransportController::transportLoopMain ()
 void
 Overflow::TransportController::startReconnectTimer ()
 {
+    if (not isRunning ())
+        return;
+    
     LOG(INFO) << "starting-reconnect-timer";
     
     uint64_t timeout = 3 * 1000;
     mIsReconnecting = true;
     
-    mReconnectTimer.start([&]() { 
+    mReconnectTimer->start([&]() { 
             startTransport ();
         },
         std::chrono::duration<uint64_t, std::milli>(timeout),
@@ -170,62 +253,86 @@ Overflow::TransportController::stopReconnectTimer ()
     LOG(INFO) << "stopping reconnect timer";
     
     mIsReconnecting = false;
-    mReconnectTimer.stop ();
+    if (mReconnectTimer != nullptr)
+        mReconnectTimer->stop ();
 }
 
 void
 Overflow::TransportController::reconnect ()
 {
-    mReconnect.send ();
+    runOnEventLoop ([&]() { startReconnectTimer (); });
+}
+        
+void
+Overflow::TransportController::setupTransport (const SetupResponse* response)
+{
+    if (mTransport != nullptr)
+        mTransport->setup (response);
 }
 
 void
-Overflow::TransportController::eventLoopMain ()
+Overflow::TransportController::sendRtspBytes (const unsigned char* buffer,
+                                              size_t length,
+                                              int timeout)
 {
-    auto eventThreadId = std::this_thread::get_id();
-    LOG(INFO) << "starting event-loop on: " << eventThreadId;
-    mLoop.run ();
+    mTransport->writeRtsp (buffer, length, timeout);
+}
 
-    // lbuv task.h make_valgrind_happy
-    uv_walk (mLoop.get (), closeWalkCb, NULL);
-    uv_run (mLoop.get (), UV_RUN_DEFAULT);
+void
+Overflow::TransportController::sendRtcpBytes (const unsigned char* buffer,
+                                              size_t length)
+{
+    if (mTransport != nullptr)
+        mTransport->writeRtcp (buffer, length);
 }
 
 void
-Overflow::TransportController::stopEventLoop ()
+Overflow::TransportController::startReportTimer ()
 {
-    LOG(INFO) << "stopping event-loop";
+    if (mReportTimer == nullptr)
+        return;
     
-    stopTransport ();
-    mReconnectTimer.stop ();
-    mKeepAliveTimer.stop ();
-    mLoop.stop ();
+    uint64_t timeout = RTCP_REPORT_INTERVAL_MS;
     
-    LOG(INFO) << "stopped event-loop core";   
+    mReportTimer->start([&]() { onReport (); },
+        std::chrono::duration<uint64_t, std::milli>(timeout),
+        std::chrono::duration<uint64_t, std::milli>(timeout));
 }
-        
+
 void
-Overflow::TransportController::sendRtspBytes (const unsigned char* buffer,
-                                              size_t length,
-                                              int timeout)
+Overflow::TransportController::stopReportTimer ()
 {
-    mTransport->writeRtsp (buffer, length, timeout);
+    if (mReportTimer != nullptr)
+        mReportTimer->stop ();
 }
 
 void
-Overflow::TransportController::startKeepAliveTimer (int seconds)
+Overflow::TransportController::startExpiryTimer (int milliseconds)
 {
-    // trim a few seconds to ensure keep-alive is sent in time
-    uint64_t timeout = (seconds - 5) * 1000;
+    if (mExpiryTimer == nullptr or milliseconds <= 0)
+        return;
     
-    mKeepAliveTimer.start([&]() { onKeepAlive (); },
+    uint64_t timeout = milliseconds;
+    
+    mExpiryTimer->start([&]() { onExpiryTimer (); },
         std::chrono::duration<uint64_t, std::milli>(timeout),
         std::chrono::duration<uint64_t, std::milli>(timeout));
 }
 
 void
-Overflow::TransportController::closeWalkCb (uv_handle_t* handle, void* arg)
+Overflow::TransportController::stopExpiryTimer ()
+{
+    if (mExpiryTimer != nullptr)
+        mExpiryTimer->stop ();
+}
+
+void
+Overflow::TransportController::startKeepAliveTimer (int seconds)
 {
-    if (!uv_is_closing (handle))
-        uv_close (handle, NULL);
+    // trim a few seconds to ensure keep-alive is sent in time
+    uint64_t timeout = (seconds - 5) * 1000;
+    
+    mKeepAliveTimer->start([&]() { onKeepAlive (); },
+        std::chrono::duration<uint64_t, std::milli>(timeout),
+        std::chrono::duration<uint64_t, std::milli>(timeout));
 }
@@ -28,10 +28,12 @@
 #include "InterleavedTcpTransport.h"
 #include "RtspFactory.h"
 #include "SessionDescription.h"
+#include "EventLoop.h"
 
 #include <string>
-#include <thread>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
 
 
 namespace Overflow
@@ -39,7 +41,9 @@ namespace Overflow
     class TransportController
     {
     public:
-        TransportController ();
+        // without a loop the controller runs one of its own, pass one from
+        // an EventLoopGroup to share threads between many clients
+        TransportController (EventLoop* loop = nullptr);
 
         virtual ~TransportController ();
 
@@ -47,6 +51,9 @@ namespace Overflow
 
         void stop ();
 
+        // waits for stop to finish, throws when called from the loop thread
+        // as it would never return. Destroying a controller from its loop
+        // thread aborts for the same reason.
         void join ();
 
         bool isRunning () const;
@@ -65,51 +72,68 @@ namespace Overflow
         void startTransport ();
 
         void startReconnectTimer ();
-        
-        void eventLoopMain ();
-
-        void transportLoopMain ();
-        
-        void stopEventLoop ();
 
         void stopReconnectTimer ();
         
+        void setupTransport (const SetupResponse* response);
+
         void sendRtspBytes (const unsigned char* buffer,
                             size_t length,
                             int timeout);
         
+        void sendRtcpBytes (const unsigned char* buffer,
+                            size_t length);
+        
         void startKeepAliveTimer (int seconds);
 
+        // repeats every few seconds until the controller stops
+        void startReportTimer ();
+
+        void stopReportTimer ();
+
+        // repeats every milliseconds until stopped, see onExpiryTimer
+        void startExpiryTimer (int milliseconds);
+
+        void stopExpiryTimer ();
+
         void onTransportConnected ();
 
         void reconnect ();
 
+        void runOnEventLoop (const std::function<void ()>& task);
+
+        uvpp::loop& getEventLoop ();
+
         virtual void onKeepAlive() = 0;
 
+        virtual void onReport() { }
+
+        virtual void onExpiryTimer() { }
+
         virtual Transport* createTransport () = 0;
 
     private:
+        void onStart ();
+
+        void onStop ();
+
+        void onStopped ();
         
-        static void closeWalkCb (uv_handle_t* handle, void* arg);
-        
-        uvpp::loop mLoop;
-        uvpp::Timer mKeepAliveTimer;
-        uvpp::Timer mReconnectTimer;
-
-        std::function<void ()> mStopEventLoopHandler;
-        std::function<void ()> mReconnectHandler;
-        std::function<void ()> mStopTransportHandler;
-        std::function<void ()> mEventLoopHandler;
-        std::function<void ()> mTransportLoopHandler;
-        
-        uvpp::Async mStopEventLoop;
-        uvpp::Async mReconnect;
-        uvpp::Async mStopTransport;
+        EventLoop* mEventLoop;
+        bool mOwnsEventLoop;
+        uvpp::Timer* mKeepAliveTimer;
+        uvpp::Timer* mReconnectTimer;
+        uvpp::Timer* mReportTimer;
+        uvpp::Timer* mExpiryTimer;
+        int mPendingCloses;
 
         bool mIsReconnecting;
         Transport* mTransport;
-        std::thread* mEventLoop;
-        std::thread* mTransportLoop;
+
+        std::atomic<bool> mIsRunning;
+        bool mIsStopped;
+        std::mutex mStoppedMutex;
+        std::condition_variable mStoppedCondition;
     };
 };
 
@@ -0,0 +1,300 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "UdpSocket.h"
+
+#include <glog/logging.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+// largest datagram udp can carry, rtp senders are free to go past the
+// path mtu and leave fragmentation to ip
+#define UDP_DATAGRAM_SIZE 65535
+
+// datagrams per recvmmsg
+#define UDP_BATCH_SIZE 32
+
+// batches per wakeup so one busy camera cannot starve the rest of the loop
+#define UDP_MAX_BATCHES_PER_POLL 8
+
+#define UDP_RECEIVE_BUFFER_SIZE (2 * 1024 * 1024)
+
+#define UDP_PORT_PAIR_ATTEMPTS 16
+
+
+Overflow::UdpSocket::UdpSocket()
+    : mFd(-1),
+      mPort(-1),
+      mPoll(nullptr),
+      mIsSourceFiltered(false),
+      mRejected(0),
+      // left uninitialised so only the pages datagrams land in are touched,
+      // a batch of mtu sized packets commits a page or so per slot
+      mBuffers(new unsigned char[UDP_BATCH_SIZE * UDP_DATAGRAM_SIZE])
+{
+    memset(&mExpectedSource, 0, sizeof(mExpectedSource));
+}
+
+Overflow::UdpSocket::~UdpSocket()
+{
+    // the poll handle must already be closed by now
+    closeSocket();
+    delete[] mBuffers;
+}
+
+bool
+Overflow::UdpSocket::bind(int port)
+{
+    closeSocket();
+    
+    mFd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (mFd < 0)
+    {
+        LOG(ERROR) << "udp socket: " << strerror(errno);
+        return false;
+    }
+
+    int flags = fcntl(mFd, F_GETFL, 0);
+    fcntl(mFd, F_SETFL, flags | O_NONBLOCK);
+    fcntl(mFd, F_SETFD, FD_CLOEXEC);
+
+    // best effort, the kernel may clamp it
+    int receiveBufferSize = UDP_RECEIVE_BUFFER_SIZE;
+    setsockopt(mFd, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+    
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (::bind(mFd, (struct sockaddr*)&address, sizeof(address)) != 0)
+    {
+        closeSocket();
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(mFd, (struct sockaddr*)&address, &length);
+    mPort = ntohs(address.sin_port);
+    
+    return true;
+}
+
+bool
+Overflow::UdpSocket::bindPortPair(UdpSocket* rtp, UdpSocket* rtcp, int basePort)
+{
+    for (int attempt = 0; attempt < UDP_PORT_PAIR_ATTEMPTS; ++attempt)
+    {
+        int port = (basePort > 0) ? (basePort & ~1) + (attempt * 2) : 0;
+        if (not rtp->bind(port))
+            continue;
+
+        if ((rtp->getPort() % 2) == 0 and rtcp->bind(rtp->getPort() + 1))
+            return true;
+        
+        rtp->closeSocket();
+    }
+    return false;
+}
+
+void
+Overflow::UdpSocket::setExpectedSource(const struct sockaddr_in& address)
+{
+    mExpectedSource = address;
+    mIsSourceFiltered = true;
+}
+
+bool
+Overflow::UdpSocket::isExpectedSource(const struct sockaddr_in& from) const
+{
+    if (not mIsSourceFiltered)
+        return true;
+    
+    if (from.sin_family != AF_INET
+        or from.sin_addr.s_addr != mExpectedSource.sin_addr.s_addr)
+        return false;
+
+    return mExpectedSource.sin_port == 0 or from.sin_port == mExpectedSource.sin_port;
+}
+
+bool
+Overflow::UdpSocket::startReading(uv_loop_t* loop)
+{
+    if (not isOpen() or mPoll != nullptr)
+        return false;
+    
+    mPoll = new uv_poll_t;
+    mPoll->data = this;
+    
+    if (uv_poll_init_socket(loop, mPoll, mFd) != 0)
+    {
+        delete mPoll;
+        mPoll = nullptr;
+        return false;
+    }
+    
+    return uv_poll_start(mPoll, UV_READABLE, pollCb) == 0;
+}
+
+#ifdef __linux__
+size_t
+Overflow::UdpSocket::drain()
+{
+    struct mmsghdr messages[UDP_BATCH_SIZE];
+    struct iovec vectors[UDP_BATCH_SIZE];
+    struct sockaddr_in senders[UDP_BATCH_SIZE];
+    
+    memset(messages, 0, sizeof(messages));
+    for (size_t i = 0; i < UDP_BATCH_SIZE; ++i)
+    {
+        vectors[i].iov_base = &mBuffers[i * UDP_DATAGRAM_SIZE];
+        vectors[i].iov_len = UDP_DATAGRAM_SIZE;
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &senders[i];
+    }
+
+    size_t delivered = 0;
+    for (int batch = 0; batch < UDP_MAX_BATCHES_PER_POLL; ++batch)
+    {
+        // recvmmsg writes the sender length back, so reset it every batch
+        for (size_t i = 0; i < UDP_BATCH_SIZE; ++i)
+            messages[i].msg_hdr.msg_namelen = sizeof(senders[i]);
+        
+        int received = recvmmsg(mFd, messages, UDP_BATCH_SIZE, MSG_DONTWAIT, NULL);
+        if (received <= 0)
+            break;
+
+        for (int i = 0; i < received; ++i)
+        {
+            if (messages[i].msg_hdr.msg_flags & MSG_TRUNC)
+            {
+                LOG(ERROR) << "dropping truncated datagram on port: " << mPort;
+                continue;
+            }
+
+            if (not isExpectedSource(senders[i]))
+            {
+                mRejected++;
+                continue;
+            }
+            
+            mHandler((const unsigned char*)vectors[i].iov_base, messages[i].msg_len);
+            delivered++;
+        }
+
+        if (received < UDP_BATCH_SIZE)
+            break;
+    }
+    return delivered;
+}
+#else
+size_t
+Overflow::UdpSocket::drain()
+{
+    size_t delivered = 0;
+    for (int i = 0; i < UDP_BATCH_SIZE * UDP_MAX_BATCHES_PER_POLL; ++i)
+    {
+        struct sockaddr_in sender;
+        socklen_t senderLength = sizeof(sender);
+        ssize_t received = recvfrom(mFd, mBuffers, UDP_DATAGRAM_SIZE, MSG_DONTWAIT,
+                                    (struct sockaddr*)&sender, &senderLength);
+        if (received < 0)
+            break;
+
+        if (not isExpectedSource(sender))
+        {
+            mRejected++;
+            continue;
+        }
+        
+        mHandler(mBuffers, static_cast<size_t>(received));
+        delivered++;
+    }
+    return delivered;
+}
+#endif
+
+bool
+Overflow::UdpSocket::sendTo(const struct sockaddr* address,
+                            const unsigned char* buffer,
+                            size_t length)
+{
+    socklen_t addressLength = (address->sa_family == AF_INET6) ?
+        sizeof(struct sockaddr_in6) :
+        sizeof(struct sockaddr_in);
+    
+    return ::sendto(mFd, buffer, length, 0, address, addressLength) == (ssize_t)length;
+}
+
+void
+Overflow::UdpSocket::close(const std::function<void ()>& onClosed)
+{
+    if (mPoll == nullptr)
+    {
+        closeSocket();
+        onClosed();
+        return;
+    }
+
+    mOnClosed = onClosed;
+    uv_poll_stop(mPoll);
+    uv_close((uv_handle_t*)mPoll, closeCb);
+}
+
+void
+Overflow::UdpSocket::closeSocket()
+{
+    if (mFd >= 0)
+        ::close(mFd);
+    mFd = -1;
+    mPort = -1;
+}
+
+void
+Overflow::UdpSocket::pollCb(uv_poll_t* handle, int status, int events)
+{
+    UdpSocket* self = static_cast<UdpSocket*>(handle->data);
+    if (status < 0)
+    {
+        LOG(ERROR) << "udp poll error on port: " << self->mPort;
+        return;
+    }
+    
+    if (events & UV_READABLE)
+        self->drain();
+}
+
+void
+Overflow::UdpSocket::closeCb(uv_handle_t* handle)
+{
+    UdpSocket* self = static_cast<UdpSocket*>(handle->data);
+    delete (uv_poll_t*)handle;
+    
+    self->mPoll = nullptr;
+    self->closeSocket();
+    self->mOnClosed();
+}
@@ -0,0 +1,104 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __UDP_SOCKET_H__
+#define __UDP_SOCKET_H__
+
+#include <functional>
+#include <cstddef>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+
+namespace Overflow
+{
+    // Non-blocking udp socket polled on the event loop. Readable sockets
+    // are drained in batches of datagrams, one recvmmsg per batch where
+    // the platform has it.
+    class UdpSocket
+    {
+    public:
+        typedef std::function<void (const unsigned char* buffer, size_t length)> DatagramHandler;
+        
+        UdpSocket();
+
+        ~UdpSocket();
+
+        // port 0 picks an ephemeral port
+        bool bind(int port);
+
+        bool isOpen() const { return mFd >= 0; }
+        
+        int getPort() const { return mPort; }
+
+        void setHandler(const DatagramHandler& handler) { mHandler = handler; }
+
+        // only datagrams from this sender reach the handler from now on,
+        // a port of 0 takes any port on that host
+        void setExpectedSource(const struct sockaddr_in& address);
+
+        // datagrams dropped for coming from someone else
+        size_t getRejectedCount() const { return mRejected; }
+
+        // polls on the loop thread until close()
+        bool startReading(uv_loop_t* loop);
+
+        // reads until the socket would block, returns datagrams delivered
+        size_t drain();
+
+        bool sendTo(const struct sockaddr* address,
+                    const unsigned char* buffer,
+                    size_t length);
+        
+        // onClosed fires once the poll handle is gone
+        void close(const std::function<void ()>& onClosed);
+
+        // even rtp port with rtcp on the next one up, as RFC 3550 asks
+        static bool bindPortPair(UdpSocket* rtp, UdpSocket* rtcp, int basePort);
+
+    private:
+        UdpSocket(const UdpSocket&);
+
+        UdpSocket& operator=(const UdpSocket&);
+
+        void closeSocket();
+
+        bool isExpectedSource(const struct sockaddr_in& from) const;
+        
+        static void pollCb(uv_poll_t* handle, int status, int events);
+
+        static void closeCb(uv_handle_t* handle);
+
+        int mFd;
+        int mPort;
+        uv_poll_t* mPoll;
+        DatagramHandler mHandler;
+        bool mIsSourceFiltered;
+        struct sockaddr_in mExpectedSource;
+        size_t mRejected;
+        std::function<void ()> mOnClosed;
+        unsigned char *mBuffers;
+    };
+};
+
+#endif //__UDP_SOCKET_H__
@@ -0,0 +1,219 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "UdpTransport.h"
+
+#include <glog/logging.h>
+
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+Overflow::UdpTransport::UdpTransport(ITransportDelegate * const delegate,
+                                     uvpp::loop& loop,
+                                     const std::string& url,
+                                     int basePort)
+    : InterleavedTcpTransport (delegate, loop, url),
+      mBasePort (basePort),
+      mRtpServerPort (-1),
+      mRtcpServerPort (-1),
+      mIsSetup (false)
+{
+    mRtpSocket.setHandler([&](const unsigned char* buffer, size_t length) {
+            onRtpDatagram(buffer, length);
+        });
+    mRtcpSocket.setHandler([&](const unsigned char* buffer, size_t length) {
+            onRtcpDatagram(buffer, length);
+        });
+}
+
+std::string
+Overflow::UdpTransport::getTransportHeaderString() const
+{
+    char ports[32];
+    snprintf(ports, sizeof(ports), "%d-%d", mRtpSocket.getPort(), mRtcpSocket.getPort());
+    
+    return "RTP/AVP;unicast;client_port=" + std::string(ports);
+}
+
+void
+Overflow::UdpTransport::start()
+{
+    bool bound = UdpSocket::bindPortPair(&mRtpSocket, &mRtcpSocket, mBasePort)
+        and mRtpSocket.startReading(getLoop().get())
+        and mRtcpSocket.startReading(getLoop().get());
+    
+    if (not bound)
+    {
+        LOG(ERROR) << "failed to bind rtp/rtcp client ports";
+        onError(SOCKET_ERROR);
+        onStateChange(DISCONNECTED);
+        return;
+    }
+
+    LOG(INFO) << "rtp/rtcp client ports: "
+              << mRtpSocket.getPort() << "-" << mRtcpSocket.getPort();
+    
+    InterleavedTcpTransport::start();
+}
+
+void
+Overflow::UdpTransport::setup(const SetupResponse* response)
+{
+    mRtpServerPort = response->getRtpServerPort();
+    mRtcpServerPort = response->getRtcpServerPort();
+
+    // anyone can send to our ports, only take media from the server
+    struct sockaddr_in source;
+    if (getMediaSource(response->getSource(), &source))
+    {
+        expectSource(&mRtpSocket, source, mRtpServerPort);
+        expectSource(&mRtcpSocket, source, mRtcpServerPort);
+    }
+    else
+    {
+        LOG(WARNING) << "unknown media source, accepting datagrams from any sender";
+    }
+    mIsSetup = true;
+
+    // open the return path through any NAT in front of us
+    punchHole(&mRtpSocket, mRtpServerPort);
+    punchHole(&mRtcpSocket, mRtcpServerPort);
+}
+
+void
+Overflow::UdpTransport::writeRtcp(const unsigned char *buffer,
+                                  const size_t length)
+{
+    struct sockaddr_storage address;
+    if (isStopping() or not getServerAddress(mRtcpServerPort, &address))
+        return;
+
+    mRtcpSocket.sendTo((const struct sockaddr*)&address, buffer, length);
+}
+
+bool
+Overflow::UdpTransport::getServerAddress(int port, struct sockaddr_storage* address)
+{
+    // the server sends from the host we hold the rtsp connection to
+    if (port <= 0 or not getPeerAddress(address))
+        return false;
+
+    if (address->ss_family == AF_INET)
+        ((struct sockaddr_in*)address)->sin_port = htons(port);
+    else if (address->ss_family == AF_INET6)
+        ((struct sockaddr_in6*)address)->sin6_port = htons(port);
+    else
+        return false;
+    
+    return true;
+}
+
+bool
+Overflow::UdpTransport::getMediaSource(const std::string& source, struct sockaddr_in* address)
+{
+    memset(address, 0, sizeof(*address));
+    address->sin_family = AF_INET;
+
+    if (not source.empty() and inet_pton(AF_INET, source.c_str(), &address->sin_addr) == 1)
+        return true;
+
+    struct sockaddr_storage peer;
+    if (not getPeerAddress(&peer))
+        return false;
+
+    if (peer.ss_family == AF_INET)
+    {
+        address->sin_addr = ((struct sockaddr_in*)&peer)->sin_addr;
+        return true;
+    }
+
+    // the client ports are ipv4, a mapped peer is the only v6 we can hear from
+    const struct in6_addr& peer6 = ((struct sockaddr_in6*)&peer)->sin6_addr;
+    if (peer.ss_family == AF_INET6 and IN6_IS_ADDR_V4MAPPED(&peer6))
+    {
+        memcpy(&address->sin_addr, &peer6.s6_addr[12], 4);
+        return true;
+    }
+    
+    return false;
+}
+
+void
+Overflow::UdpTransport::expectSource(UdpSocket* socket, const struct sockaddr_in& source, int port)
+{
+    // without a server_port any port on the server host will do
+    struct sockaddr_in expected = source;
+    expected.sin_port = (port > 0) ? htons(port) : 0;
+    
+    socket->setExpectedSource(expected);
+}
+
+void
+Overflow::UdpTransport::punchHole(UdpSocket* socket, int port)
+{
+    struct sockaddr_storage address;
+    if (not getServerAddress(port, &address))
+        return;
+
+    static const unsigned char punch[] = { 0xCE, 0xFA, 0xED, 0xFE };
+    socket->sendTo((const struct sockaddr*)&address, punch, sizeof(punch));
+}
+
+void
+Overflow::UdpTransport::onRtpDatagram(const unsigned char* buffer, size_t length)
+{
+    // nothing is expected before setup says where it comes from
+    if (isStopping() or not mIsSetup)
+        return;
+    
+    try
+    {
+        RtpPacketView pack(buffer, length);
+        onRtpPacket(&pack);
+    }
+    catch (std::exception& e)
+    {
+        LOG(ERROR) << "dropping rtp-packet: " << e.what();
+    }
+}
+
+void
+Overflow::UdpTransport::onRtcpDatagram(const unsigned char* buffer, size_t length)
+{
+    if (isStopping() or not mIsSetup)
+        return;
+
+    onRtcpBytes(buffer, length);
+}
+
+void
+Overflow::UdpTransport::closeHandles()
+{
+    // counted before anything can complete
+    addPendingCloses(2);
+    InterleavedTcpTransport::closeHandles();
+    
+    mRtpSocket.close([&]() { onHandleClosed(); });
+    mRtcpSocket.close([&]() { onHandleClosed(); });
+}
@@ -0,0 +1,84 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __UDP_TRANSPORT_H__
+#define __UDP_TRANSPORT_H__
+
+#include "InterleavedTcpTransport.h"
+#include "UdpSocket.h"
+
+#include <string>
+
+
+namespace Overflow
+{
+    // RTSP stays on the tcp connection, RTP and RTCP arrive as unicast
+    // datagrams on a client port pair so a lost packet never stalls the
+    // ones behind it.
+    class UdpTransport: public InterleavedTcpTransport
+    {
+    public:
+        // basePort 0 lets the kernel pick the pair
+        UdpTransport(ITransportDelegate * const delegate,
+                     uvpp::loop& loop,
+                     const std::string& url,
+                     int basePort = 0);
+
+        std::string getTransportHeaderString() const override;
+
+        void start() override;
+
+        void setup(const SetupResponse* response) override;
+
+        void writeRtcp(const unsigned char *buffer,
+                       const size_t length) override;
+
+        int getRtpServerPort() const { return mRtpServerPort; }
+
+        int getRtcpServerPort() const { return mRtcpServerPort; }
+
+    protected:
+        void closeHandles() override;
+
+    private:
+        void onRtpDatagram(const unsigned char* buffer, size_t length);
+
+        void onRtcpDatagram(const unsigned char* buffer, size_t length);
+
+        bool getServerAddress(int port, struct sockaddr_storage* address);
+
+        // source= from the setup response, else the host of the rtsp connection
+        bool getMediaSource(const std::string& source, struct sockaddr_in* address);
+
+        void expectSource(UdpSocket* socket, const struct sockaddr_in& source, int port);
+
+        void punchHole(UdpSocket* socket, int port);
+        
+        int mBasePort;
+        UdpSocket mRtpSocket;
+        UdpSocket mRtcpSocket;
+        int mRtpServerPort;
+        int mRtcpServerPort;
+        bool mIsSetup;
+    };
+};
+
+#endif //__UDP_TRANSPORT_H__
@@ -0,0 +1,215 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "AllocationCounter.h"
+#include "ScriptedController.h"
+#include "MockStream.h"
+
+#include "InterleavedTcpReader.h"
+
+#include <string>
+#include <vector>
+
+// Steady state is after the first two gops, once every buffer has grown to
+// the largest frame it will see. Budgets are allocations on the event-loop
+// thread per packet and per delivered frame; lower them as allocations come
+// off the hot path, never raise them to make a test pass.
+#define WARMUP_FRAMES 50
+#define MEASURED_FRAMES 100
+
+#define H264_BUDGET_PER_PACKET 0
+#define H264_BUDGET_PER_FRAME 0
+#define H265_BUDGET_PER_PACKET 0
+#define H265_BUDGET_PER_FRAME 0
+#define MJPEG_BUDGET_PER_PACKET 0
+#define MJPEG_BUDGET_PER_FRAME 0
+#define MP4V_BUDGET_PER_PACKET 0
+#define MP4V_BUDGET_PER_FRAME 0
+#define INTERLEAVED_READER_BUDGET_PER_PACKET 0
+
+
+namespace
+{
+    class CountingDelegate: public OverflowTest::PlayingDelegate
+    {
+    public:
+        CountingDelegate() : frames(0) { }
+
+        void onPayload(const unsigned char*, const size_t) override { frames++; }
+
+        uint64_t frames;
+    };
+
+    struct Measurement
+    {
+        uint64_t allocations;
+        uint64_t packets;
+        uint64_t frames;
+    };
+
+    Measurement measureController(OverflowMock::MockCodec codec)
+    {
+        OverflowMock::MockStreamOptions options;
+        options.codec = codec;
+        OverflowMock::MockStream stream(options);
+        
+        // everything the loop will be handed is made up front
+        auto warmup = OverflowTest::makeFrames(&stream, WARMUP_FRAMES);
+        auto measured = OverflowTest::makeFrames(&stream, MEASURED_FRAMES);
+
+        Overflow::EventLoop loop;
+        loop.start();
+        
+        CountingDelegate delegate;
+        Measurement measurement;
+        {
+            OverflowTest::ScriptedController controller(&delegate, &loop, stream.getSessionDescription());
+            controller.start();
+            delegate.waitUntilPlaying();
+
+            controller.runOnLoop([&](OverflowTest::ScriptedTransport* transport) {
+                    for (auto& frame: warmup)
+                        transport->deliver(frame);
+
+                    uint64_t framesBefore = delegate.frames;
+                    measurement.packets = 0;
+                    
+                    OverflowTest::AllocationScope scope;
+                    for (auto& frame: measured)
+                    {
+                        transport->deliver(frame);
+                        measurement.packets += frame.size();
+                    }
+                    measurement.allocations = scope.allocations();
+                    measurement.frames = delegate.frames - framesBefore;
+                });
+        }
+        
+        loop.stop();
+        loop.join();
+        return measurement;
+    }
+
+    void assertBudget(const Measurement& measurement, double perPacket, double perFrame)
+    {
+        ASSERT_EQ((uint64_t)MEASURED_FRAMES, measurement.frames);
+        ASSERT_GT(measurement.packets, measurement.frames);
+
+        double allocationsPerPacket = measurement.allocations / (double)measurement.packets;
+        double allocationsPerFrame = measurement.allocations / (double)measurement.frames;
+        EXPECT_LE(allocationsPerPacket, perPacket) << measurement.allocations << " allocations";
+        EXPECT_LE(allocationsPerFrame, perFrame) << measurement.allocations << " allocations";
+    }
+
+    class NullReaderDelegate: public Overflow::IInterleavedReaderDelegate
+    {
+    public:
+        NullReaderDelegate() : packets(0) { }
+        
+        void onInterleavedPacket(int, const unsigned char*, size_t) override { packets++; }
+
+        void onRtspMessage(const unsigned char*, size_t,
+                           const Overflow::RtspResponseParser&) override { }
+
+        uint64_t packets;
+    };
+};
+
+
+TEST(ALLOCATION_BUDGET, COUNTER_SEES_HEAP_ALLOCATIONS)
+{
+    std::vector<std::string*> kept;
+    
+    OverflowTest::AllocationScope scope;
+    kept.reserve(8);
+    kept.push_back(new std::string(256, 'x'));
+    uint64_t allocations = scope.allocations();
+
+    for (auto string: kept)
+        delete string;
+    
+    // the reserve, the string and its buffer
+    ASSERT_EQ(3u, allocations);
+}
+
+TEST(ALLOCATION_BUDGET, H264)
+{
+    assertBudget(measureController(OverflowMock::MOCK_H264),
+                 H264_BUDGET_PER_PACKET, H264_BUDGET_PER_FRAME);
+}
+
+TEST(ALLOCATION_BUDGET, H265)
+{
+    // parameter sets and sei in an ap on key frames, slices as fu
+    assertBudget(measureController(OverflowMock::MOCK_H265),
+                 H265_BUDGET_PER_PACKET, H265_BUDGET_PER_FRAME);
+}
+
+TEST(ALLOCATION_BUDGET, MJPEG)
+{
+    assertBudget(measureController(OverflowMock::MOCK_MJPEG),
+                 MJPEG_BUDGET_PER_PACKET, MJPEG_BUDGET_PER_FRAME);
+}
+
+TEST(ALLOCATION_BUDGET, MP4V)
+{
+    assertBudget(measureController(OverflowMock::MOCK_MP4V),
+                 MP4V_BUDGET_PER_PACKET, MP4V_BUDGET_PER_FRAME);
+}
+
+TEST(ALLOCATION_BUDGET, INTERLEAVED_READER)
+{
+    OverflowMock::MockStream stream((OverflowMock::MockStreamOptions()));
+    auto frames = OverflowTest::makeFrames(&stream, WARMUP_FRAMES + MEASURED_FRAMES);
+
+    // as it comes off the socket, in reads that split packets anywhere
+    std::string wire;
+    for (auto& frame: frames)
+    {
+        for (auto& packet: frame)
+        {
+            wire += '$';
+            wire += (char)0;
+            wire += (char)(packet.size() >> 8);
+            wire += (char)(packet.size() & 0xFF);
+            wire.append((const char*)packet.data(), packet.size());
+        }
+    }
+    size_t half = wire.length() / 2;
+    const unsigned char* bytes = (const unsigned char*)wire.c_str();
+
+    NullReaderDelegate delegate;
+    Overflow::InterleavedTcpReader reader(&delegate);
+    for (size_t offset = 0; offset < half; offset += 1500)
+        reader.feed(bytes + offset, std::min<size_t>(1500, half - offset));
+
+    uint64_t packetsBefore = delegate.packets;
+    OverflowTest::AllocationScope scope;
+    for (size_t offset = half; offset < wire.length(); offset += 1500)
+        reader.feed(bytes + offset, std::min<size_t>(1500, wire.length() - offset));
+    uint64_t allocations = scope.allocations();
+
+    uint64_t packets = delegate.packets - packetsBefore;
+    ASSERT_GT(packets, 0u);
+    EXPECT_LE(allocations / (double)packets, INTERLEAVED_READER_BUDGET_PER_PACKET)
+        << allocations << " allocations";
+}
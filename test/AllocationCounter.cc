@@ -0,0 +1,160 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#define OVERFLOW_INTERPOSE_MALLOC 1
+#endif
+
+
+static std::atomic<uint64_t> gAllocations(0);
+
+// trivially constructible so touching it from inside malloc never allocates
+static thread_local uint64_t tAllocations = 0;
+
+static inline void countAllocation()
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    tAllocations++;
+}
+
+
+uint64_t
+OverflowTest::AllocationCounter::allocations()
+{
+    return gAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t
+OverflowTest::AllocationCounter::threadAllocations()
+{
+    return tAllocations;
+}
+
+#ifdef OVERFLOW_INTERPOSE_MALLOC
+
+bool
+OverflowTest::AllocationCounter::isCountingMalloc()
+{
+    return true;
+}
+
+// glibc exports its allocator under these names as well, operator new goes
+// through malloc so it is counted here too
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* pointer);
+
+    void* malloc(size_t size)
+    {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        if (size > 0)
+            countAllocation();
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** pointer, size_t alignment, size_t size)
+    {
+        if (alignment < sizeof(void*) or (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+        
+        countAllocation();
+        *pointer = __libc_memalign(alignment, size);
+        return *pointer != nullptr ? 0 : ENOMEM;
+    }
+
+    void free(void* pointer)
+    {
+        __libc_free(pointer);
+    }
+};
+
+#else
+
+bool
+OverflowTest::AllocationCounter::isCountingMalloc()
+{
+    return false;
+}
+
+static void* countedAllocation(size_t size)
+{
+    countAllocation();
+
+    void *pointer = malloc(size > 0 ? size : 1);
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new(size_t size)
+{
+    return countedAllocation(size);
+}
+
+void* operator new[](size_t size)
+{
+    return countedAllocation(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    free(pointer);
+}
+
+#endif
@@ -0,0 +1,58 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __ALLOCATION_COUNTER_H__
+#define __ALLOCATION_COUNTER_H__
+
+#include <cstdint>
+
+
+namespace OverflowTest
+{
+    // Counts heap allocations made by the binary AllocationCounter.cc is
+    // linked into. On glibc malloc, calloc, realloc and the aligned
+    // variants are interposed so C allocations are seen too, elsewhere only
+    // global operator new is.
+    class AllocationCounter
+    {
+    public:
+        static uint64_t allocations();
+
+        // made by the calling thread
+        static uint64_t threadAllocations();
+
+        static bool isCountingMalloc();
+    };
+
+    // Allocations made on this thread while the scope is alive.
+    class AllocationScope
+    {
+    public:
+        AllocationScope() : mStart(AllocationCounter::threadAllocations()) { }
+
+        uint64_t allocations() const { return AllocationCounter::threadAllocations() - mStart; }
+
+    private:
+        uint64_t mStart;
+    };
+};
+
+#endif //__ALLOCATION_COUNTER_H__
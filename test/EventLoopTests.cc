@@ -0,0 +1,186 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "EventLoop.h"
+#include "EventLoopGroup.h"
+#include "TransportController.h"
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    class FakeTransport: public Overflow::Transport
+    {
+    public:
+        FakeTransport(Overflow::EventLoop* loop, std::atomic<int>* alive)
+            : Transport(nullptr), mLoop(loop), mAlive(alive)
+        { (*mAlive)++; }
+
+        ~FakeTransport() { (*mAlive)--; }
+
+        void writeRtsp(const unsigned char*, const size_t, int) override { }
+
+        std::string getTransportHeaderString() const override { return ""; }
+
+        void start() override { onStateChange(Overflow::CONNECTED); }
+
+        void stop(const std::function<void ()>& onStopped) override
+        {
+            mLoop->post(onStopped);
+        }
+
+    private:
+        Overflow::EventLoop* mLoop;
+        std::atomic<int>* mAlive;
+    };
+    
+    class FakeController: public Overflow::TransportController
+    {
+    public:
+        FakeController(Overflow::EventLoop* loop, std::atomic<int>* alive)
+            : TransportController(loop), mLoop(loop), mAlive(alive)
+        { }
+
+        ~FakeController() { stop(); join(); }
+        
+    protected:
+        void onKeepAlive() override { }
+
+        Overflow::Transport* createTransport() override
+        {
+            return new FakeTransport(mLoop, mAlive);
+        }
+
+    private:
+        Overflow::EventLoop* mLoop;
+        std::atomic<int>* mAlive;
+    };
+};
+
+
+TEST(EVENT_LOOP, POSTED_TASKS_RUN_IN_ORDER_ON_LOOP_THREAD)
+{
+    Overflow::EventLoop loop;
+    loop.start();
+
+    std::vector<int> order;
+    bool allInLoopThread = true;
+    for (int i = 0; i < 100; ++i)
+    {
+        loop.post([&, i]() {
+                allInLoopThread = allInLoopThread and loop.isInLoopThread();
+                order.push_back(i);
+            });
+    }
+
+    std::promise<void> done;
+    loop.post([&]() { done.set_value(); });
+    done.get_future().wait();
+    
+    ASSERT_FALSE(loop.isInLoopThread());
+    ASSERT_TRUE(allInLoopThread);
+    ASSERT_EQ(100, order.size());
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(i, order[i]);
+
+    loop.stop();
+    loop.join();
+    ASSERT_FALSE(loop.isRunning());
+}
+
+TEST(EVENT_LOOP, GROUP_PICKS_LEAST_LOADED_LOOP)
+{
+    Overflow::EventLoopGroup group(4);
+    ASSERT_EQ(4, group.size());
+
+    for (int i = 0; i < 8; ++i)
+        group.next()->attach();
+
+    for (size_t i = 0; i < group.size(); ++i)
+        ASSERT_EQ(2, group.getLoop(i)->getAttachedCount());
+}
+
+TEST(EVENT_LOOP, CONTROLLERS_SHARE_GROUP_THREADS)
+{
+    Overflow::EventLoopGroup group(2);
+    group.start();
+
+    std::atomic<int> alive(0);
+    std::vector<FakeController*> controllers;
+    for (int i = 0; i < 32; ++i)
+    {
+        FakeController* controller = new FakeController(group.next(), &alive);
+        controller->start();
+        controllers.push_back(controller);
+    }
+    ASSERT_EQ(16, group.getLoop(0)->getAttachedCount());
+    
+    for (auto controller: controllers)
+        controller->stop();
+    for (auto controller: controllers)
+    {
+        controller->join();
+        ASSERT_FALSE(controller->isRunning());
+        delete controller;
+    }
+    ASSERT_EQ(0, group.getLoop(0)->getAttachedCount());
+
+    group.stop();
+    group.join();
+    ASSERT_EQ(0, alive.load());
+}
+
+TEST(EVENT_LOOP, JOIN_FROM_LOOP_THREAD_THROWS)
+{
+    Overflow::EventLoop loop;
+    loop.start();
+
+    std::atomic<int> alive(0);
+    {
+        FakeController controller(&loop, &alive);
+        controller.start();
+
+        std::promise<bool> thrown;
+        loop.post([&]() {
+                try
+                {
+                    controller.join();
+                    thrown.set_value(false);
+                }
+                catch (std::runtime_error&)
+                {
+                    thrown.set_value(true);
+                }
+            });
+        ASSERT_TRUE(thrown.get_future().get());
+    }
+
+    loop.stop();
+    loop.join();
+    ASSERT_EQ(0, alive.load());
+}
@@ -0,0 +1,136 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "FramePool.h"
+
+#include <thread>
+
+
+TEST(FRAME_POOL, REUSES_RELEASED_FRAMES)
+{
+    Overflow::FramePool pool(4);
+
+    Overflow::Frame *frame = pool.acquire(1000);
+    ASSERT_GE(frame->capacity(), 1000);
+    frame->getBuffer()->appendByte(0x01);
+    frame->release();
+
+    Overflow::Frame *again = pool.acquire(1000);
+    ASSERT_EQ(frame, again);
+    ASSERT_EQ(0, again->length());
+    ASSERT_EQ(1, pool.getAllocatedCount());
+    ASSERT_EQ(1, pool.getReusedCount());
+    again->release();
+}
+
+TEST(FRAME_POOL, RETAINED_FRAME_IS_NOT_REUSED)
+{
+    Overflow::FramePool pool(4);
+
+    Overflow::Frame *frame = pool.acquire(1000);
+    frame->retain();
+    ASSERT_TRUE(frame->isShared());
+    
+    frame->release();
+    ASSERT_FALSE(frame->isShared());
+    ASSERT_EQ(0, pool.getFreeCount());
+
+    Overflow::Frame *other = pool.acquire(1000);
+    ASSERT_NE(frame, other);
+
+    frame->release();
+    other->release();
+    ASSERT_EQ(2, pool.getFreeCount());
+}
+
+TEST(FRAME_POOL, SIZE_CLASSES)
+{
+    Overflow::FramePool pool(4);
+
+    Overflow::Frame *small = pool.acquire(1000);
+    Overflow::Frame *large = pool.acquire(3 * 1024 * 1024);
+    ASSERT_GE(large->capacity(), 3 * 1024 * 1024);
+    small->release();
+    large->release();
+
+    // a big request should not be handed the small frame
+    Overflow::Frame *frame = pool.acquire(2 * 1024 * 1024);
+    ASSERT_EQ(large, frame);
+    frame->release();
+}
+
+TEST(FRAME_POOL, PREFERS_EXACT_SIZE_CLASS)
+{
+    Overflow::FramePool pool(4);
+
+    Overflow::Frame *small = pool.acquire(1000);
+    Overflow::Frame *huge = pool.acquire(8 * 1024 * 1024);
+    huge->release();
+
+    // nothing free that is close in size, the huge frame stays put
+    Overflow::Frame *frame = pool.acquire(1000);
+    ASSERT_NE(huge, frame);
+    ASSERT_LT(frame->capacity(), 1024 * 1024);
+
+    small->release();
+    Overflow::Frame *exact = pool.acquire(1000);
+    ASSERT_EQ(small, exact);
+
+    exact->release();
+    frame->release();
+}
+
+TEST(FRAME_POOL, OVERSIZED_FRAME_IS_NOT_POOLED)
+{
+    Overflow::FramePool pool(4);
+
+    size_t size = 20 * 1024 * 1024;
+    Overflow::Frame *frame = pool.acquire(size);
+    ASSERT_GE(frame->capacity(), size);
+    frame->release();
+    ASSERT_EQ(0, pool.getFreeCount());
+
+    Overflow::Frame *pooled = pool.acquire(16 * 1024 * 1024);
+    pooled->release();
+    ASSERT_EQ(1, pool.getFreeCount());
+
+    // the free 16M frame is too small for it
+    Overflow::Frame *again = pool.acquire(size);
+    ASSERT_GE(again->capacity(), size);
+    ASSERT_EQ(1, pool.getFreeCount());
+    again->release();
+}
+
+TEST(FRAME_POOL, RELEASE_FROM_OTHER_THREAD)
+{
+    Overflow::FramePool pool(4);
+
+    Overflow::Frame *frame = pool.acquire(1000);
+    frame->retain();
+    frame->release();
+
+    std::thread consumer([frame]() { frame->release(); });
+    consumer.join();
+
+    ASSERT_EQ(1, pool.getFreeCount());
+}
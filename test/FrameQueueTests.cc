@@ -0,0 +1,203 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "FrameQueue.h"
+#include "FramePool.h"
+
+#include "Util.h"
+
+#include <thread>
+
+using OverflowTest::Helpers;
+
+
+TEST(FRAME_QUEUE, POPS_IN_PUSH_ORDER)
+{
+    Overflow::FramePool pool(4);
+    Overflow::FrameQueue queue(4);
+
+    Overflow::Frame *first = pool.acquire(16);
+    Overflow::Frame *second = pool.acquire(16);
+    ASSERT_TRUE(queue.push(first));
+    ASSERT_TRUE(queue.push(second));
+    ASSERT_EQ(2, queue.size());
+
+    ASSERT_EQ(first, queue.tryPop());
+    ASSERT_EQ(second, queue.tryPop());
+    ASSERT_EQ(nullptr, queue.tryPop());
+
+    first->release();
+    second->release();
+}
+
+TEST(FRAME_QUEUE, FULL_QUEUE_DROPS)
+{
+    Overflow::FramePool pool(8);
+    Overflow::FrameQueue queue(3);
+    ASSERT_EQ(4, queue.capacity());
+
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(queue.push(pool.acquire(16)));
+
+    Overflow::Frame *extra = pool.acquire(16);
+    ASSERT_FALSE(queue.push(extra));
+    extra->release();
+
+    ASSERT_EQ(4, queue.getPushedCount());
+    ASSERT_EQ(1, queue.getDroppedCount());
+    ASSERT_EQ(4, queue.getHighWaterMark());
+
+    queue.tryPop()->release();
+    ASSERT_EQ(3, queue.size());
+    ASSERT_EQ(4, queue.getHighWaterMark());
+}
+
+TEST(FRAME_QUEUE, POP_TIMES_OUT_WHEN_EMPTY)
+{
+    Overflow::FrameQueue queue(4);
+    ASSERT_EQ(nullptr, queue.pop(0));
+    ASSERT_EQ(nullptr, queue.pop(10));
+}
+
+TEST(FRAME_QUEUE, BLOCKING_POP_SEES_EVERY_FRAME)
+{
+    Overflow::FramePool pool(8);
+    Overflow::FrameQueue queue(8);
+    const int count = 10000;
+
+    std::thread producer([&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                Overflow::Frame *frame = pool.acquire(16);
+                frame->getBuffer()->appendByte(i & 0xFF);
+                while (not queue.push(frame))
+                    std::this_thread::yield();
+            }
+        });
+
+    for (int i = 0; i < count; ++i)
+    {
+        Overflow::Frame *frame = queue.pop(-1);
+        ASSERT_NE(nullptr, frame);
+        ASSERT_EQ(i & 0xFF, frame->bytesPointer()[0]);
+        frame->release();
+    }
+    producer.join();
+
+    ASSERT_EQ(nullptr, queue.tryPop());
+}
+
+static bool pushOrRelease(Overflow::FrameQueue* queue, Overflow::Frame* frame)
+{
+    if (queue->push(frame))
+        return true;
+    frame->release();
+    return false;
+}
+
+TEST(FRAME_QUEUE, DROP_OLDEST_EVICTS_UP_TO_NEXT_KEY_FRAME)
+{
+    Overflow::FramePool pool(16);
+    Overflow::FrameQueue queue(4, Overflow::FRAME_DROP_OLDEST);
+
+    Overflow::Frame *key = Helpers::makeFrame(&pool, true);
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, true)));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+    ASSERT_TRUE(pushOrRelease(&queue, key));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+
+    // the first gop goes as a whole so the consumer starts on a key frame
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+    ASSERT_EQ(2, queue.getDroppedCount(Overflow::FRAME_DROP_REASON_OLDEST));
+    ASSERT_EQ(3, queue.size());
+    ASSERT_EQ(48, queue.getQueuedBytes());
+
+    Overflow::Frame *frame = queue.tryPop();
+    ASSERT_EQ(key, frame);
+    frame->release();
+}
+
+TEST(FRAME_QUEUE, DROP_OLDEST_WITHOUT_QUEUED_KEY_FRAME_AWAITS_ONE)
+{
+    Overflow::FramePool pool(16);
+    Overflow::FrameQueue queue(2, Overflow::FRAME_DROP_OLDEST);
+
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, true)));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+
+    ASSERT_FALSE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+    ASSERT_EQ(0, queue.size());
+    ASSERT_FALSE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, true)));
+
+    ASSERT_EQ(2, queue.getDroppedCount(Overflow::FRAME_DROP_REASON_OLDEST));
+    ASSERT_EQ(2, queue.getDroppedCount(Overflow::FRAME_DROP_REASON_AWAITING_KEY_FRAME));
+    ASSERT_EQ(4, queue.getDroppedCount());
+}
+
+TEST(FRAME_QUEUE, DROP_NON_REFERENCE_SHEDS_DISPOSABLE_FRAMES_FIRST)
+{
+    Overflow::FramePool pool(16);
+    Overflow::FrameQueue queue(4, Overflow::FRAME_DROP_NON_REFERENCE);
+
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, true)));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false, true)));
+
+    // half full, disposable frames go while reference frames still fit
+    ASSERT_FALSE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false, true)));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+    ASSERT_EQ(1, queue.getDroppedCount(Overflow::FRAME_DROP_REASON_NON_REFERENCE));
+
+    // a lost reference frame takes the rest of its gop with it
+    ASSERT_FALSE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+    queue.tryPop()->release();
+    queue.tryPop()->release();
+    ASSERT_FALSE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false)));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, true)));
+
+    ASSERT_EQ(1, queue.getDroppedCount(Overflow::FRAME_DROP_REASON_FULL));
+    ASSERT_EQ(1, queue.getDroppedCount(Overflow::FRAME_DROP_REASON_AWAITING_KEY_FRAME));
+}
+
+TEST(FRAME_QUEUE, DROP_UNTIL_KEY_FRAME_ON_MEMORY_BUDGET)
+{
+    Overflow::FramePool pool(16);
+    Overflow::FrameQueue queue(16, Overflow::FRAME_DROP_UNTIL_KEY_FRAME, 64);
+
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, true, false, 32)));
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false, false, 32)));
+    ASSERT_FALSE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false, false, 8)));
+
+    queue.tryPop()->release();
+    queue.tryPop()->release();
+    ASSERT_EQ(0, queue.getQueuedBytes());
+    ASSERT_FALSE(pushOrRelease(&queue, Helpers::makeFrame(&pool, false, false, 8)));
+
+    // bigger than the whole budget but the queue is empty
+    ASSERT_TRUE(pushOrRelease(&queue, Helpers::makeFrame(&pool, true, false, 128)));
+    ASSERT_FALSE(pushOrRelease(&queue, Helpers::makeFrame(&pool, true, false, 8)));
+
+    ASSERT_EQ(2, queue.getDroppedCount(Overflow::FRAME_DROP_REASON_FULL));
+    ASSERT_EQ(1, queue.getDroppedCount(Overflow::FRAME_DROP_REASON_AWAITING_KEY_FRAME));
+}
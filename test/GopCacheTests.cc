@@ -0,0 +1,105 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "GopCache.h"
+#include "FramePool.h"
+
+#include "Util.h"
+
+#include <vector>
+
+using OverflowTest::Helpers;
+
+
+TEST(GOP_CACHE, HOLDS_FRAMES_FROM_THE_LAST_KEY_FRAME)
+{
+    Overflow::FramePool pool(16);
+    Overflow::GopCache cache(1 << 20);
+
+    // nothing before the first key frame
+    std::vector<Overflow::Frame*> frames = {
+        Helpers::makeFrame(&pool, false),
+        Helpers::makeFrame(&pool, true), Helpers::makeFrame(&pool, false),
+        Helpers::makeFrame(&pool, true), Helpers::makeFrame(&pool, false), Helpers::makeFrame(&pool, false)
+    };
+    for (auto frame: frames)
+    {
+        cache.push(frame);
+        frame->release();
+    }
+    ASSERT_EQ(3, cache.getFrameCount());
+    ASSERT_EQ(3 * frames[3]->capacity(), cache.getCachedBytes());
+
+    // the first gop went back to the pool
+    ASSERT_EQ(3, pool.getFreeCount());
+
+    Overflow::FrameQueue queue(4);
+    ASSERT_EQ(3, cache.replay(&queue));
+    for (size_t i = 3; i < frames.size(); ++i)
+    {
+        Overflow::Frame *frame = queue.tryPop();
+        ASSERT_EQ(frames[i], frame);
+        ASSERT_TRUE(frame->isShared());
+        frame->release();
+    }
+
+    cache.clear();
+    ASSERT_EQ(6, pool.getFreeCount());
+}
+
+TEST(GOP_CACHE, GOP_OVER_BUDGET_WAITS_FOR_NEXT_KEY_FRAME)
+{
+    Overflow::FramePool pool(16);
+    Overflow::Frame *key = Helpers::makeFrame(&pool, true);
+    Overflow::GopCache cache(2 * key->capacity());
+
+    cache.push(key);
+    key->release();
+    for (int i = 0; i < 2; ++i)
+    {
+        Overflow::Frame *delta = Helpers::makeFrame(&pool, false);
+        cache.push(delta);
+        delta->release();
+    }
+
+    // a partial gop would not decode, so none of it is kept
+    ASSERT_EQ(0, cache.getFrameCount());
+    ASSERT_EQ(0, cache.getCachedBytes());
+
+    Overflow::Frame *delta = Helpers::makeFrame(&pool, false);
+    cache.push(delta);
+    delta->release();
+    ASSERT_EQ(0, cache.getFrameCount());
+
+    Overflow::Frame *next = Helpers::makeFrame(&pool, true);
+    cache.push(next);
+    next->release();
+    ASSERT_EQ(1, cache.getFrameCount());
+
+    Overflow::GopCache disabled;
+    Overflow::Frame *frame = Helpers::makeFrame(&pool, true);
+    disabled.push(frame);
+    ASSERT_FALSE(frame->isShared());
+    ASSERT_EQ(0, disabled.getFrameCount());
+    frame->release();
+}
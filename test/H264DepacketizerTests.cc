@@ -0,0 +1,410 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "H264Depacketizer.h"
+#include "FrameBuffer.h"
+
+#include "Util.h"
+
+#include <stdexcept>
+#include <vector>
+
+using OverflowTest::Helpers;
+
+
+static void depacketize(Overflow::SessionDescription* palette,
+                        const std::vector<unsigned char>& raw,
+                        Overflow::FrameBuffer* frame,
+                        Overflow::FrameMetadata* metadata = nullptr,
+                        Overflow::NaluWriter* writer = nullptr)
+{
+    Helpers::depacketize<Overflow::H264Depacketizer>(palette, raw, frame, metadata, writer);
+}
+
+
+TEST(H264_DEPACKETIZER, SINGLE_NALU)
+{
+    Overflow::SessionDescription palette;
+    Overflow::FrameBuffer frame(0);
+
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x41, 0x9A, 0x02 }), &frame);
+
+    std::vector<unsigned char> expected = { 0x00, 0x00, 0x01, 0x41, 0x9A, 0x02 };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H264_DEPACKETIZER, FU_A_REASSEMBLY)
+{
+    Overflow::SessionDescription palette;
+    Overflow::FrameBuffer frame(0);
+
+    // idr slice nri=3 split over three fragments
+    depacketize(&palette, Helpers::makeRtpPacket(false, 1, 0, { 0x7C, 0x85, 0x01, 0x02 }), &frame);
+    depacketize(&palette, Helpers::makeRtpPacket(false, 2, 0, { 0x7C, 0x05, 0x03 }), &frame);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, { 0x7C, 0x45, 0x04, 0x05 }), &frame);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x01, 0x65, 0x01, 0x02, 0x03, 0x04, 0x05
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H264_DEPACKETIZER, STAP_A_WRITES_EACH_UNIT)
+{
+    Overflow::SessionDescription palette;
+    Overflow::FrameBuffer frame(0);
+
+    // sps, pps and sei, then a size running past the end
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, {
+                0x18,
+                0x00, 0x02, 0x67, 0x42,
+                0x00, 0x02, 0x68, 0xCE,
+                0x00, 0x03, 0x06, 0x05, 0x01,
+                0x00, 0x09, 0x65 }), &frame);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x01, 0x67, 0x42,
+        0x00, 0x00, 0x01, 0x68, 0xCE,
+        0x00, 0x00, 0x01, 0x06, 0x05, 0x01
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H264_DEPACKETIZER, STAP_B_AND_MTAP_SKIP_DECODING_ORDER_FIELDS)
+{
+    Overflow::SessionDescription palette;
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x01, 0x67, 0x42,
+        0x00, 0x00, 0x01, 0x68, 0xCE
+    };
+
+    Overflow::FrameBuffer stapB(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, {
+                0x19, 0x00, 0x07,
+                0x00, 0x02, 0x67, 0x42,
+                0x00, 0x02, 0x68, 0xCE }), &stapB);
+    ASSERT_EQ(expected, Helpers::frameBytes(stapB));
+
+    // size, dond, 16 bit timestamp offset
+    Overflow::FrameBuffer mtap16(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 2, 0, {
+                0x1A, 0x00, 0x07,
+                0x00, 0x02, 0x00, 0x00, 0x00, 0x67, 0x42,
+                0x00, 0x02, 0x01, 0x00, 0x00, 0x68, 0xCE }), &mtap16);
+    ASSERT_EQ(expected, Helpers::frameBytes(mtap16));
+
+    // 24 bit timestamp offset
+    Overflow::FrameBuffer mtap24(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, {
+                0x1B, 0x00, 0x07,
+                0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x67, 0x42,
+                0x00, 0x02, 0x01, 0x00, 0x00, 0x00, 0x68, 0xCE }), &mtap24);
+    ASSERT_EQ(expected, Helpers::frameBytes(mtap24));
+}
+
+TEST(H264_DEPACKETIZER, LENGTH_PREFIXED_OUTPUT)
+{
+    Overflow::SessionDescription palette(Overflow::H264, "trackID=0",
+                                         "a=rtpmap:96 H264/90000",
+                                         "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=Z0IAKQ==,aM4=",
+                                         25, 640, 480);
+    Overflow::NaluWriter writer(Overflow::NALU_FORMAT_LENGTH_PREFIXED, 4);
+    Overflow::FrameBuffer frame(0);
+
+    // a stap-a sei, then the sprop units ahead of an idr whose length
+    // grows per fragment
+    depacketize(&palette, Helpers::makeRtpPacket(false, 1, 0, {
+                0x18, 0x00, 0x02, 0x06, 0x05 }), &frame, nullptr, &writer);
+    depacketize(&palette, Helpers::makeRtpPacket(false, 2, 0, { 0x7C, 0x85, 0x88, 0x02 }), &frame, nullptr, &writer);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, { 0x7C, 0x45, 0x03 }), &frame, nullptr, &writer);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x00, 0x02, 0x06, 0x05,
+        0x00, 0x00, 0x00, 0x04, 0x67, 0x42, 0x00, 0x29,
+        0x00, 0x00, 0x00, 0x02, 0x68, 0xCE,
+        0x00, 0x00, 0x00, 0x04, 0x65, 0x88, 0x02, 0x03
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+
+    Overflow::NaluWriter shortWriter(Overflow::NALU_FORMAT_LENGTH_PREFIXED, 2);
+    Overflow::FrameBuffer shortFrame(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 4, 0, { 0x41, 0x9A }), &shortFrame, nullptr, &shortWriter);
+    std::vector<unsigned char> shortExpected = { 0x00, 0x02, 0x41, 0x9A };
+    ASSERT_EQ(shortExpected, Helpers::frameBytes(shortFrame));
+
+    ASSERT_THROW(Overflow::NaluWriter(Overflow::NALU_FORMAT_LENGTH_PREFIXED, 3), std::runtime_error);
+}
+
+TEST(H264_DEPACKETIZER, LENGTH_PREFIX_TOO_SHORT_DROPS_THE_UNIT)
+{
+    Overflow::SessionDescription palette;
+    Overflow::NaluWriter writer(Overflow::NALU_FORMAT_LENGTH_PREFIXED, 2);
+    Overflow::FrameBuffer frame(0);
+
+    // a 70000 byte idr slice in fragments, then a p slice that fits
+    std::vector<unsigned char> fragment(1400, 0xAB);
+    fragment[0] = 0x7C;
+    fragment[1] = 0x85;
+    fragment[2] = 0x88;
+    depacketize(&palette, Helpers::makeRtpPacket(false, 1, 0, fragment), &frame, nullptr, &writer);
+    fragment[1] = 0x05;
+    uint16_t sequence = 2;
+    for (size_t written = 1399; written + 1398 < 70000; written += 1398)
+        depacketize(&palette, Helpers::makeRtpPacket(false, sequence++, 0, fragment), &frame, nullptr, &writer);
+    fragment[1] = 0x45;
+    depacketize(&palette, Helpers::makeRtpPacket(false, sequence++, 0, fragment), &frame, nullptr, &writer);
+    depacketize(&palette, Helpers::makeRtpPacket(true, sequence++, 0, { 0x41, 0x9A }), &frame, nullptr, &writer);
+
+    std::vector<unsigned char> expected = { 0x00, 0x02, 0x41, 0x9A };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+    ASSERT_GT(writer.getDroppedCount(), 1u);
+
+    // a single nal unit too long for a 1 byte length
+    Overflow::NaluWriter byteWriter(Overflow::NALU_FORMAT_LENGTH_PREFIXED, 1);
+    Overflow::FrameBuffer byteFrame(0);
+    std::vector<unsigned char> slice(300, 0x9A);
+    slice[0] = 0x41;
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, slice), &byteFrame, nullptr, &byteWriter);
+    ASSERT_TRUE(byteFrame.empty());
+    ASSERT_EQ(1, byteWriter.getDroppedCount());
+}
+
+TEST(H264_DEPACKETIZER, LENGTH_PREFIXED_DROPS_ORPHAN_FRAGMENTS)
+{
+    Overflow::SessionDescription palette;
+    Overflow::NaluWriter writer(Overflow::NALU_FORMAT_LENGTH_PREFIXED, 4);
+    Overflow::FrameBuffer frame(0);
+
+    // the fu start was lost, the fragments after it have no length to grow
+    depacketize(&palette, Helpers::makeRtpPacket(false, 2, 0, { 0x7C, 0x05, 0x01, 0x02 }), &frame, nullptr, &writer);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, { 0x7C, 0x45, 0x03, 0x04 }), &frame, nullptr, &writer);
+
+    ASSERT_TRUE(frame.empty());
+    ASSERT_EQ(2, writer.getDroppedCount());
+}
+
+TEST(H264_DEPACKETIZER, LONG_START_CODES)
+{
+    Overflow::SessionDescription palette;
+    Overflow::NaluWriter writer(Overflow::NALU_FORMAT_ANNEX_B_LONG);
+    Overflow::FrameBuffer frame(0);
+
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x41, 0x9A }), &frame, nullptr, &writer);
+
+    std::vector<unsigned char> expected = { 0x00, 0x00, 0x00, 0x01, 0x41, 0x9A };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H264_DEPACKETIZER, PARAMETER_SETS_AHEAD_OF_IDR)
+{
+    Overflow::SessionDescription palette(Overflow::H264, "trackID=0",
+                                         "a=rtpmap:96 H264/90000",
+                                         "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=Z0IAKQ==,aM4=",
+                                         25, 640, 480);
+
+    // nothing ahead of a p slice even as the first payload
+    Overflow::FrameBuffer slice(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x41, 0x9A }), &slice);
+    std::vector<unsigned char> sliceExpected = { 0x00, 0x00, 0x01, 0x41, 0x9A };
+    ASSERT_EQ(sliceExpected, Helpers::frameBytes(slice));
+
+    Overflow::FrameBuffer frame(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 2, 0, { 0x65, 0x88 }), &frame);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x29,
+        0x00, 0x00, 0x00, 0x01, 0x68, 0xCE,
+        0x00, 0x00, 0x01, 0x65, 0x88
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+
+    // the camera's own sets ahead of the idr are not repeated
+    Overflow::FrameBuffer inBand(0);
+    Overflow::FrameMetadata metadata;
+    depacketize(&palette, Helpers::makeRtpPacket(false, 3, 0, {
+                0x18, 0x00, 0x04, 0x67, 0x42, 0x00, 0x29, 0x00, 0x02, 0x68, 0xCE }), &inBand, &metadata);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 4, 0, { 0x65, 0x88 }), &inBand, &metadata);
+
+    std::vector<unsigned char> inBandExpected = {
+        0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x29,
+        0x00, 0x00, 0x01, 0x68, 0xCE,
+        0x00, 0x00, 0x01, 0x65, 0x88
+    };
+    ASSERT_EQ(inBandExpected, Helpers::frameBytes(inBand));
+}
+
+TEST(H264_DEPACKETIZER, IN_BAND_PARAMETER_SETS_REPLACE_SPROP)
+{
+    // sps and pps with id 0
+    Overflow::SessionDescription palette(Overflow::H264, "trackID=0",
+                                         "a=rtpmap:96 H264/90000",
+                                         "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=Z0IAKYA=,aM44gA==",
+                                         25, 640, 480);
+    ASSERT_EQ(2, palette.getParameterSets().getUnits().size());
+
+    // a new level on sps 0 in a frame of its own
+    Overflow::FrameBuffer update(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x67, 0x42, 0x00, 0x1E, 0x80 }), &update);
+    ASSERT_EQ(2, palette.getParameterSets().getUnits().size());
+
+    Overflow::FrameBuffer frame(0);
+    Overflow::FrameMetadata metadata;
+    depacketize(&palette, Helpers::makeRtpPacket(true, 2, 0, { 0x65, 0x88 }), &frame, &metadata);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x1E, 0x80,
+        0x00, 0x00, 0x00, 0x01, 0x68, 0xCE, 0x38, 0x80,
+        0x00, 0x00, 0x01, 0x65, 0x88
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+    ASSERT_TRUE(metadata.hasParameterSets);
+
+    // the same bytes again are not a change
+    uint32_t version = palette.getParameterSets().getVersion();
+    const unsigned char sps[] = { 0x67, 0x42, 0x00, 0x1E, 0x80 };
+    ASSERT_FALSE(palette.updateParameterSet(sps, sizeof(sps)));
+    ASSERT_EQ(version, palette.getParameterSets().getVersion());
+}
+
+TEST(H264_DEPACKETIZER, SPROP_WITH_SEVERAL_OR_EMPTY_UNITS)
+{
+    // an empty unit in the list, pps 1 ahead of pps 0
+    Overflow::SessionDescription palette(Overflow::H264, "trackID=0",
+                                         "a=rtpmap:96 H264/90000",
+                                         "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=Z0IAKYA=,,aE44gA==,aM44gA==",
+                                         25, 640, 480);
+    Overflow::FrameBuffer frame(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x65, 0x88 }), &frame);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x29, 0x80,
+        0x00, 0x00, 0x00, 0x01, 0x68, 0xCE, 0x38, 0x80,
+        0x00, 0x00, 0x00, 0x01, 0x68, 0x4E, 0x38, 0x80,
+        0x00, 0x00, 0x01, 0x65, 0x88
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+
+    // a lone unit or nothing at all
+    Overflow::SessionDescription single(Overflow::H264, "trackID=0", "a=rtpmap:96 H264/90000",
+                                        "a=fmtp:96 sprop-parameter-sets=Z0IAKYA=", 25, 640, 480);
+    ASSERT_EQ(1, single.getParameterSets().getUnits().size());
+
+    Overflow::SessionDescription empty(Overflow::H264, "trackID=0", "a=rtpmap:96 H264/90000",
+                                       "a=fmtp:96 sprop-parameter-sets=,", 25, 640, 480);
+    ASSERT_TRUE(empty.getParameterSets().empty());
+
+    // unpadded and garbled units are skipped, the good ones kept
+    Overflow::SessionDescription broken(Overflow::H264, "trackID=0", "a=rtpmap:96 H264/90000",
+                                        "a=fmtp:96 sprop-parameter-sets=Z0IAKYA,!!!!,aM44gA==",
+                                        25, 640, 480);
+    ASSERT_EQ(1, broken.getParameterSets().getUnits().size());
+
+    Overflow::FrameBuffer bare(0);
+    depacketize(&empty, Helpers::makeRtpPacket(true, 2, 0, { 0x65, 0x88 }), &bare);
+    std::vector<unsigned char> bareExpected = { 0x00, 0x00, 0x01, 0x65, 0x88 };
+    ASSERT_EQ(bareExpected, Helpers::frameBytes(bare));
+}
+
+TEST(H264_DEPACKETIZER, METADATA_FOR_IDR_WITH_PARAMETER_SETS)
+{
+    Overflow::SessionDescription palette(Overflow::H264, "trackID=0",
+                                         "a=rtpmap:96 H264/90000",
+                                         "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=Z0IAKQ==,aM4=",
+                                         25, 640, 480);
+    Overflow::FrameBuffer frame(0);
+    Overflow::FrameMetadata metadata;
+
+    // first_mb_in_slice 0, slice_type 7
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x65, 0x88 }), &frame, &metadata);
+
+    ASSERT_EQ((1u << 5) | (1u << 7) | (1u << 8), metadata.naluTypes);
+    ASSERT_TRUE(metadata.isKeyFrame);
+    ASSERT_TRUE(metadata.hasParameterSets);
+    ASSERT_EQ(Overflow::SLICE_TYPE_I, metadata.sliceType);
+}
+
+TEST(H264_DEPACKETIZER, METADATA_FOR_FRAGMENTED_AND_AGGREGATED)
+{
+    Overflow::SessionDescription palette;
+    Overflow::FrameBuffer frame(0);
+    Overflow::FrameMetadata metadata;
+
+    // stap-a with sps and pps, then an idr split over two fragments
+    depacketize(&palette, Helpers::makeRtpPacket(false, 1, 0, {
+                0x18, 0x00, 0x02, 0x67, 0x42, 0x00, 0x02, 0x68, 0xCE }), &frame, &metadata);
+    ASSERT_TRUE(metadata.hasParameterSets);
+    ASSERT_FALSE(metadata.isKeyFrame);
+
+    depacketize(&palette, Helpers::makeRtpPacket(false, 2, 0, { 0x7C, 0x85, 0x88, 0x84 }), &frame, &metadata);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, { 0x7C, 0x45, 0x01 }), &frame, &metadata);
+
+    ASSERT_EQ((1u << 5) | (1u << 7) | (1u << 8), metadata.naluTypes);
+    ASSERT_TRUE(metadata.isKeyFrame);
+    ASSERT_EQ(Overflow::SLICE_TYPE_I, metadata.sliceType);
+}
+
+TEST(H264_DEPACKETIZER, METADATA_FOR_P_SLICE)
+{
+    Overflow::SessionDescription palette;
+    Overflow::FrameBuffer frame(0);
+    Overflow::FrameMetadata metadata;
+
+    // slice_type 5
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x41, 0x9A, 0x02 }), &frame, &metadata);
+
+    ASSERT_EQ(1u << 1, metadata.naluTypes);
+    ASSERT_FALSE(metadata.isKeyFrame);
+    ASSERT_FALSE(metadata.hasParameterSets);
+    ASSERT_EQ(Overflow::SLICE_TYPE_P, metadata.sliceType);
+    ASSERT_FALSE(metadata.isDisposable);
+
+    // nal_ref_idc 0 on every slice, one referenced slice undoes it
+    Overflow::FrameMetadata disposable;
+    depacketize(&palette, Helpers::makeRtpPacket(false, 2, 0, { 0x01, 0x9A, 0x02 }), &frame, &disposable);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, { 0x01, 0xC0 }), &frame, &disposable);
+    ASSERT_TRUE(disposable.isDisposable);
+
+    depacketize(&palette, Helpers::makeRtpPacket(true, 4, 0, { 0x41, 0xC0 }), &frame, &disposable);
+    ASSERT_FALSE(disposable.isDisposable);
+
+    const unsigned char truncated[] = { 0x00 };
+    ASSERT_EQ(Overflow::SLICE_TYPE_UNKNOWN, Overflow::H264Depacketizer::readSliceType(truncated, 1));
+}
+
+TEST(FRAME_BUFFER, KEEPS_CAPACITY_ON_CLEAR)
+{
+    Overflow::FrameBuffer frame(0);
+
+    std::vector<unsigned char> bytes(10000, 0xAB);
+    frame.append(&bytes[0], bytes.size());
+    size_t capacity = frame.capacity();
+    ASSERT_GE(capacity, bytes.size());
+
+    frame.clear();
+    ASSERT_TRUE(frame.empty());
+    ASSERT_EQ(capacity, frame.capacity());
+
+    frame.appendByte(0x01);
+    ASSERT_EQ(1, frame.length());
+    ASSERT_EQ(0x01, frame.bytesPointer()[0]);
+}
@@ -0,0 +1,250 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "H265Depacketizer.h"
+#include "FrameBuffer.h"
+
+#include "Util.h"
+
+#include <vector>
+
+using OverflowTest::Helpers;
+
+
+static Overflow::SessionDescription makePalette(const std::string& fmtp)
+{
+    return Overflow::SessionDescription(Overflow::H265, "trackID=0",
+                                        "a=rtpmap:96 H265/90000",
+                                        fmtp, 25, 640, 480);
+}
+
+static void depacketize(Overflow::SessionDescription* palette,
+                        const std::vector<unsigned char>& raw,
+                        Overflow::FrameBuffer* frame,
+                        Overflow::FrameMetadata* metadata = nullptr)
+{
+    Helpers::depacketize<Overflow::H265Depacketizer>(palette, raw, frame, metadata);
+}
+
+
+TEST(H265_DEPACKETIZER, SESSION_TYPE_FROM_MIME)
+{
+    ASSERT_EQ(Overflow::H265, Overflow::SessionDescription::getTypeFromMime("a=rtpmap:96 H265/90000"));
+    ASSERT_EQ("H265", Overflow::SessionDescription::typeToString(Overflow::H265));
+
+    Overflow::SessionDescription palette = makePalette("a=fmtp:96 sprop-max-don-diff=2;sprop-vps=QAEM");
+    ASSERT_EQ(2, palette.getH265MaxDonDiff());
+    ASSERT_EQ("QAEM", palette.getFmtpParameter("sprop-vps"));
+    ASSERT_EQ("", palette.getFmtpParameter("vps"));
+    ASSERT_EQ(0, makePalette("a=fmtp:96 sprop-vps=QAEM").getH265MaxDonDiff());
+}
+
+TEST(H265_DEPACKETIZER, SINGLE_NALU)
+{
+    Overflow::SessionDescription palette = makePalette("");
+    Overflow::FrameBuffer frame(0);
+
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x02, 0x01, 0xAF, 0x02 }), &frame);
+
+    std::vector<unsigned char> expected = { 0x00, 0x00, 0x01, 0x02, 0x01, 0xAF, 0x02 };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H265_DEPACKETIZER, FU_REASSEMBLY)
+{
+    Overflow::SessionDescription palette = makePalette("");
+    Overflow::FrameBuffer frame(0);
+
+    // idr_w_radl split over three fragments
+    depacketize(&palette, Helpers::makeRtpPacket(false, 1, 0, { 0x62, 0x01, 0x93, 0x01, 0x02 }), &frame);
+    depacketize(&palette, Helpers::makeRtpPacket(false, 2, 0, { 0x62, 0x01, 0x13, 0x03 }), &frame);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, { 0x62, 0x01, 0x53, 0x04, 0x05 }), &frame);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x01, 0x26, 0x01, 0x01, 0x02, 0x03, 0x04, 0x05
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H265_DEPACKETIZER, AGGREGATION_PACKET)
+{
+    Overflow::SessionDescription palette = makePalette("");
+    Overflow::FrameBuffer frame(0);
+
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, {
+                0x60, 0x01,
+                0x00, 0x03, 0x40, 0x01, 0x0C,
+                0x00, 0x03, 0x42, 0x01, 0x01 }), &frame);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x01, 0x40, 0x01, 0x0C,
+        0x00, 0x00, 0x01, 0x42, 0x01, 0x01
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H265_DEPACKETIZER, DONL_IS_SKIPPED)
+{
+    Overflow::SessionDescription palette = makePalette("a=fmtp:96 sprop-max-don-diff=2");
+    Overflow::FrameBuffer frame(0);
+
+    depacketize(&palette, Helpers::makeRtpPacket(false, 1, 0, { 0x02, 0x01, 0x00, 0x05, 0xAA }), &frame);
+    depacketize(&palette, Helpers::makeRtpPacket(false, 2, 0, {
+                0x60, 0x01, 0x00, 0x06,
+                0x00, 0x03, 0x40, 0x01, 0x0C,
+                0x01, 0x00, 0x03, 0x42, 0x01, 0x01 }), &frame);
+    depacketize(&palette, Helpers::makeRtpPacket(false, 3, 0, { 0x62, 0x01, 0x93, 0x00, 0x08, 0x01 }), &frame);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 4, 0, { 0x62, 0x01, 0x53, 0x02 }), &frame);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x01, 0x02, 0x01, 0xAA,
+        0x00, 0x00, 0x01, 0x40, 0x01, 0x0C,
+        0x00, 0x00, 0x01, 0x42, 0x01, 0x01,
+        0x00, 0x00, 0x01, 0x26, 0x01, 0x01, 0x02
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H265_DEPACKETIZER, PARAMETER_SETS_AND_METADATA)
+{
+    Overflow::SessionDescription palette = makePalette(
+        "a=fmtp:96 sprop-vps=QAEM;sprop-sps=QgEB;sprop-pps=RAHB");
+    Overflow::FrameBuffer frame(0);
+    Overflow::FrameMetadata metadata;
+
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, { 0x26, 0x01, 0xAF }), &frame, &metadata);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0C,
+        0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01,
+        0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xC1,
+        0x00, 0x00, 0x01, 0x26, 0x01, 0xAF
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+    ASSERT_TRUE(metadata.isKeyFrame);
+    ASSERT_TRUE(metadata.hasParameterSets);
+    ASSERT_EQ(Overflow::SLICE_TYPE_I, metadata.sliceType);
+    ASSERT_EQ((uint64_t(1) << 19) | (uint64_t(1) << 32) | (uint64_t(1) << 33) | (uint64_t(1) << 34),
+              metadata.naluTypes);
+
+    Overflow::FrameMetadata trailing;
+    depacketize(&palette, Helpers::makeRtpPacket(true, 2, 0, { 0x02, 0x01, 0xAF }), &frame, &trailing);
+    ASSERT_FALSE(trailing.isKeyFrame);
+    ASSERT_FALSE(trailing.hasParameterSets);
+}
+
+TEST(H265_DEPACKETIZER, SUB_LAYER_NON_REFERENCE_IS_DISPOSABLE)
+{
+    Overflow::SessionDescription palette = makePalette("");
+    Overflow::FrameBuffer frame(0);
+
+    // TRAIL_N then a fragmented RASL_N, every slice sub-layer non-reference
+    Overflow::FrameMetadata disposable;
+    depacketize(&palette, Helpers::makeRtpPacket(false, 1, 0, { 0x00, 0x01, 0xAF }), &frame, &disposable);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 2, 0, { 0x62, 0x01, 0xC8, 0xAF }), &frame, &disposable);
+    ASSERT_TRUE(disposable.isDisposable);
+
+    // one TRAIL_R slice makes the picture a reference
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, { 0x02, 0x01, 0xAF }), &frame, &disposable);
+    ASSERT_FALSE(disposable.isDisposable);
+
+    // an irap picture is never disposable
+    Overflow::FrameMetadata irap;
+    depacketize(&palette, Helpers::makeRtpPacket(true, 4, 0, { 0x26, 0x01, 0xAF }), &frame, &irap);
+    ASSERT_FALSE(irap.isDisposable);
+}
+
+TEST(H265_DEPACKETIZER, PARAMETER_SETS_KEPT_BY_ID)
+{
+    // sps 0 and sps 1 behind a profile_tier_level with emulation
+    // prevention bytes
+    Overflow::SessionDescription palette = makePalette(
+        "a=fmtp:96 sprop-vps=QAEM;sprop-sps=QgEBAWAAAAMAkAAAAwAAAwBdQA==,QgEBAWAAAAMAkAAAAwAAAwBdoA==;sprop-pps=RAHB");
+    ASSERT_EQ(4, palette.getParameterSets().getUnits().size());
+
+    // sps 1 again in-band with another level
+    Overflow::FrameBuffer update(0);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 1, 0, {
+                0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90,
+                0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5A, 0x40 }), &update);
+    ASSERT_EQ(4, palette.getParameterSets().getUnits().size());
+
+    // a second slice segment gets nothing ahead of it
+    Overflow::FrameBuffer frame(0);
+    depacketize(&palette, Helpers::makeRtpPacket(false, 2, 0, { 0x26, 0x01, 0xAF }), &frame);
+    depacketize(&palette, Helpers::makeRtpPacket(true, 3, 0, { 0x26, 0x01, 0x2F }), &frame);
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0C,
+        0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90,
+        0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5D, 0xA0,
+        0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90,
+        0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5A, 0x40,
+        0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xC1,
+        0x00, 0x00, 0x01, 0x26, 0x01, 0xAF,
+        0x00, 0x00, 0x01, 0x26, 0x01, 0x2F
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
+
+TEST(H265_DEPACKETIZER, CLASSIFIES_PACKETS_FROM_PAYLOAD_HEADER)
+{
+    const unsigned char trailing[] = { 0x02, 0x01, 0xAF };
+    const unsigned char idr[] = { 0x26, 0x01, 0xAF };
+    const unsigned char vps[] = { 0x40, 0x01, 0x0C };
+    const unsigned char trailingFragment[] = { 0x62, 0x01, 0x81, 0xAF };
+    const unsigned char idrEnd[] = { 0x62, 0x01, 0x53, 0xAF };
+
+    ASSERT_TRUE(Overflow::H265Depacketizer::isNonIrapSlice(trailing, sizeof(trailing)));
+    ASSERT_TRUE(Overflow::H265Depacketizer::isNonIrapSlice(trailingFragment, sizeof(trailingFragment)));
+    ASSERT_FALSE(Overflow::H265Depacketizer::isNonIrapSlice(idr, sizeof(idr)));
+    ASSERT_FALSE(Overflow::H265Depacketizer::isNonIrapSlice(vps, sizeof(vps)));
+
+    ASSERT_TRUE(Overflow::H265Depacketizer::isEndOfNalUnit(idr, sizeof(idr)));
+    ASSERT_FALSE(Overflow::H265Depacketizer::isEndOfNalUnit(trailingFragment, sizeof(trailingFragment)));
+    ASSERT_TRUE(Overflow::H265Depacketizer::isEndOfNalUnit(idrEnd, sizeof(idrEnd)));
+}
+
+TEST(H265_DEPACKETIZER, LENGTH_PREFIXED_OUTPUT)
+{
+    Overflow::SessionDescription palette = makePalette("a=fmtp:96 sprop-max-don-diff=2");
+    Overflow::NaluWriter writer(Overflow::NALU_FORMAT_LENGTH_PREFIXED, 4);
+    Overflow::FrameBuffer frame(0);
+
+    // donl on the first fragment only
+    std::vector<std::vector<unsigned char>> packets = {
+        Helpers::makeRtpPacket(false, 1, 0, { 0x62, 0x01, 0x93, 0x00, 0x08, 0x01 }),
+        Helpers::makeRtpPacket(false, 2, 0, { 0x62, 0x01, 0x13, 0x02, 0x03 }),
+        Helpers::makeRtpPacket(true, 3, 0, { 0x62, 0x01, 0x53, 0x04 })
+    };
+    for (auto& raw: packets)
+    {
+        Overflow::RtpPacketView packet(&raw[0], raw.size());
+        Overflow::H265Depacketizer depacketizer(&palette, &packet, &writer);
+        depacketizer.addToFrame(&frame);
+    }
+
+    std::vector<unsigned char> expected = {
+        0x00, 0x00, 0x00, 0x06, 0x26, 0x01, 0x01, 0x02, 0x03, 0x04
+    };
+    ASSERT_EQ(expected, Helpers::frameBytes(frame));
+}
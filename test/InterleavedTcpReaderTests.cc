@@ -0,0 +1,204 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "InterleavedTcpReader.h"
+#include "Response.h"
+#include "RtspResponse.h"
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+
+class ReaderDelegate: public Overflow::IInterleavedReaderDelegate
+{
+public:
+    void onInterleavedPacket(int channel,
+                             const unsigned char* buffer,
+                             size_t length) override
+    {
+        channels.push_back(channel);
+        packets.push_back(std::string((const char*)buffer, length));
+    }
+
+    void onRtspMessage(const unsigned char* buffer,
+                       size_t length,
+                       const Overflow::RtspResponseParser& parsed) override
+    {
+        messages.push_back(std::string((const char*)buffer, length));
+
+        Overflow::Response response(buffer, length, &parsed);
+        Overflow::RtspResponse rtsp(&response);
+        codes.push_back(rtsp.getCode());
+        cseqs.push_back(rtsp.headerValueForKey("CSeq"));
+        bodies.push_back(rtsp.getBodyString());
+    }
+
+    std::vector<int> channels;
+    std::vector<std::string> packets;
+    std::vector<std::string> messages;
+    std::vector<int> codes;
+    std::vector<std::string> cseqs;
+    std::vector<std::string> bodies;
+};
+
+static std::string interleave(int channel, const std::string& payload)
+{
+    std::string frame;
+    frame += '$';
+    frame += (char)channel;
+    frame += (char)((payload.size() >> 8) & 0xFF);
+    frame += (char)(payload.size() & 0xFF);
+    return frame + payload;
+}
+
+
+TEST(INTERLEAVED_TCP_READER, WHOLE_PACKET_IS_NOT_COPIED)
+{
+    ReaderDelegate delegate;
+    Overflow::InterleavedTcpReader reader(&delegate);
+
+    std::string stream = interleave(0, "abcdef") + interleave(1, "xyz");
+    reader.feed((const unsigned char*)stream.c_str(), stream.size());
+
+    ASSERT_EQ(2, delegate.packets.size());
+    ASSERT_EQ(0, delegate.channels[0]);
+    ASSERT_STREQ("abcdef", delegate.packets[0].c_str());
+    ASSERT_EQ(1, delegate.channels[1]);
+    ASSERT_STREQ("xyz", delegate.packets[1].c_str());
+    ASSERT_EQ(0, reader.getReceiveBuffer().bytesCopied());
+    ASSERT_TRUE(reader.getReceiveBuffer().empty());
+}
+
+TEST(INTERLEAVED_TCP_READER, SPLIT_PACKET)
+{
+    ReaderDelegate delegate;
+    Overflow::InterleavedTcpReader reader(&delegate);
+
+    std::string stream = interleave(0, "abcdef");
+    reader.feed((const unsigned char*)stream.c_str(), 6);
+    ASSERT_EQ(0, delegate.packets.size());
+
+    reader.feed((const unsigned char*)stream.c_str() + 6, stream.size() - 6);
+    ASSERT_EQ(1, delegate.packets.size());
+    ASSERT_STREQ("abcdef", delegate.packets[0].c_str());
+    ASSERT_EQ(stream.size(), reader.getReceiveBuffer().bytesCopied());
+    ASSERT_TRUE(reader.getReceiveBuffer().empty());
+}
+
+TEST(INTERLEAVED_TCP_READER, RTSP_RESPONSE_THEN_RTP)
+{
+    ReaderDelegate delegate;
+    Overflow::InterleavedTcpReader reader(&delegate);
+
+    std::string response = "RTSP/1.0 200 OK\r\nCSeq: 1\r\nContent-Length: 4\r\n\r\nv=0\n";
+    std::string stream = response + interleave(0, "abc");
+
+    for (size_t i = 0; i < stream.size(); ++i)
+        reader.feed((const unsigned char*)stream.c_str() + i, 1);
+
+    ASSERT_EQ(1, delegate.messages.size());
+    ASSERT_STREQ(response.c_str(), delegate.messages[0].c_str());
+    ASSERT_EQ(1, delegate.packets.size());
+    ASSERT_STREQ("abc", delegate.packets[0].c_str());
+}
+
+TEST(INTERLEAVED_TCP_READER, RESPONSE_BUILT_FROM_PARSED_VIEWS)
+{
+    ReaderDelegate delegate;
+    Overflow::InterleavedTcpReader reader(&delegate);
+
+    std::string stream = "RTSP/1.0 454 Session Not Found\r\nCSeq: 7\r\nContent-Length: 4\r\n\r\nv=0\n"
+        + interleave(0, "abc");
+    reader.feed((const unsigned char*)stream.c_str(), stream.size());
+
+    // the views have to still be there when the delegate is called
+    ASSERT_EQ(1, delegate.codes.size());
+    ASSERT_EQ(454, delegate.codes[0]);
+    ASSERT_STREQ("7", delegate.cseqs[0].c_str());
+    ASSERT_STREQ("v=0\n", delegate.bodies[0].c_str());
+}
+
+TEST(INTERLEAVED_TCP_READER, EMPTY_FRAME_AT_END_OF_READ)
+{
+    ReaderDelegate delegate;
+    Overflow::InterleavedTcpReader reader(&delegate);
+
+    // a read ending on a zero length header, then one split after it
+    std::string empty = interleave(0, "");
+    reader.feed((const unsigned char*)empty.c_str(), empty.size());
+    ASSERT_TRUE(reader.getReceiveBuffer().empty());
+
+    std::string stream = empty + interleave(1, "abc");
+    reader.feed((const unsigned char*)stream.c_str(), 2);
+    reader.feed((const unsigned char*)stream.c_str() + 2, stream.size() - 2);
+
+    ASSERT_EQ(1, delegate.packets.size());
+    ASSERT_EQ(1, delegate.channels[0]);
+    ASSERT_STREQ("abc", delegate.packets[0].c_str());
+    ASSERT_TRUE(reader.getReceiveBuffer().empty());
+}
+
+TEST(INTERLEAVED_TCP_READER, BOGUS_CONTENT_LENGTH_IS_DROPPED)
+{
+    ReaderDelegate delegate;
+    Overflow::InterleavedTcpReader reader(&delegate);
+
+    std::string bogus = "RTSP/1.0 200 OK\r\nCSeq: 1\r\nContent-Length: 99999999999999999999999\r\n\r\n";
+    reader.feed((const unsigned char*)bogus.c_str(), bogus.size());
+
+    ASSERT_EQ(0, delegate.messages.size());
+    ASSERT_TRUE(reader.getReceiveBuffer().empty());
+
+    // framing picks up again with the next message
+    std::string stream = "RTSP/1.0 200 OK\r\nCSeq: 2\r\n\r\n" + interleave(0, "abc");
+    reader.feed((const unsigned char*)stream.c_str(), stream.size());
+
+    ASSERT_EQ(1, delegate.messages.size());
+    ASSERT_STREQ("2", delegate.cseqs[0].c_str());
+    ASSERT_EQ(1, delegate.packets.size());
+}
+
+TEST(RECEIVE_BUFFER, COMPACT_AND_GROW)
+{
+    Overflow::ReceiveBuffer buffer(8);
+
+    buffer.append((const unsigned char*)"abcdef", 6);
+    buffer.consume(4);
+    ASSERT_EQ(2, buffer.readableLength());
+
+    // moves "ef" to the front rather than growing
+    buffer.append((const unsigned char*)"ghij", 4);
+    ASSERT_EQ(8, buffer.capacity());
+    ASSERT_EQ(6, buffer.readableLength());
+    ASSERT_EQ(0, memcmp(buffer.readPointer(), "efghij", 6));
+
+    buffer.append((const unsigned char*)"klmnop", 6);
+    ASSERT_EQ(16, buffer.capacity());
+    ASSERT_EQ(12, buffer.readableLength());
+    ASSERT_EQ(0, memcmp(buffer.readPointer(), "efghijklmnop", 12));
+
+    buffer.consume(12);
+    ASSERT_TRUE(buffer.empty());
+    ASSERT_EQ(16, buffer.writableLength());
+}
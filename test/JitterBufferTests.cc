@@ -0,0 +1,215 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "JitterBuffer.h"
+
+#include "Util.h"
+
+#include <vector>
+
+
+namespace
+{
+    class Recorder: public Overflow::IJitterBufferDelegate
+    {
+    public:
+        Recorder() : lost(0) { }
+        
+        void onOrderedRtpPacket(const Overflow::RtpPacketView* packet,
+                                uint64_t arrivalMicroseconds) override
+        {
+            sequence.push_back(packet->getSequenceNumber());
+            arrivals.push_back(arrivalMicroseconds / 1000);
+        }
+
+        void onRtpPacketsLost(uint64_t count) override
+        {
+            lost += count;
+        }
+
+        std::vector<int> sequence;
+        std::vector<uint64_t> arrivals;
+        uint64_t lost;
+    };
+
+    void push(Overflow::JitterBuffer* buffer, uint16_t seq, uint64_t now)
+    {
+        std::vector<unsigned char> bytes =
+            OverflowTest::Helpers::makeRtpPacket(false, seq, 0, { 0x01 });
+        Overflow::RtpPacketView packet(&bytes[0], bytes.size());
+        buffer->push(&packet, now * 1000);
+    }
+};
+
+
+TEST(JITTER_BUFFER, REORDERS_WITHIN_LATENCY)
+{
+    Recorder recorder;
+    Overflow::JitterBuffer buffer(&recorder, 64, 50);
+
+    push(&buffer, 10, 0);
+    push(&buffer, 12, 1);
+    push(&buffer, 13, 2);
+    ASSERT_EQ(std::vector<int>({ 10 }), recorder.sequence);
+    ASSERT_EQ(2, buffer.getBufferedCount());
+    
+    push(&buffer, 11, 3);
+    ASSERT_EQ(std::vector<int>({ 10, 11, 12, 13 }), recorder.sequence);
+    // held packets keep the time they arrived
+    ASSERT_EQ(std::vector<uint64_t>({ 0, 3, 1, 2 }), recorder.arrivals);
+    ASSERT_EQ(0, buffer.getBufferedCount());
+    ASSERT_EQ(1, buffer.getReorderedCount());
+    ASSERT_EQ(0, buffer.getLostCount());
+}
+
+TEST(JITTER_BUFFER, DECLARES_LOSS_AFTER_DEADLINE)
+{
+    Recorder recorder;
+    Overflow::JitterBuffer buffer(&recorder, 64, 50);
+
+    push(&buffer, 1, 0);
+    push(&buffer, 4, 10);
+    push(&buffer, 5, 20);
+    ASSERT_EQ(std::vector<int>({ 1 }), recorder.sequence);
+    
+    push(&buffer, 6, 60);
+    ASSERT_EQ(std::vector<int>({ 1, 4, 5, 6 }), recorder.sequence);
+    ASSERT_EQ(2, recorder.lost);
+    ASSERT_EQ(2, buffer.getLostCount());
+
+    // too late now
+    push(&buffer, 2, 61);
+    ASSERT_EQ(1, buffer.getLateCount());
+    ASSERT_EQ(4, recorder.sequence.size());
+}
+
+TEST(JITTER_BUFFER, EXPIRE_RELEASES_HELD_PACKETS_WHEN_NOTHING_ARRIVES)
+{
+    Recorder recorder;
+    Overflow::JitterBuffer buffer(&recorder, 64, 50);
+
+    push(&buffer, 1, 0);
+    push(&buffer, 3, 10);
+    push(&buffer, 4, 11);
+    ASSERT_EQ(std::vector<int>({ 1 }), recorder.sequence);
+
+    // the stream stalls, only the timer comes by
+    buffer.expire(59 * 1000);
+    ASSERT_EQ(2, buffer.getBufferedCount());
+    
+    buffer.expire(60 * 1000);
+    ASSERT_EQ(std::vector<int>({ 1, 3, 4 }), recorder.sequence);
+    ASSERT_EQ(1, recorder.lost);
+    ASSERT_EQ(0, buffer.getBufferedCount());
+
+    // nothing held, nothing to do
+    buffer.expire(1000 * 1000);
+    ASSERT_EQ(1, recorder.lost);
+}
+
+TEST(JITTER_BUFFER, ZERO_LATENCY_PASSES_STRAIGHT_THROUGH)
+{
+    Recorder recorder;
+    Overflow::JitterBuffer buffer(&recorder, 64, 0);
+
+    push(&buffer, 100, 0);
+    push(&buffer, 102, 0);
+    push(&buffer, 101, 0);
+    ASSERT_EQ(std::vector<int>({ 100, 102 }), recorder.sequence);
+    ASSERT_EQ(1, buffer.getLostCount());
+    ASSERT_EQ(1, buffer.getLateCount());
+}
+
+TEST(JITTER_BUFFER, HANDLES_SEQUENCE_WRAPAROUND)
+{
+    Recorder recorder;
+    Overflow::JitterBuffer buffer(&recorder, 64, 50);
+
+    push(&buffer, 65534, 0);
+    push(&buffer, 0, 1);
+    push(&buffer, 65535, 2);
+    push(&buffer, 1, 3);
+    
+    ASSERT_EQ(std::vector<int>({ 65534, 65535, 0, 1 }), recorder.sequence);
+    ASSERT_EQ(0, buffer.getLostCount());
+}
+
+TEST(JITTER_BUFFER, SAME_SOURCE_RESTART_RESYNCS)
+{
+    Recorder recorder;
+    Overflow::JitterBuffer buffer(&recorder, 64, 50);
+
+    for (uint16_t seq = 10000; seq < 10005; ++seq)
+        push(&buffer, seq, 0);
+
+    // backwards, would otherwise all be late until 10005 came round again
+    for (uint16_t seq = 500; seq < 505; ++seq)
+        push(&buffer, seq, 1);
+    ASSERT_EQ(std::vector<int>({ 10000, 10001, 10002, 10003, 10004, 501, 502, 503, 504 }),
+              recorder.sequence);
+    ASSERT_EQ(0, buffer.getLateCount());
+    ASSERT_EQ(0, buffer.getLostCount());
+
+    // forwards by most of the sequence space, none of it lost
+    recorder.sequence.clear();
+    for (uint16_t seq = 40000; seq < 40003; ++seq)
+        push(&buffer, seq, 2);
+    ASSERT_EQ(std::vector<int>({ 40001, 40002 }), recorder.sequence);
+    ASSERT_EQ(0, buffer.getLostCount());
+
+    // a lone stray is dropped without moving anything
+    push(&buffer, 20000, 3);
+    push(&buffer, 40003, 3);
+    ASSERT_EQ(std::vector<int>({ 40001, 40002, 40003 }), recorder.sequence);
+    ASSERT_EQ(0, buffer.getLostCount());
+}
+
+TEST(JITTER_BUFFER, DROPS_DUPLICATES)
+{
+    Recorder recorder;
+    Overflow::JitterBuffer buffer(&recorder, 64, 50);
+
+    push(&buffer, 1, 0);
+    push(&buffer, 3, 1);
+    push(&buffer, 3, 2);
+    push(&buffer, 2, 3);
+    push(&buffer, 2, 4);
+
+    ASSERT_EQ(std::vector<int>({ 1, 2, 3 }), recorder.sequence);
+    ASSERT_EQ(1, buffer.getDuplicateCount());
+    ASSERT_EQ(1, buffer.getLateCount());
+}
+
+TEST(JITTER_BUFFER, JUMP_PAST_CAPACITY_FLUSHES)
+{
+    Recorder recorder;
+    Overflow::JitterBuffer buffer(&recorder, 8, 1000);
+
+    push(&buffer, 1, 0);
+    push(&buffer, 3, 0);
+    push(&buffer, 20, 0);
+    
+    ASSERT_EQ(std::vector<int>({ 1, 3, 20 }), recorder.sequence);
+    ASSERT_EQ(17, buffer.getLostCount());
+    ASSERT_EQ(0, buffer.getBufferedCount());
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "LoadGenerator.h"
+
+#include <string>
+#include <vector>
+
+
+TEST(LOAD_GENERATOR, PERCENTILE)
+{
+    std::vector<uint64_t> values;
+    for (uint64_t i = 100; i > 0; --i)
+        values.push_back(i);
+
+    ASSERT_EQ(51, OverflowTools::LoadGenerator::percentile(&values, 0.50));
+    ASSERT_EQ(100, OverflowTools::LoadGenerator::percentile(&values, 0.99));
+    ASSERT_EQ(100, OverflowTools::LoadGenerator::percentile(&values, 1.0));
+
+    std::vector<uint64_t> empty;
+    ASSERT_EQ(0, OverflowTools::LoadGenerator::percentile(&empty, 0.50));
+}
+
+TEST(LOAD_GENERATOR, JSON_REPORT)
+{
+    OverflowTools::LoadReport report;
+    report.durationSeconds = 2;
+    report.frames = 50;
+    report.bytes = 1000;
+    report.bitsPerSecond = 4000;
+    report.latencyP50Ms = -1;
+    report.latencyP99Ms = 1.5;
+    report.threads = 3;
+    report.residentBytes = 4096;
+    report.userCpuSeconds = 0.25;
+    report.systemCpuSeconds = 0.5;
+    report.mockCpuSeconds = 0;
+
+    OverflowTools::SessionReport session;
+    session.url = "rtsp://cam/\"a\"";
+    session.state = "play-ok";
+    session.frames = 50;
+    session.bytes = 1000;
+    session.packetsLost = 1;
+    session.reconnects = 0;
+    session.framesPerSecond = 25;
+    session.timeToFirstFrameSeconds = -1;
+    session.latencyP50Ms = -1;
+    session.latencyP99Ms = -1;
+    report.sessions.push_back(session);
+
+    std::string json = report.toJson();
+    ASSERT_NE(std::string::npos, json.find("\"bits_per_second\": 4000,"));
+    ASSERT_NE(std::string::npos, json.find("\"latency_p50_ms\": null,"));
+    ASSERT_NE(std::string::npos, json.find("\"latency_p99_ms\": 1.5,"));
+    ASSERT_NE(std::string::npos, json.find("\"url\": \"rtsp://cam/\\\"a\\\"\""));
+    ASSERT_NE(std::string::npos, json.find("\"frames_per_second\": 25"));
+    ASSERT_EQ('}', json[json.length() - 2]);
+}
+
+TEST(LOAD_GENERATOR, PROCESS_STATS)
+{
+    ASSERT_GE(OverflowTools::ProcessStats::threadCount(), 1);
+    ASSERT_GT(OverflowTools::ProcessStats::residentBytes(), 0u);
+
+    double user = -1;
+    double system = -1;
+    OverflowTools::ProcessStats::cpuSeconds(&user, &system);
+    ASSERT_GE(user, 0);
+    ASSERT_GE(system, 0);
+}
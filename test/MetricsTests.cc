@@ -0,0 +1,143 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "SessionMetrics.h"
+#include "MetricsExporter.h"
+#include "RtspWanClient.h"
+
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+TEST(METRICS, SNAPSHOT_COUNTS_AND_RATES)
+{
+    Overflow::SessionMetrics metrics;
+    Overflow::SessionMetricsWindow window;
+    metrics.onStateChange(Overflow::CLIENT_CONNECTING);
+    
+    Overflow::SessionMetricsSnapshot snapshot = metrics.snapshot(0, 0, &window);
+    ASSERT_EQ(-1, snapshot.timeToFirstFrameSeconds);
+    ASSERT_EQ(0, snapshot.reconnects);
+
+    for (int i = 0; i < 10; ++i)
+        metrics.onPacket(1000);
+    metrics.onFrame();
+    metrics.onStateChange(Overflow::CLIENT_PLAY_OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    snapshot = metrics.snapshot(3, 2, &window);
+    ASSERT_EQ(10000, snapshot.bytesReceived);
+    ASSERT_EQ(10, snapshot.packetsReceived);
+    ASSERT_EQ(1, snapshot.framesDelivered);
+    ASSERT_EQ(3, snapshot.packetsLost);
+    ASSERT_EQ(2, snapshot.packetsReordered);
+    ASSERT_EQ(Overflow::CLIENT_PLAY_OK, snapshot.state);
+    ASSERT_GE(snapshot.timeToFirstFrameSeconds, 0);
+    ASSERT_GT(snapshot.bitsPerSecond, 0);
+    ASSERT_GT(snapshot.framesPerSecond, 0);
+
+    // nothing new since the last look
+    snapshot = metrics.snapshot(3, 2, &window);
+    ASSERT_EQ(0, snapshot.bitsPerSecond);
+
+    metrics.onStateChange(Overflow::CLIENT_CONNECTING);
+    snapshot = metrics.snapshot(3, 2);
+    ASSERT_EQ(1, snapshot.reconnects);
+    ASSERT_EQ(-1, snapshot.timeToFirstFrameSeconds);
+}
+
+TEST(METRICS, EACH_READER_KEEPS_ITS_OWN_RATE_WINDOW)
+{
+    Overflow::SessionMetrics metrics;
+    Overflow::SessionMetricsWindow first, second;
+    metrics.snapshot(0, 0, &first);
+    metrics.snapshot(0, 0, &second);
+
+    metrics.onPacket(1000);
+    metrics.onFrame();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // another reader looking in, with or without a window of its own,
+    // leaves the first reader's rates alone
+    ASSERT_GT(metrics.snapshot(0, 0, &second).bitsPerSecond, 0);
+    ASSERT_EQ(0, metrics.snapshot(0, 0).bitsPerSecond);
+    
+    Overflow::SessionMetricsSnapshot snapshot = metrics.snapshot(0, 0, &first);
+    ASSERT_GT(snapshot.bitsPerSecond, 0);
+    ASSERT_GT(snapshot.framesPerSecond, 0);
+    ASSERT_EQ(snapshot.nanoseconds, first.nanoseconds);
+    ASSERT_EQ(1000, first.bytesReceived);
+}
+
+TEST(METRICS, RENDERS_PROMETHEUS_TEXT)
+{
+    Overflow::SessionMetrics metrics;
+    metrics.onPacket(1500);
+    
+    std::vector<std::pair<std::string, Overflow::SessionMetricsSnapshot>> sessions;
+    sessions.push_back(std::make_pair("cam\"1", metrics.snapshot(0, 0)));
+
+    std::string text = Overflow::MetricsExporter::render(sessions);
+    ASSERT_NE(std::string::npos, text.find("# TYPE overflow_rtp_bytes_received_total counter\n"));
+    ASSERT_NE(std::string::npos, text.find("overflow_rtp_bytes_received_total{session=\"cam\\\"1\"} 1500\n"));
+    ASSERT_NE(std::string::npos, text.find("overflow_client_state{session=\"cam\\\"1\",state=\"initialized\"} 1\n"));
+}
+
+TEST(METRICS, SERVES_HTTP_ENDPOINT)
+{
+    Overflow::RtspWanClient client(nullptr, "rtsp://127.0.0.1:8554/test");
+    
+    Overflow::MetricsExporter exporter;
+    ASSERT_TRUE(exporter.start(0));
+    exporter.add(&client, "front-door");
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(exporter.getPort());
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, connect(fd, (struct sockaddr*)&addr, sizeof(addr)));
+
+    std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_EQ((ssize_t)request.length(), send(fd, request.c_str(), request.length(), 0));
+
+    std::string response;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        response.append(buffer, received);
+    close(fd);
+
+    ASSERT_EQ(0, response.find("HTTP/1.1 200 OK\r\n"));
+    ASSERT_NE(std::string::npos, response.find("overflow_frames_total{session=\"front-door\"} 0\n"));
+
+    exporter.remove(&client);
+    exporter.stop();
+}
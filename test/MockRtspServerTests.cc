@@ -0,0 +1,332 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "MockRtspServer.h"
+#include "H264Depacketizer.h"
+#include "H265Depacketizer.h"
+#include "MJPEGDepacketizer.h"
+#include "MP4VDepacketizer.h"
+#include "SessionDescriptionFactory.h"
+#include "RtpPacketView.h"
+#include "RtcpPacket.h"
+#include "FrameBuffer.h"
+
+#include "Util.h"
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using OverflowTest::Helpers;
+
+
+static uint64_t steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename Depacketizer>
+static void depacketizeFrame(Overflow::SessionDescription* palette,
+                             const std::vector<OverflowMock::Bytes>& packets,
+                             Overflow::FrameBuffer* frame)
+{
+    for (size_t i = 0; i < packets.size(); ++i)
+    {
+        Overflow::RtpPacketView packet(packets[i].data(), packets[i].size());
+        Helpers::addPacketToFrame<Depacketizer>(palette, &packet, i == 0, frame);
+    }
+}
+
+static Overflow::SessionDescription describe(const OverflowMock::MockStream& stream)
+{
+    return Overflow::SessionDescriptionFactory::parseSessionDescriptions(stream.getSessionDescription())[0];
+}
+
+static int connectTo(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool readSome(int fd, std::string* buffer)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 2000) <= 0)
+        return false;
+
+    char data[4096];
+    ssize_t received = recv(fd, data, sizeof(data), 0);
+    if (received <= 0)
+        return false;
+    buffer->append(data, received);
+    return true;
+}
+
+// sends one request and returns the response including any body
+static std::string request(int fd, const std::string& method, int cseq, const std::string& extra = "")
+{
+    std::ostringstream out;
+    out << method << " rtsp://127.0.0.1/mock RTSP/1.0\r\n"
+        << "CSeq: " << cseq << "\r\n"
+        << extra
+        << "\r\n";
+    std::string data = out.str();
+    send(fd, data.c_str(), data.length(), 0);
+
+    std::string response;
+    size_t end;
+    while ((end = response.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (not readSome(fd, &response))
+            return response;
+    }
+
+    size_t length = 0;
+    size_t header = response.find("Content-Length: ");
+    if (header != std::string::npos)
+        length = atoi(response.c_str() + header + 16);
+    
+    while (response.length() < end + 4 + length)
+    {
+        if (not readSome(fd, &response))
+            break;
+    }
+    return response;
+}
+
+
+TEST(MOCK_STREAM, H264_FRAMES_DEPACKETIZE_WITH_STAMP)
+{
+    OverflowMock::MockStreamOptions options;
+    options.bitrate = 2 * 1000 * 1000;
+    options.packetSize = 500;
+    options.gopLength = 2;
+    OverflowMock::MockStream stream(options);
+    Overflow::SessionDescription palette = describe(stream);
+    ASSERT_EQ(Overflow::H264, palette.getType());
+    ASSERT_FALSE(palette.getFmtpH264ConfigParameters().empty());
+
+    for (uint64_t stamp = 1000; stamp < 1004; ++stamp)
+    {
+        std::vector<OverflowMock::Bytes> packets;
+        stream.nextFrame(stamp, &packets);
+
+        size_t payload = 0;
+        for (size_t i = 0; i < packets.size(); ++i)
+        {
+            ASSERT_LE(packets[i].size(), options.packetSize);
+            ASSERT_EQ(i + 1 == packets.size(), (packets[i][1] & 0x80) != 0);
+            payload += packets[i].size() - 12;
+        }
+        // within a few headers of bitrate / fps
+        ASSERT_NEAR(options.bitrate / 8 / options.fps, payload, 200);
+        
+        // key frames lead with sps and pps
+        bool isKeyFrame = (stamp % 2) == 0;
+        ASSERT_EQ(isKeyFrame, (packets[0][12] & 0x1F) == 7);
+        
+        Overflow::FrameBuffer frame(0);
+        depacketizeFrame<Overflow::H264Depacketizer>(&palette, packets, &frame);
+
+        uint64_t found = 0;
+        ASSERT_TRUE(OverflowMock::MockStream::findFrameStamp(frame.bytesPointer(), frame.length(), &found));
+        ASSERT_EQ(stamp, found);
+    }
+}
+
+TEST(MOCK_STREAM, H265_FRAMES_DEPACKETIZE_WITH_STAMP)
+{
+    OverflowMock::MockStreamOptions options;
+    options.codec = OverflowMock::MOCK_H265;
+    options.packetSize = 500;
+    options.gopLength = 2;
+    OverflowMock::MockStream stream(options);
+    Overflow::SessionDescription palette = describe(stream);
+    ASSERT_EQ(Overflow::H265, palette.getType());
+
+    for (uint64_t stamp = 1000; stamp < 1004; ++stamp)
+    {
+        std::vector<OverflowMock::Bytes> packets;
+        stream.nextFrame(stamp, &packets);
+
+        for (size_t i = 0; i < packets.size(); ++i)
+            ASSERT_LE(packets[i].size(), options.packetSize);
+
+        // key frames lead with an ap, the slice is always fragmented
+        bool isKeyFrame = (stamp % 2) == 0;
+        ASSERT_EQ(isKeyFrame, ((packets[0][12] >> 1) & 0x3F) == 48);
+        ASSERT_EQ(49, (packets.back()[12] >> 1) & 0x3F);
+
+        Overflow::FrameBuffer frame(0);
+        Overflow::FrameMetadata metadata;
+        for (size_t i = 0; i < packets.size(); ++i)
+        {
+            Overflow::RtpPacketView packet(packets[i].data(), packets[i].size());
+            Overflow::H265Depacketizer depacketizer(&palette, &packet);
+            depacketizer.addToFrame(&frame, &metadata);
+        }
+        ASSERT_EQ(isKeyFrame, metadata.isKeyFrame);
+        ASSERT_EQ(isKeyFrame, metadata.hasParameterSets);
+
+        uint64_t found = 0;
+        ASSERT_TRUE(OverflowMock::MockStream::findFrameStamp(frame.bytesPointer(), frame.length(), &found));
+        ASSERT_EQ(stamp, found);
+    }
+}
+
+TEST(MOCK_STREAM, MJPEG_AND_MP4V_FRAMES_CARRY_STAMP)
+{
+    OverflowMock::MockCodec codecs[] = { OverflowMock::MOCK_MJPEG, OverflowMock::MOCK_MP4V };
+    for (auto codec: codecs)
+    {
+        OverflowMock::MockStreamOptions options;
+        options.codec = codec;
+        OverflowMock::MockStream stream(options);
+        Overflow::SessionDescription palette = describe(stream);
+        
+        std::vector<OverflowMock::Bytes> packets;
+        stream.nextFrame(0x1234567890ULL, &packets);
+        ASSERT_GT(packets.size(), 1u);
+
+        Overflow::FrameBuffer frame(0);
+        if (codec == OverflowMock::MOCK_MJPEG)
+        {
+            ASSERT_EQ(Overflow::MJPEG, palette.getType());
+            depacketizeFrame<Overflow::MJPEGDepacketizer>(&palette, packets, &frame);
+        }
+        else
+        {
+            ASSERT_EQ(Overflow::MP4V, palette.getType());
+            depacketizeFrame<Overflow::MP4VDepacketizer>(&palette, packets, &frame);
+        }
+
+        uint64_t found = 0;
+        ASSERT_TRUE(OverflowMock::MockStream::findFrameStamp(frame.bytesPointer(), frame.length(), &found));
+        ASSERT_EQ(0x1234567890ULL, found);
+    }
+}
+
+TEST(MOCK_RTSP_SERVER, HANDSHAKE_THEN_INTERLEAVED_RTP)
+{
+    OverflowMock::MockStreamOptions options;
+    options.fps = 50;
+    OverflowMock::MockRtspServer server(options);
+    ASSERT_TRUE(server.start());
+
+    int fd = connectTo(server.getPort());
+    ASSERT_GE(fd, 0);
+
+    ASSERT_EQ(0u, request(fd, "OPTIONS", 1).find("RTSP/1.0 200 OK"));
+    
+    std::string describeResponse = request(fd, "DESCRIBE", 2);
+    ASSERT_EQ(0u, describeResponse.find("RTSP/1.0 200 OK"));
+    std::string body = describeResponse.substr(describeResponse.find("\r\n\r\n") + 4);
+    auto sessions = Overflow::SessionDescriptionFactory::parseSessionDescriptions(body);
+    ASSERT_EQ(1u, sessions.size());
+    ASSERT_EQ(Overflow::H264, sessions[0].getType());
+    ASSERT_EQ("trackID=0", sessions[0].getControl());
+    
+    std::string setupResponse = request(fd, "SETUP", 3, "Transport: RTP/AVP/TCP;unicast;interleaved=2-3\r\n");
+    ASSERT_EQ(0u, setupResponse.find("RTSP/1.0 200 OK"));
+    ASSERT_NE(std::string::npos, setupResponse.find("interleaved=2-3"));
+    ASSERT_NE(std::string::npos, setupResponse.find("Session: "));
+    
+    std::string playResponse = request(fd, "PLAY", 4);
+    ASSERT_EQ(0u, playResponse.find("RTSP/1.0 200 OK"));
+
+    // whatever followed the play response is interleaved rtp
+    std::string pending = playResponse.substr(playResponse.find("\r\n\r\n") + 4);
+    Overflow::FrameBuffer frame(0);
+    int frames = 0;
+    int senderReports = 0;
+    uint64_t latest = 0;
+    
+    while (frames < 3)
+    {
+        if (pending.length() < 4 or pending.length() < 4 + (size_t)(((unsigned char)pending[2] << 8) | (unsigned char)pending[3]))
+        {
+            ASSERT_TRUE(readSome(fd, &pending));
+            continue;
+        }
+
+        ASSERT_EQ('$', pending[0]);
+        size_t length = ((unsigned char)pending[2] << 8) | (unsigned char)pending[3];
+        if (pending[1] == 3)
+        {
+            // a sender report leads the gop
+            Overflow::RtcpPacket report((const unsigned char*)pending.data() + 4, length);
+            ASSERT_TRUE(report.hasSenderReport());
+            ASSERT_EQ(0, frames);
+            senderReports++;
+            pending.erase(0, 4 + length);
+            continue;
+        }
+        ASSERT_EQ(2, pending[1]);
+        
+        Overflow::RtpPacketView packet((const unsigned char*)pending.data() + 4, length);
+        Overflow::H264Depacketizer depacketizer(&sessions[0], &packet);
+        depacketizer.addToFrame(&frame);
+        
+        if (packet.isMarked())
+        {
+            uint64_t stamp = 0;
+            ASSERT_TRUE(OverflowMock::MockStream::findFrameStamp(frame.bytesPointer(), frame.length(), &stamp));
+            ASSERT_GT(stamp, latest);
+            ASSERT_LE(stamp, steadyNanoseconds());
+            latest = stamp;
+            
+            frame.clear();
+            frames++;
+        }
+        pending.erase(0, 4 + length);
+    }
+
+    ASSERT_EQ(0u, request(fd, "TEARDOWN", 5).find("RTSP/1.0 200 OK"));
+    close(fd);
+    server.stop();
+
+    ASSERT_EQ(1, senderReports);
+    ASSERT_EQ(1u, server.getSessionsServed());
+    ASSERT_GE(server.getFramesSent(), 3u);
+    ASSERT_GT(server.getBytesSent(), 0u);
+}
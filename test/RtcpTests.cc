@@ -0,0 +1,265 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "RtcpPacket.h"
+#include "ReceptionStatistics.h"
+#include "RtpClock.h"
+#include "RtpPacketView.h"
+
+#include "Util.h"
+
+#include <stdexcept>
+#include <vector>
+
+
+using OverflowTest::Helpers;
+
+
+static const std::vector<unsigned char> SENDER_REPORT = {
+    // SR, 1 block, length 12 words
+    0x81, 0xC8, 0x00, 0x0C,
+    0xDE, 0xAD, 0xBE, 0xEF,     // sender ssrc
+    0xE1, 0x2A, 0x3B, 0x4C,     // ntp seconds
+    0x80, 0x00, 0x00, 0x00,     // ntp fraction
+    0x00, 0x01, 0x5F, 0x90,     // rtp timestamp 90000
+    0x00, 0x00, 0x00, 0x64,     // packets 100
+    0x00, 0x01, 0x86, 0xA0,     // octets 100000
+    0x01, 0x02, 0x03, 0x04,     // block ssrc
+    0x40, 0xFF, 0xFF, 0xFE,     // 1/4 lost, cumulative -2
+    0x00, 0x01, 0x00, 0x10,     // highest sequence
+    0x00, 0x00, 0x00, 0x20,     // jitter
+    0x11, 0x22, 0x33, 0x44,     // lsr
+    0x00, 0x01, 0x00, 0x00,     // dlsr
+    // SDES, 1 chunk, length 3 words
+    0x81, 0xCA, 0x00, 0x03,
+    0xDE, 0xAD, 0xBE, 0xEF,
+    0x01, 0x03, 'c', 'a',
+    'm', 0x00, 0x00, 0x00
+};
+
+
+TEST(RTCP, SENDER_REPORT_AND_CNAME)
+{
+    Overflow::RtcpPacket packet(&SENDER_REPORT[0], SENDER_REPORT.size());
+
+    ASSERT_TRUE(packet.hasSenderReport());
+    ASSERT_FALSE(packet.hasReceiverReport());
+    ASSERT_FALSE(packet.hasBye());
+    ASSERT_EQ(0xDEADBEEF, packet.getSsrc());
+    ASSERT_EQ(0xE12A3B4C80000000ULL, packet.getNtpTimestamp());
+    ASSERT_EQ(90000, packet.getRtpTimestamp());
+    ASSERT_EQ(100, packet.getSenderPacketCount());
+    ASSERT_EQ(100000, packet.getSenderOctetCount());
+    ASSERT_EQ("cam", packet.getCname());
+
+    ASSERT_EQ(1, packet.getReportBlocks().size());
+    const Overflow::RtcpReportBlock& block = packet.getReportBlocks()[0];
+    ASSERT_EQ(0x01020304, block.ssrc);
+    ASSERT_EQ(0x40, block.fractionLost);
+    ASSERT_EQ(-2, block.cumulativeLost);
+    ASSERT_EQ(0x00010010, block.highestSequence);
+    ASSERT_EQ(0x20, block.jitter);
+    ASSERT_EQ(0x11223344, block.lastSenderReport);
+    ASSERT_EQ(0x10000, block.delaySinceLastSenderReport);
+}
+
+TEST(RTCP, BYE_AND_UNKNOWN_TYPES)
+{
+    std::vector<unsigned char> raw = {
+        // RR, no blocks
+        0x80, 0xC9, 0x00, 0x01,
+        0x00, 0x00, 0x00, 0x07,
+        // APP is skipped
+        0x80, 0xCC, 0x00, 0x02,
+        0x00, 0x00, 0x00, 0x07,
+        'n', 'a', 'm', 'e',
+        // BYE for two sources
+        0x82, 0xCB, 0x00, 0x02,
+        0x00, 0x00, 0x00, 0x07,
+        0x00, 0x00, 0x00, 0x08
+    };
+    Overflow::RtcpPacket packet(&raw[0], raw.size());
+
+    ASSERT_TRUE(packet.hasReceiverReport());
+    ASSERT_FALSE(packet.hasSenderReport());
+    ASSERT_EQ(7, packet.getSsrc());
+    ASSERT_TRUE(packet.getReportBlocks().empty());
+    ASSERT_TRUE(packet.hasBye());
+    ASSERT_EQ(2, packet.getByeSsrcs().size());
+    ASSERT_EQ(8, packet.getByeSsrcs()[1]);
+}
+
+TEST(RTCP, INVALID)
+{
+    std::vector<unsigned char> raw(SENDER_REPORT);
+    ASSERT_THROW(Overflow::RtcpPacket(&raw[0], 2), std::runtime_error);
+    
+    // length runs past the end
+    ASSERT_THROW(Overflow::RtcpPacket(&raw[0], 40), std::runtime_error);
+
+    // claims more blocks than it carries
+    raw[0] = 0x82;
+    ASSERT_THROW(Overflow::RtcpPacket(&raw[0], raw.size()), std::runtime_error);
+
+    raw[0] = 0x41;
+    ASSERT_THROW(Overflow::RtcpPacket(&raw[0], raw.size()), std::runtime_error);
+}
+
+TEST(RTCP, RECEIVER_REPORT_ROUND_TRIP)
+{
+    Overflow::RtcpReportBlock block;
+    block.ssrc = 0xDEADBEEF;
+    block.fractionLost = 12;
+    block.cumulativeLost = 300;
+    block.highestSequence = 70000;
+    block.jitter = 45;
+    block.lastSenderReport = 0x3B4C8000;
+    block.delaySinceLastSenderReport = 32768;
+
+    unsigned char buffer[512];
+    size_t length = Overflow::RtcpPacket::writeReceiverReport(buffer, sizeof(buffer), 42, &block, "overflow@test");
+    ASSERT_EQ(0, length % 4);
+    ASSERT_EQ(0, Overflow::RtcpPacket::writeReceiverReport(buffer, 40, 42, &block, "overflow@test"));
+
+    Overflow::RtcpPacket packet(buffer, length);
+    ASSERT_TRUE(packet.hasReceiverReport());
+    ASSERT_EQ(42, packet.getSsrc());
+    ASSERT_EQ("overflow@test", packet.getCname());
+    ASSERT_EQ(1, packet.getReportBlocks().size());
+    
+    const Overflow::RtcpReportBlock& parsed = packet.getReportBlocks()[0];
+    ASSERT_EQ(block.ssrc, parsed.ssrc);
+    ASSERT_EQ(block.fractionLost, parsed.fractionLost);
+    ASSERT_EQ(block.cumulativeLost, parsed.cumulativeLost);
+    ASSERT_EQ(block.highestSequence, parsed.highestSequence);
+    ASSERT_EQ(block.jitter, parsed.jitter);
+    ASSERT_EQ(block.lastSenderReport, parsed.lastSenderReport);
+    ASSERT_EQ(block.delaySinceLastSenderReport, parsed.delaySinceLastSenderReport);
+}
+
+static void feed(Overflow::ReceptionStatistics* statistics, int sequence, uint32_t timestamp, uint64_t arrival)
+{
+    std::vector<unsigned char> raw = Helpers::makeRtpPacket(false, sequence, timestamp, { 0x41 });
+    Overflow::RtpPacketView packet(&raw[0], raw.size());
+    statistics->onRtpPacket(&packet, arrival);
+}
+
+TEST(RTCP, STEADY_ARRIVAL_HAS_NO_JITTER)
+{
+    Overflow::ReceptionStatistics statistics;
+    for (int i = 0; i < 100; ++i)
+        feed(&statistics, i, i * 3600, i * 40000);
+
+    Overflow::RtcpReportBlock block;
+    ASSERT_TRUE(statistics.makeReportBlock(4000000, &block));
+    ASSERT_EQ(0, block.jitter);
+    ASSERT_EQ(0, block.fractionLost);
+    ASSERT_EQ(0, block.cumulativeLost);
+    ASSERT_EQ(99, block.highestSequence);
+    ASSERT_EQ(0, block.lastSenderReport);
+    ASSERT_DOUBLE_EQ(0, statistics.getJitterSeconds());
+}
+
+TEST(RTCP, JITTER_CONVERGES_ON_TRANSIT_VARIATION)
+{
+    // every other packet is 10ms late, D is 900 ticks each time
+    Overflow::ReceptionStatistics statistics;
+    for (int i = 0; i < 500; ++i)
+        feed(&statistics, i, i * 3600, i * 40000 + (i % 2) * 10000);
+
+    Overflow::RtcpReportBlock block;
+    ASSERT_TRUE(statistics.makeReportBlock(20000000, &block));
+    ASSERT_NEAR(900, block.jitter, 2);
+    ASSERT_NEAR(0.01, statistics.getJitterSeconds(), 0.0001);
+}
+
+TEST(RTCP, LOSS_FRACTION_AND_SEQUENCE_WRAP)
+{
+    Overflow::ReceptionStatistics statistics;
+    Overflow::RtcpReportBlock block;
+    ASSERT_FALSE(statistics.makeReportBlock(0, &block));
+    
+    // 65500 .. 65535, 0 .. 62 with every fourth one missing
+    int sent = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i % 4 == 3)
+            continue;
+        feed(&statistics, (65500 + i) & 0xFFFF, i * 3600, i * 40000);
+        ++sent;
+    }
+
+    ASSERT_TRUE(statistics.makeReportBlock(4000000, &block));
+    ASSERT_EQ(65536 + 62, block.highestSequence);
+    ASSERT_EQ(75, sent);
+    ASSERT_EQ(24, block.cumulativeLost);
+    ASSERT_EQ(24 * 256 / 99, block.fractionLost);
+    ASSERT_EQ(24 * 256 / 99, statistics.getFractionLost());
+    ASSERT_EQ(24, statistics.getCumulativeLost());
+
+    // nothing lost in the next interval
+    for (int i = 99; i < 110; ++i)
+        feed(&statistics, (65500 + i) & 0xFFFF, i * 3600, i * 40000);
+    ASSERT_TRUE(statistics.makeReportBlock(4400000, &block));
+    ASSERT_EQ(0, block.fractionLost);
+    ASSERT_EQ(24, block.cumulativeLost);
+}
+
+TEST(RTCP, LAST_SENDER_REPORT_AND_DELAY)
+{
+    Overflow::ReceptionStatistics statistics;
+    feed(&statistics, 1, 0, 0);
+
+    Overflow::RtcpPacket report(&SENDER_REPORT[0], SENDER_REPORT.size());
+    statistics.onSenderReport(&report, 1000000);
+
+    Overflow::RtcpReportBlock block;
+    ASSERT_TRUE(statistics.makeReportBlock(1500000, &block));
+    ASSERT_EQ(0x3B4C8000, block.lastSenderReport);
+    ASSERT_EQ(32768, block.delaySinceLastSenderReport);
+}
+
+TEST(RTCP, RTP_CLOCK_COUNTS_WRAPS)
+{
+    Overflow::RtpClock clock;
+    ASSERT_EQ(0xFFFFF000u, clock.extend(0xFFFFF000));
+    ASSERT_EQ(0x100000800ULL, clock.extend(0x800));
+    // a b-frame stepping back over the wrap
+    ASSERT_EQ(0xFFFFFF00ULL, clock.extend(0xFFFFFF00));
+    ASSERT_EQ(0x100001000ULL, clock.extend(0x1000));
+}
+
+TEST(RTCP, RTP_CLOCK_MAPS_THROUGH_SENDER_REPORT)
+{
+    Overflow::RtpClock clock;
+    ASSERT_FALSE(clock.hasWallClock());
+    ASSERT_EQ(-1, clock.toWallClockMicroseconds(0));
+
+    // 1970 plus 10.5 seconds at rtp time 0xFFFFFF00
+    uint64_t ntp = ((2208988800ULL + 10) << 32) | 0x80000000;
+    clock.onSenderReport(ntp, 0xFFFFFF00);
+    ASSERT_TRUE(clock.hasWallClock());
+    
+    ASSERT_EQ(10500000, clock.toWallClockMicroseconds(0xFFFFFF00));
+    ASSERT_EQ(10500000 + 1000000, clock.toWallClockMicroseconds(0x100000000ULL + 90000 - 0x100));
+    ASSERT_EQ(10500000 - 40000, clock.toWallClockMicroseconds(0xFFFFFF00 - 3600));
+}
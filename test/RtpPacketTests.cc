@@ -0,0 +1,96 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "RtpPacketView.h"
+#include "RtpPacket.h"
+
+#include "Util.h"
+
+#include <stdexcept>
+#include <vector>
+
+
+using OverflowTest::Helpers;
+
+
+TEST(RTP_PACKET, VIEW_POINTS_INTO_BUFFER)
+{
+    std::vector<unsigned char> raw = Helpers::makeRtpPacket(true, 65535, 90000, { 0x65, 1, 2, 3 });
+    Overflow::RtpPacketView view(&raw[0], raw.size());
+
+    ASSERT_EQ(2, view.getVersion());
+    ASSERT_EQ(96, view.getType());
+    ASSERT_EQ(65535, view.getSequenceNumber());
+    ASSERT_EQ(90000, view.getTimestamp());
+    ASSERT_EQ(0xDEADBEEF, view.getSsrc());
+    ASSERT_TRUE(view.isMarked());
+    ASSERT_FALSE(view.hasExtension());
+    ASSERT_EQ(4, view.payloadLength());
+    ASSERT_EQ(&raw[12], view.payloadData());
+}
+
+TEST(RTP_PACKET, EXTENSION_AND_PADDING)
+{
+    std::vector<unsigned char> raw = Helpers::makeRtpPacket(false, 1, 0, {
+            0xAB, 0xAC, 0x00, 0x01,     // extension id + length in words
+            0x01, 0x02, 0x03, 0x04,     // extension data
+            0x41, 0x42,                 // payload
+            0x00, 0x02                  // padding
+        });
+    raw[0] |= 0x30;
+
+    Overflow::RtpPacketView view(&raw[0], raw.size());
+    ASSERT_TRUE(view.hasExtension());
+    ASSERT_EQ(0xABAC, view.getExtensionID());
+    ASSERT_EQ(4, view.getExtensionLength());
+    ASSERT_EQ(0x01, view.getExtensionData()[0]);
+    ASSERT_EQ(2, view.payloadLength());
+    ASSERT_EQ(0x41, view.payloadData()[0]);
+}
+
+TEST(RTP_PACKET, CLONE_OWNS_BYTES)
+{
+    std::vector<unsigned char> raw = Helpers::makeRtpPacket(false, 7, 1234, { 0x41, 0x01 });
+    Overflow::RtpPacketView view(&raw[0], raw.size());
+
+    Overflow::RtpPacket *packet = view.clone();
+    raw.assign(raw.size(), 0);
+
+    ASSERT_EQ(7, packet->getSequenceNumber());
+    ASSERT_EQ(1234, packet->getTimestamp());
+    ASSERT_EQ(2, packet->payloadLength());
+    ASSERT_EQ(0x41, packet->payloadData()[0]);
+    delete packet;
+}
+
+TEST(RTP_PACKET, INVALID)
+{
+    std::vector<unsigned char> raw = Helpers::makeRtpPacket(false, 1, 0, { 0x41 });
+    ASSERT_THROW(Overflow::RtpPacketView(&raw[0], 8), std::runtime_error);
+
+    raw[0] = 0x40;
+    ASSERT_THROW(Overflow::RtpPacketView(&raw[0], raw.size()), std::runtime_error);
+
+    raw[0] = 0x90;
+    ASSERT_THROW(Overflow::RtpPacketView(&raw[0], raw.size()), std::runtime_error);
+}
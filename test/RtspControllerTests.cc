@@ -0,0 +1,403 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "ScriptedController.h"
+#include "MockStream.h"
+
+#include <vector>
+
+
+namespace
+{
+    class TimestampDelegate: public OverflowTest::PlayingDelegate
+    {
+    public:
+        void onFrame(Overflow::Frame * const frame) override
+        {
+            timestamps.push_back(*frame->getTimestamps());
+        }
+
+        std::vector<Overflow::FrameTimestamps> timestamps;
+    };
+
+    class MetadataDelegate: public OverflowTest::PlayingDelegate
+    {
+    public:
+        void onFrame(Overflow::Frame * const frame) override
+        {
+            metadata.push_back(*frame->getMetadata());
+        }
+
+        std::vector<Overflow::FrameMetadata> metadata;
+    };
+
+    class NalUnitsDelegate: public OverflowTest::PlayingDelegate
+    {
+    public:
+        void onFrame(Overflow::Frame * const frame) override
+        {
+            frames.push_back(std::vector<unsigned char>(frame->bytesPointer(),
+                                                        frame->bytesPointer() + frame->length()));
+        }
+
+        void onNalUnits(Overflow::Frame * const frame,
+                        const size_t offset,
+                        bool isEndOfAccessUnit) override
+        {
+            if (accessUnit.empty())
+                chunkCounts.push_back(0);
+            chunkCounts.back()++;
+
+            accessUnit.insert(accessUnit.end(),
+                              frame->bytesPointer() + offset,
+                              frame->bytesPointer() + frame->length());
+            if (isEndOfAccessUnit)
+            {
+                frames.push_back(accessUnit);
+                accessUnit.clear();
+            }
+        }
+
+        void onAccessUnitAborted() override
+        {
+            aborted.push_back(accessUnit.size());
+            accessUnit.clear();
+        }
+
+        std::vector<std::vector<unsigned char>> frames;
+        std::vector<unsigned char> accessUnit;
+        std::vector<int> chunkCounts;
+        std::vector<size_t> aborted;
+    };
+
+    std::vector<std::vector<unsigned char>> playNalUnits(bool subFrameDelivery, std::vector<int>* chunkCounts)
+    {
+        OverflowMock::MockStreamOptions options;
+        options.gopLength = 2;
+        OverflowMock::MockStream stream(options);
+        auto frames = OverflowTest::makeFrames(&stream, 3);
+
+        Overflow::EventLoop loop;
+        loop.start();
+
+        NalUnitsDelegate delegate;
+        {
+            OverflowTest::ScriptedController controller(&delegate, &loop, stream.getSessionDescription());
+            controller.setSubFrameDelivery(subFrameDelivery);
+            controller.start();
+            delegate.waitUntilPlaying();
+
+            controller.runOnLoop([&](OverflowTest::ScriptedTransport* transport) {
+                    for (auto& frame: frames)
+                        transport->deliver(frame);
+                });
+        }
+        loop.stop();
+        loop.join();
+
+        *chunkCounts = delegate.chunkCounts;
+        return delegate.frames;
+    }
+
+    std::vector<Overflow::FrameMetadata> playFrames(OverflowMock::MockCodec codec, int count,
+                                                    bool keyFramesOnly = false, int first = 0)
+    {
+        OverflowMock::MockStreamOptions options;
+        options.codec = codec;
+        options.gopLength = 4;
+        OverflowMock::MockStream stream(options);
+        auto frames = OverflowTest::makeFrames(&stream, count);
+        
+        Overflow::EventLoop loop;
+        loop.start();
+
+        MetadataDelegate delegate;
+        {
+            OverflowTest::ScriptedController controller(&delegate, &loop, stream.getSessionDescription());
+            controller.setKeyFramesOnly(keyFramesOnly);
+            controller.start();
+            delegate.waitUntilPlaying();
+
+            controller.runOnLoop([&](OverflowTest::ScriptedTransport* transport) {
+                    for (size_t i = first; i < frames.size(); ++i)
+                        transport->deliver(frames[i]);
+                });
+        }
+        loop.stop();
+        loop.join();
+        return delegate.metadata;
+    }
+};
+
+
+TEST(RTSP_CONTROLLER, FRAMES_CARRY_RTP_AND_WALL_CLOCK_TIME)
+{
+    OverflowMock::MockStream stream((OverflowMock::MockStreamOptions()));
+    auto frames = OverflowTest::makeFrames(&stream, 3);
+
+    // ties the rtp time after the last frame to this wall-clock time
+    const uint64_t reportTime = 1500000000000000ULL;
+    OverflowMock::Bytes senderReport;
+    stream.makeSenderReport(reportTime, &senderReport);
+    
+    Overflow::EventLoop loop;
+    loop.start();
+
+    TimestampDelegate delegate;
+    {
+        OverflowTest::ScriptedController controller(&delegate, &loop, stream.getSessionDescription());
+        controller.start();
+        delegate.waitUntilPlaying();
+
+        controller.runOnLoop([&](OverflowTest::ScriptedTransport* transport) {
+                transport->deliver(frames[0]);
+                transport->deliverRtcp(senderReport);
+                transport->deliver(frames[1]);
+                transport->deliver(frames[2]);
+            });
+    }
+    loop.stop();
+    loop.join();
+
+    ASSERT_EQ(3u, delegate.timestamps.size());
+    for (size_t i = 0; i < delegate.timestamps.size(); ++i)
+    {
+        const Overflow::FrameTimestamps& timestamps = delegate.timestamps[i];
+        ASSERT_EQ(i * 3600, timestamps.rtpTimestamp);
+        ASSERT_EQ(i * 3600, timestamps.extendedTimestamp);
+        ASSERT_EQ(90000, timestamps.clockRate);
+        ASSERT_GT(timestamps.firstPacketMicroseconds, 0u);
+        ASSERT_LE(timestamps.firstPacketMicroseconds, timestamps.lastPacketMicroseconds);
+    }
+
+    // nothing to map with until the sender report, 40ms a frame after it
+    ASSERT_EQ(-1, delegate.timestamps[0].wallClockMicroseconds);
+    ASSERT_EQ((int64_t)reportTime - 80000, delegate.timestamps[1].wallClockMicroseconds);
+    ASSERT_EQ((int64_t)reportTime - 40000, delegate.timestamps[2].wallClockMicroseconds);
+}
+
+TEST(RTSP_CONTROLLER, LOSS_DROPS_THE_DAMAGED_FRAME_ONLY)
+{
+    OverflowMock::MockStream stream((OverflowMock::MockStreamOptions()));
+    auto frames = OverflowTest::makeFrames(&stream, 6);
+    ASSERT_GT(frames[1].size(), 2u);
+
+    // the head of frame 2 right after a marker, the middle of frame 4
+    frames[2].erase(frames[2].begin());
+    frames[4].erase(frames[4].begin() + 1);
+
+    Overflow::EventLoop loop;
+    loop.start();
+
+    TimestampDelegate delegate;
+    {
+        OverflowTest::ScriptedController controller(&delegate, &loop, stream.getSessionDescription());
+        controller.setReorderLatency(0);
+        controller.start();
+        delegate.waitUntilPlaying();
+
+        controller.runOnLoop([&](OverflowTest::ScriptedTransport* transport) {
+                for (auto& frame: frames)
+                    transport->deliver(frame);
+            });
+    }
+    loop.stop();
+    loop.join();
+
+    std::vector<uint32_t> stamps;
+    for (auto& timestamps: delegate.timestamps)
+        stamps.push_back(timestamps.rtpTimestamp);
+    std::vector<uint32_t> expected = { 0, 3600, 3 * 3600, 5 * 3600 };
+    ASSERT_EQ(expected, stamps);
+}
+
+TEST(RTSP_CONTROLLER, LOSS_ABORTS_PARTLY_DELIVERED_ACCESS_UNIT)
+{
+    OverflowMock::MockStreamOptions options;
+    options.gopLength = 2;
+    OverflowMock::MockStream stream(options);
+    auto frames = OverflowTest::makeFrames(&stream, 3);
+    ASSERT_GT(frames[1].size(), 3u);
+
+    // well into frame 1, after some of its nal units have gone out
+    frames[1].erase(frames[1].end() - 2);
+
+    Overflow::EventLoop loop;
+    loop.start();
+
+    NalUnitsDelegate delegate;
+    {
+        OverflowTest::ScriptedController controller(&delegate, &loop, stream.getSessionDescription());
+        controller.setSubFrameDelivery(true);
+        controller.setReorderLatency(0);
+        controller.start();
+        delegate.waitUntilPlaying();
+
+        controller.runOnLoop([&](OverflowTest::ScriptedTransport* transport) {
+                for (auto& frame: frames)
+                    transport->deliver(frame);
+            });
+    }
+    loop.stop();
+    loop.join();
+
+    ASSERT_EQ(1u, delegate.aborted.size());
+    ASSERT_GT(delegate.aborted[0], 0u);
+    // frames 0 and 2 whole, nothing of frame 1 ends up in either
+    ASSERT_EQ(2u, delegate.frames.size());
+    ASSERT_EQ(3u, delegate.chunkCounts.size());
+    ASSERT_TRUE(delegate.accessUnit.empty());
+}
+
+TEST(RTSP_CONTROLLER, H264_FRAMES_FLAG_IDR)
+{
+    auto metadata = playFrames(OverflowMock::MOCK_H264, 6);
+    
+    ASSERT_EQ(6u, metadata.size());
+    for (size_t i = 0; i < metadata.size(); ++i)
+    {
+        bool isKeyFrame = i % 4 == 0;
+        ASSERT_EQ(isKeyFrame, metadata[i].isKeyFrame) << i;
+        ASSERT_EQ(isKeyFrame, metadata[i].hasParameterSets) << i;
+        ASSERT_EQ(isKeyFrame ? Overflow::SLICE_TYPE_I : Overflow::SLICE_TYPE_P, metadata[i].sliceType) << i;
+        // sei rides along on every frame
+        ASSERT_NE(0u, metadata[i].naluTypes & (1u << 6));
+    }
+}
+
+TEST(RTSP_CONTROLLER, MP4V_AND_MJPEG_FRAMES_FLAG_INTRA)
+{
+    auto vops = playFrames(OverflowMock::MOCK_MP4V, 6);
+    ASSERT_EQ(6u, vops.size());
+    for (size_t i = 0; i < vops.size(); ++i)
+    {
+        ASSERT_EQ(i % 4 == 0, vops[i].isKeyFrame) << i;
+        ASSERT_EQ(i % 4 == 0 ? Overflow::SLICE_TYPE_I : Overflow::SLICE_TYPE_P, vops[i].sliceType) << i;
+    }
+    // the sdp config goes in front of the first frame
+    ASSERT_TRUE(vops[0].hasParameterSets);
+
+    auto jpegs = playFrames(OverflowMock::MOCK_MJPEG, 3);
+    ASSERT_EQ(3u, jpegs.size());
+    for (auto& jpeg: jpegs)
+    {
+        ASSERT_TRUE(jpeg.isKeyFrame);
+        ASSERT_EQ(Overflow::SLICE_TYPE_I, jpeg.sliceType);
+    }
+}
+
+TEST(RTSP_CONTROLLER, KEY_FRAMES_ONLY_DROPS_DELTA_FRAMES)
+{
+    auto idrs = playFrames(OverflowMock::MOCK_H264, 10, true);
+    ASSERT_EQ(3u, idrs.size());
+    for (auto& idr: idrs)
+    {
+        EXPECT_TRUE(idr.isKeyFrame);
+        EXPECT_TRUE(idr.hasParameterSets);
+        EXPECT_EQ(Overflow::SLICE_TYPE_I, idr.sliceType);
+    }
+
+    auto vops = playFrames(OverflowMock::MOCK_MP4V, 10, true);
+    ASSERT_EQ(3u, vops.size());
+    for (auto& vop: vops)
+    {
+        EXPECT_TRUE(vop.isKeyFrame);
+        EXPECT_EQ(Overflow::SLICE_TYPE_I, vop.sliceType);
+    }
+}
+
+TEST(RTSP_CONTROLLER, KEY_FRAMES_ONLY_JOINING_MID_GOP_WAITS_FOR_IDR)
+{
+    auto idrs = playFrames(OverflowMock::MOCK_H264, 6, true, 1);
+    ASSERT_EQ(1u, idrs.size());
+    EXPECT_TRUE(idrs[0].isKeyFrame);
+    EXPECT_TRUE(idrs[0].hasParameterSets);
+}
+
+TEST(RTSP_CONTROLLER, LATE_SUBSCRIBER_STARTS_FROM_CACHED_GOP)
+{
+    OverflowMock::MockStreamOptions options;
+    options.gopLength = 4;
+    OverflowMock::MockStream stream(options);
+    auto frames = OverflowTest::makeFrames(&stream, 7);
+
+    Overflow::EventLoop loop;
+    loop.start();
+
+    Overflow::FrameQueue early(8);
+    Overflow::FrameQueue late(8);
+    MetadataDelegate delegate;
+    {
+        OverflowTest::ScriptedController controller(&delegate, &loop, stream.getSessionDescription());
+        controller.setGopCacheBudget(16 << 20);
+        controller.subscribe(&early);
+        controller.start();
+        delegate.waitUntilPlaying();
+
+        // idr at 0 and 4, the late one joins two frames into the second gop
+        controller.runOnLoop([&](OverflowTest::ScriptedTransport* transport) {
+                for (size_t i = 0; i < 6; ++i)
+                    transport->deliver(frames[i]);
+            });
+        controller.subscribe(&late);
+        controller.runOnLoop([&](OverflowTest::ScriptedTransport* transport) {
+                transport->deliver(frames[6]);
+            });
+        controller.unsubscribe(&early);
+        controller.unsubscribe(&late);
+    }
+    loop.stop();
+    loop.join();
+
+    ASSERT_EQ(7u, delegate.metadata.size());
+    ASSERT_EQ(7u, early.size());
+
+    std::vector<uint32_t> stamps;
+    while (Overflow::Frame *frame = late.tryPop())
+    {
+        ASSERT_EQ(stamps.empty(), frame->isKeyFrame());
+        stamps.push_back(frame->getTimestamps()->rtpTimestamp);
+        frame->release();
+    }
+    std::vector<uint32_t> expected = { 4 * 3600, 5 * 3600, 6 * 3600 };
+    ASSERT_EQ(expected, stamps);
+
+    while (Overflow::Frame *frame = early.tryPop())
+        frame->release();
+}
+
+TEST(RTSP_CONTROLLER, SUB_FRAME_DELIVERY_HANDS_OUT_NAL_UNITS_AS_THEY_COMPLETE)
+{
+    std::vector<int> chunkCounts;
+    auto whole = playNalUnits(false, &chunkCounts);
+    ASSERT_EQ(3u, whole.size());
+    ASSERT_TRUE(chunkCounts.empty());
+
+    auto joined = playNalUnits(true, &chunkCounts);
+    ASSERT_EQ(whole, joined);
+
+    // sps, pps, sei and the slice of the idr, sei and slice after it
+    ASSERT_EQ(3u, chunkCounts.size());
+    ASSERT_EQ(4, chunkCounts[0]);
+    ASSERT_EQ(2, chunkCounts[1]);
+    ASSERT_EQ(4, chunkCounts[2]);
+}
@@ -0,0 +1,111 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "RtspResponseParser.h"
+
+#include <string>
+
+
+TEST(RTSP_RESPONSE_PARSER, HEADERS_AND_BODY)
+{
+    const std::string response =
+        "RTSP/1.0 200 OK\r\n"
+        "CSeq: 2\r\n"
+        "content-length:   5\r\n"
+        "Session: 1234;timeout=60\r\n"
+        "\r\n"
+        "v=0\r\n";
+
+    Overflow::RtspResponseParser parser;
+    ASSERT_TRUE(parser.parse((const unsigned char*)response.c_str(), response.size()));
+
+    ASSERT_EQ(200, parser.getCode());
+    ASSERT_EQ(3, parser.getHeaderCount());
+    ASSERT_EQ(5, parser.getContentLength());
+    ASSERT_EQ(response.size(), parser.getMessageLength());
+    ASSERT_STREQ("CSeq", parser.getHeaderKey(0).toString().c_str());
+    ASSERT_STREQ("2", parser.getHeaderValue(0).toString().c_str());
+    ASSERT_STREQ("1234;timeout=60", parser.headerValueForKey("session").toString().c_str());
+    ASSERT_STREQ("v=0\r\n", parser.getBody().toString().c_str());
+    ASSERT_TRUE(parser.headerValueForKey("Transport").empty());
+}
+
+TEST(RTSP_RESPONSE_PARSER, RESUMES_ACROSS_READS)
+{
+    const std::string response =
+        "RTSP/1.0 200 OK\r\n"
+        "CSeq: 1\r\n"
+        "Content-Length: 3\r\n"
+        "\r\n"
+        "abc";
+    const std::string trailing = "$\x00\x00\x01z";
+    const std::string stream = response + trailing;
+
+    Overflow::RtspResponseParser parser;
+    for (size_t i = 1; i < response.size(); ++i)
+    {
+        ASSERT_FALSE(parser.parse((const unsigned char*)stream.c_str(), i));
+    }
+
+    ASSERT_TRUE(parser.haveHeaders());
+    ASSERT_TRUE(parser.parse((const unsigned char*)stream.c_str(), stream.size()));
+    ASSERT_EQ(response.size(), parser.getMessageLength());
+    ASSERT_STREQ("abc", parser.getBody().toString().c_str());
+}
+
+TEST(RTSP_RESPONSE_PARSER, NO_CONTENT_LENGTH)
+{
+    const std::string response = "RTSP/1.0 454 Session Not Found\r\nCSeq: 9\r\n\r\n";
+
+    Overflow::RtspResponseParser parser;
+    ASSERT_TRUE(parser.parse((const unsigned char*)response.c_str(), response.size()));
+    ASSERT_EQ(454, parser.getCode());
+    ASSERT_EQ(0, parser.getContentLength());
+    ASSERT_EQ(response.size(), parser.getMessageLength());
+
+    parser.reset();
+    ASSERT_EQ(0, parser.getHeaderCount());
+    ASSERT_FALSE(parser.isComplete());
+}
+
+TEST(RTSP_RESPONSE_PARSER, OVERSIZED_CONTENT_LENGTH_IS_AN_ERROR)
+{
+    // would wrap a size_t if it were accumulated unchecked
+    const std::string response =
+        "RTSP/1.0 200 OK\r\n"
+        "CSeq: 3\r\n"
+        "Content-Length: 184467440737095516160\r\n"
+        "\r\n"
+        "v=0\r\n";
+
+    Overflow::RtspResponseParser parser;
+    ASSERT_FALSE(parser.parse((const unsigned char*)response.c_str(), response.size()));
+    ASSERT_TRUE(parser.isError());
+    ASSERT_FALSE(parser.haveHeaders());
+    ASSERT_TRUE(parser.getBody().empty());
+
+    const std::string too_big = "RTSP/1.0 200 OK\r\nContent-Length: 65536\r\n\r\n";
+    parser.reset();
+    ASSERT_FALSE(parser.parse((const unsigned char*)too_big.c_str(), too_big.size()));
+    ASSERT_TRUE(parser.isError());
+}
@@ -0,0 +1,193 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __SCRIPTED_CONTROLLER_H__
+#define __SCRIPTED_CONTROLLER_H__
+
+#include "RtspController.h"
+#include "EventLoop.h"
+#include "Transport.h"
+#include "MockStream.h"
+
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace OverflowTest
+{
+    // Answers every request as the mock server would, straight from the
+    // event loop, and lets the test push rtp and rtcp in as if it was read.
+    class ScriptedTransport: public Overflow::Transport
+    {
+    public:
+        ScriptedTransport(Overflow::ITransportDelegate* delegate,
+                          Overflow::EventLoop* loop,
+                          const std::string& sessionDescription)
+            : Transport(delegate),
+              mLoop(loop),
+              mSessionDescription(sessionDescription)
+        { }
+
+        void writeRtsp(const unsigned char* buffer, const size_t length, int) override
+        {
+            std::string request((const char*)buffer, length);
+            std::string method = request.substr(0, request.find(' '));
+            
+            std::ostringstream response;
+            response << "RTSP/1.0 200 OK\r\n";
+            if (method == "DESCRIBE")
+            {
+                response << "Content-Type: application/sdp\r\n"
+                         << "Content-Length: " << mSessionDescription.length() << "\r\n"
+                         << "\r\n"
+                         << mSessionDescription;
+            }
+            else if (method == "SETUP")
+            {
+                response << "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n"
+                         << "Session: 12345678;timeout=60\r\n"
+                         << "\r\n";
+            }
+            else
+            {
+                response << "\r\n";
+            }
+
+            std::string reply = response.str();
+            mLoop->post([this, reply]() {
+                    Overflow::Response response((const unsigned char*)reply.c_str(), reply.length());
+                    onRtspResponse(&response);
+                });
+        }
+
+        std::string getTransportHeaderString() const override
+        {
+            return "RTP/AVP/TCP;unicast;interleaved=0-1";
+        }
+
+        void start() override { onStateChange(Overflow::CONNECTED); }
+
+        void stop(const std::function<void ()>& onStopped) override
+        {
+            mLoop->post(onStopped);
+        }
+
+        // loop thread only
+        void deliver(const std::vector<OverflowMock::Bytes>& packets)
+        {
+            for (auto& raw: packets)
+            {
+                Overflow::RtpPacketView packet(raw.data(), raw.size());
+                onRtpPacket(&packet);
+            }
+        }
+
+        void deliverRtcp(const OverflowMock::Bytes& raw)
+        {
+            Overflow::RtcpPacket packet(raw.data(), raw.size());
+            onRtcpPacket(&packet);
+        }
+
+    private:
+        Overflow::EventLoop* mLoop;
+        std::string mSessionDescription;
+    };
+
+    class ScriptedController: public Overflow::RtspController
+    {
+    public:
+        ScriptedController(Overflow::IRtspDelegate* delegate,
+                           Overflow::EventLoop* loop,
+                           const std::string& sessionDescription)
+            : RtspController(delegate, "rtsp://127.0.0.1:8554/mock", loop),
+              mLoop(loop),
+              mSessionDescription(sessionDescription),
+              mTransport(nullptr)
+        { }
+
+        ~ScriptedController() { stop(); join(); }
+
+        ScriptedTransport* getTransport() { return mTransport; }
+
+        // runs task on the loop with the transport and waits for it
+        void runOnLoop(const std::function<void (ScriptedTransport*)>& task)
+        {
+            std::promise<void> done;
+            mLoop->post([&]() {
+                    task(mTransport);
+                    done.set_value();
+                });
+            done.get_future().wait();
+        }
+        
+    protected:
+        Overflow::Transport* createTransport() override
+        {
+            mTransport = new ScriptedTransport(this, mLoop, mSessionDescription);
+            return mTransport;
+        }
+
+    private:
+        Overflow::EventLoop* mLoop;
+        std::string mSessionDescription;
+        ScriptedTransport* mTransport;
+    };
+
+    // waits for the first PLAY to be answered
+    class PlayingDelegate: public Overflow::IRtspDelegate
+    {
+    public:
+        PlayingDelegate() : isPlaying(false) { }
+        
+        void onPaletteType(Overflow::RtspSessionType) override { }
+
+        void onRtspClientStateChange(Overflow::RtspClientState, Overflow::RtspClientState newState) override
+        {
+            if (newState == Overflow::CLIENT_PLAY_OK and not isPlaying)
+            {
+                isPlaying = true;
+                playing.set_value();
+            }
+        }
+
+        void onRtpPacketExtension(int, const unsigned char*, const size_t) override { }
+
+        void onPayload(const unsigned char*, const size_t) override { }
+
+        void waitUntilPlaying() { playing.get_future().wait(); }
+
+    private:
+        std::promise<void> playing;
+        bool isPlaying;
+    };
+
+    inline std::vector<std::vector<OverflowMock::Bytes>> makeFrames(OverflowMock::MockStream* stream, int count)
+    {
+        std::vector<std::vector<OverflowMock::Bytes>> frames(count);
+        for (int i = 0; i < count; ++i)
+            stream->nextFrame(i + 1, &frames[i]);
+        return frames;
+    }
+};
+
+#endif //__SCRIPTED_CONTROLLER_H__
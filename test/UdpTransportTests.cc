@@ -0,0 +1,189 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include "SetupResponse.h"
+#include "UdpSocket.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+
+
+static Overflow::SetupResponse* makeSetupResponse(const std::string& transport)
+{
+    std::string raw = "RTSP/1.0 200 OK\r\n"
+        "CSeq: 3\r\n"
+        "Session: 12345678;timeout=30\r\n"
+        "Transport: " + transport + "\r\n"
+        "\r\n";
+    
+    Overflow::Response response((const unsigned char*)raw.c_str(), raw.length());
+    return new Overflow::SetupResponse(&response);
+}
+
+
+TEST(SETUP_RESPONSE, PARSES_UDP_SERVER_PORTS)
+{
+    Overflow::SetupResponse* resp = makeSetupResponse(
+        "RTP/AVP;unicast;client_port=5000-5001;server_port=6970-6971;source=10.0.0.2");
+
+    ASSERT_FALSE(resp->isInterleaved());
+    ASSERT_EQ(5000, resp->getRtpClientPort());
+    ASSERT_EQ(5001, resp->getRtcpClientPort());
+    ASSERT_EQ(6970, resp->getRtpServerPort());
+    ASSERT_EQ(6971, resp->getRtcpServerPort());
+    ASSERT_EQ("10.0.0.2", resp->getSource());
+    ASSERT_EQ(30, resp->getTimeoutSeconds());
+    delete resp;
+}
+
+TEST(SETUP_RESPONSE, INTERLEAVED_HAS_NO_SERVER_PORTS)
+{
+    Overflow::SetupResponse* resp = makeSetupResponse(
+        "RTP/AVP/TCP;unicast;interleaved=2-3");
+
+    ASSERT_TRUE(resp->isInterleaved());
+    ASSERT_EQ(2, resp->getRtpInterleavedChannel());
+    ASSERT_EQ(3, resp->getRtcpInterleavedChannel());
+    ASSERT_EQ(-1, resp->getRtpServerPort());
+    ASSERT_EQ(-1, resp->getRtcpServerPort());
+    delete resp;
+}
+
+TEST(UDP_SOCKET, BINDS_EVEN_ODD_PORT_PAIR)
+{
+    Overflow::UdpSocket rtp, rtcp;
+    ASSERT_TRUE(Overflow::UdpSocket::bindPortPair(&rtp, &rtcp, 0));
+    
+    ASSERT_EQ(0, rtp.getPort() % 2);
+    ASSERT_EQ(rtp.getPort() + 1, rtcp.getPort());
+}
+
+TEST(UDP_SOCKET, DRAINS_DATAGRAMS_IN_BATCHES)
+{
+    Overflow::UdpSocket receiver, sender;
+    ASSERT_TRUE(receiver.bind(0));
+    ASSERT_TRUE(sender.bind(0));
+
+    std::vector<size_t> lengths;
+    receiver.setHandler([&](const unsigned char* buffer, size_t length) {
+            lengths.push_back(length);
+        });
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(receiver.getPort());
+
+    unsigned char payload[1200];
+    memset(payload, 0xAB, sizeof(payload));
+    for (size_t i = 1; i <= 40; ++i)
+        ASSERT_TRUE(sender.sendTo((struct sockaddr*)&address, payload, i * 10));
+
+    ASSERT_EQ(40, receiver.drain());
+    ASSERT_EQ(40, lengths.size());
+    for (size_t i = 0; i < lengths.size(); ++i)
+        ASSERT_EQ((i + 1) * 10, lengths[i]);
+    ASSERT_EQ(0, receiver.drain());
+
+    bool closed = false;
+    receiver.close([&]() { closed = true; });
+    sender.close([]() { });
+    ASSERT_TRUE(closed);
+}
+
+TEST(UDP_SOCKET, IGNORES_STRAY_SENDER)
+{
+    Overflow::UdpSocket receiver, server, stray;
+    ASSERT_TRUE(receiver.bind(0));
+    ASSERT_TRUE(server.bind(0));
+    ASSERT_TRUE(stray.bind(0));
+
+    std::vector<std::string> payloads;
+    receiver.setHandler([&](const unsigned char* buffer, size_t length) {
+            payloads.push_back(std::string((const char*)buffer, length));
+        });
+
+    struct sockaddr_in expected;
+    memset(&expected, 0, sizeof(expected));
+    expected.sin_family = AF_INET;
+    expected.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    expected.sin_port = htons(server.getPort());
+    receiver.setExpectedSource(expected);
+
+    struct sockaddr_in address = expected;
+    address.sin_port = htons(receiver.getPort());
+    
+    // same host, wrong port
+    ASSERT_TRUE(stray.sendTo((struct sockaddr*)&address, (const unsigned char*)"stray", 5));
+    ASSERT_TRUE(server.sendTo((struct sockaddr*)&address, (const unsigned char*)"media", 5));
+
+    ASSERT_EQ(1, receiver.drain());
+    ASSERT_EQ(1, payloads.size());
+    ASSERT_EQ("media", payloads[0]);
+    ASSERT_EQ(1, receiver.getRejectedCount());
+
+    // a different host entirely
+    expected.sin_addr.s_addr = htonl(0x0A000002);
+    receiver.setExpectedSource(expected);
+    ASSERT_TRUE(server.sendTo((struct sockaddr*)&address, (const unsigned char*)"media", 5));
+    ASSERT_EQ(0, receiver.drain());
+    ASSERT_EQ(2, receiver.getRejectedCount());
+
+    receiver.close([]() { });
+    server.close([]() { });
+    stray.close([]() { });
+}
+
+TEST(UDP_SOCKET, KEEPS_DATAGRAMS_PAST_THE_MTU)
+{
+    Overflow::UdpSocket receiver, sender;
+    ASSERT_TRUE(receiver.bind(0));
+    ASSERT_TRUE(sender.bind(0));
+
+    std::vector<std::string> payloads;
+    receiver.setHandler([&](const unsigned char* buffer, size_t length) {
+            payloads.push_back(std::string((const char*)buffer, length));
+        });
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(receiver.getPort());
+
+    // a sender that leaves fragmentation to ip
+    std::string large(9000, 'x');
+    std::string small(100, 'y');
+    ASSERT_TRUE(sender.sendTo((struct sockaddr*)&address, (const unsigned char*)large.c_str(), large.size()));
+    ASSERT_TRUE(sender.sendTo((struct sockaddr*)&address, (const unsigned char*)small.c_str(), small.size()));
+
+    ASSERT_EQ(2, receiver.drain());
+    ASSERT_EQ(large, payloads[0]);
+    ASSERT_EQ(small, payloads[1]);
+
+    receiver.close([]() { });
+    sender.close([]() { });
+}
@@ -22,10 +22,21 @@
 #ifndef __UTIL_H__
 #define __UTIL_H__
 
+#include "Frame.h"
+#include "FrameBuffer.h"
+#include "FramePool.h"
+#include "H264Depacketizer.h"
+#include "H265Depacketizer.h"
+#include "NaluWriter.h"
+#include "RtpPacketView.h"
+#include "SessionDescription.h"
+
 #include <glog/logging.h>
 
 #include <thread>
 #include <chrono>
+#include <vector>
+#include <cstdint>
 
 
 namespace OverflowTest
@@ -44,6 +55,67 @@ namespace OverflowTest
             std::this_thread::sleep_for (std::chrono::seconds(seconds));
         }
 
+        static std::vector<unsigned char> makeRtpPacket (bool marker,
+                                                         uint16_t seq,
+                                                         uint32_t timestamp,
+                                                         const std::vector<unsigned char>& payload)
+        {
+            std::vector<unsigned char> packet = {
+                0x80, (unsigned char)((marker ? 0x80 : 0x00) | 96),
+                (unsigned char)(seq >> 8), (unsigned char)(seq & 0xFF),
+                (unsigned char)(timestamp >> 24), (unsigned char)(timestamp >> 16),
+                (unsigned char)(timestamp >> 8), (unsigned char)(timestamp & 0xFF),
+                0xDE, 0xAD, 0xBE, 0xEF
+            };
+            packet.insert(packet.end(), payload.begin(), payload.end());
+            return packet;
+        }
+
+        // one packet through a fresh depacketizer, as the controller does
+        template <typename Depacketizer>
+        static void depacketize (Overflow::SessionDescription* palette,
+                                 const std::vector<unsigned char>& raw,
+                                 Overflow::FrameBuffer* frame,
+                                 Overflow::FrameMetadata* metadata = nullptr,
+                                 Overflow::NaluWriter* writer = nullptr)
+        {
+            Overflow::RtpPacketView packet(&raw[0], raw.size());
+            Depacketizer depacketizer(palette, &packet, writer);
+            depacketizer.addToFrame(frame, metadata);
+        }
+
+        // for code shared between codecs, only the mpeg-4 and jpeg
+        // depacketizers are told which payload of the stream comes first
+        template <typename Depacketizer>
+        static void addPacketToFrame (Overflow::SessionDescription* palette,
+                                      const Overflow::RtpPacketView* packet,
+                                      bool isFirstPayload,
+                                      Overflow::FrameBuffer* frame)
+        {
+            Depacketizer depacketizer(palette, packet, isFirstPayload);
+            depacketizer.addToFrame(frame);
+        }
+
+        // length bytes of zeros with the metadata the queues look at
+        static Overflow::Frame* makeFrame (Overflow::FramePool* pool,
+                                           bool isKeyFrame,
+                                           bool isDisposable = false,
+                                           size_t length = 16)
+        {
+            Overflow::Frame *frame = pool->acquire(length);
+            frame->getMetadata()->isKeyFrame = isKeyFrame;
+            frame->getMetadata()->isDisposable = isDisposable;
+            for (size_t i = 0; i < length; ++i)
+                frame->getBuffer()->appendByte(0);
+            return frame;
+        }
+
+        static std::vector<unsigned char> frameBytes (const Overflow::FrameBuffer& frame)
+        {
+            return std::vector<unsigned char>(frame.bytesPointer(),
+                                              frame.bytesPointer() + frame.length());
+        }
+
         static void printOutAllNaluTypes (const unsigned char *buffer, size_t length)
         {
             std::string nalus;
@@ -67,6 +139,26 @@ namespace OverflowTest
             LOG(INFO) << "NALUS: " << nalus;
         }        
     };
+
+    template <>
+    inline void Helpers::addPacketToFrame<Overflow::H264Depacketizer> (Overflow::SessionDescription* palette,
+                                                                       const Overflow::RtpPacketView* packet,
+                                                                       bool,
+                                                                       Overflow::FrameBuffer* frame)
+    {
+        Overflow::H264Depacketizer depacketizer(palette, packet);
+        depacketizer.addToFrame(frame);
+    }
+
+    template <>
+    inline void Helpers::addPacketToFrame<Overflow::H265Depacketizer> (Overflow::SessionDescription* palette,
+                                                                       const Overflow::RtpPacketView* packet,
+                                                                       bool,
+                                                                       Overflow::FrameBuffer* frame)
+    {
+        Overflow::H265Depacketizer depacketizer(palette, packet);
+        depacketizer.addToFrame(frame);
+    }
 };
 
 #endif //__UTIL_H__
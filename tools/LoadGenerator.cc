@@ -0,0 +1,388 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "LoadGenerator.h"
+#include "MockRtspServer.h"
+
+#include "RtspWanClient.h"
+#include "EventLoopGroup.h"
+#include "IRtspDelegate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+// keeps a long run at many sessions from growing without bound
+#define LOAD_MAX_LATENCY_SAMPLES (64 * 1024)
+
+
+namespace
+{
+    uint64_t steadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    class LoadSession: public Overflow::IRtspDelegate
+    {
+    public:
+        LoadSession(const std::string& sessionUrl)
+            : url(sessionUrl),
+              client(nullptr),
+              frames(0),
+              bytes(0),
+              firstFrameNanoseconds(0)
+        { }
+
+        void onPaletteType(Overflow::RtspSessionType) override { }
+
+        void onRtspClientStateChange(Overflow::RtspClientState, Overflow::RtspClientState) override { }
+
+        void onRtpPacketExtension(int, const unsigned char*, const size_t) override { }
+
+        void onPayload(const unsigned char* buffer, const size_t length) override
+        {
+            uint64_t now = steadyNanoseconds();
+            uint64_t stamp = 0;
+            bool haveStamp = OverflowMock::MockStream::findFrameStamp(buffer, length, &stamp);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (haveStamp and now >= stamp and latencies.size() < LOAD_MAX_LATENCY_SAMPLES)
+                latencies.push_back(now - stamp);
+            if (firstFrameNanoseconds == 0)
+                firstFrameNanoseconds = now;
+            frames++;
+            bytes += length;
+        }
+
+        std::string url;
+        Overflow::RtspWanClient* client;
+        
+        std::mutex mutex;
+        std::vector<uint64_t> latencies;
+        uint64_t frames;
+        uint64_t bytes;
+        uint64_t firstFrameNanoseconds;
+    };
+
+    std::string jsonString(const std::string& value)
+    {
+        std::ostringstream out;
+        out << '"';
+        for (char c: value)
+        {
+            if (c == '"' or c == '\\')
+                out << '\\' << c;
+            else if ((unsigned char)c < 0x20)
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+            else
+                out << c;
+        }
+        out << '"';
+        return out.str();
+    }
+
+    // -1 means no measurement and comes out as null
+    std::string jsonNumber(double value)
+    {
+        if (value < 0)
+            return "null";
+        std::ostringstream out;
+        out.precision(15);
+        out << value;
+        return out.str();
+    }
+};
+
+
+int
+OverflowTools::ProcessStats::threadCount()
+{
+    DIR* tasks = opendir("/proc/self/task");
+    if (tasks == nullptr)
+        return -1;
+
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(tasks)) != nullptr)
+    {
+        if (entry->d_name[0] != '.')
+            count++;
+    }
+    closedir(tasks);
+    return count;
+}
+
+uint64_t
+OverflowTools::ProcessStats::residentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (not (statm >> size >> resident))
+    {
+        // max rss is the best the other platforms offer
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        return usage.ru_maxrss * 1024ULL;
+#endif
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+void
+OverflowTools::ProcessStats::cpuSeconds(double* user, double* system)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    *user = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+    *system = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+
+OverflowTools::LoadGenerator::LoadGenerator(const LoadGeneratorOptions& options)
+    : mOptions(options)
+{
+}
+
+OverflowTools::LoadReport
+OverflowTools::LoadGenerator::run()
+{
+    std::vector<std::string> urls = mOptions.urls;
+    OverflowMock::MockRtspServer* server = nullptr;
+    if (mOptions.useMock)
+    {
+        server = new OverflowMock::MockRtspServer(mOptions.mock);
+        if (not server->start())
+        {
+            delete server;
+            throw std::runtime_error("mock server failed to start");
+        }
+        urls.push_back(server->getUrl());
+    }
+
+    if (urls.empty() or mOptions.sessions <= 0)
+    {
+        delete server;
+        throw std::runtime_error("nothing to connect to");
+    }
+
+    Overflow::EventLoopGroup* group = nullptr;
+    if (mOptions.eventLoops >= 0)
+    {
+        group = new Overflow::EventLoopGroup(mOptions.eventLoops);
+        group->start();
+    }
+
+    double userBefore, systemBefore;
+    ProcessStats::cpuSeconds(&userBefore, &systemBefore);
+    double mockBefore = server != nullptr ? server->getCpuSeconds() : 0;
+    
+    std::vector<LoadSession*> sessions;
+    for (int i = 0; i < mOptions.sessions; ++i)
+    {
+        if (i > 0 and mOptions.staggerMs > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(mOptions.staggerMs));
+        
+        LoadSession* session = new LoadSession(urls[i % urls.size()]);
+        session->client = new Overflow::RtspWanClient(session, session->url,
+                                                      group != nullptr ? group->next() : nullptr);
+        session->client->start();
+        sessions.push_back(session);
+    }
+
+    // the measured window starts once everyone is connecting
+    uint64_t framesBefore = 0;
+    uint64_t bytesBefore = 0;
+    for (auto session: sessions)
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        framesBefore += session->frames;
+        bytesBefore += session->client->getMetrics().bytesReceived;
+        session->latencies.clear();
+    }
+    uint64_t startNanoseconds = steadyNanoseconds();
+    
+    std::this_thread::sleep_for(std::chrono::seconds(mOptions.durationSeconds));
+
+    LoadReport report;
+    uint64_t endNanoseconds = steadyNanoseconds();
+    report.durationSeconds = (endNanoseconds - startNanoseconds) / 1e9;
+    report.threads = ProcessStats::threadCount();
+    report.residentBytes = ProcessStats::residentBytes();
+    ProcessStats::cpuSeconds(&report.userCpuSeconds, &report.systemCpuSeconds);
+    report.userCpuSeconds -= userBefore;
+    report.systemCpuSeconds -= systemBefore;
+    report.mockCpuSeconds = server != nullptr ? server->getCpuSeconds() - mockBefore : 0;
+
+    report.frames = 0;
+    report.bytes = 0;
+    std::vector<uint64_t> latencies;
+    for (auto session: sessions)
+    {
+        Overflow::SessionMetricsSnapshot metrics = session->client->getMetrics();
+        std::lock_guard<std::mutex> lock(session->mutex);
+        
+        SessionReport entry;
+        entry.url = session->url;
+        entry.state = Overflow::IRtspDelegate::stateToString(metrics.state);
+        entry.frames = session->frames;
+        entry.bytes = metrics.bytesReceived;
+        entry.packetsLost = metrics.packetsLost;
+        entry.reconnects = metrics.reconnects;
+        entry.timeToFirstFrameSeconds = metrics.timeToFirstFrameSeconds;
+        entry.framesPerSecond = 0;
+        if (session->firstFrameNanoseconds != 0 and endNanoseconds > session->firstFrameNanoseconds)
+            entry.framesPerSecond = session->frames / ((endNanoseconds - session->firstFrameNanoseconds) / 1e9);
+        
+        latencies.insert(latencies.end(), session->latencies.begin(), session->latencies.end());
+        entry.latencyP50Ms = session->latencies.empty() ? -1 : percentile(&session->latencies, 0.50) / 1e6;
+        entry.latencyP99Ms = session->latencies.empty() ? -1 : percentile(&session->latencies, 0.99) / 1e6;
+        
+        report.frames += session->frames;
+        report.bytes += metrics.bytesReceived;
+        report.sessions.push_back(entry);
+    }
+    report.frames -= framesBefore;
+    report.bytes -= bytesBefore;
+    report.bitsPerSecond = report.durationSeconds > 0 ? report.bytes * 8 / report.durationSeconds : 0;
+    report.latencyP50Ms = latencies.empty() ? -1 : percentile(&latencies, 0.50) / 1e6;
+    report.latencyP99Ms = latencies.empty() ? -1 : percentile(&latencies, 0.99) / 1e6;
+
+    for (auto session: sessions)
+    {
+        session->client->stop();
+        session->client->join();
+        delete session->client;
+        delete session;
+    }
+
+    if (group != nullptr)
+    {
+        group->stop();
+        group->join();
+        delete group;
+    }
+    
+    if (server != nullptr)
+    {
+        server->stop();
+        delete server;
+    }
+    
+    return report;
+}
+
+double
+OverflowTools::LoadGenerator::percentile(std::vector<uint64_t>* values, double fraction)
+{
+    if (values->empty())
+        return 0;
+    
+    size_t index = std::min(values->size() - 1, (size_t)(fraction * values->size()));
+    std::nth_element(values->begin(), values->begin() + index, values->end());
+    return (*values)[index];
+}
+
+std::string
+OverflowTools::LoadReport::toText() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "sessions: " << sessions.size()
+        << " duration: " << durationSeconds << "s" << std::endl
+        << "throughput: " << bitsPerSecond / 1e6 << " Mbps"
+        << " frames: " << frames << std::endl;
+    out << "latency p50: " << jsonNumber(latencyP50Ms) << " ms"
+        << " p99: " << jsonNumber(latencyP99Ms) << " ms" << std::endl;
+    out << "threads: " << threads
+        << " rss: " << residentBytes / (1024.0 * 1024.0) << " MiB"
+        << " cpu user: " << userCpuSeconds << "s"
+        << " system: " << systemCpuSeconds << "s";
+    if (mockCpuSeconds > 0)
+        out << " (mock server: " << mockCpuSeconds << "s)";
+    out << std::endl;
+
+    for (size_t i = 0; i < sessions.size(); ++i)
+    {
+        const SessionReport& session = sessions[i];
+        out << "  [" << i << "] " << session.state
+            << " fps: " << session.framesPerSecond
+            << " frames: " << session.frames
+            << " lost: " << session.packetsLost
+            << " reconnects: " << session.reconnects
+            << " p99: " << jsonNumber(session.latencyP99Ms) << " ms"
+            << " " << session.url << std::endl;
+    }
+    return out.str();
+}
+
+std::string
+OverflowTools::LoadReport::toJson() const
+{
+    std::ostringstream out;
+    out.precision(15);
+    out << "{\n"
+        << "  \"duration_seconds\": " << durationSeconds << ",\n"
+        << "  \"frames\": " << frames << ",\n"
+        << "  \"bytes\": " << bytes << ",\n"
+        << "  \"bits_per_second\": " << bitsPerSecond << ",\n"
+        << "  \"latency_p50_ms\": " << jsonNumber(latencyP50Ms) << ",\n"
+        << "  \"latency_p99_ms\": " << jsonNumber(latencyP99Ms) << ",\n"
+        << "  \"threads\": " << threads << ",\n"
+        << "  \"rss_bytes\": " << residentBytes << ",\n"
+        << "  \"cpu_user_seconds\": " << userCpuSeconds << ",\n"
+        << "  \"cpu_system_seconds\": " << systemCpuSeconds << ",\n"
+        << "  \"mock_cpu_seconds\": " << mockCpuSeconds << ",\n"
+        << "  \"sessions\": [";
+
+    for (size_t i = 0; i < sessions.size(); ++i)
+    {
+        const SessionReport& session = sessions[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {"
+            << "\"url\": " << jsonString(session.url)
+            << ", \"state\": " << jsonString(session.state)
+            << ", \"frames\": " << session.frames
+            << ", \"bytes\": " << session.bytes
+            << ", \"packets_lost\": " << session.packetsLost
+            << ", \"reconnects\": " << session.reconnects
+            << ", \"frames_per_second\": " << session.framesPerSecond
+            << ", \"time_to_first_frame_seconds\": " << jsonNumber(session.timeToFirstFrameSeconds)
+            << ", \"latency_p50_ms\": " << jsonNumber(session.latencyP50Ms)
+            << ", \"latency_p99_ms\": " << jsonNumber(session.latencyP99Ms)
+            << "}";
+    }
+    out << (sessions.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    return out.str();
+}
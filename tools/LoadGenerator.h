@@ -0,0 +1,123 @@
+// -*-c++-*-
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef __LOAD_GENERATOR_H__
+#define __LOAD_GENERATOR_H__
+
+#include "MockStream.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace OverflowTools
+{
+    struct LoadGeneratorOptions
+    {
+        LoadGeneratorOptions()
+            : sessions(1),
+              staggerMs(100),
+              durationSeconds(10),
+              eventLoops(-1),
+              useMock(false)
+        { }
+        
+        // sessions are handed out round robin
+        std::vector<std::string> urls;
+        int sessions;
+        // delay between session starts so they do not all connect at once
+        int staggerMs;
+        // measured from the last session start
+        int durationSeconds;
+        // -1 gives every client its own loop, 0 one loop per core
+        int eventLoops;
+        // run a mock server in-process and add it to urls
+        bool useMock;
+        OverflowMock::MockStreamOptions mock;
+    };
+
+    struct SessionReport
+    {
+        std::string url;
+        std::string state;
+        uint64_t frames;
+        uint64_t bytes;
+        uint64_t packetsLost;
+        uint64_t reconnects;
+        double framesPerSecond;
+        double timeToFirstFrameSeconds;
+        // -1 when frames carry no mock server stamp
+        double latencyP50Ms;
+        double latencyP99Ms;
+    };
+
+    struct LoadReport
+    {
+        double durationSeconds;
+        uint64_t frames;
+        uint64_t bytes;
+        double bitsPerSecond;
+        double latencyP50Ms;
+        double latencyP99Ms;
+        int threads;
+        uint64_t residentBytes;
+        double userCpuSeconds;
+        double systemCpuSeconds;
+        // an in-process mock server's share of the cpu above
+        double mockCpuSeconds;
+        std::vector<SessionReport> sessions;
+
+        std::string toText() const;
+
+        std::string toJson() const;
+    };
+
+    class ProcessStats
+    {
+    public:
+        static int threadCount();
+
+        static uint64_t residentBytes();
+
+        static void cpuSeconds(double* user, double* system);
+    };
+
+    // Opens options.sessions RtspWanClients, lets them stream for the
+    // duration and reports what they received.
+    class LoadGenerator
+    {
+    public:
+        LoadGenerator(const LoadGeneratorOptions& options);
+
+        // blocks for the staggered starts plus the duration
+        LoadReport run();
+
+        // fraction in [0, 1] of values, which get reordered
+        static double percentile(std::vector<uint64_t>* values, double fraction);
+
+    private:
+        LoadGeneratorOptions mOptions;
+    };
+};
+
+#endif //__LOAD_GENERATOR_H__
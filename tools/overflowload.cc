@@ -0,0 +1,139 @@
+// Copyright (c) 2017 Philip Herron.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "LoadGenerator.h"
+
+#include <glog/logging.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <getopt.h>
+
+
+static void usage(const char* program)
+{
+    std::cerr << "usage: " << program << " [options] [rtsp-url ...]" << std::endl
+              << "  --sessions N        sessions to open, default 1" << std::endl
+              << "  --stagger-ms N      delay between session starts, default 100" << std::endl
+              << "  --duration N        seconds to measure after the last start, default 10" << std::endl
+              << "  --loops N           share N event loops, 0 for one per core, default one per client" << std::endl
+              << "  --urls-file PATH    read urls one per line" << std::endl
+              << "  --json PATH         write the report as json" << std::endl
+              << "  --mock              stream from an in-process mock server" << std::endl
+              << "  --mock-codec NAME   h264, mjpeg or mp4v, default h264" << std::endl
+              << "  --mock-bitrate BPS  default 4000000" << std::endl
+              << "  --mock-fps N        default 25" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    google::InitGoogleLogging(argv[0]);
+
+    OverflowTools::LoadGeneratorOptions options;
+    std::string jsonPath;
+    
+    static struct option longOptions[] = {
+        { "sessions", required_argument, 0, 'n' },
+        { "stagger-ms", required_argument, 0, 's' },
+        { "duration", required_argument, 0, 'd' },
+        { "loops", required_argument, 0, 'l' },
+        { "urls-file", required_argument, 0, 'u' },
+        { "json", required_argument, 0, 'j' },
+        { "mock", no_argument, 0, 'm' },
+        { "mock-codec", required_argument, 0, 'c' },
+        { "mock-bitrate", required_argument, 0, 'b' },
+        { "mock-fps", required_argument, 0, 'f' },
+        { "help", no_argument, 0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:s:d:l:u:j:mc:b:f:h", longOptions, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': options.sessions = atoi(optarg); break;
+        case 's': options.staggerMs = atoi(optarg); break;
+        case 'd': options.durationSeconds = atoi(optarg); break;
+        case 'l': options.eventLoops = atoi(optarg); break;
+        case 'j': jsonPath = optarg; break;
+        case 'm': options.useMock = true; break;
+        case 'b': options.mock.bitrate = atoi(optarg); break;
+        case 'f': options.mock.fps = atoi(optarg); break;
+        case 'u': {
+            std::ifstream file(optarg);
+            if (not file)
+            {
+                std::cerr << "unable to read: " << optarg << std::endl;
+                return 1;
+            }
+            std::string line;
+            while (std::getline(file, line))
+            {
+                if (not line.empty() and line[0] != '#')
+                    options.urls.push_back(line);
+            }
+        }
+            break;
+        case 'c':
+            if (not OverflowMock::MockStream::codecFromString(optarg, &options.mock.codec))
+            {
+                std::cerr << "unknown codec: " << optarg << std::endl;
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    for (int i = optind; i < argc; ++i)
+        options.urls.push_back(argv[i]);
+    
+    if (options.urls.empty())
+        options.useMock = true;
+
+    try
+    {
+        OverflowTools::LoadGenerator generator(options);
+        OverflowTools::LoadReport report = generator.run();
+        
+        std::cout << report.toText();
+        
+        if (not jsonPath.empty())
+        {
+            std::ofstream json(jsonPath.c_str());
+            json << report.toJson();
+            if (not json)
+            {
+                std::cerr << "unable to write: " << jsonPath << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}